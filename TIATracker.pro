@@ -7,6 +7,7 @@
 QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+QT += concurrent
 
 TARGET = TIATracker
 TEMPLATE = app
@@ -47,7 +48,39 @@ SOURCES += main.cpp\
     optionstab.cpp \
     aboutdialog.cpp \
     guidekeyboard.cpp \
-    createguidedialog.cpp
+    createguidedialog.cpp \
+    emulation/cpu6502.cpp \
+    emulation/assembler6502.cpp \
+    emulation/dasmexporter.cpp \
+    emulation/playerharness.cpp \
+    emulation/playervalidator.cpp \
+    emulation/playervariantfinder.cpp \
+    emulation/envelopecache.cpp \
+    emulation/frameclock.cpp \
+    emulation/audiosink.cpp \
+    emulation/sdlaudiosink.cpp \
+    emulation/wavfilesink.cpp \
+    emulation/ringsink.cpp \
+    emulation/pcmring.cpp \
+    emulation/trackkeyframes.cpp \
+    track/playorder.cpp \
+    tiasound/pitchguideoptimizer.cpp \
+    tiasound/tuningoptimizer.cpp \
+    emulation/pitchmeasurement.cpp \
+    emulation/spectrum.cpp \
+    emulation/wavfilesource.cpp \
+    emulation/voicedictionary.cpp \
+    emulation/percussionfitter.cpp \
+    emulation/instrumentfitter.cpp \
+    emulation/monotonicclock.cpp \
+    emulation/inputlatencytracer.cpp \
+    emulation/eventtrace.cpp \
+    emulation/benchmarkrunner.cpp \
+    emulation/benchmarksuite.cpp \
+    emulation/rendercorpus.cpp \
+    emulation/registerlog.cpp \
+    emulation/wavfilewriter.cpp \
+    emulation/stemfilesink.cpp
 
 HEADERS  += mainwindow.h \
     pianokeyboard.h \
@@ -84,7 +117,39 @@ HEADERS  += mainwindow.h \
     optionstab.h \
     aboutdialog.h \
     guidekeyboard.h \
-    createguidedialog.h
+    createguidedialog.h \
+    emulation/cpu6502.h \
+    emulation/assembler6502.h \
+    emulation/dasmexporter.h \
+    emulation/playerharness.h \
+    emulation/playervalidator.h \
+    emulation/playervariantfinder.h \
+    emulation/envelopecache.h \
+    emulation/frameclock.h \
+    emulation/audiosink.h \
+    emulation/sdlaudiosink.h \
+    emulation/wavfilesink.h \
+    emulation/ringsink.h \
+    emulation/pcmring.h \
+    emulation/trackkeyframes.h \
+    track/playorder.h \
+    tiasound/pitchguideoptimizer.h \
+    tiasound/tuningoptimizer.h \
+    emulation/pitchmeasurement.h \
+    emulation/spectrum.h \
+    emulation/wavfilesource.h \
+    emulation/voicedictionary.h \
+    emulation/percussionfitter.h \
+    emulation/instrumentfitter.h \
+    emulation/monotonicclock.h \
+    emulation/inputlatencytracer.h \
+    emulation/eventtrace.h \
+    emulation/benchmarkrunner.h \
+    emulation/benchmarksuite.h \
+    emulation/rendercorpus.h \
+    emulation/registerlog.h \
+    emulation/wavfilewriter.h \
+    emulation/stemfilesink.h
 
 
 FORMS    += mainwindow.ui \
@@ -5,10 +5,12 @@
 #include <QString>
 #include "tiasound/tiasound.h"
 #include "tiasound/pitchguidefactory.h"
+#include "tiasound/pitchguideoptimizer.h"
 #include "percussiontab.h"
 #include <iostream>
 #include "mainwindow.h"
 #include <QProgressDialog>
+#include <QFutureWatcher>
 #include "guidekeyboard.h"
 #include <QKeyEvent>
 #include <cmath>
@@ -52,61 +54,47 @@ void CreateGuideDialog::on_pushButtonCreateGuide_clicked() {
     TiaSound::TvStandard standard = ui->radioButtonGuidePal->isChecked() ? TiaSound::TvStandard::PAL : TiaSound::TvStandard::NTSC;
     TiaSound::PitchGuideFactory pg;
 
-    // Optimize
-    long bestError = 99999999;
-    double bestFreq = 0;
-    int bestNum = 0;
+    // Collect what to optimize for
+    QList<TiaSound::Distortion> distortions;
+    for (int i = 0; i < checkBoxNames.size(); ++i) {
+        TiaSound::Distortion dist = checkBoxNames.keys()[i];
+        QCheckBox *cbDist = findChild<QCheckBox *>(checkBoxNames[dist]);
+        if (cbDist->isChecked()) {
+            distortions.append(dist);
+        }
+    }
+    QVector<bool> enabledNotes;
+    for (int i = 0; i < TiaSound::PitchGuideFactory::numNotes; ++i) {
+        enabledNotes.append(ui->guidePianoKeyboard->keyInfo[i].isEnabled);
+    }
     int maxNoteDeviation = ui->spinBoxGuideMaxDeviation->value();
     double lowerBound = std::pow(2.0, -maxNoteDeviation/12.0) * 440.0;
     double upperBound = std::pow(2.0, maxNoteDeviation/12.0) * 440.0;
 
-    // Loop over frequencies in range
-    QProgressDialog pd("Optimizing pitch guide...", "Cancel", 0, (upperBound - lowerBound)*10, this);
+    // Optimize in the background
+    TiaSound::PitchGuideOptimizer optimizer(standard, distortions, enabledNotes, threshold);
+    QProgressDialog pd("Optimizing pitch guide...", "Cancel", 0, 0, this);
     pd.setWindowModality(Qt::WindowModal);
-    pd.setMinimumDuration(0);
-    GuideKeyboard *keyboard = findChild<GuideKeyboard *>("guidePianoKeyboard");
-
-    for (double f = lowerBound; f < upperBound; f += 0.1) {
-        pd.setValue((f - lowerBound)*10);
-        long currentError = 0;
-        int curNum = 0;
-        // For this frequency, loop over all requested distortions
-        for (int i = 0; i < checkBoxNames.size(); ++i) {
-            TiaSound::Distortion dist = checkBoxNames.keys()[i];
-            QCheckBox *cbDist = findChild<QCheckBox *>(checkBoxNames[dist]);
-            if (cbDist->isChecked()) {
-                QList<TiaSound::FrequencyPitchGuide> guide = pg.calcInstrumentPitchGuide(standard, dist, f);
-                for (int i = 0; i < guide.size(); ++i) {
-                    // Consider only requested notes
-                    if (guide[i].note != TiaSound::Note::NotANote) {
-                        int noteIndex = TiaSound::getIntFromNote(guide[i].note);
-                        if (keyboard->keyInfo[noteIndex].isEnabled
-                                && std::abs(guide[i].percentOff) <= threshold) {
-                            currentError += guide[i].percentOff*guide[i].percentOff;
-                            curNum++;
-                        }
-                    }
-                }
-            }
-        }
-        // Now check if new best has been found
-        if (curNum > bestNum || (curNum == bestNum && currentError < bestError)) {
-            bestError = currentError;
-            bestFreq = f;
-            bestNum = curNum;
-        }
-        // Cancel pressed?
-        if (pd.wasCanceled()) {
-            ui->labelGuideBaseFreq->setText("");
-            isGuideCreated = false;
-            ui->guidePianoKeyboard->removeGuide();
-            update();
-            return;
-        }
+    QFutureWatcher<void> watcher;
+    connect(&watcher, &QFutureWatcher<void>::finished, &pd, &QProgressDialog::reset);
+    connect(&watcher, &QFutureWatcher<void>::progressRangeChanged, &pd, &QProgressDialog::setRange);
+    connect(&watcher, &QFutureWatcher<void>::progressValueChanged, &pd, &QProgressDialog::setValue);
+    connect(&pd, &QProgressDialog::canceled, &watcher, &QFutureWatcher<void>::cancel);
+    watcher.setFuture(optimizer.start(lowerBound, upperBound));
+    pd.exec();
+    watcher.waitForFinished();
+
+    // Cancel pressed?
+    if (watcher.isCanceled()) {
+        ui->labelGuideBaseFreq->setText("");
+        isGuideCreated = false;
+        ui->guidePianoKeyboard->removeGuide();
+        update();
+        return;
     }
 
     // Now create pitch guide for the best frequency
-    newGuide = pg.calculateGuide(name, standard, bestFreq);
+    newGuide = pg.calculateGuide(name, standard, optimizer.getResult().baseFreq);
     isGuideCreated = true;
 
     // Set A4= label text
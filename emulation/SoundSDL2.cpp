@@ -24,11 +24,13 @@
 
 #include "TIASnd.h"
 #include "SoundSDL2.h"
+#include "monotonicclock.h"
+#include "eventtrace.h"
 
 namespace Emulation {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-SoundSDL2::SoundSDL2(TIASound *tiasound)
+SoundSDL2::SoundSDL2(TIASound *tiasound, Int32 sampleRate, Int32 bufferSize)
   : myTIASound(tiasound),
     myIsEnabled(false),
     myIsInitializedFlag(false),
@@ -36,21 +38,62 @@ SoundSDL2::SoundSDL2(TIASound *tiasound)
     myNumChannels(0),
     myFragmentSizeLogBase2(0),
     myIsMuted(true),
-    myVolume(100)
+    myVolume(100),
+    myFrameRate(60.0),
+    myIsPrecise(false),
+    mySamplesLeftInFrame(0),
+    myQueuedFrames(0),
+    myLatencyTarget(1),
+    myTimingStats{0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    myPrerenderFrames(0),
+    myMarkedInput(-1),
+    myPrefillSamples(0),
+    myIsPrefilled(false),
+    myDevice(0),
+    myRequestedSampleRate(sampleRate),
+    myRequestedBufferSize(bufferSize),
+    myIsAdaptive(false),
+    myAdaptiveFloor(MinBufferSize),
+    myAdaptiveUnderruns(0),
+    myAdaptiveTicks(0),
+    myUnderruns(0),
+    myDeliveredSamples(0),
+    myStartCounter(0)
+{
+  // SDL_OpenAudioDevice() needs the audio subsystem, SDL_OpenAudio() used
+  // to initialize it implicitly
+  if(SDL_WasInit(SDL_INIT_AUDIO) == 0 && SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+  {
+    std::cerr << "WARNING: Couldn't initialize SDL audio system!\n"
+        << "         " << SDL_GetError() << "\n";
+    return;
+  }
+  openDevice();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+SoundSDL2::~SoundSDL2()
+{
+  closeDevice();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::openDevice()
 {
-  // The sound system is opened only once per program run, to eliminate
-  // issues with opening and closing it multiple times
-  // This fixes a bug most prevalent with ATI video cards in Windows,
-  // whereby sound stopped working after the first video change
   SDL_AudioSpec desired;
-  desired.freq   = 44100;
+  SDL_zero(desired);
+  desired.freq   = myRequestedSampleRate;
   desired.format = AUDIO_S16SYS;
   desired.channels = 2;
-  desired.samples  = 1024;
+  desired.samples  = Uint16(myRequestedBufferSize);
   desired.callback = callback;
   desired.userdata = static_cast<void*>(this);
 
-  if(SDL_OpenAudio(&desired, &myHardwareSpec) < 0)
+  // Let SDL convert if the hardware can't do exactly what was requested,
+  // except for the buffer size
+  myDevice = SDL_OpenAudioDevice(NULL, 0, &desired, &myHardwareSpec,
+                                 SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+  if(myDevice == 0)
   {
     std::cerr << "WARNING: Couldn't open SDL audio system!\n"
         << "         " << SDL_GetError() << "\n";
@@ -64,30 +107,121 @@ SoundSDL2::SoundSDL2(TIASound *tiasound)
     std::cerr << "WARNING: Sound device doesn't support realtime audio! Make "
         << "sure a sound\n"
         << "         server isn't running.  Audio is disabled.\n";
-    SDL_CloseAudio();
+    SDL_CloseAudioDevice(myDevice);
+    myDevice = 0;
     return;
   }
 
   // Pre-compute fragment-related variables as much as possible
   myFragmentSizeLogBase2 = log(myHardwareSpec.samples) / log(2.0);
-  myFragmentSizeLogDiv1 = myFragmentSizeLogBase2 / 60.0;
-  myFragmentSizeLogDiv2 = (myFragmentSizeLogBase2 - 1) / 60.0;
+  myFragmentSizeLogDiv1 = myFragmentSizeLogBase2 / myFrameRate;
+  myFragmentSizeLogDiv2 = (myFragmentSizeLogBase2 - 1) / myFrameRate;
+
+  myStartCounter = 0;
+  myAdaptiveUnderruns = 0;
+  myAdaptiveTicks = SDL_GetTicks();
 
   myIsInitializedFlag = true;
-  SDL_PauseAudio(1);
+  SDL_PauseAudioDevice(myDevice, 1);
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-SoundSDL2::~SoundSDL2()
+void SoundSDL2::closeDevice()
 {
-  // Close the SDL audio system if it's initialized
+  // Close the SDL audio device if it's initialized
   if(myIsInitializedFlag)
   {
-    SDL_CloseAudio();
+    SDL_CloseAudioDevice(myDevice);
+    myDevice = 0;
     myIsEnabled = myIsInitializedFlag = false;
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::setDevice(Int32 sampleRate, Int32 bufferSize)
+{
+  if(bufferSize < Int32(MinBufferSize))
+    bufferSize = MinBufferSize;
+  else if(bufferSize > Int32(MaxBufferSize))
+    bufferSize = MaxBufferSize;
+  if(myIsInitializedFlag && sampleRate == myRequestedSampleRate
+      && bufferSize == myRequestedBufferSize)
+    return;
+
+  bool wasEnabled = myIsEnabled;
+  closeDevice();
+  myRequestedSampleRate = sampleRate;
+  myRequestedBufferSize = bufferSize;
+  openDevice();
+  if(wasEnabled)
+  {
+    // Register state is kept, but queued writes refer to the old timing
+    myRegWriteQueue.clear();
+    myLastRegisterSetCycle = 0;
+    open();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::setAdaptiveBufferSize(bool state)
+{
+  myIsAdaptive = state;
+  myAdaptiveFloor = MinBufferSize;
+  myAdaptiveUnderruns = getUnderruns();
+  myAdaptiveTicks = SDL_GetTicks();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::adaptBufferSize()
+{
+  if(!myIsAdaptive || !myIsInitializedFlag)
+    return;
+
+  uInt32 underruns = getUnderruns();
+  uInt32 now = SDL_GetTicks();
+  Int32 bufferSize = myRequestedBufferSize;
+  if(underruns != myAdaptiveUnderruns)
+  {
+    // Too small: go back up and never try this size again
+    if(bufferSize < Int32(MaxBufferSize))
+    {
+      myAdaptiveFloor = bufferSize * 2;
+      setDevice(myRequestedSampleRate, bufferSize * 2);
+    }
+  }
+  else if(now - myAdaptiveTicks >= AdaptiveInterval
+          && bufferSize / 2 >= Int32(myAdaptiveFloor))
+  {
+    setDevice(myRequestedSampleRate, bufferSize / 2);
+  }
+  else
+    return;
+
+  myAdaptiveUnderruns = getUnderruns();
+  myAdaptiveTicks = now;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Int32 SoundSDL2::getSampleRate() const
+{
+  return myIsInitializedFlag ? myHardwareSpec.freq : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Int32 SoundSDL2::getBufferSize() const
+{
+  return myIsInitializedFlag ? myHardwareSpec.samples : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+uInt32 SoundSDL2::getUnderruns()
+{
+  SDL_LockAudioDevice(myDevice);
+  uInt32 underruns = myUnderruns;
+  SDL_UnlockAudioDevice(myDevice);
+  return underruns;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void SoundSDL2::setEnabled(bool)
 {
@@ -105,6 +239,8 @@ void SoundSDL2::open()
 
   // Now initialize the TIASound object which will actually generate sound
   myTIASound->outputFrequency(myHardwareSpec.freq);
+  myFrameClock.setRates(myHardwareSpec.freq, myFrameRate);
+  resetPrecise();
   const string& chanResult =
       myTIASound->channels(myHardwareSpec.channels, myNumChannels == 2);
 
@@ -123,10 +259,11 @@ void SoundSDL2::close()
   if(myIsInitializedFlag)
   {
     myIsEnabled = false;
-    SDL_PauseAudio(1);
+    SDL_PauseAudioDevice(myDevice, 1);
     myLastRegisterSetCycle = 0;
     myTIASound->reset();
     myRegWriteQueue.clear();
+    resetPrecise();
   }
 }
 
@@ -136,7 +273,9 @@ void SoundSDL2::mute(bool state)
   if(myIsInitializedFlag)
   {
     myIsMuted = state;
-    SDL_PauseAudio(myIsMuted ? 1 : 0);
+    // No callbacks while paused, which must not count as an underrun
+    myStartCounter = 0;
+    SDL_PauseAudioDevice(myDevice, myIsMuted ? 1 : 0);
   }
 }
 
@@ -145,10 +284,11 @@ void SoundSDL2::reset()
 {
   if(myIsInitializedFlag)
   {
-    SDL_PauseAudio(1);
+    SDL_PauseAudioDevice(myDevice, 1);
     myLastRegisterSetCycle = 0;
     myTIASound->reset();
     myRegWriteQueue.clear();
+    resetPrecise();
     mute(myIsMuted);
   }
 }
@@ -158,10 +298,10 @@ void SoundSDL2::setVolume(Int32 percent)
 {
   if(myIsInitializedFlag && (percent >= 0) && (percent <= 100))
   {
-    SDL_LockAudio();
+    SDL_LockAudioDevice(myDevice);
     myVolume = percent;
     myTIASound->volume(percent);
-    SDL_UnlockAudio();
+    SDL_UnlockAudioDevice(myDevice);
   }
 }
 
@@ -203,12 +343,158 @@ void SoundSDL2::setFrameRate(float framerate)
   // FIXME - should we clear out the queue or adjust the values in it?
   myFragmentSizeLogDiv1 = myFragmentSizeLogBase2 / framerate;
   myFragmentSizeLogDiv2 = (myFragmentSizeLogBase2 - 1) / framerate;
+  myFrameRate = framerate;
+  if(myIsInitializedFlag)
+    myFrameClock.setRates(myHardwareSpec.freq, myFrameRate);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::setPreciseTiming(bool state)
+{
+  SDL_LockAudioDevice(myDevice);
+  if(state != myIsPrecise)
+  {
+    // Queued writes of one mode make no sense in the other
+    myIsPrecise = state;
+    myRegWriteQueue.clear();
+    myLastRegisterSetCycle = 0;
+    resetPrecise();
+  }
+  SDL_UnlockAudioDevice(myDevice);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::endFrame()
+{
+  if(myPrerenderFrames != 0)
+  {
+    uInt32 channels = myHardwareSpec.channels;
+    uInt32 samples = uInt32(myFrameClock.nextFrameSamples());
+    myFrameSamples.resize(samples * channels);
+    myTIASound->process(myFrameSamples.data(), samples);
+    uInt32 samplesAhead = uInt32(myPcmRing.getNumAvailable()) / channels;
+    bool isWritten =
+        myPcmRing.write(myFrameSamples.data(), int(samples * channels)) == int(samples * channels);
+
+    // The ring needs no lock, but the statistics are shared with the
+    // callback and getTimingStats()
+    SDL_LockAudioDevice(myDevice);
+    if(isWritten)
+      ++myTimingStats.appliedFrames;
+    else
+      ++myTimingStats.droppedFrames;
+    if(myMarkedInput >= 0)
+      measureInput(samplesAhead);
+    SDL_UnlockAudioDevice(myDevice);
+    return;
+  }
+  if(!myIsPrecise)
+    return;
+
+  SDL_LockAudioDevice(myDevice);
+  RegWrite info;
+  info.addr = FrameEndAddress;
+  info.value = 0;
+  info.delta = 0.0;
+  myRegWriteQueue.enqueue(info);
+  ++myQueuedFrames;
+  SDL_UnlockAudioDevice(myDevice);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::markInput(Int64 inputMicros)
+{
+  if(myPrerenderFrames != 0)
+  {
+    // Measured by endFrame() in this thread
+    myMarkedInput = inputMicros;
+    return;
+  }
+  if(!myIsPrecise)
+    return;
+
+  // Travels with the frame, so it is measured when the frame is applied
+  SDL_LockAudioDevice(myDevice);
+  RegWrite info;
+  info.addr = InputMarkAddress;
+  info.value = 0;
+  info.delta = double(inputMicros);
+  myRegWriteQueue.enqueue(info);
+  SDL_UnlockAudioDevice(myDevice);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::setPrerenderFrames(uInt32 frames)
+{
+  SDL_LockAudioDevice(myDevice);
+  if(frames != myPrerenderFrames)
+  {
+    myPrerenderFrames = frames;
+    myRegWriteQueue.clear();
+    myLastRegisterSetCycle = 0;
+    resetPrecise();
+  }
+  SDL_UnlockAudioDevice(myDevice);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::setLatencyTarget(uInt32 frames)
+{
+  SDL_LockAudioDevice(myDevice);
+  myLatencyTarget = frames < 1 ? 1 : frames;
+  SDL_UnlockAudioDevice(myDevice);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+SoundSDL2::TimingStats SoundSDL2::getTimingStats()
+{
+  SDL_LockAudioDevice(myDevice);
+  TimingStats stats = myTimingStats;
+  SDL_UnlockAudioDevice(myDevice);
+  return stats;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::resetTimingStats()
+{
+  SDL_LockAudioDevice(myDevice);
+  TimingStats stats{0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  stats.measuredInputs = myTimingStats.measuredInputs;
+  stats.lastInputMicros = myTimingStats.lastInputMicros;
+  stats.lastAppliedMicros = myTimingStats.lastAppliedMicros;
+  stats.lastAudibleMicros = myTimingStats.lastAudibleMicros;
+  myTimingStats = stats;
+  myUnderruns = 0;
+  SDL_UnlockAudioDevice(myDevice);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::resetPrecise()
+{
+  myFrameClock.reset();
+  mySamplesLeftInFrame = 0;
+  myQueuedFrames = 0;
+  myMarkedInput = -1;
+
+  // Room for the prefill depth plus a few frames of jitter
+  myIsPrefilled = false;
+  uInt32 frameSamples = myIsInitializedFlag
+      ? uInt32(myHardwareSpec.freq / myFrameRate) * myHardwareSpec.channels : 0;
+  myPrefillSamples = myPrerenderFrames * frameSamples;
+  myPcmRing.resize(myPrerenderFrames != 0 ? int(myPrefillSamples + 4 * frameSamples) : 0);
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void SoundSDL2::set(uInt16 addr, uInt8 value, Int32 cycle)
 {
-  SDL_LockAudio();
+  // The callback doesn't touch the TIA in pre-rendered mode
+  if(myPrerenderFrames != 0)
+  {
+    myTIASound->set(addr, value);
+    return;
+  }
+
+  SDL_LockAudioDevice(myDevice);
 
   // First, calculate how many seconds would have past since the last
   // register write on a real 2600
@@ -227,12 +513,24 @@ void SoundSDL2::set(uInt16 addr, uInt8 value, Int32 cycle)
   // Update last cycle counter to the current cycle
   myLastRegisterSetCycle = cycle;
 
-  SDL_UnlockAudio();
+  SDL_UnlockAudioDevice(myDevice);
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void SoundSDL2::processFragment(Int16* stream, uInt32 length)
 {
+  EventTrace::Scope trace("audio", "SoundSDL2::processFragment");
+  if(myPrerenderFrames != 0)
+  {
+    processFragmentPrerendered(stream, length);
+    return;
+  }
+  if(myIsPrecise)
+  {
+    processFragmentPrecise(stream, length);
+    return;
+  }
+
   uInt32 channels = myHardwareSpec.channels;
   length = length / channels;
 
@@ -311,10 +609,132 @@ void SoundSDL2::processFragment(Int16* stream, uInt32 length)
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::processFragmentPrecise(Int16* stream, uInt32 length)
+{
+  uInt32 channels = myHardwareSpec.channels;
+  length = length / channels;
+
+  uInt32 position = 0;
+  while(position < length)
+  {
+    if(mySamplesLeftInFrame == 0)
+    {
+      startFrame();
+      if(myMarkedInput >= 0)
+        measureInput(position);
+    }
+
+    uInt32 samples = length - position;
+    if(samples > mySamplesLeftInFrame)
+      samples = mySamplesLeftInFrame;
+    myTIASound->process(stream + position * channels, samples);
+    position += samples;
+    mySamplesLeftInFrame -= samples;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::processFragmentPrerendered(Int16* stream, uInt32 length)
+{
+  int available = myPcmRing.getNumAvailable();
+  if(!myIsPrefilled)
+  {
+    if(available < int(myPrefillSamples))
+    {
+      SDL_memset(stream, 0, length * sizeof(Int16));
+      return;
+    }
+    myIsPrefilled = true;
+  }
+
+  // If the device is slower than the player, the ring slowly fills up;
+  // skip ahead to keep the latency at the prefill depth
+  uInt32 frameSamples = myPrerenderFrames != 0 ? myPrefillSamples / myPrerenderFrames : 0;
+  int excess = available - int(length) - int(myPrefillSamples);
+  if(excess > int(frameSamples))
+  {
+    // Whole sample frames only, so channels stay in order
+    excess -= excess % myHardwareSpec.channels;
+    myPcmRing.skip(excess);
+  }
+
+  uInt32 copied = uInt32(myPcmRing.read(stream, int(length)));
+  if(copied < length)
+  {
+    SDL_memset(stream + copied, 0, (length - copied) * sizeof(Int16));
+    ++myTimingStats.ringUnderruns;
+    myIsPrefilled = false;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::startFrame()
+{
+  if(myQueuedFrames == 0)
+  {
+    // Player is late; keep the current registers for this frame
+    ++myTimingStats.starvedFrames;
+  }
+  else
+  {
+    if(myQueuedFrames > myTimingStats.maxQueuedFrames)
+      myTimingStats.maxQueuedFrames = myQueuedFrames;
+    while(myQueuedFrames > myLatencyTarget)
+    {
+      applyQueuedFrame();
+      ++myTimingStats.droppedFrames;
+    }
+    applyQueuedFrame();
+    ++myTimingStats.appliedFrames;
+  }
+  mySamplesLeftInFrame = myFrameClock.nextFrameSamples();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::applyQueuedFrame()
+{
+  while(myRegWriteQueue.size() > 0)
+  {
+    RegWrite& info = myRegWriteQueue.front();
+    bool isFrameEnd = info.addr == FrameEndAddress;
+    if(info.addr == InputMarkAddress)
+      myMarkedInput = Int64(info.delta);
+    else if(!isFrameEnd)
+      myTIASound->set(info.addr, info.value);
+    myRegWriteQueue.dequeue();
+    if(isFrameEnd)
+      break;
+  }
+  --myQueuedFrames;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::measureInput(uInt32 samplesAhead)
+{
+  if(!myIsInitializedFlag)
+  {
+    myMarkedInput = -1;
+    return;
+  }
+  // The fragment being filled starts to play when the device is done
+  // with the one before, which takes about one buffer
+  Int64 now = MonotonicClock::micros();
+  myTimingStats.lastInputMicros = myMarkedInput;
+  myTimingStats.lastAppliedMicros = now;
+  myTimingStats.lastAudibleMicros = now
+      + Int64(samplesAhead + myHardwareSpec.samples) * 1000000 / myHardwareSpec.freq;
+  ++myTimingStats.measuredInputs;
+  myMarkedInput = -1;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void SoundSDL2::callback(void* udata, uInt8* stream, int len)
 {
   SoundSDL2* sound = static_cast<SoundSDL2*>(udata);
+  EventTrace::nameThread("Audio callback");
+  Uint64 start = SDL_GetPerformanceCounter();
+  sound->countUnderruns(uInt32(len) / (2 * sound->myHardwareSpec.channels));
   if(sound->myIsEnabled)
   {
     // The callback is requesting 8-bit (unsigned) data, but the TIA sound
@@ -324,6 +744,35 @@ void SoundSDL2::callback(void* udata, uInt8* stream, int len)
   }
   else
     SDL_memset(stream, 0, len);  // Write 'silence'
+
+  uInt32 micros = uInt32((SDL_GetPerformanceCounter() - start) * 1000000
+      / SDL_GetPerformanceFrequency());
+  if(micros > sound->myTimingStats.maxCallbackMicros)
+    sound->myTimingStats.maxCallbackMicros = micros;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void SoundSDL2::countUnderruns(uInt32 samples)
+{
+  // The device consumes samples at a steady rate, so if it has consumed
+  // more than we delivered plus one fragment of slack, it ran dry
+  Uint64 now = SDL_GetPerformanceCounter();
+  if(myStartCounter != 0)
+  {
+    double consumed = double(now - myStartCounter) * myHardwareSpec.freq
+        / double(SDL_GetPerformanceFrequency());
+    if(consumed > double(myDeliveredSamples + myHardwareSpec.samples))
+    {
+      ++myUnderruns;
+      myStartCounter = 0;
+    }
+  }
+  if(myStartCounter == 0)
+  {
+    myStartCounter = now;
+    myDeliveredSamples = 0;
+  }
+  myDeliveredSamples += samples;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
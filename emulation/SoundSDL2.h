@@ -20,6 +20,9 @@
 #ifndef SOUND_SDL2_HXX
 #define SOUND_SDL2_HXX
 
+#include "frameclock.h"
+#include "pcmring.h"
+
 namespace Emulation {
 
 class OSystem;
@@ -39,11 +42,22 @@ class OSystem;
 class SoundSDL2
 {
   public:
+    // Range of supported buffer sizes in samples
+    static const uInt32 MinBufferSize = 64;
+    static const uInt32 MaxBufferSize = 2048;
+
+    // Milliseconds without underruns before the adaptive mode shrinks
+    // the buffer
+    static const uInt32 AdaptiveInterval = 3000;
+
     /**
       Create a new sound object.  The init method must be invoked before
       using the object.
+
+      @param sampleRate  The sample rate to request from the device
+      @param bufferSize  The buffer size in samples to request
     */
-    SoundSDL2(TIASound *tiasound);
+    SoundSDL2(TIASound *tiasound, Int32 sampleRate = 44100, Int32 bufferSize = 1024);
  
     /**
       Destructor
@@ -135,6 +149,127 @@ class SoundSDL2
     */
     void adjustVolume(Int8 direction);
 
+    /**
+      Enables or disables precise timing.  In precise mode, register writes
+      are grouped into frames by endFrame() and frame n is applied at
+      exactly n * (sample rate / framerate) samples, so the output is the
+      same as when rendering offline.  Otherwise, writes are flushed using
+      the fragment size heuristic.
+
+      @param state  True to enable precise timing
+    */
+    void setPreciseTiming(bool state);
+
+    /**
+      Marks the end of the register writes of one frame.  Only has an
+      effect in precise or pre-rendered mode.
+    */
+    void endFrame();
+
+    /**
+      Enables pre-rendered mode if frames is not 0.  Register writes are
+      then applied directly and endFrame() synthesizes the frame in the
+      calling thread into a lock-free ring, so the callback only copies
+      samples out.  Playback starts when this many frames are in the
+      ring; more frames make dropouts less likely but add latency.
+      Frame boundaries are the same as in precise mode.
+
+      @param frames  Number of frames to render ahead, or 0
+    */
+    void setPrerenderFrames(uInt32 frames);
+
+    /**
+      Sets how many frames may be queued when a frame boundary is reached
+      in precise mode.  Surplus frames are applied at once, so a frame is
+      never played later than this many frames after endFrame().
+
+      @param frames  The maximum latency in frames, at least 1
+    */
+    void setLatencyTarget(uInt32 frames);
+
+    /**
+      Marks the frame currently being written as the response to an
+      input event, e.g. a key press.  When the frame is about to be
+      played, the time since the event gets measured, see TimingStats.
+      Only has an effect in precise or pre-rendered mode.
+
+      @param inputMicros  Time of the event, see MonotonicClock
+    */
+    void markInput(Int64 inputMicros);
+
+    // Timing statistics.  They accumulate across device changes and
+    // resets until resetTimingStats() is called
+    struct TimingStats
+    {
+      uInt32 appliedFrames;
+      // Frames skipped to stay within the latency target, or that did
+      // not fit into the ring in pre-rendered mode
+      uInt32 droppedFrames;
+      // Frame boundaries at which no frame was queued
+      uInt32 starvedFrames;
+      uInt32 maxQueuedFrames;
+      // Callbacks that found too few samples in the ring
+      uInt32 ringUnderruns;
+      // Longest time spent in the callback, in microseconds
+      uInt32 maxCallbackMicros;
+      // Number of marked inputs whose frame has been played.  For the
+      // last one, the time of the input event, of applying or rendering
+      // its frame and the estimated time the first sample of the frame
+      // leaves the device, see MonotonicClock
+      uInt32 measuredInputs;
+      Int64 lastInputMicros;
+      Int64 lastAppliedMicros;
+      Int64 lastAudibleMicros;
+    };
+
+    /**
+      Get the timing statistics of precise and pre-rendered mode.
+    */
+    TimingStats getTimingStats();
+
+    /**
+      Restart the timing statistics and the underrun count from zero.
+      The marked input measurements are kept, so callers comparing
+      measuredInputs do not miss or repeat one.
+    */
+    void resetTimingStats();
+
+    /**
+      Reopens the audio device with a new sample rate and buffer size, if
+      they differ from the current ones.  Playback continues if it was
+      running.
+
+      @param sampleRate  The sample rate to request from the device
+      @param bufferSize  The buffer size in samples, 64 to 2048
+    */
+    void setDevice(Int32 sampleRate, Int32 bufferSize);
+
+    /**
+      Enables or disables the adaptive buffer size.  When enabled,
+      adaptBufferSize() halves the buffer while no underruns occur and
+      goes back up when they do.
+    */
+    void setAdaptiveBufferSize(bool state);
+
+    /**
+      Adjusts the buffer size in adaptive mode.  Must be called regularly
+      from the thread that writes the registers, e.g. once per frame.
+    */
+    void adaptBufferSize();
+
+    /**
+      Sample rate and buffer size the device was opened with, or 0 if
+      there is no device.
+    */
+    Int32 getSampleRate() const;
+    Int32 getBufferSize() const;
+
+    /**
+      Get the number of times the device ran out of samples, over all
+      devices opened.  This is an estimate based on wall-clock time.
+    */
+    uInt32 getUnderruns();
+
   public:
     /**
       Get a descriptor for this console class (used in error checking).
@@ -154,7 +289,57 @@ class SoundSDL2
     */
     void processFragment(Int16* stream, uInt32 length);
 
+    /**
+      Precise mode version of processFragment.
+    */
+    void processFragmentPrecise(Int16* stream, uInt32 length);
+
+    /**
+      Pre-rendered mode version of processFragment.
+    */
+    void processFragmentPrerendered(Int16* stream, uInt32 length);
+
+    /**
+      Applies the writes of the oldest queued frame.
+    */
+    void applyQueuedFrame();
+
+    /**
+      Called at a frame boundary in precise mode.
+    */
+    void startFrame();
+
+    /**
+      Measures the latency of the marked input, whose frame starts the
+      given number of samples after the ones being written now.  The
+      audio device must be locked, or this is called from the callback.
+    */
+    void measureInput(uInt32 samplesAhead);
+
+    /**
+      Resets the state of precise and pre-rendered mode.
+    */
+    void resetPrecise();
+
+    /**
+      Opens and closes the audio device with the requested settings.
+    */
+    void openDevice();
+    void closeDevice();
+
+    /**
+      Called by the callback to detect underruns.
+
+      @param samples  Number of samples requested by the device
+    */
+    void countUnderruns(uInt32 samples);
+
   protected:
+    // Address of the marker separating frames in the queue
+    static const uInt16 FrameEndAddress = 0xffff;
+    // Address of an input marker, whose delta holds the time of the input
+    static const uInt16 InputMarkAddress = 0xfffe;
+
     // Struct to hold information regarding a TIA sound register write
     struct RegWrite
     {
@@ -270,6 +455,65 @@ class SoundSDL2
     // Queue of TIA register writes
     RegWriteQueue myRegWriteQueue;
 
+    // Current display framerate
+    float myFrameRate;
+
+    // Indicates if precise timing is used
+    bool myIsPrecise;
+
+    // Frame boundaries for precise mode
+    FrameClock myFrameClock;
+
+    // Samples left until the next frame boundary
+    uInt32 mySamplesLeftInFrame;
+
+    // Number of complete frames in the queue
+    uInt32 myQueuedFrames;
+
+    // Maximum number of queued frames at a frame boundary
+    uInt32 myLatencyTarget;
+
+    TimingStats myTimingStats;
+
+    // Frames to render ahead, 0 if not in pre-rendered mode
+    uInt32 myPrerenderFrames;
+
+    // Time of the input marked for the frame that gets played or
+    // rendered next, -1 if none
+    Int64 myMarkedInput;
+
+    // Samples rendered ahead by endFrame()
+    PcmRing myPcmRing;
+
+    // Samples (of all channels) in the ring before playback starts
+    uInt32 myPrefillSamples;
+
+    // Indicates if the ring has been filled up since the last underrun
+    bool myIsPrefilled;
+
+    // Buffer to render a frame into
+    std::vector<Int16> myFrameSamples;
+
+    // The opened audio device, 0 if none
+    SDL_AudioDeviceID myDevice;
+
+    // Settings requested for the device
+    Int32 myRequestedSampleRate;
+    Int32 myRequestedBufferSize;
+
+    // Adaptive buffer size state: smallest size left to try, underruns
+    // and ticks at the last adjustment
+    bool myIsAdaptive;
+    uInt32 myAdaptiveFloor;
+    uInt32 myAdaptiveUnderruns;
+    uInt32 myAdaptiveTicks;
+
+    // Underrun detection: samples delivered since the counter value
+    // at which the device was assumed to be in sync
+    uInt32 myUnderruns;
+    Uint64 myDeliveredSamples;
+    Uint64 myStartCounter;
+
   private:
     // Callback function invoked by the SDL Audio library when it needs data
     static void callback(void* udata, uInt8* stream, int len);
@@ -18,6 +18,7 @@
 //============================================================================
 
 #include "TIASnd.h"
+#include "eventtrace.h"
 
 namespace Emulation {
 
@@ -163,6 +164,8 @@ void TIASound::volume(uInt32 percent)
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void TIASound::process(Int16* buffer, uInt32 samples)
 {
+  EventTrace::Scope trace("audio", "TIASound::process");
+
   // Make temporary local copy
   uInt8 audc0 = myAUDC[0], audc1 = myAUDC[1];
   uInt8 p5_0 = myP5[0], p5_1 = myP5[1];
@@ -0,0 +1,943 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "assembler6502.h"
+
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+
+
+namespace Emulation {
+
+namespace {
+
+const int numMnemonics = int(Cpu6502::Mnemonic::Tya) + 1;
+const int numModes = int(Cpu6502::AddressMode::Relative) + 1;
+
+/* Reverse lookup of the CPU opcode table: opcode for mnemonic and
+ * address mode, or -1 if the combination does not exist. */
+struct AssemblerTable {
+    int opcodes[numMnemonics][numModes];
+    QMap<QString, Cpu6502::Mnemonic> mnemonics;
+
+    AssemblerTable() {
+        for (int m = 0; m < numMnemonics; ++m) {
+            for (int mode = 0; mode < numModes; ++mode) {
+                opcodes[m][mode] = -1;
+            }
+        }
+        for (int i = 0; i < 256; ++i) {
+            const Cpu6502::Opcode &op = Cpu6502::getOpcode(i);
+            if (op.mnemonic != Cpu6502::Mnemonic::Illegal) {
+                opcodes[int(op.mnemonic)][int(op.mode)] = i;
+                mnemonics[Cpu6502::getMnemonicName(op.mnemonic)] = op.mnemonic;
+            }
+        }
+    }
+
+    int get(Cpu6502::Mnemonic mnemonic, Cpu6502::AddressMode mode) const {
+        return opcodes[int(mnemonic)][int(mode)];
+    }
+};
+
+const AssemblerTable &assemblerTable() {
+    static const AssemblerTable table;
+    return table;
+}
+
+bool isSymbolChar(QChar c) {
+    return c.isLetterOrNumber() || c == '_' || c == '.';
+}
+
+}
+
+/*************************************************************************/
+
+Assembler6502::Assembler6502() : memory(0x10000, -1)
+{
+}
+
+/*************************************************************************/
+
+void Assembler6502::addFile(const QString &fileName, const QString &contents) {
+    files[fileName] = contents;
+}
+
+/*************************************************************************/
+
+void Assembler6502::setIncludePath(const QString &path) {
+    includePath = path;
+}
+
+/*************************************************************************/
+
+void Assembler6502::defineSymbol(const QString &name, int value) {
+    predefined[name] = value;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::assemble(const QString &mainFileName) {
+    symbols = predefined;
+    errorMessage.clear();
+    for (pass = 1; pass <= maxPasses; ++pass) {
+        isFinalPass = false;
+        if (!doPass(mainFileName)) {
+            return false;
+        }
+        if (!symbolsChanged && !unresolvedUsed) {
+            if (!deferredError.isEmpty()) {
+                errorMessage = deferredError;
+                return false;
+            }
+            return true;
+        }
+        if (!symbolsChanged) {
+            // Nothing will change anymore: Report the undefined symbol
+            break;
+        }
+    }
+    isFinalPass = true;
+    if (doPass(mainFileName)) {
+        errorMessage = "Unable to resolve all symbols after " + QString::number(maxPasses) + " passes";
+    }
+    return false;
+}
+
+/*************************************************************************/
+
+QString Assembler6502::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+int Assembler6502::getOrigin() const {
+    return lowestAddress;
+}
+
+/*************************************************************************/
+
+QByteArray Assembler6502::getImage() const {
+    QByteArray image;
+    for (int address = lowestAddress; address <= highestAddress; ++address) {
+        image.append(char(memory[address] == -1 ? 0 : memory[address]));
+    }
+    return image;
+}
+
+/*************************************************************************/
+
+int Assembler6502::getSymbol(const QString &name) const {
+    return symbols.value(name, -1);
+}
+
+/*************************************************************************/
+
+QMap<QString, int> Assembler6502::getSymbols() const {
+    QMap<QString, int> globals;
+    for (auto it = symbols.constBegin(); it != symbols.constEnd(); ++it) {
+        if (!it.key().contains('.')) {
+            globals[it.key()] = it.value();
+        }
+    }
+    return globals;
+}
+
+/*************************************************************************/
+
+QStringList Assembler6502::getEchoOutput() const {
+    return echoOutput;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::doPass(const QString &mainFileName) {
+    pc = 0;
+    segmentUninitialized = false;
+    currentSegment = "";
+    segmentPcs.clear();
+    localScope = 0;
+    nextLocalScope = 1;
+    conditionals.clear();
+    macros.clear();
+    pCurrentMacro = nullptr;
+    macroDepth = 0;
+    memory.fill(-1);
+    lowestAddress = 0x10000;
+    highestAddress = -1;
+    echoOutput.clear();
+    definedInPass.clear();
+    deferredError.clear();
+    symbolsChanged = false;
+    unresolvedUsed = false;
+
+    if (!processFile(mainFileName)) {
+        return false;
+    }
+    if (pCurrentMacro != nullptr) {
+        return error("MAC without ENDM");
+    }
+    if (!conditionals.isEmpty()) {
+        return error("IF without ENDIF");
+    }
+    if (highestAddress == -1) {
+        lowestAddress = 0;
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::readFile(const QString &fileName, QString *pContents) {
+    if (files.contains(fileName)) {
+        *pContents = files[fileName];
+        return true;
+    }
+    QString path = QDir::isAbsolutePath(fileName) ? fileName : QDir(includePath).filePath(fileName);
+    QFile fileIn(path);
+    if (!fileIn.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QTextStream inStream(&fileIn);
+    *pContents = inStream.readAll();
+    fileIn.close();
+    return true;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::processFile(const QString &fileName) {
+    QString contents;
+    if (!readFile(fileName, &contents)) {
+        return error("Unable to open file " + fileName);
+    }
+    QString parentFile = currentFile;
+    int parentLine = currentLine;
+    QStringList lines = contents.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        if (lines[i].endsWith('\r')) {
+            lines[i].chop(1);
+        }
+    }
+    bool result = processLines(lines, fileName, 1);
+    currentFile = parentFile;
+    currentLine = parentLine;
+    return result;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::processLines(const QStringList &lines, const QString &fileName, int firstLine) {
+    for (int i = 0; i < lines.size(); ++i) {
+        currentFile = fileName;
+        currentLine = firstLine + i;
+        if (!processLine(lines[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+QString Assembler6502::stripComment(const QString &line) {
+    bool inString = false;
+    for (int i = 0; i < line.size(); ++i) {
+        QChar c = line[i];
+        if (c == '"') {
+            inString = !inString;
+        } else if (c == '\'' && !inString) {
+            // Character constant: skip the character
+            i++;
+        } else if (c == ';' && !inString) {
+            return line.left(i);
+        }
+    }
+    return line;
+}
+
+/*************************************************************************/
+
+QStringList Assembler6502::splitArguments(const QString &operand) {
+    QStringList arguments;
+    int depth = 0;
+    bool inString = false;
+    int start = 0;
+    for (int i = 0; i < operand.size(); ++i) {
+        QChar c = operand[i];
+        if (c == '"') {
+            inString = !inString;
+        } else if (!inString) {
+            if (c == '(' || c == '[') {
+                depth++;
+            } else if (c == ')' || c == ']') {
+                depth--;
+            } else if (c == ',' && depth == 0) {
+                arguments.append(operand.mid(start, i - start).trimmed());
+                start = i + 1;
+            }
+        }
+    }
+    QString last = operand.mid(start).trimmed();
+    if (!last.isEmpty() || !arguments.isEmpty()) {
+        arguments.append(last);
+    }
+    return arguments;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::isActive() const {
+    return conditionals.isEmpty() || conditionals.last().active;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::error(const QString &message) {
+    if (errorMessage.isEmpty()) {
+        errorMessage = currentFile + ":" + QString::number(currentLine) + ": " + message;
+    }
+    return false;
+}
+
+/*************************************************************************/
+
+void Assembler6502::deferError(const QString &message) {
+    if (deferredError.isEmpty()) {
+        deferredError = currentFile + ":" + QString::number(currentLine) + ": " + message;
+    }
+}
+
+/*************************************************************************/
+
+QString Assembler6502::qualifiedName(const QString &name) const {
+    if (name.startsWith('.')) {
+        return QString::number(localScope) + name;
+    }
+    return name;
+}
+
+/*************************************************************************/
+
+void Assembler6502::defineLabel(const QString &name, int value) {
+    QString fullName = qualifiedName(name);
+    if (!symbols.contains(fullName) || symbols[fullName] != value) {
+        symbolsChanged = true;
+    }
+    symbols[fullName] = value;
+}
+
+/*************************************************************************/
+
+void Assembler6502::emitByte(int value) {
+    if (!segmentUninitialized && pc <= 0xffff) {
+        memory[pc] = value&0xff;
+        lowestAddress = qMin(lowestAddress, pc);
+        highestAddress = qMax(highestAddress, pc);
+    }
+    pc++;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::processLine(const QString &line) {
+    QString text = stripComment(line);
+
+    // Split into label, operation and operand fields
+    QString label;
+    int pos = 0;
+    if (!text.isEmpty() && !text[0].isSpace()) {
+        while (pos < text.size() && !text[pos].isSpace()) {
+            pos++;
+        }
+        label = text.left(pos);
+        if (label.endsWith(':')) {
+            label.chop(1);
+        }
+    }
+    QString rest = text.mid(pos).trimmed();
+    int opEnd = 0;
+    while (opEnd < rest.size() && !rest[opEnd].isSpace()) {
+        opEnd++;
+    }
+    QString op = rest.left(opEnd).toLower();
+    QString operand = rest.mid(opEnd).trimmed();
+
+    // Record macro body
+    if (pCurrentMacro != nullptr) {
+        if (op == "endm") {
+            pCurrentMacro = nullptr;
+        } else {
+            pCurrentMacro->lines.append(line);
+        }
+        return true;
+    }
+
+    // Conditional assembly is evaluated even in inactive blocks
+    if (op == "if" || op == "ifconst" || op == "ifnconst") {
+        Conditional c;
+        c.parentActive = isActive();
+        c.active = false;
+        if (c.parentActive) {
+            if (op == "if") {
+                int value;
+                bool resolved;
+                if (!evaluate(operand, &value, &resolved)) {
+                    return false;
+                }
+                c.active = resolved && value != 0;
+            } else {
+                bool defined = symbols.contains(qualifiedName(operand));
+                c.active = (op == "ifconst") == defined;
+            }
+        }
+        c.taken = c.active;
+        conditionals.append(c);
+        return true;
+    }
+    if (op == "else") {
+        if (conditionals.isEmpty()) {
+            return error("ELSE without IF");
+        }
+        Conditional &c = conditionals.last();
+        c.active = c.parentActive && !c.taken;
+        c.taken = true;
+        return true;
+    }
+    if (op == "endif" || op == "eif") {
+        if (conditionals.isEmpty()) {
+            return error("ENDIF without IF");
+        }
+        conditionals.removeLast();
+        return true;
+    }
+    if (!isActive()) {
+        return true;
+    }
+
+    // Equates
+    if (op == "=" || op == "equ" || op == "set") {
+        if (label.isEmpty()) {
+            return error("Equate without a label");
+        }
+        int value;
+        bool resolved;
+        if (!evaluate(operand, &value, &resolved)) {
+            return false;
+        }
+        if (resolved) {
+            defineLabel(label, value);
+        }
+        return true;
+    }
+
+    if (op == "mac" || op == "macro") {
+        if (operand.isEmpty()) {
+            return error("Macro without a name");
+        }
+        Macro macro;
+        macro.fileName = currentFile;
+        macro.firstLine = currentLine + 1;
+        macros[operand] = macro;
+        pCurrentMacro = &(macros[operand]);
+        return true;
+    }
+
+    if (op == "subroutine") {
+        if (!label.isEmpty()) {
+            defineLabel(label, pc);
+        }
+        localScope = nextLocalScope++;
+        return true;
+    }
+
+    if (!label.isEmpty()) {
+        QString fullName = qualifiedName(label);
+        if (definedInPass.contains(fullName)) {
+            return error("Label " + label + " defined twice");
+        }
+        definedInPass.insert(fullName);
+        defineLabel(label, pc);
+    }
+    if (op.isEmpty()) {
+        return true;
+    }
+
+    if (op == "processor") {
+        if (operand != "6502") {
+            return error("Unsupported processor " + operand);
+        }
+        return true;
+    }
+    if (op == "include") {
+        QString fileName = operand;
+        if (fileName.startsWith('"') && fileName.endsWith('"') && fileName.size() >= 2) {
+            fileName = fileName.mid(1, fileName.size() - 2);
+        }
+        return processFile(fileName);
+    }
+    if (op == "seg" || op == "seg.u") {
+        segmentPcs[currentSegment] = pc;
+        currentSegment = operand;
+        pc = segmentPcs.value(currentSegment, pc);
+        segmentUninitialized = (op == "seg.u");
+        return true;
+    }
+
+    QStringList arguments = splitArguments(operand);
+    if (op == "org" || op == "align" || op == "ds" || op == "ds.b" || op == "ds.w") {
+        if (arguments.isEmpty()) {
+            return error("Missing argument for " + op);
+        }
+        int value;
+        bool resolved;
+        if (!evaluate(arguments[0], &value, &resolved)) {
+            return false;
+        }
+        int fill = 0;
+        if (arguments.size() > 1) {
+            bool fillResolved;
+            if (!evaluate(arguments[1], &fill, &fillResolved)) {
+                return false;
+            }
+        }
+        if (op == "org") {
+            pc = value;
+            return true;
+        }
+        int count = value;
+        if (op == "align") {
+            count = value <= 0 ? 0 : (value - pc%value)%value;
+        } else if (op == "ds.w") {
+            count *= 2;
+        }
+        for (int i = 0; i < count; ++i) {
+            emitByte(fill);
+        }
+        return true;
+    }
+    if (op == "dc" || op == "dc.b" || op == ".byte" || op == "byte"
+            || op == "dc.w" || op == ".word" || op == "word") {
+        bool isWord = op.endsWith("w") || op.endsWith("word");
+        for (int i = 0; i < arguments.size(); ++i) {
+            if (arguments[i].startsWith('"') && arguments[i].endsWith('"') && !isWord) {
+                for (int c = 1; c < arguments[i].size() - 1; ++c) {
+                    emitByte(arguments[i][c].toLatin1());
+                }
+                continue;
+            }
+            int value;
+            bool resolved;
+            if (!evaluate(arguments[i], &value, &resolved)) {
+                return false;
+            }
+            emitByte(value);
+            if (isWord) {
+                emitByte(value>>8);
+            }
+        }
+        return true;
+    }
+    if (op == "echo") {
+        QString message;
+        for (int i = 0; i < arguments.size(); ++i) {
+            if (arguments[i].startsWith('"') && arguments[i].endsWith('"')) {
+                message.append(arguments[i].mid(1, arguments[i].size() - 2));
+            } else {
+                int value;
+                bool resolved;
+                if (!evaluate(arguments[i], &value, &resolved)) {
+                    return false;
+                }
+                message.append(QString("$%1").arg(value, 0, 16));
+            }
+        }
+        echoOutput.append(message);
+        return true;
+    }
+    if (op == "err") {
+        return error("ERR directive");
+    }
+    if (op == "endm") {
+        return error("ENDM without MAC");
+    }
+
+    // Instruction?
+    const AssemblerTable &table = assemblerTable();
+    if (table.mnemonics.contains(op)) {
+        return processInstruction(table.mnemonics[op], operand);
+    }
+
+    // Macro invocation?
+    for (auto it = macros.constBegin(); it != macros.constEnd(); ++it) {
+        if (it.key().toLower() == op) {
+            return invokeMacro(it.value(), operand);
+        }
+    }
+
+    return error("Unknown mnemonic or directive: " + op);
+}
+
+/*************************************************************************/
+
+bool Assembler6502::invokeMacro(const Macro &macro, const QString &arguments) {
+    if (macroDepth >= maxMacroDepth) {
+        return error("Macros nested too deeply");
+    }
+    QStringList args = splitArguments(arguments);
+    QStringList expanded = macro.lines;
+    for (int i = 0; i < expanded.size(); ++i) {
+        for (int a = 0; a < args.size(); ++a) {
+            expanded[i].replace("{" + QString::number(a + 1) + "}", args[a]);
+        }
+    }
+    // Each invocation gets its own scope for local labels
+    int parentScope = localScope;
+    localScope = nextLocalScope++;
+    macroDepth++;
+    QString parentFile = currentFile;
+    int parentLine = currentLine;
+    bool result = processLines(expanded, macro.fileName, macro.firstLine);
+    currentFile = parentFile;
+    currentLine = parentLine;
+    macroDepth--;
+    localScope = parentScope;
+    return result;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::processInstruction(Cpu6502::Mnemonic mnemonic, const QString &operand) {
+    typedef Cpu6502::AddressMode A;
+    const AssemblerTable &table = assemblerTable();
+    QString lower = operand.toLower();
+    QString compact = lower;
+    compact.remove(' ');
+
+    A mode;
+    QString expression;
+    if (operand.isEmpty()) {
+        mode = table.get(mnemonic, A::Implied) != -1 ? A::Implied : A::Accumulator;
+    } else if (lower == "a") {
+        mode = A::Accumulator;
+    } else if (operand.startsWith('#')) {
+        mode = A::Immediate;
+        expression = operand.mid(1);
+    } else if (table.get(mnemonic, A::Relative) != -1) {
+        mode = A::Relative;
+        expression = operand;
+    } else if (operand.startsWith('(') && compact.endsWith("),y")) {
+        mode = A::IndirectY;
+        expression = operand.mid(1, operand.lastIndexOf(')') - 1);
+    } else if (operand.startsWith('(') && compact.endsWith(",x)")) {
+        mode = A::IndirectX;
+        expression = operand.mid(1, operand.lastIndexOf(',') - 1);
+    } else if (operand.startsWith('(') && operand.endsWith(')')
+               && table.get(mnemonic, A::Indirect) != -1) {
+        mode = A::Indirect;
+        expression = operand.mid(1, operand.size() - 2);
+    } else {
+        // Absolute or zero page, maybe indexed
+        QStringList parts = splitArguments(operand);
+        A zpMode = A::ZeroPage;
+        A absMode = A::Absolute;
+        if (parts.size() == 2 && parts[1].toLower() == "x") {
+            zpMode = A::ZeroPageX;
+            absMode = A::AbsoluteX;
+        } else if (parts.size() == 2 && parts[1].toLower() == "y") {
+            zpMode = A::ZeroPageY;
+            absMode = A::AbsoluteY;
+        } else if (parts.size() != 1) {
+            return error("Invalid operand: " + operand);
+        }
+        int value;
+        bool resolved;
+        if (!evaluate(parts[0], &value, &resolved)) {
+            return false;
+        }
+        bool fitsZp = resolved && value >= 0 && value < 256;
+        if (table.get(mnemonic, zpMode) != -1
+                && (fitsZp || table.get(mnemonic, absMode) == -1)) {
+            mode = zpMode;
+        } else {
+            mode = absMode;
+        }
+        expression = parts[0];
+    }
+
+    int opcode = table.get(mnemonic, mode);
+    if (opcode == -1) {
+        return error("Invalid address mode for " + QString(Cpu6502::getMnemonicName(mnemonic)));
+    }
+    int value = 0;
+    bool resolved = true;
+    if (!expression.isEmpty() && !evaluate(expression, &value, &resolved)) {
+        return false;
+    }
+
+    int instructionAddress = pc;
+    emitByte(opcode);
+    switch (Cpu6502::getOperandSize(mode)) {
+    case 1:
+        if (mode == A::Relative) {
+            int offset = value - (instructionAddress + 2);
+            if (resolved && (offset < -128 || offset > 127)) {
+                deferError("Branch out of range");
+            }
+            value = offset;
+        } else if (resolved && (value < -128 || value > 255)) {
+            deferError("Value out of range: " + expression);
+        }
+        emitByte(value);
+        break;
+    case 2:
+        emitByte(value);
+        emitByte(value>>8);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+bool Assembler6502::evaluate(const QString &expression, int *pValue, bool *pResolved) {
+    expr = expression;
+    exprPos = 0;
+    exprResolved = true;
+    if (!parseBinary(0, pValue)) {
+        return false;
+    }
+    skipSpaces();
+    if (exprPos != expr.size()) {
+        return error("Syntax error in expression: " + expression);
+    }
+    *pResolved = exprResolved;
+    if (!exprResolved) {
+        *pValue = 0;
+        unresolvedUsed = true;
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+void Assembler6502::skipSpaces() {
+    while (exprPos < expr.size() && expr[exprPos].isSpace()) {
+        exprPos++;
+    }
+}
+
+/*************************************************************************/
+
+bool Assembler6502::parseBinary(int level, int *pValue) {
+    static const int maxLevel = 10;
+    if (level == maxLevel) {
+        return parseUnary(pValue);
+    }
+    if (!parseBinary(level + 1, pValue)) {
+        return false;
+    }
+    while (true) {
+        skipSpaces();
+        QStringRef rest = expr.midRef(exprPos);
+        QString op;
+        switch (level) {
+        case 0:
+            if (rest.startsWith("||")) op = "||";
+            break;
+        case 1:
+            if (rest.startsWith("&&")) op = "&&";
+            break;
+        case 2:
+            if (rest.startsWith("|") && !rest.startsWith("||")) op = "|";
+            break;
+        case 3:
+            if (rest.startsWith("^")) op = "^";
+            break;
+        case 4:
+            if (rest.startsWith("&") && !rest.startsWith("&&")) op = "&";
+            break;
+        case 5:
+            if (rest.startsWith("==")) op = "==";
+            else if (rest.startsWith("!=")) op = "!=";
+            else if (rest.startsWith("=")) op = "=";
+            break;
+        case 6:
+            if (rest.startsWith("<=")) op = "<=";
+            else if (rest.startsWith(">=")) op = ">=";
+            else if (rest.startsWith("<") && !rest.startsWith("<<")) op = "<";
+            else if (rest.startsWith(">") && !rest.startsWith(">>")) op = ">";
+            break;
+        case 7:
+            if (rest.startsWith("<<")) op = "<<";
+            else if (rest.startsWith(">>")) op = ">>";
+            break;
+        case 8:
+            if (rest.startsWith("+")) op = "+";
+            else if (rest.startsWith("-")) op = "-";
+            break;
+        case 9:
+            if (rest.startsWith("*")) op = "*";
+            else if (rest.startsWith("/")) op = "/";
+            else if (rest.startsWith("%")) op = "%";
+            break;
+        }
+        if (op.isEmpty()) {
+            return true;
+        }
+        exprPos += op.size();
+        int right;
+        if (!parseBinary(level + 1, &right)) {
+            return false;
+        }
+        int left = *pValue;
+        if (op == "||") *pValue = (left != 0 || right != 0) ? 1 : 0;
+        else if (op == "&&") *pValue = (left != 0 && right != 0) ? 1 : 0;
+        else if (op == "|") *pValue = left | right;
+        else if (op == "^") *pValue = left ^ right;
+        else if (op == "&") *pValue = left & right;
+        else if (op == "==" || op == "=") *pValue = left == right ? 1 : 0;
+        else if (op == "!=") *pValue = left != right ? 1 : 0;
+        else if (op == "<=") *pValue = left <= right ? 1 : 0;
+        else if (op == ">=") *pValue = left >= right ? 1 : 0;
+        else if (op == "<") *pValue = left < right ? 1 : 0;
+        else if (op == ">") *pValue = left > right ? 1 : 0;
+        else if (op == "<<") *pValue = left << right;
+        else if (op == ">>") *pValue = left >> right;
+        else if (op == "+") *pValue = left + right;
+        else if (op == "-") *pValue = left - right;
+        else if (op == "*") *pValue = left * right;
+        else if (right == 0) {
+            // Division by zero with unresolved symbols is expected in early passes
+            if (exprResolved) {
+                return error("Division by zero");
+            }
+            *pValue = 0;
+        } else if (op == "/") *pValue = left / right;
+        else *pValue = left % right;
+    }
+}
+
+/*************************************************************************/
+
+bool Assembler6502::parseUnary(int *pValue) {
+    skipSpaces();
+    if (exprPos >= expr.size()) {
+        return error("Unexpected end of expression: " + expr);
+    }
+    QChar c = expr[exprPos];
+    if (c == '-' || c == '~' || c == '!' || c == '<' || c == '>') {
+        exprPos++;
+        if (!parseUnary(pValue)) {
+            return false;
+        }
+        switch (c.toLatin1()) {
+        case '-': *pValue = -*pValue; break;
+        case '~': *pValue = ~*pValue; break;
+        case '!': *pValue = *pValue == 0 ? 1 : 0; break;
+        case '<': *pValue = *pValue&0xff; break;
+        case '>': *pValue = (*pValue>>8)&0xff; break;
+        }
+        return true;
+    }
+    return parsePrimary(pValue);
+}
+
+/*************************************************************************/
+
+bool Assembler6502::parsePrimary(int *pValue) {
+    skipSpaces();
+    if (exprPos >= expr.size()) {
+        return error("Unexpected end of expression: " + expr);
+    }
+    QChar c = expr[exprPos];
+
+    // Grouping
+    if (c == '(' || c == '[') {
+        QChar closing = c == '(' ? ')' : ']';
+        exprPos++;
+        if (!parseBinary(0, pValue)) {
+            return false;
+        }
+        skipSpaces();
+        if (exprPos >= expr.size() || expr[exprPos] != closing) {
+            return error("Missing " + QString(closing) + " in expression: " + expr);
+        }
+        exprPos++;
+        return true;
+    }
+
+    // Numbers
+    int base = 10;
+    if (c == '$') {
+        base = 16;
+        exprPos++;
+    } else if (c == '%') {
+        base = 2;
+        exprPos++;
+    }
+    if (base != 10 || c.isDigit()) {
+        int start = exprPos;
+        while (exprPos < expr.size() && expr[exprPos].isLetterOrNumber()) {
+            exprPos++;
+        }
+        bool ok;
+        *pValue = expr.mid(start, exprPos - start).toInt(&ok, base);
+        if (!ok) {
+            return error("Invalid number in expression: " + expr);
+        }
+        return true;
+    }
+
+    // Character constant
+    if (c == '\'') {
+        if (exprPos + 1 >= expr.size()) {
+            return error("Invalid character constant: " + expr);
+        }
+        *pValue = expr[exprPos + 1].toLatin1();
+        exprPos += 2;
+        if (exprPos < expr.size() && expr[exprPos] == '\'') {
+            exprPos++;
+        }
+        return true;
+    }
+
+    // Current address
+    if (c == '*') {
+        exprPos++;
+        *pValue = pc;
+        return true;
+    }
+
+    // Symbol
+    if (isSymbolChar(c)) {
+        int start = exprPos;
+        while (exprPos < expr.size() && isSymbolChar(expr[exprPos])) {
+            exprPos++;
+        }
+        QString name = expr.mid(start, exprPos - start);
+        QString fullName = qualifiedName(name);
+        if (symbols.contains(fullName)) {
+            *pValue = symbols[fullName];
+        } else {
+            if (isFinalPass) {
+                return error("Undefined symbol: " + name);
+            }
+            exprResolved = false;
+            *pValue = 0;
+        }
+        return true;
+    }
+
+    return error("Syntax error in expression: " + expr);
+}
+
+}
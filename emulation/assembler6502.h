@@ -0,0 +1,154 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef ASSEMBLER6502_H
+#define ASSEMBLER6502_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QMap>
+#include <QList>
+#include <QSet>
+#include <QVector>
+
+#include "cpu6502.h"
+
+
+namespace Emulation {
+
+/* Minimal multi-pass assembler for the subset of dasm syntax used by
+ * the TIATracker player templates:
+ * - labels in column 0 (optional ":"), local ".labels" scoped by
+ *   SUBROUTINE and by macro invocations
+ * - "=" / EQU, ORG, SEG, SEG.U, DS, DC.B/DC.W/.BYTE/.WORD, INCLUDE,
+ *   ECHO, PROCESSOR, IF/IFCONST/IFNCONST/ELSE/ENDIF, MAC/ENDM
+ * - expressions with $hex, %binary, decimal and 'c' values, * as the
+ *   current address, unary <, >, -, ~, !, C-style binary operators and
+ *   [] or () for grouping
+ * Included files are looked up in the in-memory file list first and
+ * then on disk, relative to the include path.
+ */
+class Assembler6502
+{
+public:
+    Assembler6502();
+
+    /* Provides the contents of a file for INCLUDE without disk access */
+    void addFile(const QString &fileName, const QString &contents);
+    void setIncludePath(const QString &path);
+
+    /* Pre-defines a symbol before assembly, e.g. a variant flag */
+    void defineSymbol(const QString &name, int value);
+
+    /* Assembles the given main file. Returns false on error. */
+    bool assemble(const QString &mainFileName);
+
+    QString getErrorMessage() const;
+
+    /* Lowest address written to in an initialized segment and the
+     * contiguous image from there up to the highest written address */
+    int getOrigin() const;
+    QByteArray getImage() const;
+
+    /* Value of a global symbol, or -1 if it is not defined */
+    int getSymbol(const QString &name) const;
+    QMap<QString, int> getSymbols() const;
+
+    /* Output of ECHO directives of the final pass */
+    QStringList getEchoOutput() const;
+
+private:
+    static const int maxPasses = 10;
+    static const int maxMacroDepth = 16;
+
+    struct Macro {
+        QStringList lines;
+        QString fileName;
+        int firstLine;
+    };
+
+    struct Conditional {
+        // Is the current branch assembled?
+        bool active;
+        // Has any branch of this IF been taken?
+        bool taken;
+        // Was the enclosing block active?
+        bool parentActive;
+    };
+
+    bool doPass(const QString &mainFileName);
+    bool processFile(const QString &fileName);
+    bool processLines(const QStringList &lines, const QString &fileName, int firstLine);
+    bool processLine(const QString &line);
+    bool processInstruction(Cpu6502::Mnemonic mnemonic, const QString &operand);
+    bool invokeMacro(const Macro &macro, const QString &arguments);
+
+    bool readFile(const QString &fileName, QString *pContents);
+    void defineLabel(const QString &name, int value);
+    QString qualifiedName(const QString &name) const;
+    void emitByte(int value);
+    bool isActive() const;
+    bool error(const QString &message);
+    void deferError(const QString &message);
+
+    static QStringList splitArguments(const QString &operand);
+    static QString stripComment(const QString &line);
+
+    /* Expression evaluation. Sets *pResolved to false if an undefined
+     * symbol was used (which is legal in all but the final pass). */
+    bool evaluate(const QString &expression, int *pValue, bool *pResolved);
+    bool parseBinary(int level, int *pValue);
+    bool parseUnary(int *pValue);
+    bool parsePrimary(int *pValue);
+    void skipSpaces();
+
+    QMap<QString, QString> files;
+    QString includePath;
+    QMap<QString, int> predefined;
+
+    // Symbols persist over passes
+    QMap<QString, int> symbols;
+    QMap<QString, Macro> macros;
+
+    QList<Conditional> conditionals;
+    Macro *pCurrentMacro = nullptr;
+    int macroDepth = 0;
+
+    int pass = 0;
+    bool isFinalPass = false;
+    bool symbolsChanged = false;
+    bool unresolvedUsed = false;
+    int pc = 0;
+    bool segmentUninitialized = false;
+    QString currentSegment;
+    QMap<QString, int> segmentPcs;
+    int localScope = 0;
+    int nextLocalScope = 0;
+
+    // Output memory, -1 for unused
+    QVector<int> memory;
+    int lowestAddress = 0;
+    int highestAddress = -1;
+    QStringList echoOutput;
+    QSet<QString> definedInPass;
+
+    QString currentFile;
+    int currentLine = 0;
+    QString errorMessage;
+    // Range errors are only reported once all symbols are stable
+    QString deferredError;
+
+    // Expression parser state
+    QString expr;
+    int exprPos = 0;
+    bool exprResolved = true;
+};
+
+}
+
+#endif // ASSEMBLER6502_H
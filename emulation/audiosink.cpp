@@ -0,0 +1,80 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "audiosink.h"
+
+
+namespace Emulation {
+
+void AudioSink::configureDevice(int, int, bool, int) {
+}
+
+/*************************************************************************/
+
+void AudioSink::update() {
+}
+
+/*************************************************************************/
+
+void AudioSink::markInput(qint64) {
+}
+
+/*************************************************************************/
+
+bool AudioSink::takeInputTiming(InputTiming *) {
+    return false;
+}
+
+/*************************************************************************/
+
+AudioSink::Status AudioSink::getStatus() {
+    return {0, 0, 0, 0, 0};
+}
+
+/*************************************************************************/
+
+void AudioSink::resetStatus() {
+}
+
+/*************************************************************************/
+
+RenderingSink::RenderingSink(int sampleRate) :
+    sampleRate(sampleRate),
+    frameClock(sampleRate, 50.0)
+{
+    tiaSound.outputFrequency(sampleRate);
+    tiaSound.channels(1, false);
+}
+
+/*************************************************************************/
+
+void RenderingSink::set(uInt16 address, uInt8 value) {
+    tiaSound.set(address, value);
+}
+
+/*************************************************************************/
+
+void RenderingSink::endFrame() {
+    int count = frameClock.nextFrameSamples();
+    frameBuffer.resize(count);
+    tiaSound.process(frameBuffer.data(), uInt32(count));
+    writeSamples(frameBuffer.constData(), count);
+}
+
+/*************************************************************************/
+
+void RenderingSink::setFrameRate(float rate) {
+    frameClock.setRates(sampleRate, rate);
+}
+
+/*************************************************************************/
+
+int RenderingSink::getSampleRate() const {
+    return sampleRate;
+}
+
+}
@@ -0,0 +1,120 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef AUDIOSINK_H
+#define AUDIOSINK_H
+
+#include <QVector>
+
+#include "TIASnd.h"
+#include "frameclock.h"
+
+
+namespace Emulation {
+
+/* Receives the TIA register writes of the Player, frame by frame. Sinks
+ * decide what to do with them: play them on a sound device, render them
+ * to a file or memory, or nothing at all.
+ */
+class AudioSink
+{
+public:
+    struct Status {
+        // 0 if there is no device
+        int sampleRate;
+        int bufferSize;
+        int underruns;
+        // Frames that arrived too late to be played in time
+        int lateFrames;
+        // Worst case time spent in the audio callback
+        int maxCallbackMicros;
+    };
+
+    /* Time stamps of a marked input, see MonotonicClock */
+    struct InputTiming {
+        qint64 inputMicros;
+        // Frame applied in the audio callback or rendered ahead
+        qint64 appliedMicros;
+        // Estimated time its first sample leaves the device
+        qint64 audibleMicros;
+    };
+
+    virtual ~AudioSink() {}
+
+    /* Sets a TIA sound register for the current frame */
+    virtual void set(uInt16 address, uInt8 value) = 0;
+
+    /* Marks the end of the register writes of a frame */
+    virtual void endFrame() = 0;
+
+    virtual void setFrameRate(float rate) = 0;
+
+    /* Sinks with a sound device can change its settings. With
+     * prerenderFrames not 0, frames get synthesized that many frames
+     * ahead in the player thread. The default does nothing. */
+    virtual void configureDevice(int sampleRate, int bufferSize, bool adaptive, int prerenderFrames);
+
+    /* Called regularly from the player thread for housekeeping */
+    virtual void update();
+
+    /* Marks the frame being written as the response to an input event
+     * at inputMicros, see MonotonicClock. Sinks with a sound device
+     * measure when the frame starts to play. The default does nothing. */
+    virtual void markInput(qint64 inputMicros);
+
+    /* Gets the timing of the last marked input whose frame has been
+     * played. Returns false if there was none since the last call. */
+    virtual bool takeInputTiming(InputTiming *pTiming);
+
+    /* Counters of the status accumulate until resetStatus(), also
+     * across device changes */
+    virtual Status getStatus();
+    virtual void resetStatus();
+};
+
+/*************************************************************************/
+
+/* Discards everything, so the player runs as fast as it can */
+class NullSink : public AudioSink
+{
+public:
+    void set(uInt16, uInt8) override {}
+    void endFrame() override {}
+    void setFrameRate(float) override {}
+};
+
+/*************************************************************************/
+
+/* Base class for sinks that render frames to mono samples. Frames are
+ * split into samples by a FrameClock, so the output is exactly the
+ * same as with SoundSDL2 in precise mode.
+ */
+class RenderingSink : public AudioSink
+{
+public:
+    explicit RenderingSink(int sampleRate = 44100);
+
+    void set(uInt16 address, uInt8 value) override;
+    void endFrame() override;
+    void setFrameRate(float rate) override;
+
+    int getSampleRate() const;
+
+protected:
+    /* Receives the samples of one frame */
+    virtual void writeSamples(const Int16 *samples, int count) = 0;
+
+private:
+    int sampleRate;
+    TIASound tiaSound;
+    FrameClock frameClock;
+    QVector<Int16> frameBuffer;
+};
+
+}
+
+#endif // AUDIOSINK_H
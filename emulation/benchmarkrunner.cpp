@@ -0,0 +1,169 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "benchmarkrunner.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <algorithm>
+
+
+namespace Emulation {
+
+constexpr double BenchmarkRunner::RegressionThreshold;
+
+/*************************************************************************/
+
+double BenchmarkRunner::Result::getItemsPerSecond() const {
+    return nanosPerIteration > 0.0 ? itemsPerIteration*1e9/nanosPerIteration : 0.0;
+}
+
+/*************************************************************************/
+
+void BenchmarkRunner::run(const QString &name, const std::function<void()> &body,
+                          qint64 itemsPerIteration, const QString &itemName) {
+    // The warm-up also tells how many iterations fill a batch
+    QElapsedTimer timer;
+    timer.start();
+    body();
+    qint64 warmUpNanos = qMax(qint64(1), timer.nsecsElapsed());
+    qint64 iterations = qMax(qint64(1), qint64(BatchMillis)*1000000/warmUpNanos);
+
+    double bestNanos = 0.0;
+    for (int batch = 0; batch < NumBatches; ++batch) {
+        timer.restart();
+        for (qint64 i = 0; i < iterations; ++i) {
+            body();
+        }
+        double nanos = double(timer.nsecsElapsed())/iterations;
+        if (batch == 0 || nanos < bestNanos) {
+            bestNanos = nanos;
+        }
+    }
+    results.append({name, iterations, bestNanos, itemsPerIteration, itemName});
+}
+
+/*************************************************************************/
+
+void BenchmarkRunner::skip(const QString &name, const QString &reason) {
+    skipped.append(name + ": " + reason);
+}
+
+/*************************************************************************/
+
+QList<BenchmarkRunner::Result> BenchmarkRunner::getResults() const {
+    return results;
+}
+
+/*************************************************************************/
+
+QStringList BenchmarkRunner::getSkipped() const {
+    return skipped;
+}
+
+/*************************************************************************/
+
+bool BenchmarkRunner::save(const QString &fileName) const {
+    QDir().mkpath(QFileInfo(fileName).path());
+    QFile saveFile(fileName);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    saveFile.write(toJson());
+    return true;
+}
+
+/*************************************************************************/
+
+QByteArray BenchmarkRunner::toJson() const {
+    QJsonArray resultArray;
+    for (const Result &result : results) {
+        QJsonObject resultObject;
+        resultObject["name"] = result.name;
+        resultObject["iterations"] = double(result.iterations);
+        resultObject["nanosPerIteration"] = result.nanosPerIteration;
+        resultObject["itemsPerIteration"] = double(result.itemsPerIteration);
+        resultObject["itemName"] = result.itemName;
+        resultObject["itemsPerSecond"] = result.getItemsPerSecond();
+        resultArray.append(resultObject);
+    }
+    QJsonArray skippedArray;
+    for (const QString &reason : skipped) {
+        skippedArray.append(reason);
+    }
+    QJsonObject json;
+    json["version"] = Version;
+    json["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    json["results"] = resultArray;
+    json["skipped"] = skippedArray;
+    return QJsonDocument(json).toJson();
+}
+
+/*************************************************************************/
+
+bool BenchmarkRunner::load(const QString &fileName) {
+    QFile loadFile(fileName);
+    if (!loadFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject json = QJsonDocument::fromJson(loadFile.readAll()).object();
+    if (json["version"].toInt() != Version) {
+        return false;
+    }
+    results.clear();
+    skipped.clear();
+    QJsonArray resultArray = json["results"].toArray();
+    for (int i = 0; i < resultArray.size(); ++i) {
+        QJsonObject resultObject = resultArray[i].toObject();
+        results.append({resultObject["name"].toString(),
+                        qint64(resultObject["iterations"].toDouble()),
+                        resultObject["nanosPerIteration"].toDouble(),
+                        qint64(resultObject["itemsPerIteration"].toDouble()),
+                        resultObject["itemName"].toString()});
+    }
+    QJsonArray skippedArray = json["skipped"].toArray();
+    for (int i = 0; i < skippedArray.size(); ++i) {
+        skipped.append(skippedArray[i].toString());
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+QList<BenchmarkRunner::Change> BenchmarkRunner::findRegressions(const BenchmarkRunner &baseline) const {
+    QHash<QString, double> baselineNanos;
+    for (const Result &result : baseline.results) {
+        baselineNanos[result.name] = result.nanosPerIteration;
+    }
+    QList<Change> regressions;
+    for (const Result &result : results) {
+        double oldNanos = baselineNanos.value(result.name, 0.0);
+        if (oldNanos > 0.0 && result.nanosPerIteration > oldNanos*(1.0 + RegressionThreshold)) {
+            regressions.append({result.name, result.nanosPerIteration/oldNanos});
+        }
+    }
+    std::sort(regressions.begin(), regressions.end(), [](const Change &a, const Change &b) {
+        return a.ratio > b.ratio;
+    });
+    return regressions;
+}
+
+/*************************************************************************/
+
+QString BenchmarkRunner::getDefaultFileName() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/benchmarks.json";
+}
+
+}
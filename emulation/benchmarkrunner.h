@@ -0,0 +1,86 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <functional>
+
+
+namespace Emulation {
+
+/* Times small pieces of code and keeps the results in a form that can
+ * be saved as JSON and compared with an earlier run, so performance
+ * work can be measured and regressions flagged.
+ *
+ * Every benchmark is warmed up once and then run in several batches of
+ * about BatchMillis each. The fastest batch counts, since it is the one
+ * least disturbed by the rest of the system.
+ */
+class BenchmarkRunner
+{
+public:
+    static const int Version = 1;
+    static const int BatchMillis = 20;
+    static const int NumBatches = 5;
+    // Slowdown above which compare() reports a benchmark
+    static constexpr double RegressionThreshold = 0.1;
+
+    struct Result {
+        QString name;
+        // Iterations per batch
+        qint64 iterations;
+        double nanosPerIteration;
+        // What one iteration processes, e.g. 4410 "samples"
+        qint64 itemsPerIteration;
+        QString itemName;
+
+        double getItemsPerSecond() const;
+    };
+
+    /* A benchmark that got slower or faster than in the baseline */
+    struct Change {
+        QString name;
+        // New time divided by the old one
+        double ratio;
+    };
+
+    /* Runs body repeatedly and stores the result under name */
+    void run(const QString &name, const std::function<void()> &body,
+             qint64 itemsPerIteration = 1, const QString &itemName = "iterations");
+
+    /* Notes a benchmark that could not be run */
+    void skip(const QString &name, const QString &reason);
+
+    QList<Result> getResults() const;
+    QStringList getSkipped() const;
+
+    /* Returns false if the file can't be written or read */
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+    /* The contents save() writes */
+    QByteArray toJson() const;
+
+    /* Benchmarks that are slower than in baseline by more than
+     * RegressionThreshold, slowest first */
+    QList<Change> findRegressions(const BenchmarkRunner &baseline) const;
+
+    /* Where the results of the last run are kept */
+    static QString getDefaultFileName();
+
+private:
+    QList<Result> results;
+    QStringList skipped;
+};
+
+}
+
+#endif // BENCHMARKRUNNER_H
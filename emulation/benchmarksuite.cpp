@@ -0,0 +1,199 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "benchmarksuite.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+#include "SoundSDL2.h"
+#include "TIASnd.h"
+#include "audiosink.h"
+#include "dasmexporter.h"
+#include "player.h"
+#include "playerharness.h"
+#include "track/track.h"
+
+
+namespace Emulation {
+
+namespace {
+
+/* Gives access to the audio callback's work without a running device */
+class SoundBench : public SoundSDL2
+{
+public:
+    using SoundSDL2::SoundSDL2;
+    using SoundSDL2::processFragment;
+};
+
+/* Writes one frame of changing registers */
+void writeFrame(SoundSDL2 &sound, int frame) {
+    sound.set(AUDC0, uInt8(4 + (frame&3)), 0);
+    sound.set(AUDF0, uInt8(frame&31), 0);
+    sound.set(AUDV0, uInt8(8 + (frame&7)), 0);
+    sound.endFrame();
+}
+
+}
+
+/*************************************************************************/
+
+BenchmarkSuite::BenchmarkSuite(BenchmarkRunner *runner) :
+    pRunner(runner)
+{
+}
+
+/*************************************************************************/
+
+void BenchmarkSuite::runTiaSound() {
+    const int rates[] = {22050, 31400, 44100, 48000};
+    for (int rate : rates) {
+        // A tenth of a second per iteration
+        int numSamples = rate/10;
+        QVector<Int16> samples(numSamples);
+        for (int audc = 0; audc < 16; ++audc) {
+            TIASound tiaSound(rate);
+            tiaSound.channels(1, false);
+            tiaSound.set(AUDC0, uInt8(audc));
+            tiaSound.set(AUDF0, 10);
+            tiaSound.set(AUDV0, 15);
+            pRunner->run(QString("TIASound::process AUDC %1 %2Hz").arg(audc).arg(rate), [&]() {
+                tiaSound.process(samples.data(), uInt32(numSamples));
+            }, numSamples, "samples");
+        }
+    }
+}
+
+/*************************************************************************/
+
+void BenchmarkSuite::runSoundDevice() {
+    const int depths[] = {0, 1, 2, 4, 8};
+    TIASound tiaSound;
+    SoundBench sound(&tiaSound);
+    if (sound.getSampleRate() == 0) {
+        pRunner->skip("SoundSDL2::processFragment", "no sound device");
+        return;
+    }
+    sound.setFrameRate(50.0);
+    sound.open();
+    // Paused, so the callback doesn't run concurrently
+    sound.mute(true);
+    sound.setPreciseTiming(true);
+
+    // One frame written and one frame of stereo samples processed per
+    // iteration, so the queue stays at its depth
+    int frameSamples = sound.getSampleRate()/50;
+    QVector<Int16> stream(frameSamples*2);
+    for (int depth : depths) {
+        sound.reset();
+        sound.setLatencyTarget(uInt32(qMax(1, depth)));
+        int frame = 0;
+        for (; frame < depth; ++frame) {
+            writeFrame(sound, frame);
+        }
+        pRunner->run(QString("SoundSDL2::processFragment %1 frames queued").arg(depth), [&]() {
+            writeFrame(sound, frame++);
+            sound.processFragment(stream.data(), uInt32(stream.size()));
+        }, frameSamples, "samples");
+    }
+    sound.close();
+}
+
+/*************************************************************************/
+
+bool BenchmarkSuite::runSong(const QString &name, const QByteArray &json) {
+    QJsonObject songObject = QJsonDocument::fromJson(json).object();
+    Track::Track track;
+    if (!track.fromJson(songObject)) {
+        pRunner->skip(name, "can't be loaded");
+        return false;
+    }
+
+    pRunner->run(name + ": Track::fromJson", [&]() {
+        Track::Track loadedTrack;
+        loadedTrack.fromJson(songObject);
+    });
+    pRunner->run(name + ": Track::toJson", [&]() {
+        QJsonObject savedObject;
+        track.toJson(savedObject);
+    });
+
+    int startRow[2];
+    for (int channel = 0; channel < 2; ++channel) {
+        int startEntry = track.startPatterns[channel];
+        startRow[channel] = track.channelSequences[channel].sequence[startEntry].firstNoteNumber;
+    }
+    // Restarted whenever the song ends, so short songs still fill
+    // every iteration
+    Player player(&track, new NullSink());
+    player.playTrack(startRow[0], startRow[1]);
+    pRunner->run(name + ": Player::advanceFrame", [&]() {
+        for (int frame = 0; frame < PlayerFrames; ++frame) {
+            if (!player.isPlaying()) {
+                player.playTrack(startRow[0], startRow[1]);
+            }
+            track.lock();
+            player.advanceFrame();
+            track.unlock();
+        }
+    }, PlayerFrames, "frames");
+
+    PlayerHarness harness;
+    track.lock();
+    bool harnessLoaded = harness.loadTrack(&track);
+    track.unlock();
+    if (harnessLoaded) {
+        harness.run(PlayerFrames);
+        int numFrames = harness.getNumFrames();
+        pRunner->run(name + ": PlayerHarness::run", [&]() {
+            harness.run(PlayerFrames);
+        }, numFrames, "frames");
+    } else {
+        pRunner->skip(name + ": PlayerHarness::run", harness.getErrorMessage());
+    }
+
+    DasmExporter exporter(&track);
+    pRunner->run(name + ": DasmExporter::exportTrackSpecifics", [&]() {
+        exporter.exportTrackSpecifics();
+    });
+    pRunner->run(name + ": DasmExporter::exportPlayer", [&]() {
+        exporter.exportPlayer();
+    });
+
+    // Repeat the sequences until every channel has enough rows that
+    // the lookup cost of long songs shows
+    Track::Track scaledTrack;
+    scaledTrack.fromJson(songObject);
+    for (int channel = 0; channel < 2; ++channel) {
+        QList<Track::SequenceEntry> &entries = scaledTrack.channelSequences[channel].sequence;
+        if (entries.isEmpty()) {
+            continue;
+        }
+        for (int rows = scaledTrack.getChannelNumRows(channel); rows > 0 && rows < ScaledRows; rows *= 2) {
+            entries.append(QList<Track::SequenceEntry>(entries));
+        }
+    }
+    scaledTrack.updateFirstNoteNumbers();
+    int channelRows[2]{};
+    for (int channel = 0; channel < 2; ++channel) {
+        if (!scaledTrack.channelSequences[channel].sequence.isEmpty()) {
+            channelRows[channel] = scaledTrack.getChannelNumRows(channel);
+        }
+    }
+    pRunner->run(name + ": Track::getNote", [&]() {
+        for (int channel = 0; channel < 2; ++channel) {
+            for (int row = 0; row < channelRows[channel]; ++row) {
+                scaledTrack.getNote(channel, row);
+            }
+        }
+    }, channelRows[0] + channelRows[1], "rows");
+    return true;
+}
+
+}
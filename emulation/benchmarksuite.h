@@ -0,0 +1,53 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef BENCHMARKSUITE_H
+#define BENCHMARKSUITE_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "benchmarkrunner.h"
+
+
+namespace Emulation {
+
+/* The benchmarks of the emulation and track model hot paths: TIA sound
+ * synthesis, the audio callback, the tracker player, and loading,
+ * saving, traversing and exporting songs.
+ *
+ * Runs on the calling thread, which should be idle otherwise. The
+ * sound device benchmark opens a device of its own and keeps it paused.
+ */
+class BenchmarkSuite
+{
+public:
+    // Player frames per iteration of the player benchmark
+    static const int PlayerFrames = 3000;
+    // Rows per channel of the scaled-up track for the note lookup
+    static const int ScaledRows = 16384;
+
+    explicit BenchmarkSuite(BenchmarkRunner *runner);
+
+    /* TIASound::process() for every distortion and common sample rates */
+    void runTiaSound();
+
+    /* SoundSDL2::processFragment() in precise mode, with different
+     * numbers of frames queued. Skipped if there is no sound device. */
+    void runSoundDevice();
+
+    /* Benchmarks for one song. json is the contents of its .ttt file.
+     * Returns false if it can't be loaded. */
+    bool runSong(const QString &name, const QByteArray &json);
+
+private:
+    BenchmarkRunner *pRunner;
+};
+
+}
+
+#endif // BENCHMARKSUITE_H
@@ -0,0 +1,667 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "cpu6502.h"
+
+#include <QByteArray>
+#include <cstring>
+
+
+namespace Emulation {
+
+namespace {
+
+typedef Cpu6502::Mnemonic M;
+typedef Cpu6502::AddressMode A;
+
+struct OpcodeEntry {
+    int opcode;
+    Cpu6502::Opcode info;
+};
+
+const OpcodeEntry opcodeList[] = {
+    {0x00, {M::Brk, A::Implied, 7, false}},     {0x01, {M::Ora, A::IndirectX, 6, false}},
+    {0x05, {M::Ora, A::ZeroPage, 3, false}},    {0x06, {M::Asl, A::ZeroPage, 5, false}},
+    {0x08, {M::Php, A::Implied, 3, false}},     {0x09, {M::Ora, A::Immediate, 2, false}},
+    {0x0a, {M::Asl, A::Accumulator, 2, false}}, {0x0d, {M::Ora, A::Absolute, 4, false}},
+    {0x0e, {M::Asl, A::Absolute, 6, false}},    {0x10, {M::Bpl, A::Relative, 2, false}},
+    {0x11, {M::Ora, A::IndirectY, 5, true}},    {0x15, {M::Ora, A::ZeroPageX, 4, false}},
+    {0x16, {M::Asl, A::ZeroPageX, 6, false}},   {0x18, {M::Clc, A::Implied, 2, false}},
+    {0x19, {M::Ora, A::AbsoluteY, 4, true}},    {0x1d, {M::Ora, A::AbsoluteX, 4, true}},
+    {0x1e, {M::Asl, A::AbsoluteX, 7, false}},   {0x20, {M::Jsr, A::Absolute, 6, false}},
+    {0x21, {M::And, A::IndirectX, 6, false}},   {0x24, {M::Bit, A::ZeroPage, 3, false}},
+    {0x25, {M::And, A::ZeroPage, 3, false}},    {0x26, {M::Rol, A::ZeroPage, 5, false}},
+    {0x28, {M::Plp, A::Implied, 4, false}},     {0x29, {M::And, A::Immediate, 2, false}},
+    {0x2a, {M::Rol, A::Accumulator, 2, false}}, {0x2c, {M::Bit, A::Absolute, 4, false}},
+    {0x2d, {M::And, A::Absolute, 4, false}},    {0x2e, {M::Rol, A::Absolute, 6, false}},
+    {0x30, {M::Bmi, A::Relative, 2, false}},    {0x31, {M::And, A::IndirectY, 5, true}},
+    {0x35, {M::And, A::ZeroPageX, 4, false}},   {0x36, {M::Rol, A::ZeroPageX, 6, false}},
+    {0x38, {M::Sec, A::Implied, 2, false}},     {0x39, {M::And, A::AbsoluteY, 4, true}},
+    {0x3d, {M::And, A::AbsoluteX, 4, true}},    {0x3e, {M::Rol, A::AbsoluteX, 7, false}},
+    {0x40, {M::Rti, A::Implied, 6, false}},     {0x41, {M::Eor, A::IndirectX, 6, false}},
+    {0x45, {M::Eor, A::ZeroPage, 3, false}},    {0x46, {M::Lsr, A::ZeroPage, 5, false}},
+    {0x48, {M::Pha, A::Implied, 3, false}},     {0x49, {M::Eor, A::Immediate, 2, false}},
+    {0x4a, {M::Lsr, A::Accumulator, 2, false}}, {0x4c, {M::Jmp, A::Absolute, 3, false}},
+    {0x4d, {M::Eor, A::Absolute, 4, false}},    {0x4e, {M::Lsr, A::Absolute, 6, false}},
+    {0x50, {M::Bvc, A::Relative, 2, false}},    {0x51, {M::Eor, A::IndirectY, 5, true}},
+    {0x55, {M::Eor, A::ZeroPageX, 4, false}},   {0x56, {M::Lsr, A::ZeroPageX, 6, false}},
+    {0x58, {M::Cli, A::Implied, 2, false}},     {0x59, {M::Eor, A::AbsoluteY, 4, true}},
+    {0x5d, {M::Eor, A::AbsoluteX, 4, true}},    {0x5e, {M::Lsr, A::AbsoluteX, 7, false}},
+    {0x60, {M::Rts, A::Implied, 6, false}},     {0x61, {M::Adc, A::IndirectX, 6, false}},
+    {0x65, {M::Adc, A::ZeroPage, 3, false}},    {0x66, {M::Ror, A::ZeroPage, 5, false}},
+    {0x68, {M::Pla, A::Implied, 4, false}},     {0x69, {M::Adc, A::Immediate, 2, false}},
+    {0x6a, {M::Ror, A::Accumulator, 2, false}}, {0x6c, {M::Jmp, A::Indirect, 5, false}},
+    {0x6d, {M::Adc, A::Absolute, 4, false}},    {0x6e, {M::Ror, A::Absolute, 6, false}},
+    {0x70, {M::Bvs, A::Relative, 2, false}},    {0x71, {M::Adc, A::IndirectY, 5, true}},
+    {0x75, {M::Adc, A::ZeroPageX, 4, false}},   {0x76, {M::Ror, A::ZeroPageX, 6, false}},
+    {0x78, {M::Sei, A::Implied, 2, false}},     {0x79, {M::Adc, A::AbsoluteY, 4, true}},
+    {0x7d, {M::Adc, A::AbsoluteX, 4, true}},    {0x7e, {M::Ror, A::AbsoluteX, 7, false}},
+    {0x81, {M::Sta, A::IndirectX, 6, false}},   {0x84, {M::Sty, A::ZeroPage, 3, false}},
+    {0x85, {M::Sta, A::ZeroPage, 3, false}},    {0x86, {M::Stx, A::ZeroPage, 3, false}},
+    {0x88, {M::Dey, A::Implied, 2, false}},     {0x8a, {M::Txa, A::Implied, 2, false}},
+    {0x8c, {M::Sty, A::Absolute, 4, false}},    {0x8d, {M::Sta, A::Absolute, 4, false}},
+    {0x8e, {M::Stx, A::Absolute, 4, false}},    {0x90, {M::Bcc, A::Relative, 2, false}},
+    {0x91, {M::Sta, A::IndirectY, 6, false}},   {0x94, {M::Sty, A::ZeroPageX, 4, false}},
+    {0x95, {M::Sta, A::ZeroPageX, 4, false}},   {0x96, {M::Stx, A::ZeroPageY, 4, false}},
+    {0x98, {M::Tya, A::Implied, 2, false}},     {0x99, {M::Sta, A::AbsoluteY, 5, false}},
+    {0x9a, {M::Txs, A::Implied, 2, false}},     {0x9d, {M::Sta, A::AbsoluteX, 5, false}},
+    {0xa0, {M::Ldy, A::Immediate, 2, false}},   {0xa1, {M::Lda, A::IndirectX, 6, false}},
+    {0xa2, {M::Ldx, A::Immediate, 2, false}},   {0xa4, {M::Ldy, A::ZeroPage, 3, false}},
+    {0xa5, {M::Lda, A::ZeroPage, 3, false}},    {0xa6, {M::Ldx, A::ZeroPage, 3, false}},
+    {0xa8, {M::Tay, A::Implied, 2, false}},     {0xa9, {M::Lda, A::Immediate, 2, false}},
+    {0xaa, {M::Tax, A::Implied, 2, false}},     {0xac, {M::Ldy, A::Absolute, 4, false}},
+    {0xad, {M::Lda, A::Absolute, 4, false}},    {0xae, {M::Ldx, A::Absolute, 4, false}},
+    {0xb0, {M::Bcs, A::Relative, 2, false}},    {0xb1, {M::Lda, A::IndirectY, 5, true}},
+    {0xb4, {M::Ldy, A::ZeroPageX, 4, false}},   {0xb5, {M::Lda, A::ZeroPageX, 4, false}},
+    {0xb6, {M::Ldx, A::ZeroPageY, 4, false}},   {0xb8, {M::Clv, A::Implied, 2, false}},
+    {0xb9, {M::Lda, A::AbsoluteY, 4, true}},    {0xba, {M::Tsx, A::Implied, 2, false}},
+    {0xbc, {M::Ldy, A::AbsoluteX, 4, true}},    {0xbd, {M::Lda, A::AbsoluteX, 4, true}},
+    {0xbe, {M::Ldx, A::AbsoluteY, 4, true}},    {0xc0, {M::Cpy, A::Immediate, 2, false}},
+    {0xc1, {M::Cmp, A::IndirectX, 6, false}},   {0xc4, {M::Cpy, A::ZeroPage, 3, false}},
+    {0xc5, {M::Cmp, A::ZeroPage, 3, false}},    {0xc6, {M::Dec, A::ZeroPage, 5, false}},
+    {0xc8, {M::Iny, A::Implied, 2, false}},     {0xc9, {M::Cmp, A::Immediate, 2, false}},
+    {0xca, {M::Dex, A::Implied, 2, false}},     {0xcc, {M::Cpy, A::Absolute, 4, false}},
+    {0xcd, {M::Cmp, A::Absolute, 4, false}},    {0xce, {M::Dec, A::Absolute, 6, false}},
+    {0xd0, {M::Bne, A::Relative, 2, false}},    {0xd1, {M::Cmp, A::IndirectY, 5, true}},
+    {0xd5, {M::Cmp, A::ZeroPageX, 4, false}},   {0xd6, {M::Dec, A::ZeroPageX, 6, false}},
+    {0xd8, {M::Cld, A::Implied, 2, false}},     {0xd9, {M::Cmp, A::AbsoluteY, 4, true}},
+    {0xdd, {M::Cmp, A::AbsoluteX, 4, true}},    {0xde, {M::Dec, A::AbsoluteX, 7, false}},
+    {0xe0, {M::Cpx, A::Immediate, 2, false}},   {0xe1, {M::Sbc, A::IndirectX, 6, false}},
+    {0xe4, {M::Cpx, A::ZeroPage, 3, false}},    {0xe5, {M::Sbc, A::ZeroPage, 3, false}},
+    {0xe6, {M::Inc, A::ZeroPage, 5, false}},    {0xe8, {M::Inx, A::Implied, 2, false}},
+    {0xe9, {M::Sbc, A::Immediate, 2, false}},   {0xea, {M::Nop, A::Implied, 2, false}},
+    {0xec, {M::Cpx, A::Absolute, 4, false}},    {0xed, {M::Sbc, A::Absolute, 4, false}},
+    {0xee, {M::Inc, A::Absolute, 6, false}},    {0xf0, {M::Beq, A::Relative, 2, false}},
+    {0xf1, {M::Sbc, A::IndirectY, 5, true}},    {0xf5, {M::Sbc, A::ZeroPageX, 4, false}},
+    {0xf6, {M::Inc, A::ZeroPageX, 6, false}},   {0xf8, {M::Sed, A::Implied, 2, false}},
+    {0xf9, {M::Sbc, A::AbsoluteY, 4, true}},    {0xfd, {M::Sbc, A::AbsoluteX, 4, true}},
+    {0xfe, {M::Inc, A::AbsoluteX, 7, false}}
+};
+
+const char *mnemonicNames[] = {
+    "???",
+    "adc", "and", "asl", "bcc", "bcs", "beq", "bit", "bmi", "bne", "bpl", "brk", "bvc", "bvs",
+    "clc", "cld", "cli", "clv", "cmp", "cpx", "cpy", "dec", "dex", "dey", "eor", "inc", "inx",
+    "iny", "jmp", "jsr", "lda", "ldx", "ldy", "lsr", "nop", "ora", "pha", "php", "pla", "plp",
+    "rol", "ror", "rti", "rts", "sbc", "sec", "sed", "sei", "sta", "stx", "sty", "tax", "tay",
+    "tsx", "txa", "txs", "tya"
+};
+
+struct OpcodeTable {
+    Cpu6502::Opcode opcodes[256];
+
+    OpcodeTable() {
+        for (int i = 0; i < 256; ++i) {
+            opcodes[i] = {M::Illegal, A::Implied, 0, false};
+        }
+        for (const OpcodeEntry &entry : opcodeList) {
+            opcodes[entry.opcode] = entry.info;
+        }
+    }
+};
+
+const OpcodeTable opcodeTable;
+
+}
+
+/*************************************************************************/
+
+Cpu6502::Cpu6502() : rom(romSize, 0)
+{
+    reset();
+}
+
+/*************************************************************************/
+
+const Cpu6502::Opcode &Cpu6502::getOpcode(int opcode) {
+    return opcodeTable.opcodes[opcode&0xff];
+}
+
+/*************************************************************************/
+
+const char *Cpu6502::getMnemonicName(Mnemonic mnemonic) {
+    return mnemonicNames[int(mnemonic)];
+}
+
+/*************************************************************************/
+
+int Cpu6502::getOperandSize(AddressMode mode) {
+    switch (mode) {
+    case AddressMode::Implied:
+    case AddressMode::Accumulator:
+        return 0;
+    case AddressMode::Absolute:
+    case AddressMode::AbsoluteX:
+    case AddressMode::AbsoluteY:
+    case AddressMode::Indirect:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+/*************************************************************************/
+
+void Cpu6502::reset() {
+    std::memset(ram, 0, ramSize);
+    rom.fill(0);
+    pc = 0;
+    a = 0;
+    x = 0;
+    y = 0;
+    sp = 0xff;
+    p = FlagU|FlagI;
+    cycles = 0;
+    romWrites = 0;
+    tiaWrites.clear();
+}
+
+/*************************************************************************/
+
+void Cpu6502::loadImage(int address, const QByteArray &image) {
+    for (int i = 0; i < image.size(); ++i) {
+        int target = (address + i)&0xffff;
+        if ((target&0x1000) != 0) {
+            rom[target] = (unsigned char)image[i];
+        } else {
+            poke(target, (unsigned char)image[i]);
+        }
+    }
+}
+
+/*************************************************************************/
+
+int Cpu6502::peek(int address) {
+    address &= 0xffff;
+    if ((address&0x1000) != 0) {
+        return rom[address];
+    }
+    if ((address&0x0080) == 0 || (address&0x0200) != 0) {
+        // TIA or RIOT
+        return 0;
+    }
+    return ram[address&0x7f];
+}
+
+/*************************************************************************/
+
+void Cpu6502::poke(int address, int value) {
+    address &= 0xffff;
+    value &= 0xff;
+    if ((address&0x1000) != 0) {
+        ++romWrites;
+    } else if ((address&0x0080) == 0) {
+        if (recordTiaWrites) {
+            tiaWrites.append({cycles, address&0x3f, value});
+        }
+    } else if ((address&0x0200) == 0) {
+        ram[address&0x7f] = value;
+    }
+}
+
+/*************************************************************************/
+
+void Cpu6502::push(int value) {
+    poke(0x100 + sp, value);
+    sp = (sp - 1)&0xff;
+}
+
+/*************************************************************************/
+
+int Cpu6502::pull() {
+    sp = (sp + 1)&0xff;
+    return peek(0x100 + sp);
+}
+
+/*************************************************************************/
+
+void Cpu6502::setNZ(int value) {
+    p &= ~(FlagN|FlagZ);
+    if ((value&0xff) == 0) {
+        p |= FlagZ;
+    }
+    p |= value&FlagN;
+}
+
+/*************************************************************************/
+
+void Cpu6502::compare(int reg, int value) {
+    int result = reg - value;
+    p &= ~FlagC;
+    if (result >= 0) {
+        p |= FlagC;
+    }
+    setNZ(result&0xff);
+}
+
+/*************************************************************************/
+
+void Cpu6502::doAdc(int value) {
+    int carry = p&FlagC;
+    if ((p&FlagD) == 0) {
+        int result = a + value + carry;
+        p &= ~(FlagC|FlagV);
+        if (((a^result)&(value^result)&0x80) != 0) {
+            p |= FlagV;
+        }
+        if (result > 0xff) {
+            p |= FlagC;
+        }
+        a = result&0xff;
+        setNZ(a);
+    } else {
+        // NMOS decimal mode; N, V and Z follow the binary result
+        int binary = (a + value + carry)&0xff;
+        int lo = (a&0x0f) + (value&0x0f) + carry;
+        if (lo > 9) {
+            lo += 6;
+        }
+        int hi = (a>>4) + (value>>4) + (lo > 0x0f ? 1 : 0);
+        p &= ~(FlagC|FlagV|FlagN|FlagZ);
+        if (binary == 0) {
+            p |= FlagZ;
+        }
+        if ((hi&0x08) != 0) {
+            p |= FlagN;
+        }
+        if ((((hi<<4)^a)&0x80) != 0 && ((a^value)&0x80) == 0) {
+            p |= FlagV;
+        }
+        if (hi > 9) {
+            hi += 6;
+        }
+        if (hi > 0x0f) {
+            p |= FlagC;
+        }
+        a = ((hi<<4)|(lo&0x0f))&0xff;
+    }
+}
+
+/*************************************************************************/
+
+void Cpu6502::doSbc(int value) {
+    int borrow = (p&FlagC) == 0 ? 1 : 0;
+    int result = a - value - borrow;
+    p &= ~(FlagC|FlagV);
+    if (((a^value)&(a^result)&0x80) != 0) {
+        p |= FlagV;
+    }
+    if (result >= 0) {
+        p |= FlagC;
+    }
+    if ((p&FlagD) == 0) {
+        a = result&0xff;
+    } else {
+        int lo = (a&0x0f) - (value&0x0f) - borrow;
+        int hi = (a>>4) - (value>>4);
+        if (lo < 0) {
+            lo -= 6;
+            hi--;
+        }
+        if (hi < 0) {
+            hi -= 6;
+        }
+        a = ((hi<<4)|(lo&0x0f))&0xff;
+    }
+    setNZ(result&0xff);
+}
+
+/*************************************************************************/
+
+bool Cpu6502::effectiveAddress(AddressMode mode, int *pAddress) {
+    int base;
+    switch (mode) {
+    case AddressMode::Immediate:
+        *pAddress = pc;
+        pc = (pc + 1)&0xffff;
+        return false;
+    case AddressMode::ZeroPage:
+        *pAddress = peek(pc);
+        pc = (pc + 1)&0xffff;
+        return false;
+    case AddressMode::ZeroPageX:
+        *pAddress = (peek(pc) + x)&0xff;
+        pc = (pc + 1)&0xffff;
+        return false;
+    case AddressMode::ZeroPageY:
+        *pAddress = (peek(pc) + y)&0xff;
+        pc = (pc + 1)&0xffff;
+        return false;
+    case AddressMode::Absolute:
+        *pAddress = peek(pc) | (peek(pc + 1)<<8);
+        pc = (pc + 2)&0xffff;
+        return false;
+    case AddressMode::AbsoluteX:
+        base = peek(pc) | (peek(pc + 1)<<8);
+        pc = (pc + 2)&0xffff;
+        *pAddress = (base + x)&0xffff;
+        return (base&0xff00) != (*pAddress&0xff00);
+    case AddressMode::AbsoluteY:
+        base = peek(pc) | (peek(pc + 1)<<8);
+        pc = (pc + 2)&0xffff;
+        *pAddress = (base + y)&0xffff;
+        return (base&0xff00) != (*pAddress&0xff00);
+    case AddressMode::Indirect:
+        // Includes the NMOS page wrap bug
+        base = peek(pc) | (peek(pc + 1)<<8);
+        pc = (pc + 2)&0xffff;
+        *pAddress = peek(base) | (peek((base&0xff00) | ((base + 1)&0xff))<<8);
+        return false;
+    case AddressMode::IndirectX:
+        base = (peek(pc) + x)&0xff;
+        pc = (pc + 1)&0xffff;
+        *pAddress = peek(base) | (peek((base + 1)&0xff)<<8);
+        return false;
+    case AddressMode::IndirectY:
+        base = peek(pc);
+        pc = (pc + 1)&0xffff;
+        base = peek(base) | (peek((base + 1)&0xff)<<8);
+        *pAddress = (base + y)&0xffff;
+        return (base&0xff00) != (*pAddress&0xff00);
+    case AddressMode::Relative:
+        base = peek(pc);
+        pc = (pc + 1)&0xffff;
+        *pAddress = (pc + (base < 128 ? base : base - 256))&0xffff;
+        return (pc&0xff00) != (*pAddress&0xff00);
+    default:
+        *pAddress = 0;
+        return false;
+    }
+}
+
+/*************************************************************************/
+
+int Cpu6502::step() {
+    const Opcode &op = getOpcode(peek(pc));
+    if (op.mnemonic == Mnemonic::Illegal) {
+        return -1;
+    }
+    pc = (pc + 1)&0xffff;
+    int address = 0;
+    bool pageCrossed = effectiveAddress(op.mode, &address);
+    int opCycles = op.cycles;
+    if (op.pagePenalty && pageCrossed) {
+        opCycles++;
+    }
+
+    bool branch = false;
+    int value;
+    switch (op.mnemonic) {
+    case Mnemonic::Adc:
+        doAdc(peek(address));
+        break;
+    case Mnemonic::And:
+        a &= peek(address);
+        setNZ(a);
+        break;
+    case Mnemonic::Asl:
+    case Mnemonic::Lsr:
+    case Mnemonic::Rol:
+    case Mnemonic::Ror:
+    {
+        value = op.mode == AddressMode::Accumulator ? a : peek(address);
+        int carryIn = p&FlagC;
+        p &= ~FlagC;
+        if (op.mnemonic == Mnemonic::Asl || op.mnemonic == Mnemonic::Rol) {
+            if ((value&0x80) != 0) {
+                p |= FlagC;
+            }
+            value = ((value<<1) | (op.mnemonic == Mnemonic::Rol ? carryIn : 0))&0xff;
+        } else {
+            if ((value&0x01) != 0) {
+                p |= FlagC;
+            }
+            value = (value>>1) | (op.mnemonic == Mnemonic::Ror && carryIn != 0 ? 0x80 : 0);
+        }
+        setNZ(value);
+        if (op.mode == AddressMode::Accumulator) {
+            a = value;
+        } else {
+            poke(address, value);
+        }
+        break;
+    }
+    case Mnemonic::Bcc:
+        branch = (p&FlagC) == 0;
+        break;
+    case Mnemonic::Bcs:
+        branch = (p&FlagC) != 0;
+        break;
+    case Mnemonic::Beq:
+        branch = (p&FlagZ) != 0;
+        break;
+    case Mnemonic::Bmi:
+        branch = (p&FlagN) != 0;
+        break;
+    case Mnemonic::Bne:
+        branch = (p&FlagZ) == 0;
+        break;
+    case Mnemonic::Bpl:
+        branch = (p&FlagN) == 0;
+        break;
+    case Mnemonic::Bvc:
+        branch = (p&FlagV) == 0;
+        break;
+    case Mnemonic::Bvs:
+        branch = (p&FlagV) != 0;
+        break;
+    case Mnemonic::Bit:
+        value = peek(address);
+        p &= ~(FlagN|FlagV|FlagZ);
+        p |= value&(FlagN|FlagV);
+        if ((a&value) == 0) {
+            p |= FlagZ;
+        }
+        break;
+    case Mnemonic::Brk:
+        pc = (pc + 1)&0xffff;
+        push(pc>>8);
+        push(pc&0xff);
+        push(p|FlagB|FlagU);
+        p |= FlagI;
+        pc = peek(0xfffe) | (peek(0xffff)<<8);
+        break;
+    case Mnemonic::Clc:
+        p &= ~FlagC;
+        break;
+    case Mnemonic::Cld:
+        p &= ~FlagD;
+        break;
+    case Mnemonic::Cli:
+        p &= ~FlagI;
+        break;
+    case Mnemonic::Clv:
+        p &= ~FlagV;
+        break;
+    case Mnemonic::Cmp:
+        compare(a, peek(address));
+        break;
+    case Mnemonic::Cpx:
+        compare(x, peek(address));
+        break;
+    case Mnemonic::Cpy:
+        compare(y, peek(address));
+        break;
+    case Mnemonic::Dec:
+        value = (peek(address) - 1)&0xff;
+        poke(address, value);
+        setNZ(value);
+        break;
+    case Mnemonic::Dex:
+        x = (x - 1)&0xff;
+        setNZ(x);
+        break;
+    case Mnemonic::Dey:
+        y = (y - 1)&0xff;
+        setNZ(y);
+        break;
+    case Mnemonic::Eor:
+        a ^= peek(address);
+        setNZ(a);
+        break;
+    case Mnemonic::Inc:
+        value = (peek(address) + 1)&0xff;
+        poke(address, value);
+        setNZ(value);
+        break;
+    case Mnemonic::Inx:
+        x = (x + 1)&0xff;
+        setNZ(x);
+        break;
+    case Mnemonic::Iny:
+        y = (y + 1)&0xff;
+        setNZ(y);
+        break;
+    case Mnemonic::Jmp:
+        pc = address;
+        break;
+    case Mnemonic::Jsr:
+    {
+        int returnAddress = (pc - 1)&0xffff;
+        push(returnAddress>>8);
+        push(returnAddress&0xff);
+        pc = address;
+        break;
+    }
+    case Mnemonic::Lda:
+        a = peek(address);
+        setNZ(a);
+        break;
+    case Mnemonic::Ldx:
+        x = peek(address);
+        setNZ(x);
+        break;
+    case Mnemonic::Ldy:
+        y = peek(address);
+        setNZ(y);
+        break;
+    case Mnemonic::Nop:
+        break;
+    case Mnemonic::Ora:
+        a |= peek(address);
+        setNZ(a);
+        break;
+    case Mnemonic::Pha:
+        push(a);
+        break;
+    case Mnemonic::Php:
+        push(p|FlagB|FlagU);
+        break;
+    case Mnemonic::Pla:
+        a = pull();
+        setNZ(a);
+        break;
+    case Mnemonic::Plp:
+        p = (pull()&~FlagB)|FlagU;
+        break;
+    case Mnemonic::Rti:
+        p = (pull()&~FlagB)|FlagU;
+        pc = pull();
+        pc |= pull()<<8;
+        break;
+    case Mnemonic::Rts:
+        pc = pull();
+        pc |= pull()<<8;
+        pc = (pc + 1)&0xffff;
+        break;
+    case Mnemonic::Sbc:
+        doSbc(peek(address));
+        break;
+    case Mnemonic::Sec:
+        p |= FlagC;
+        break;
+    case Mnemonic::Sed:
+        p |= FlagD;
+        break;
+    case Mnemonic::Sei:
+        p |= FlagI;
+        break;
+    case Mnemonic::Sta:
+        poke(address, a);
+        break;
+    case Mnemonic::Stx:
+        poke(address, x);
+        break;
+    case Mnemonic::Sty:
+        poke(address, y);
+        break;
+    case Mnemonic::Tax:
+        x = a;
+        setNZ(x);
+        break;
+    case Mnemonic::Tay:
+        y = a;
+        setNZ(y);
+        break;
+    case Mnemonic::Tsx:
+        x = sp;
+        setNZ(x);
+        break;
+    case Mnemonic::Txa:
+        a = x;
+        setNZ(a);
+        break;
+    case Mnemonic::Txs:
+        sp = x;
+        break;
+    case Mnemonic::Tya:
+        a = y;
+        setNZ(a);
+        break;
+    default:
+        return -1;
+    }
+
+    if (branch) {
+        // +1 if taken, +1 more if the target is on another page
+        opCycles += pageCrossed ? 2 : 1;
+        pc = address;
+    }
+    cycles += opCycles;
+    return opCycles;
+}
+
+/*************************************************************************/
+
+long Cpu6502::callSubroutine(int address, long maxCycles) {
+    // Fake a jsr from a sentinel address, so the final rts is detectable
+    const int sentinel = 0xffff;
+    int startSp = sp;
+    push((sentinel - 1)>>8);
+    push((sentinel - 1)&0xff);
+    pc = address&0xffff;
+    long startCycles = cycles;
+    while (pc != sentinel || sp != startSp) {
+        if (step() == -1 || cycles - startCycles > maxCycles) {
+            sp = startSp;
+            return -1;
+        }
+    }
+    return cycles - startCycles;
+}
+
+}
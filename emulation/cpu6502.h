@@ -0,0 +1,141 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef CPU6502_H
+#define CPU6502_H
+
+#include <QByteArray>
+#include <QVector>
+
+
+namespace Emulation {
+
+/* Minimal cycle-counting 6502 core with a VCS-like memory map, used to
+ * run the exported player routine offline. Only the documented opcodes
+ * are supported; an illegal opcode halts execution.
+ *
+ * Memory map:
+ * - A12 = 1: ROM, i.e. the eight 4K windows $1000-$1FFF, $3000-$3FFF,
+ *   ..., $F000-$FFFF. They are not mirrored, each address holds its own
+ *   byte. Addresses with A12 = 0 in between, e.g. $2000-$2FFF, decode to
+ *   TIA/RAM/RIOT below, so an image must not cross a 4K window.
+ * - A12 = 0, A7 = 1, A9 = 0: 128 bytes of RAM, mirrored (incl. stack)
+ * - A12 = 0, A7 = 0: TIA. Writes are recorded, reads return 0
+ * - A12 = 0, A7 = 1, A9 = 1: RIOT. Ignored, reads return 0
+ */
+class Cpu6502
+{
+public:
+    enum class Mnemonic {
+        Illegal,
+        Adc, And, Asl, Bcc, Bcs, Beq, Bit, Bmi, Bne, Bpl, Brk, Bvc, Bvs,
+        Clc, Cld, Cli, Clv, Cmp, Cpx, Cpy, Dec, Dex, Dey, Eor, Inc, Inx,
+        Iny, Jmp, Jsr, Lda, Ldx, Ldy, Lsr, Nop, Ora, Pha, Php, Pla, Plp,
+        Rol, Ror, Rti, Rts, Sbc, Sec, Sed, Sei, Sta, Stx, Sty, Tax, Tay,
+        Tsx, Txa, Txs, Tya
+    };
+
+    enum class AddressMode {
+        Implied, Accumulator, Immediate, ZeroPage, ZeroPageX, ZeroPageY,
+        Absolute, AbsoluteX, AbsoluteY, Indirect, IndirectX, IndirectY,
+        Relative
+    };
+
+    struct Opcode {
+        Mnemonic mnemonic;
+        AddressMode mode;
+        // Base number of cycles
+        int cycles;
+        // +1 cycle if an indexed read crosses a page boundary
+        bool pagePenalty;
+    };
+
+    /* A register write into TIA space */
+    struct TiaWrite {
+        long cycle;
+        int address;
+        int value;
+    };
+
+    /* Status flags */
+    static const int FlagC = 0x01;
+    static const int FlagZ = 0x02;
+    static const int FlagI = 0x04;
+    static const int FlagD = 0x08;
+    static const int FlagB = 0x10;
+    static const int FlagU = 0x20;
+    static const int FlagV = 0x40;
+    static const int FlagN = 0x80;
+
+    Cpu6502();
+
+    /* Opcode table lookup, also used by the assembler */
+    static const Opcode &getOpcode(int opcode);
+    static const char *getMnemonicName(Mnemonic mnemonic);
+    /* Number of operand bytes for an address mode */
+    static int getOperandSize(AddressMode mode);
+
+    /* Clears RAM, ROM and registers */
+    void reset();
+
+    /* Copies an image into memory at the given address. This is the
+     * only way to put something into ROM. */
+    void loadImage(int address, const QByteArray &image);
+
+    /* Read/write through the memory map. poke() into ROM space is
+     * ignored and counted in romWrites. */
+    int peek(int address);
+    void poke(int address, int value);
+
+    /* Executes a single instruction and returns its cycle count, or -1
+     * for an illegal opcode. */
+    int step();
+
+    /* Calls the subroutine at address and runs it until it returns.
+     * Returns the number of cycles including the final rts, or -1 if
+     * an illegal opcode was hit or maxCycles was exceeded. */
+    long callSubroutine(int address, long maxCycles);
+
+    /* Registers */
+    int pc = 0;
+    int a = 0;
+    int x = 0;
+    int y = 0;
+    int sp = 0xff;
+    int p = FlagU|FlagI;
+
+    /* Total number of cycles executed since reset */
+    long cycles = 0;
+
+    /* Writes into ROM space since reset. They point to a bug in the
+     * code being run, e.g. a bad indirect pointer. */
+    long romWrites = 0;
+
+    /* TIA writes since last clear, if recording is enabled */
+    bool recordTiaWrites = true;
+    QVector<TiaWrite> tiaWrites;
+
+private:
+    static const int ramSize = 128;
+    static const int romSize = 0x10000;
+
+    unsigned char ram[ramSize];
+    QVector<unsigned char> rom;
+
+    void push(int value);
+    int pull();
+    void setNZ(int value);
+    void compare(int reg, int value);
+    void doAdc(int value);
+    void doSbc(int value);
+    // Computes effective address. Returns true if a page was crossed.
+    bool effectiveAddress(AddressMode mode, int *pAddress);
+};
+
+}
+
+#endif // CPU6502_H
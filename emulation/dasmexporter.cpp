@@ -0,0 +1,374 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "dasmexporter.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QMap>
+#include <QVector>
+#include "track/instrument.h"
+#include "track/percussion.h"
+#include "track/pattern.h"
+#include "tiasound/tiasound.h"
+#include "player.h"
+
+
+namespace Emulation {
+
+const QString DasmExporter::templatePath{"player/dasm/"};
+
+DasmExporter::DasmExporter(Track::Track *track)
+{
+    pTrack = track;
+}
+
+/*************************************************************************/
+
+QString DasmExporter::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+QString DasmExporter::readTemplate(const QString &fileName) {
+    QFile fileIn(templatePath + fileName);
+    if (!fileIn.open(QIODevice::ReadOnly)) {
+        errorMessage = "Unable to open file " + templatePath + fileName + "!";
+        return "";
+    }
+    QTextStream inStream(&fileIn);
+    QString inString = inStream.readAll();
+    fileIn.close();
+    return inString;
+}
+
+/*************************************************************************/
+
+QString DasmExporter::listToDasmBytes(QList<int> list) {
+    QString out;
+    for (int i = 0; i < list.size(); ++i) {
+        if (i%8 == 0) {
+            if (i > 0) {
+                out.append("\n");
+            }
+            out.append("        dc.b ");
+        }
+        out = (out + "$%1").arg(list[i], 2, 16, QChar('0'));
+        if (i%8 != 7 && i != list.size() - 1) {
+            out.append(", ");
+        }
+    }
+    out.append("\n");
+    return out;
+}
+
+/*************************************************************************/
+
+bool DasmExporter::exportFlags() {
+    // Export flags
+    QString flagsString = readTemplate("tt_variables.asm");
+    if (flagsString == "") {
+        return false;
+    }
+    flagsString.replace("%%AUTHOR%%", pTrack->metaAuthor);
+    flagsString.replace("%%NAME%%", pTrack->metaName);
+    flagsString.replace("%%GLOBALSPEED%%", QString::number(pTrack->globalSpeed));
+    flagsString.replace("%%EVENSPEED%%", QString::number(pTrack->evenSpeed));
+    flagsString.replace("%%ODDSPEED%%", QString::number(pTrack->oddSpeed));
+    bool usesGoto = pTrack->usesGoto();
+    flagsString.replace("%%USEGOTO%%", (usesGoto ? "1" : "0"));
+    bool usesSlide = pTrack->usesSlide();
+    flagsString.replace("%%USESLIDE%%", (usesSlide ? "1" : "0"));
+    bool usesOverlay = pTrack->usesOverlay();
+    flagsString.replace("%%USEOVERLAY%%", (usesOverlay ? "1" : "0"));
+    bool usesFunk = pTrack->usesFunktempo();
+    flagsString.replace("%%USEFUNKTEMPO%%", (usesFunk ? "1" : "0"));
+    flagsString.replace("%%GLOBALSPEED%%", (pTrack->globalSpeed ? "1" : "0"));
+    bool startsWithHold = pTrack->startsWithHold();
+    flagsString.replace("%%STARTSWITHNOTES%%", (startsWithHold ? "0" : "1"));
+    flagsString.replace("%%INLINECALCINSINDEX%%", (variant.inlineCalcInsIndex ? "1" : "0"));
+    flagsString.replace("%%INLINEFETCHNOTE%%", (variant.inlineFetchNote ? "1" : "0"));
+    variablesString = flagsString;
+    return true;
+}
+
+/*************************************************************************/
+
+bool DasmExporter::exportTrackSpecifics() {
+    if (!exportFlags()) {
+        return false;
+    }
+
+    // Export track data
+    QString trackString = readTemplate("tt_trackdata.asm");
+    if (trackString == "") {
+        return false;
+    }
+    trackString.replace("%%AUTHOR%%", pTrack->metaAuthor);
+    trackString.replace("%%NAME%%", pTrack->metaName);
+    // Mapping of encountered to real, to weed out the unused
+    QMap<int, int> insMapping{};
+    int numInstruments = 0;
+    QList<int> insWaveforms;
+    QList<int> insADStarts;
+    QList<int> insSustainStarts;
+    QList<int> insReleaseStarts;
+    int insEnvelopeIndex = 0;
+    QString insString;
+    QMap<int, int> percMapping{};
+    int numPercussion = 0;
+    QList<int> percStarts;
+    int percEnvelopeIndex = 0;
+    QString percFreqString;
+    QString percCtrlVolString;
+    QMap<int, int> patternMapping{};
+    QString patternString;
+    QString patternPtrString;
+    QVector<QList<int>> sequence(2);
+    QList<int> patternSpeeds;
+    bool usesFunktempo = pTrack->usesFunktempo();
+    int numPatterns = 0;
+    for (int channel = 0; channel < 2; ++channel) {
+        int gotoOffset = 0;
+        for (int entry = 0; entry < pTrack->channelSequences[channel].sequence.size(); ++entry) {
+            int patternIndex = pTrack->channelSequences[channel].sequence[entry].patternIndex;
+            if (!patternMapping.contains(patternIndex)) {
+                // Pattern not encountered yet
+                patternMapping[patternIndex] = numPatterns;
+                numPatterns++;
+                // Write out pattern
+                patternString.append("; " + pTrack->patterns[patternIndex].name + "\n");
+                patternString.append("tt_pattern" + QString::number(patternMapping[patternIndex]) + ":\n");
+                // Loop over all notes
+                QList<int> patternValues;
+                for (int n = 0; n < pTrack->patterns[patternIndex].notes.size(); ++n) {
+                    Track::Note *note = &(pTrack->patterns[patternIndex].notes[n]);
+                    switch (note->type) {
+                    case Track::Note::instrumentType::Hold:
+                    {
+                        patternValues.append(int(Emulation::Player::NoteHold));
+                        break;
+                    }
+                    case Track::Note::instrumentType::Instrument:
+                    {
+                        if (!insMapping.contains(note->instrumentNumber)) {
+                            // Instrument not encountered yet
+                            insMapping[note->instrumentNumber] = numInstruments;
+                            Track::Instrument *ins = &(pTrack->instruments[note->instrumentNumber]);
+                            // insSize includes end marker that is not in vol/freq lists, so do -1
+                            int insSize = ins->calcEffectiveSize() - 1;
+                            QList<int> insEnvelopeValues;
+                            for (int i = 0; i < insSize; ++i) {
+                                int freqValue = ins->frequencies[i] + 8;
+                                int volValue = ins->volumes[i];
+                                insEnvelopeValues.append((freqValue<<4)|volValue);
+                            }
+                            // Insert dummy byte between sustain and release
+                            insEnvelopeValues.insert(ins->getReleaseStart(), 0);
+                            // Insert end marker
+                            insEnvelopeValues.append(0);
+                            // Insert indexes. Two times if PURE_COMBINED
+                            for (int i = 0; i < (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED ? 2 : 1); ++i) {
+                                insADStarts.append(insEnvelopeIndex);
+                                insSustainStarts.append(insEnvelopeIndex + ins->getSustainStart());
+                                // +1 for dummy byte, -1 because player expects that
+                                insReleaseStarts.append(insEnvelopeIndex + ins->getReleaseStart());
+                            }
+                            // Store waveform(s)
+                            if (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED) {
+                                insWaveforms.append(TiaSound::getDistortionInt(TiaSound::Distortion::PURE_HIGH));
+                                insWaveforms.append(TiaSound::getDistortionInt(TiaSound::Distortion::PURE_LOW));
+                            } else {
+                                insWaveforms.append(TiaSound::getDistortionInt(ins->baseDistortion));
+                            }
+                            // Write out instrument data
+                            insString.append("; " + QString::number(numInstruments));
+                            if (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED) {
+                                insString.append("+" + QString::number(numInstruments + 1));
+                            }
+                            insString.append(": " + ins->name + "\n");
+                            insString.append(listToDasmBytes(insEnvelopeValues));
+                            // Increase running instrument index
+                            numInstruments += (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED ? 2 : 1);
+                            // +1 for dummy byte, +1 for end marker
+                            insEnvelopeIndex += insSize + 2;
+                        }
+                        // +1 because first instrument number is 1
+                        int valueIns = insMapping[note->instrumentNumber] + 1;
+                        if (pTrack->instruments[note->instrumentNumber].baseDistortion == TiaSound::Distortion::PURE_COMBINED
+                                && note->value > 31) {
+                            valueIns++;
+                        }
+                        int valueFreq = (note->value)%32;
+                        patternValues.append((valueIns<<5)|valueFreq);
+                        break;
+                    }
+                    case Track::Note::instrumentType::Pause:
+                    {
+                        patternValues.append(int(Emulation::Player::NotePause));
+                        break;
+                    }
+                    case Track::Note::instrumentType::Percussion:
+                    {
+                        if (!percMapping.contains(note->instrumentNumber)) {
+                            // Percussion not encountered yet
+                            percMapping[note->instrumentNumber] = numPercussion;
+                            Track::Percussion *perc = &(pTrack->percussion[note->instrumentNumber]);
+                            // percSize includes end marker that is not in lists, so do -1
+                            int percSize = perc->calcEffectiveSize() - 1;
+                            QList<int> percFreqValues;
+                            QList<int> percCtrlVolValues;
+                            for (int i = 0; i < percSize; ++i) {
+                                int freqValue = perc->frequencies[i];
+                                if (perc->overlay && i == percSize - 1) {
+                                    freqValue += 128;
+                                }
+                                percFreqValues.append(freqValue);
+                                int ctrlValue = TiaSound::getDistortionInt(perc->waveforms[i]);
+                                int volValue = perc->volumes[i];
+                                percCtrlVolValues.append((ctrlValue<<4)|volValue);
+                            }
+                            // Insert end marker
+                            percFreqValues.append(0);
+                            percCtrlVolValues.append(0);
+                            // Insert index. +1 because player expects that
+                            percStarts.append(percEnvelopeIndex + 1);
+                            // Write out percussion data
+                            percFreqString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
+                            percFreqString.append(listToDasmBytes(percFreqValues));
+                            percCtrlVolString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
+                            percCtrlVolString.append(listToDasmBytes(percCtrlVolValues));
+                            // Increase running percussion index
+                            numPercussion++;
+                            // +1 for end marker
+                            percEnvelopeIndex += percSize + 1;
+                        }
+                        patternValues.append(percMapping[note->instrumentNumber] + Emulation::Player::NoteFirstPerc);
+                        break;
+                    }
+                    case Track::Note::instrumentType::Slide:
+                    {
+                        patternValues.append(Emulation::Player::NoteHold + note->value);
+                        break;
+                    }
+                    }
+                }
+                // Pattern end marker
+                patternValues.append(0);
+                patternString.append(listToDasmBytes(patternValues));
+                patternString.append("\n");
+                // Pattern speed, if local tempo
+                if (!pTrack->globalSpeed) {
+                    if (usesFunktempo) {
+                        int evenSpeed = pTrack->patterns[patternIndex].evenSpeed - 1;
+                        int oddSpeed = pTrack->patterns[patternIndex].oddSpeed - 1;
+                        patternSpeeds.append(evenSpeed*16 + oddSpeed);
+                    } else {
+                        patternSpeeds.append(pTrack->patterns[patternIndex].evenSpeed - 1);
+                    }
+                }
+                // Pattern ptr
+                if ((patternMapping.size())%4 == 1) {
+                    patternPtrString.append("        dc.b ");
+                } else {
+                    patternPtrString.append(", ");
+                }
+                patternPtrString.append("<tt_pattern" + QString::number(patternMapping[patternIndex]));
+                if ((patternMapping.size())%4 == 0) {
+                    patternPtrString.append("\n");
+                }
+            }
+            sequence[channel].append(patternMapping[patternIndex]);
+            int gotoTarget = pTrack->channelSequences[channel].sequence[entry].gotoTarget;
+            if (gotoTarget != -1) {
+                int value = 128 + gotoTarget + gotoOffset;
+                gotoOffset++;
+                if (channel == 1) {
+                    value += sequence[0].size();
+                }
+                if (value > 255) {
+                    errorMessage = "Unable to export: Goto target in channel " + QString::number(channel) + " is out of range (" + QString::number(value) + ")!";
+                    return false;
+                }
+                sequence[channel].append(value);
+            }
+        }
+    }
+    trackString.replace("%%INSFREQVOLTABLE%%", insString);
+    trackString.replace("%%INSCTRLTABLE%%", listToDasmBytes(insWaveforms));
+    trackString.replace("%%INSADINDEXES%%", listToDasmBytes(insADStarts));
+    trackString.replace("%%INSSUSTAININDEXES%%", listToDasmBytes(insSustainStarts));
+    trackString.replace("%%INSRELEASEINDEXES%%", listToDasmBytes(insReleaseStarts));
+    trackString.replace("%%PERCINDEXES%%", listToDasmBytes(percStarts));
+    trackString.replace("%%PERCFREQTABLE%%", percFreqString);
+    trackString.replace("%%PERCCTRLVOLTABLE%%", percCtrlVolString);
+    trackString.replace("%%SEQUENCECHANNEL0%%", listToDasmBytes(sequence[0]));
+    trackString.replace("%%SEQUENCECHANNEL1%%", listToDasmBytes(sequence[1]));
+    trackString.replace("%%PATTERNDEFS%%", patternString);
+    if (!pTrack->globalSpeed) {
+        trackString.replace("%%PATTERNSPEEDS%%", listToDasmBytes(patternSpeeds));
+    }
+    trackString.replace("%%PATTERNPTRLO%%", patternPtrString);
+    patternPtrString.replace("<", ">");
+    trackString.replace("%%PATTERNPTRHI%%", patternPtrString);
+
+    trackDataString = trackString;
+    sequenceSize[0] = sequence[0].size();
+    sequenceSize[1] = sequence[1].size();
+
+    // Export Init
+    initString = readTemplate("tt_init.asm");
+    if (initString == "") {
+        return false;
+    }
+    initString.replace("%%AUTHOR%%", pTrack->metaAuthor);
+    initString.replace("%%NAME%%", pTrack->metaName);
+    // Correct start values for any gotos before
+    int start0 = pTrack->startPatterns[0];
+    for (int i = 0; i <= start0; ++i) {
+        if (sequence[0][i] > 127) {
+            start0++;
+        }
+    }
+    initString.replace("%%C0INIT%%", QString::number(start0));
+    int start1 = pTrack->startPatterns[1];
+    for (int i = 0; i <= start1; ++i) {
+        if (sequence[1][i] > 127) {
+            start1++;
+        }
+    }
+    initString.replace("%%C1INIT%%", QString::number(start1 + sequence[0].size()));
+    return true;
+}
+
+/*************************************************************************/
+
+bool DasmExporter::exportPlayer() {
+    playerString = readTemplate("tt_player.asm");
+    if (playerString == "") {
+        return false;
+    }
+    playerString.replace("%%AUTHOR%%", pTrack->metaAuthor);
+    playerString.replace("%%NAME%%", pTrack->metaName);
+    return true;
+}
+
+/*************************************************************************/
+
+bool DasmExporter::exportHarness(const QString &baseName) {
+    harnessString = readTemplate("tt_harness.asm");
+    if (harnessString == "") {
+        return false;
+    }
+    harnessString.replace("%%AUTHOR%%", pTrack->metaAuthor);
+    harnessString.replace("%%NAME%%", pTrack->metaName);
+    harnessString.replace("%%FILENAME%%", baseName);
+    return true;
+}
+
+}
@@ -0,0 +1,73 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef DASMEXPORTER_H
+#define DASMEXPORTER_H
+
+#include <QString>
+#include <QList>
+
+#include "track/track.h"
+
+
+namespace Emulation {
+
+/* Fills the dasm player templates from player/dasm/ for a track.
+ * Works on strings only, so it can be used both for exporting files
+ * and for assembling the player in memory (see PlayerHarness).
+ */
+class DasmExporter
+{
+public:
+    static const QString templatePath;
+
+    /* Optional player code variants, see tt_player.asm. They don't
+     * change what the player plays, only its size and speed. */
+    struct Variant {
+        bool inlineCalcInsIndex;
+        bool inlineFetchNote;
+    };
+
+    explicit DasmExporter(Track::Track *track);
+
+    // Player variant used by exportFlags()
+    Variant variant{false, false};
+
+    /* Each method fills the corresponding string. Return false on
+     * error, see getErrorMessage(). */
+    bool exportFlags();
+    // Also does exportFlags()
+    bool exportTrackSpecifics();
+    bool exportPlayer();
+    /* Test harness that includes the exported files under the given
+     * base name, see tt_harness.asm */
+    bool exportHarness(const QString &baseName);
+
+    QString getErrorMessage() const;
+
+    static QString listToDasmBytes(QList<int> list);
+
+    QString variablesString;
+    QString trackDataString;
+    QString initString;
+    QString playerString;
+    QString harnessString;
+
+    /* Number of bytes per channel in tt_SequenceTable, including goto
+     * entries. Valid after exportTrackSpecifics(). */
+    int sequenceSize[2]{};
+
+private:
+    QString readTemplate(const QString &fileName);
+
+    Track::Track *pTrack = nullptr;
+    QString errorMessage;
+};
+
+}
+
+#endif // DASMEXPORTER_H
@@ -0,0 +1,90 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "envelopecache.h"
+
+#include <QMutexLocker>
+
+
+namespace Emulation {
+
+EnvelopeCache::EnvelopeCache()
+{
+}
+
+/*************************************************************************/
+
+EnvelopeCache::Envelope EnvelopeCache::get(Track::Instrument *instrument, int frequency) {
+    QMutexLocker locker(&mutex);
+
+    Entry &entry = entries[instrument];
+    if (entry.revision != instrument->getRevision()) {
+        numEnvelopes -= entry.envelopes.size();
+        entry.envelopes.clear();
+        entry.revision = instrument->getRevision();
+    }
+    QHash<int, Envelope>::const_iterator it = entry.envelopes.constFind(frequency);
+    if (it != entry.envelopes.constEnd()) {
+        return it.value();
+    }
+
+    Envelope envelope = resolve(instrument, frequency);
+    if (numEnvelopes >= MaxEnvelopes) {
+        // Instruments of closed tracks pile up otherwise
+        entries.clear();
+        numEnvelopes = 0;
+        entries[instrument].revision = envelope.revision;
+    }
+    entries[instrument].envelopes.insert(frequency, envelope);
+    numEnvelopes++;
+    return envelope;
+}
+
+/*************************************************************************/
+
+void EnvelopeCache::clear() {
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    numEnvelopes = 0;
+}
+
+/*************************************************************************/
+
+EnvelopeCache &EnvelopeCache::getShared() {
+    static EnvelopeCache sharedCache;
+    return sharedCache;
+}
+
+/*************************************************************************/
+
+EnvelopeCache::Envelope EnvelopeCache::resolve(Track::Instrument *instrument, int frequency) {
+    Envelope envelope;
+    envelope.instrument = instrument;
+    envelope.frequency = frequency;
+    envelope.revision = instrument->getRevision();
+    envelope.audC = instrument->getAudCValue(frequency);
+    envelope.sustainStart = instrument->getSustainStart();
+    envelope.releaseStart = instrument->getReleaseStart();
+
+    int length = instrument->getEnvelopeLength();
+    envelope.audF.resize(length);
+    envelope.audV.resize(length);
+    // PURE_COMBINED uses frequencies 32-63 for the low waveform
+    int realFrequency = frequency <= 31 ? frequency : frequency - 32;
+    for (int frame = 0; frame < length; ++frame) {
+        int FValue = realFrequency + instrument->frequencies[frame];
+        // Check if envelope has caused an underrun
+        if (FValue < 0) {
+            FValue = 256 + FValue;
+        }
+        envelope.audF[frame] = FValue;
+        envelope.audV[frame] = instrument->volumes[frame];
+    }
+    return envelope;
+}
+
+}
@@ -0,0 +1,79 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef ENVELOPECACHE_H
+#define ENVELOPECACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "track/instrument.h"
+
+
+namespace Emulation {
+
+/* Caches instrument envelopes fully resolved for a base frequency, i.e.
+ * with the AUDC value, the PURE_COMBINED frequency fold and the AUDF
+ * underrun wrap already applied, so playing a frame is a table lookup.
+ *
+ * Envelopes are rebuilt when the instrument's revision has changed, see
+ * Instrument::markChanged(). The cache is thread-safe and can be shared
+ * between the live player and offline renderers via getShared().
+ */
+class EnvelopeCache
+{
+public:
+    struct Envelope {
+        const Track::Instrument *instrument = nullptr;
+        int frequency = -1;
+        int revision = -1;
+
+        int audC = 0;
+        QVector<int> audF;
+        QVector<int> audV;
+        int sustainStart = 0;
+        int releaseStart = 0;
+
+        int getLength() const { return audV.size(); }
+        /* True if this is the current envelope of instrument at frequency */
+        bool isValidFor(const Track::Instrument *ins, int freq) const {
+            return instrument == ins && frequency == freq
+                    && revision == ins->getRevision();
+        }
+    };
+
+    /* Everything gets flushed when there are more envelopes than this */
+    static const int MaxEnvelopes = 4096;
+
+    EnvelopeCache();
+
+    /* Returns the resolved envelope, building it if necessary. The
+     * instrument must not be modified while this is running. */
+    Envelope get(Track::Instrument *instrument, int frequency);
+
+    void clear();
+
+    /* Instance shared by all players */
+    static EnvelopeCache &getShared();
+
+private:
+    struct Entry {
+        int revision = -1;
+        QHash<int, Envelope> envelopes;
+    };
+
+    static Envelope resolve(Track::Instrument *instrument, int frequency);
+
+    QMutex mutex;
+    QHash<const Track::Instrument *, Entry> entries;
+    int numEnvelopes = 0;
+};
+
+}
+
+#endif // ENVELOPECACHE_H
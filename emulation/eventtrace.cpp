@@ -0,0 +1,186 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "eventtrace.h"
+
+#include <QAtomicInteger>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+
+namespace Emulation {
+
+namespace {
+
+struct Event {
+    const char *category;
+    const char *name;
+    qint64 startMicros;
+    qint64 durationMicros;
+    int thread;
+};
+
+struct Slot {
+    // Index of the event plus 1 once it is complete, 0 while it is
+    // being written
+    QAtomicInteger<quint32> sequence{0};
+    Event event;
+};
+
+// Allocated when recording gets enabled for the first time, never freed
+// so late events of a disabled trace still have a place to go
+Slot *ring = nullptr;
+QAtomicInteger<quint32> writeIndex{0};
+
+QAtomicInt numThreads{0};
+thread_local int threadId = 0;
+thread_local bool isThreadNamed = false;
+
+QMutex threadNameMutex;
+QMap<int, QString> threadNames;
+
+int getThreadId() {
+    if (threadId == 0) {
+        threadId = numThreads.fetchAndAddRelaxed(1) + 1;
+    }
+    return threadId;
+}
+
+}
+
+QAtomicInt EventTrace::enabled{0};
+
+/*************************************************************************/
+
+void EventTrace::setEnabled(bool enable) {
+    if (enable && ring == nullptr) {
+        ring = new Slot[Capacity];
+    }
+    enabled.storeRelease(enable ? 1 : 0);
+}
+
+/*************************************************************************/
+
+bool EventTrace::isEnabled() {
+    return enabled.loadAcquire() != 0;
+}
+
+/*************************************************************************/
+
+void EventTrace::nameThread(const char *name) {
+    if (isThreadNamed) {
+        return;
+    }
+    isThreadNamed = true;
+    int thread = getThreadId();
+    QMutexLocker locker(&threadNameMutex);
+    threadNames[thread] = name;
+}
+
+/*************************************************************************/
+
+void EventTrace::record(const char *category, const char *name, qint64 startMicros, qint64 endMicros) {
+    if (enabled.loadAcquire() == 0) {
+        return;
+    }
+    quint32 index = writeIndex.fetchAndAddRelaxed(1);
+    Slot &slot = ring[index%Capacity];
+    slot.sequence.storeRelease(0);
+    slot.event = {category, name, startMicros, endMicros - startMicros, getThreadId()};
+    slot.sequence.storeRelease(index + 1);
+}
+
+/*************************************************************************/
+
+void EventTrace::clear() {
+    if (ring == nullptr) {
+        return;
+    }
+    for (int i = 0; i < Capacity; ++i) {
+        ring[i].sequence.storeRelease(0);
+    }
+}
+
+/*************************************************************************/
+
+bool EventTrace::writeJson(const QString &fileName) {
+    QFile saveFile(fileName);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    // Events still being written, or overwritten while copying, get
+    // skipped
+    QVector<Event> copies;
+    qint64 firstMicros = 0;
+    for (int i = 0; ring != nullptr && i < Capacity; ++i) {
+        const Slot &slot = ring[i];
+        quint32 sequence = slot.sequence.loadAcquire();
+        if (sequence == 0) {
+            continue;
+        }
+        Event event = slot.event;
+        if (slot.sequence.loadAcquire() != sequence) {
+            continue;
+        }
+        if (copies.isEmpty() || event.startMicros < firstMicros) {
+            firstMicros = event.startMicros;
+        }
+        copies.append(event);
+    }
+
+    QJsonArray events;
+    for (const Event &copy : copies) {
+        QJsonObject event;
+        event["cat"] = copy.category;
+        event["name"] = copy.name;
+        event["ph"] = "X";
+        // Start at 0 to keep the numbers short
+        event["ts"] = double(copy.startMicros - firstMicros);
+        event["dur"] = double(copy.durationMicros);
+        event["pid"] = 1;
+        event["tid"] = copy.thread;
+        events.append(event);
+    }
+
+    QJsonObject processName;
+    processName["name"] = "process_name";
+    processName["ph"] = "M";
+    processName["pid"] = 1;
+    QJsonObject processArgs;
+    processArgs["name"] = "TIATracker";
+    processName["args"] = processArgs;
+    events.append(processName);
+    threadNameMutex.lock();
+    QMap<int, QString> names = threadNames;
+    threadNameMutex.unlock();
+    for (auto it = names.constBegin(); it != names.constEnd(); ++it) {
+        QJsonObject threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = 1;
+        threadName["tid"] = it.key();
+        QJsonObject threadArgs;
+        threadArgs["name"] = it.value();
+        threadName["args"] = threadArgs;
+        events.append(threadName);
+    }
+
+    QJsonObject json;
+    json["traceEvents"] = events;
+    json["displayTimeUnit"] = "ms";
+    saveFile.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+}
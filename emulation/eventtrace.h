@@ -0,0 +1,80 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include <QAtomicInt>
+#include <QString>
+
+#include "monotonicclock.h"
+
+
+namespace Emulation {
+
+/* Records how long things take in which thread, e.g. player frames,
+ * audio callbacks and repaints, to see which thread stalls whom when
+ * the audio glitches. Events go into a lock-free ring that keeps the
+ * most recent Capacity of them, so recording can run all the time and
+ * be saved after a glitch. The file is in trace-event JSON format, for
+ * chrome://tracing or Perfetto.
+ *
+ * While recording is disabled, a Scope costs one atomic load.
+ */
+class EventTrace
+{
+public:
+    static const int Capacity = 1<<16;
+
+    /* Records the time from construction to destruction as one event.
+     * category and name are only stored as pointers, so they must be
+     * string literals. */
+    class Scope
+    {
+    public:
+        Scope(const char *category, const char *name) {
+            if (enabled.loadAcquire() != 0) {
+                this->category = category;
+                this->name = name;
+                startMicros = MonotonicClock::micros();
+            }
+        }
+        ~Scope() {
+            if (name != nullptr) {
+                record(category, name, startMicros, MonotonicClock::micros());
+            }
+        }
+
+    private:
+        const char *category = nullptr;
+        const char *name = nullptr;
+        qint64 startMicros = 0;
+    };
+
+    static void setEnabled(bool enable);
+    static bool isEnabled();
+
+    /* Names the calling thread in the trace. Only the first call per
+     * thread counts, so it is cheap to call repeatedly. */
+    static void nameThread(const char *name);
+
+    /* Records an event that has already ended */
+    static void record(const char *category, const char *name, qint64 startMicros, qint64 endMicros);
+
+    static void clear();
+
+    /* Writes the events in the ring. Returns false if the file can't
+     * be written. */
+    static bool writeJson(const QString &fileName);
+
+private:
+    static QAtomicInt enabled;
+};
+
+}
+
+#endif // EVENTTRACE_H
@@ -0,0 +1,67 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "frameclock.h"
+
+#include <cmath>
+
+
+namespace Emulation {
+
+FrameClock::FrameClock(int sampleRate, double frameRate)
+{
+    setRates(sampleRate, frameRate);
+}
+
+/*************************************************************************/
+
+void FrameClock::setRates(int newSampleRate, double newFrameRate) {
+    sampleRate = newSampleRate;
+    frameRate = newFrameRate;
+    frameRateMilli = quint64(qMax(1LL, std::llround(frameRate*1000.0)));
+    reset();
+}
+
+/*************************************************************************/
+
+void FrameClock::reset() {
+    frame = 0;
+}
+
+/*************************************************************************/
+
+int FrameClock::nextFrameSamples() {
+    quint64 start = frameStart(frame);
+    frame++;
+    return int(frameStart(frame) - start);
+}
+
+/*************************************************************************/
+
+int FrameClock::getSampleRate() const {
+    return sampleRate;
+}
+
+/*************************************************************************/
+
+double FrameClock::getFrameRate() const {
+    return frameRate;
+}
+
+/*************************************************************************/
+
+long FrameClock::getFrame() const {
+    return frame;
+}
+
+/*************************************************************************/
+
+quint64 FrameClock::frameStart(long n) const {
+    return quint64(n)*quint64(sampleRate)*1000/frameRateMilli;
+}
+
+}
@@ -0,0 +1,54 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <QtGlobal>
+
+
+namespace Emulation {
+
+/* Splits a sample stream into frames. Frame n starts at exactly
+ * floor(n*sampleRate/frameRate) samples, computed from the frame index
+ * with the frame rate rounded to 1/1000 Hz, so there is no drift over
+ * long songs. Live playback and offline rendering use this to apply
+ * register writes at identical positions.
+ */
+class FrameClock
+{
+public:
+    FrameClock(int sampleRate = 44100, double frameRate = 50.0);
+
+    /* Also resets the clock to frame 0 */
+    void setRates(int sampleRate, double frameRate);
+
+    void reset();
+
+    /* Returns the number of samples of the next frame and advances
+     * the clock to the frame after it */
+    int nextFrameSamples();
+
+    int getSampleRate() const;
+    double getFrameRate() const;
+    // Number of frames handed out since the last reset
+    long getFrame() const;
+
+private:
+    int sampleRate;
+    double frameRate;
+    // Frame rate in 1/1000 Hz
+    quint64 frameRateMilli;
+    long frame = 0;
+
+    // First sample of a frame
+    quint64 frameStart(long n) const;
+};
+
+}
+
+#endif // FRAMECLOCK_H
@@ -0,0 +1,169 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "inputlatencytracer.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include "monotonicclock.h"
+
+
+namespace Emulation {
+
+int InputLatencyTracer::Trace::getMicros(Stage from, Stage to) const {
+    if (stamps[from] == -1 || stamps[to] == -1) {
+        return -1;
+    }
+    return int(stamps[to] - stamps[from]);
+}
+
+/*************************************************************************/
+
+QString InputLatencyTracer::getStageName(Stage stage) {
+    switch (stage) {
+    case KeyPressed:
+        return "key pressed";
+    case Dispatched:
+        return "dispatched";
+    case PlayerReceived:
+        return "player received";
+    case FrameWritten:
+        return "frame written";
+    case FrameApplied:
+        return "frame applied";
+    case Audible:
+        return "audible";
+    default:
+        return "";
+    }
+}
+
+/*************************************************************************/
+
+void InputLatencyTracer::keyPressed() {
+    qint64 now = MonotonicClock::micros();
+    QMutexLocker locker(&mutex);
+    for (qint64 &stamp : current.stamps) {
+        stamp = -1;
+    }
+    current.stamps[KeyPressed] = now;
+    isInFlight = true;
+}
+
+/*************************************************************************/
+
+void InputLatencyTracer::mark(Stage stage) {
+    qint64 now = MonotonicClock::micros();
+    QMutexLocker locker(&mutex);
+    if (isInFlight && current.stamps[stage] == -1) {
+        current.stamps[stage] = now;
+    }
+}
+
+/*************************************************************************/
+
+qint64 InputLatencyTracer::getInputMicros() {
+    QMutexLocker locker(&mutex);
+    return isInFlight ? current.stamps[KeyPressed] : -1;
+}
+
+/*************************************************************************/
+
+void InputLatencyTracer::finish(qint64 inputMicros, qint64 appliedMicros, qint64 audibleMicros) {
+    QMutexLocker locker(&mutex);
+    if (!isInFlight || current.stamps[KeyPressed] != inputMicros) {
+        return;
+    }
+    current.stamps[FrameApplied] = appliedMicros;
+    current.stamps[Audible] = audibleMicros;
+    if (traces.size() == MaxTraces) {
+        traces.removeFirst();
+    }
+    traces.append(current);
+    isInFlight = false;
+}
+
+/*************************************************************************/
+
+QVector<InputLatencyTracer::Trace> InputLatencyTracer::getTraces() {
+    QMutexLocker locker(&mutex);
+    return traces;
+}
+
+/*************************************************************************/
+
+void InputLatencyTracer::clear() {
+    QMutexLocker locker(&mutex);
+    traces.clear();
+}
+
+/*************************************************************************/
+
+InputLatencyTracer::StageStats InputLatencyTracer::getStats(Stage from, Stage to) {
+    StageStats stats{0, 0, 0.0, 0};
+    for (const Trace &trace : getTraces()) {
+        int micros = trace.getMicros(from, to);
+        if (micros == -1) {
+            continue;
+        }
+        if (stats.count == 0 || micros < stats.minMicros) {
+            stats.minMicros = micros;
+        }
+        stats.maxMicros = qMax(stats.maxMicros, micros);
+        stats.averageMicros += micros;
+        stats.count++;
+    }
+    if (stats.count != 0) {
+        stats.averageMicros /= stats.count;
+    }
+    return stats;
+}
+
+/*************************************************************************/
+
+QVector<int> InputLatencyTracer::getHistogram() {
+    QVector<int> histogram(NumBuckets, 0);
+    for (const Trace &trace : getTraces()) {
+        int micros = trace.getMicros(KeyPressed, Audible);
+        if (micros != -1) {
+            histogram[qBound(0, micros/BucketMicros, NumBuckets - 1)]++;
+        }
+    }
+    return histogram;
+}
+
+/*************************************************************************/
+
+bool InputLatencyTracer::exportCsv(const QString &fileName) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QTextStream out(&file);
+    for (int stage = 0; stage < NumStages; ++stage) {
+        out << (stage == 0 ? "" : ", ") << getStageName(Stage(stage));
+    }
+    out << "\n";
+    for (const Trace &trace : getTraces()) {
+        for (int stage = 0; stage < NumStages; ++stage) {
+            out << (stage == 0 ? "" : ", ") << trace.getMicros(KeyPressed, Stage(stage));
+        }
+        out << "\n";
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+InputLatencyTracer &InputLatencyTracer::getShared() {
+    static InputLatencyTracer tracer;
+    return tracer;
+}
+
+}
@@ -0,0 +1,103 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef INPUTLATENCYTRACER_H
+#define INPUTLATENCYTRACER_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+
+namespace Emulation {
+
+/* Follows piano key presses on their way to the sound device, stamping
+ * the time at every stage: the key event, the handler in the main
+ * window, the player thread taking the note, the frame being written
+ * to the sink, the sink applying or rendering it and the estimated time
+ * it becomes audible. Finished traces are kept for statistics and for
+ * export.
+ *
+ * Only one press is in flight at a time; a new press replaces one that
+ * never reached the device, e.g. because no track was played. Presses
+ * are far apart compared to frames, so this doesn't lose real traces.
+ * All methods are thread-safe. Time stamps are from MonotonicClock.
+ */
+class InputLatencyTracer
+{
+public:
+    enum Stage {
+        KeyPressed, Dispatched, PlayerReceived, FrameWritten, FrameApplied, Audible,
+        NumStages
+    };
+
+    // Older traces get dropped
+    static const int MaxTraces = 1000;
+    // Histogram of the total latency
+    static const int BucketMicros = 5000;
+    // The last bucket also counts everything above
+    static const int NumBuckets = 20;
+
+    /* Time stamps of all stages, -1 if a stage has been skipped */
+    struct Trace {
+        qint64 stamps[NumStages];
+
+        /* Microseconds from one stage to a later one, -1 if unknown */
+        int getMicros(Stage from, Stage to) const;
+    };
+
+    /* Minimum, average and maximum time between two stages */
+    struct StageStats {
+        int count;
+        int minMicros;
+        double averageMicros;
+        int maxMicros;
+    };
+
+    static QString getStageName(Stage stage);
+
+    /* Starts a new trace at the current time */
+    void keyPressed();
+
+    /* Stamps a stage of the trace in flight with the current time,
+     * unless it has been stamped already */
+    void mark(Stage stage);
+
+    /* Key press time of the trace in flight, -1 if there is none */
+    qint64 getInputMicros();
+
+    /* Completes the trace of the press at inputMicros with the
+     * measurements of the sink. Nothing happens if the trace is not in
+     * flight anymore. */
+    void finish(qint64 inputMicros, qint64 appliedMicros, qint64 audibleMicros);
+
+    QVector<Trace> getTraces();
+    void clear();
+
+    /* Statistics over all finished traces */
+    StageStats getStats(Stage from, Stage to);
+    /* Number of traces per BucketMicros of the total latency */
+    QVector<int> getHistogram();
+
+    /* Writes all finished traces as CSV, with the stages in
+     * microseconds after the key press. Returns false if the file can't
+     * be written. */
+    bool exportCsv(const QString &fileName);
+
+    /* Instance shared by the GUI and the player */
+    static InputLatencyTracer &getShared();
+
+private:
+    QMutex mutex;
+    Trace current;
+    bool isInFlight = false;
+    QVector<Trace> traces;
+};
+
+}
+
+#endif // INPUTLATENCYTRACER_H
@@ -0,0 +1,427 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "instrumentfitter.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "voicedictionary.h"
+#include "wavfilesource.h"
+
+
+namespace Emulation {
+
+namespace {
+
+// Frames below this fraction of the loudest one count as silent
+const double SilenceLevel = 0.001;
+// Cost of every envelope frame relative to the mean squared norm of a
+// sample frame. Without it, the attack would cover the whole sample
+// instead of a sustain loop, and envelopes cost ROM.
+const double LengthCost = 0.02;
+
+struct Target {
+    int numFrames;
+    // Squared norms of the leveled and compressed bands
+    QVector<double> norms;
+    // Dot products of the compressed bands with every voice, indexed
+    // by (audc*numFrames + frame)*32 + audf
+    QVector<double> dots;
+
+    double getDot(int audc, int frame, int audf) const {
+        return dots[(audc*numFrames + frame)*32 + audf];
+    }
+};
+
+struct Candidate {
+    int audc;
+    int frequency;
+    // Sum of the distances of every frame fitted on its own, which no
+    // envelope can beat
+    double bound;
+    double distance;
+    // Distance plus the cost of the envelope length
+    double score;
+    int sustainStart;
+    int sustainLength;
+    // First sample frame of the release
+    int releaseFrame;
+};
+
+struct Fit {
+    int audf;
+    int volume;
+    double distance;
+};
+
+Target analyzeTarget(const VoiceDictionary &dictionary, const QVector<QVector<double>> &bands,
+                     double gain, const QVector<int> &audcs) {
+    Target target;
+    target.numFrames = bands.size();
+    target.norms.fill(0.0, target.numFrames);
+    target.dots.fill(0.0, 16*target.numFrames*32);
+    QVector<int> frames;
+    for (int frame = 0; frame < target.numFrames; ++frame) {
+        frames.append(frame);
+    }
+    Target *pTarget = &target;
+    QtConcurrent::blockingMap(frames, [&dictionary, &bands, gain, &audcs, pTarget](int &frame) {
+        QVector<double> compressed = bands[frame];
+        for (double &band : compressed) {
+            band *= gain;
+        }
+        BandAnalyzer::compress(compressed);
+        double norm = 0.0;
+        for (double band : compressed) {
+            norm += band*band;
+        }
+        pTarget->norms[frame] = norm;
+        for (int audc : audcs) {
+            for (int audf = 0; audf < 32; ++audf) {
+                const QVector<double> &voice = dictionary.getBands(audc, audf);
+                double dot = 0.0;
+                for (int band = 0; band < voice.size(); ++band) {
+                    dot += compressed[band]*voice[band];
+                }
+                pTarget->dots[(audc*pTarget->numFrames + frame)*32 + audf] = dot;
+            }
+        }
+    });
+    return target;
+}
+
+/*************************************************************************/
+
+/* Best frequency offset and volume for a group of frames of the sample
+ * that share one envelope frame: every loop-th frame from first up to
+ * and including last */
+Fit fitFrames(const VoiceDictionary &dictionary, const Target &target, int audc, int frequency,
+              int first, int last, int loop, double *exactVolume = nullptr) {
+    double norm = 0.0;
+    int count = 0;
+    for (int frame = first; frame <= last; frame += loop) {
+        norm += target.norms[frame];
+        count++;
+    }
+    Fit best{frequency, 0, norm};
+    if (exactVolume != nullptr) {
+        *exactVolume = 0.0;
+    }
+    for (int audf = qMax(0, frequency - 8); audf <= qMin(31, frequency + 7); ++audf) {
+        double dot = 0.0;
+        for (int frame = first; frame <= last; frame += loop) {
+            dot += target.getDot(audc, frame, audf);
+        }
+        int volume;
+        double exact;
+        double distance = VoiceDictionary::fitVolume(dot, norm, dictionary.getSquaredNorm(audc, audf),
+                                                     count, &volume, &exact);
+        if (distance < best.distance) {
+            best = {audf, volume, distance};
+            if (exactVolume != nullptr) {
+                *exactVolume = exact;
+            }
+        }
+    }
+    return best;
+}
+
+/*************************************************************************/
+
+void searchStructure(const VoiceDictionary &dictionary, const Target &target, Candidate &candidate) {
+    int numFrames = target.numFrames;
+    int audc = candidate.audc;
+    int frequency = candidate.frequency;
+    QVector<double> single(numFrames);
+    QVector<double> prefix(numFrames + 1, 0.0);
+    for (int frame = 0; frame < numFrames; ++frame) {
+        single[frame] = fitFrames(dictionary, target, audc, frequency, frame, frame, 1).distance;
+        prefix[frame + 1] = prefix[frame] + single[frame];
+    }
+    int lowAudf = qMax(0, frequency - 8);
+    int highAudf = qMin(31, frequency + 7);
+    int numAudfs = highAudf - lowAudf + 1;
+
+    double totalNorm = 0.0;
+    for (double norm : target.norms) {
+        totalNorm += norm;
+    }
+    double frameCost = LengthCost*totalNorm/numFrames;
+    candidate.score = std::numeric_limits<double>::max();
+    for (int loop = 1; loop <= InstrumentFitter::MaxSustainLength; ++loop) {
+        // Sums over every loop-th frame, so a loop frame's group of
+        // sample frames is a difference of two entries
+        QVector<double> dotSums(numFrames*numAudfs);
+        QVector<double> normSums(numFrames);
+        for (int frame = 0; frame < numFrames; ++frame) {
+            for (int i = 0; i < numAudfs; ++i) {
+                dotSums[frame*numAudfs + i] = target.getDot(audc, frame, lowAudf + i)
+                        + (frame >= loop ? dotSums[(frame - loop)*numAudfs + i] : 0.0);
+            }
+            normSums[frame] = target.norms[frame] + (frame >= loop ? normSums[frame - loop] : 0.0);
+        }
+
+        // At least one frame of release
+        for (int start = 0; start + loop < numFrames; ++start) {
+            QVector<double> loopDistances(loop);
+            double loopDistance = 0.0;
+            for (int j = 0; j < loop; ++j) {
+                loopDistances[j] = single[start + j];
+                loopDistance += loopDistances[j];
+            }
+            for (int release = start + loop; release < numFrames; ++release) {
+                if (release > start + loop) {
+                    // Sample frame release - 1 joins its loop frame
+                    int last = release - 1;
+                    int j = (last - start)%loop;
+                    int first = start + j;
+                    int count = (last - first)/loop + 1;
+                    double norm = normSums[last] - (first >= loop ? normSums[first - loop] : 0.0);
+                    double best = norm;
+                    for (int i = 0; i < numAudfs; ++i) {
+                        double dot = dotSums[last*numAudfs + i]
+                                - (first >= loop ? dotSums[(first - loop)*numAudfs + i] : 0.0);
+                        int volume;
+                        best = qMin(best, VoiceDictionary::fitVolume(
+                                        dot, norm, dictionary.getSquaredNorm(audc, lowAudf + i),
+                                        count, &volume));
+                    }
+                    loopDistance += best - loopDistances[j];
+                    loopDistances[j] = best;
+                }
+                int length = start + loop + numFrames - release;
+                if (length > Track::Instrument::maxEnvelopeLength) {
+                    continue;
+                }
+                double distance = prefix[start] + loopDistance + prefix[numFrames] - prefix[release];
+                double score = distance + frameCost*length;
+                if (score < candidate.score) {
+                    candidate.score = score;
+                    candidate.distance = distance;
+                    candidate.sustainStart = start;
+                    candidate.sustainLength = loop;
+                    candidate.releaseFrame = release;
+                }
+            }
+        }
+    }
+}
+
+}
+
+/*************************************************************************/
+
+InstrumentFitter::InstrumentFitter(TiaSound::TvStandard standard, const QList<TiaSound::Distortion> &waveforms) :
+    frameRate(standard == TiaSound::TvStandard::PAL ? 50 : 60)
+{
+    for (TiaSound::Distortion waveform : waveforms) {
+        if (waveform == TiaSound::Distortion::PURE_COMBINED) {
+            audcs.append(TiaSound::getDistortionInt(TiaSound::Distortion::PURE_HIGH));
+            audcs.append(TiaSound::getDistortionInt(TiaSound::Distortion::PURE_LOW));
+        } else if (waveform != TiaSound::Distortion::SILENT) {
+            audcs.append(TiaSound::getDistortionInt(waveform));
+        }
+    }
+    std::sort(audcs.begin(), audcs.end());
+    audcs.erase(std::unique(audcs.begin(), audcs.end()), audcs.end());
+}
+
+/*************************************************************************/
+
+bool InstrumentFitter::fit(const QString &fileName) {
+    WavFileSource source(fileName);
+    if (!source.load()) {
+        errorMessage = source.getErrorMessage();
+        return false;
+    }
+    if (source.getSamples().isEmpty()) {
+        errorMessage = fileName + " contains no samples!";
+        return false;
+    }
+    fit(source.getSamples(), source.getSampleRate());
+    return true;
+}
+
+/*************************************************************************/
+
+void InstrumentFitter::fit(const QVector<double> &samples, int sampleRate) {
+    int frameLength = qMax(1, int(std::round(double(sampleRate)/frameRate)));
+    QSharedPointer<const VoiceDictionary> dictionary = VoiceDictionary::get(sampleRate, frameLength);
+    const VoiceDictionary *pDictionary = dictionary.data();
+    QVector<QVector<double>> bands = dictionary->getAnalyzer().analyzeFrames(samples, MaxFrames);
+
+    // Cut the silence at the end except for one frame, but leave room
+    // for a release
+    QVector<double> levels;
+    double maxLevel = 0.0;
+    for (const QVector<double> &frameBands : bands) {
+        double level = 0.0;
+        for (double band : frameBands) {
+            level += band*band;
+        }
+        levels.append(std::sqrt(level));
+        maxLevel = qMax(maxLevel, levels.last());
+    }
+    int numFrames = bands.size();
+    while (numFrames > 2 && levels[numFrames - 2] <= SilenceLevel*maxLevel) {
+        numFrames--;
+    }
+    bands.resize(qMax(2, numFrames));
+    for (QVector<double> &frameBands : bands) {
+        if (frameBands.isEmpty()) {
+            frameBands.fill(0.0, BandAnalyzer::NumBands);
+        }
+    }
+
+    QVector<Candidate> candidates;
+    for (int audc : audcs) {
+        for (int freq = 0; freq < 32; ++freq) {
+            candidates.append({audc, freq, 0.0, 0.0, 0.0, 0, 1, 1});
+        }
+    }
+    auto computeBounds = [pDictionary, &candidates](const Target &target) {
+        QtConcurrent::blockingMap(candidates, [pDictionary, &target](Candidate &candidate) {
+            candidate.bound = 0.0;
+            for (int frame = 0; frame < target.numFrames; ++frame) {
+                candidate.bound += fitFrames(*pDictionary, target, candidate.audc, candidate.frequency,
+                                             frame, frame, 1).distance;
+            }
+        });
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+            return a.bound < b.bound;
+        });
+    };
+
+    // Start with the loudest frame at the level of a typical voice, then
+    // rescale so the best candidate makes full use of the volume range
+    double gain = dictionary->getLevelingGain(bands);
+    Target target = analyzeTarget(*dictionary, bands, gain, audcs);
+    computeBounds(target);
+    double maxVolume = 0.0;
+    for (int frame = 0; frame < target.numFrames; ++frame) {
+        double exactVolume;
+        fitFrames(*dictionary, target, candidates[0].audc, candidates[0].frequency, frame, frame, 1, &exactVolume);
+        maxVolume = qMax(maxVolume, exactVolume);
+    }
+    if (maxVolume > 0.0) {
+        gain *= 15.0/maxVolume;
+        target = analyzeTarget(*dictionary, bands, gain, audcs);
+        computeBounds(target);
+    }
+
+    // Search envelope structures of the beam in parallel
+    QVector<Candidate> beam = candidates.mid(0, BeamWidth);
+    const Target *pTarget = &target;
+    QtConcurrent::blockingMap(beam, [pDictionary, pTarget](Candidate &candidate) {
+        searchStructure(*pDictionary, *pTarget, candidate);
+    });
+    Candidate best = beam[0];
+    for (const Candidate &candidate : beam) {
+        if (candidate.score < best.score) {
+            best = candidate;
+        }
+    }
+
+    // Build the envelopes of the winner
+    distortion = TiaSound::distortions[best.audc];
+    sustainStart = best.sustainStart;
+    releaseStart = best.sustainStart + best.sustainLength;
+    QVector<Fit> envelope;
+    for (int frame = 0; frame < best.sustainStart; ++frame) {
+        envelope.append(fitFrames(*dictionary, target, best.audc, best.frequency, frame, frame, 1));
+    }
+    for (int j = 0; j < best.sustainLength; ++j) {
+        int first = best.sustainStart + j;
+        int last = first + (best.releaseFrame - 1 - first)/best.sustainLength*best.sustainLength;
+        envelope.append(fitFrames(*dictionary, target, best.audc, best.frequency, first, last, best.sustainLength));
+    }
+    for (int frame = best.releaseFrame; frame < target.numFrames; ++frame) {
+        envelope.append(fitFrames(*dictionary, target, best.audc, best.frequency, frame, frame, 1));
+    }
+    // Candidates only differ in the range of frequencies they can reach,
+    // so play at the one the loudest frames use most
+    QVector<int> usage(32, 0);
+    for (const Fit &fit : envelope) {
+        usage[fit.audf] += fit.volume;
+    }
+    int minAudf = 31;
+    int maxAudf = 0;
+    for (const Fit &fit : envelope) {
+        if (fit.volume > 0) {
+            minAudf = qMin(minAudf, fit.audf);
+            maxAudf = qMax(maxAudf, fit.audf);
+        }
+    }
+    // All offsets have to stay within -8..7
+    frequency = best.frequency;
+    int maxUsage = 0;
+    for (int audf = qMax(0, maxAudf - 7); audf <= qMin(31, minAudf + 8); ++audf) {
+        if (usage[audf] > maxUsage) {
+            maxUsage = usage[audf];
+            frequency = audf;
+        }
+    }
+    volumes.clear();
+    frequencies.clear();
+    for (const Fit &fit : envelope) {
+        volumes.append(fit.volume);
+        // Silent frames keep the offset of the previous one
+        int offset = fit.audf - frequency;
+        if (fit.volume == 0) {
+            offset = frequencies.isEmpty() ? 0 : frequencies.last();
+        }
+        frequencies.append(offset);
+    }
+
+    double totalNorm = 0.0;
+    for (double norm : target.norms) {
+        totalNorm += norm;
+    }
+    relativeError = totalNorm > 0.0 ? best.distance/totalNorm : 0.0;
+}
+
+/*************************************************************************/
+
+TiaSound::Distortion InstrumentFitter::getDistortion() const {
+    return distortion;
+}
+
+/*************************************************************************/
+
+int InstrumentFitter::getFrequency() const {
+    return frequency;
+}
+
+/*************************************************************************/
+
+double InstrumentFitter::getRelativeError() const {
+    return relativeError;
+}
+
+/*************************************************************************/
+
+void InstrumentFitter::apply(Track::Instrument *instrument) const {
+    if (volumes.size() < 2) {
+        return;
+    }
+    instrument->baseDistortion = distortion;
+    instrument->volumes = volumes;
+    instrument->frequencies = frequencies;
+    instrument->setEnvelopeLength(volumes.size());
+    instrument->setSustainAndRelease(sustainStart, releaseStart);
+}
+
+/*************************************************************************/
+
+QString InstrumentFitter::getErrorMessage() const {
+    return errorMessage;
+}
+
+}
@@ -0,0 +1,83 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef INSTRUMENTFITTER_H
+#define INSTRUMENTFITTER_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "tiasound/tiasound.h"
+#include "track/instrument.h"
+
+
+namespace Emulation {
+
+/* Converts a sampled note into an instrument: a distortion, the
+ * frequency the sample plays at, and volume and frequency envelopes
+ * with a sustain loop and a release.
+ *
+ * The sample is cut into TV frames and compared with the compressed
+ * band spectra of a VoiceDictionary. The envelope plays the attack
+ * frame by frame, repeats the sustain loop until the note is released
+ * and then plays the release, so the search is over the distortion, the
+ * base frequency, the sustain start, the loop length and the release
+ * frame. Volumes and frequency offsets of every envelope frame follow
+ * from these.
+ *
+ * Fitting every single frame on its own gives a lower bound for each
+ * distortion and base frequency. Only the best of them by this bound
+ * form the beam whose envelope structures get searched, in parallel.
+ */
+class InstrumentFitter
+{
+public:
+    static const int BeamWidth = 8;
+    static const int MaxSustainLength = 8;
+    // Longer samples are cut, since the loop covers the held part
+    static const int MaxFrames = 300;
+
+    /* waveforms are the ones to choose from. PURE_COMBINED is fitted
+     * as PURE_HIGH and PURE_LOW. */
+    InstrumentFitter(TiaSound::TvStandard standard, const QList<TiaSound::Distortion> &waveforms);
+
+    /* Returns false if the file can't be read, see getErrorMessage() */
+    bool fit(const QString &fileName);
+    void fit(const QVector<double> &samples, int sampleRate);
+
+    TiaSound::Distortion getDistortion() const;
+    /* Frequency the instrument has to be played at to sound like the
+     * sample */
+    int getFrequency() const;
+
+    /* Remaining distance relative to the sample, 0 being a perfect match */
+    double getRelativeError() const;
+
+    /* Replaces the envelopes and the waveform of an instrument with the
+     * fitted ones */
+    void apply(Track::Instrument *instrument) const;
+
+    QString getErrorMessage() const;
+
+private:
+    QVector<int> audcs;
+    int frameRate;
+
+    TiaSound::Distortion distortion = TiaSound::Distortion::PURE_HIGH;
+    int frequency = 0;
+    QList<int> volumes;
+    QList<int> frequencies;
+    int sustainStart = 0;
+    int releaseStart = 1;
+    double relativeError = 0.0;
+    QString errorMessage;
+};
+
+}
+
+#endif // INSTRUMENTFITTER_H
@@ -0,0 +1,29 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+
+
+namespace Emulation {
+
+/* Time stamps that can be compared across threads, e.g. a key press in
+ * the GUI thread and the audio callback playing the note. Unlike the
+ * wall-clock time, it never jumps.
+ */
+class MonotonicClock
+{
+public:
+    /* Microseconds since an arbitrary, fixed point in time */
+    static qint64 micros();
+};
+
+}
+
+#endif // MONOTONICCLOCK_H
@@ -0,0 +1,92 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "pcmring.h"
+
+#include <cstring>
+
+
+namespace Emulation {
+
+PcmRing::PcmRing(int capacity)
+{
+    resize(capacity);
+}
+
+/*************************************************************************/
+
+void PcmRing::resize(int capacity) {
+    int size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+    buffer.fill(0, size);
+    data = buffer.data();
+    mask = quint32(size - 1);
+    clear();
+}
+
+/*************************************************************************/
+
+void PcmRing::clear() {
+    readPos.storeRelease(0);
+    writePos.storeRelease(0);
+}
+
+/*************************************************************************/
+
+int PcmRing::write(const qint16 *samples, int count) {
+    quint32 write = writePos.load();
+    quint32 used = write - readPos.loadAcquire();
+    int free = buffer.size() - int(used);
+    count = qMin(count, free);
+    // In at most two parts, at the end and at the start of the buffer
+    int start = int(write & mask);
+    int first = qMin(count, buffer.size() - start);
+    std::memcpy(data + start, samples, size_t(first)*sizeof(qint16));
+    std::memcpy(data, samples + first, size_t(count - first)*sizeof(qint16));
+    writePos.storeRelease(write + quint32(count));
+    return count;
+}
+
+/*************************************************************************/
+
+int PcmRing::read(qint16 *dest, int count) {
+    quint32 read = readPos.load();
+    int available = int(writePos.loadAcquire() - read);
+    count = qMin(count, available);
+    int start = int(read & mask);
+    int first = qMin(count, buffer.size() - start);
+    std::memcpy(dest, data + start, size_t(first)*sizeof(qint16));
+    std::memcpy(dest + first, data, size_t(count - first)*sizeof(qint16));
+    readPos.storeRelease(read + quint32(count));
+    return count;
+}
+
+/*************************************************************************/
+
+int PcmRing::skip(int count) {
+    quint32 read = readPos.load();
+    int available = int(writePos.loadAcquire() - read);
+    count = qMin(count, available);
+    readPos.storeRelease(read + quint32(count));
+    return count;
+}
+
+/*************************************************************************/
+
+int PcmRing::getNumAvailable() const {
+    return int(writePos.loadAcquire() - readPos.loadAcquire());
+}
+
+/*************************************************************************/
+
+int PcmRing::getCapacity() const {
+    return buffer.size();
+}
+
+}
@@ -0,0 +1,54 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PCMRING_H
+#define PCMRING_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+
+namespace Emulation {
+
+/* Lock-free ring of 16 bit samples for exactly one producer and one
+ * consumer thread, e.g. the player thread rendering ahead and the audio
+ * callback copying out.
+ */
+class PcmRing
+{
+public:
+    /* Capacity gets rounded up to a power of two */
+    explicit PcmRing(int capacity = 0);
+
+    /* Not thread-safe; both sides must be stopped */
+    void resize(int capacity);
+    void clear();
+
+    /* Producer side. Returns the number of samples written, which is
+     * less than count if the ring is full. */
+    int write(const qint16 *samples, int count);
+
+    /* Consumer side. Return the number of samples read or skipped. */
+    int read(qint16 *dest, int count);
+    int skip(int count);
+
+    int getNumAvailable() const;
+    int getCapacity() const;
+
+private:
+    QVector<qint16> buffer;
+    // Raw pointer into buffer, so the threads never make it detach
+    qint16 *data = nullptr;
+    quint32 mask = 0;
+    // Free-running positions, only masked for indexing
+    QAtomicInteger<quint32> readPos{0};
+    QAtomicInteger<quint32> writePos{0};
+};
+
+}
+
+#endif // PCMRING_H
@@ -0,0 +1,217 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "percussionfitter.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+#include "voicedictionary.h"
+#include "wavfilesource.h"
+
+
+namespace Emulation {
+
+namespace {
+
+struct Candidate {
+    int audc;
+    int audf;
+    double dot;
+    double bound;
+};
+
+struct Work {
+    // Uncompressed band amplitudes of the sample
+    QVector<double> bands;
+    // Squared norm of the leveled and compressed bands
+    double norm;
+    // Best volume of the best match if it could be any real number
+    double exactVolume;
+    PercussionFitter::Frame frame;
+};
+
+void fitFrame(const VoiceDictionary &dictionary, const QVector<int> &audcs, double gain, Work &w) {
+    QVector<double> target = w.bands;
+    for (double &band : target) {
+        band *= gain;
+    }
+    BandAnalyzer::compress(target);
+    w.norm = 0.0;
+    for (double band : target) {
+        w.norm += band*band;
+    }
+
+    // Silence is always possible
+    w.frame = {TiaSound::Distortion::SILENT, 0, 0, w.norm};
+    w.exactVolume = 0.0;
+
+    // Distance at the continuous best volume is a lower bound
+    QVector<Candidate> candidates;
+    for (int audc : audcs) {
+        for (int audf = 0; audf < 32; ++audf) {
+            double norm = dictionary.getSquaredNorm(audc, audf);
+            if (norm <= 0.0) {
+                continue;
+            }
+            const QVector<double> &bands = dictionary.getBands(audc, audf);
+            double dot = 0.0;
+            for (int band = 0; band < bands.size(); ++band) {
+                dot += target[band]*bands[band];
+            }
+            if (dot > 0.0) {
+                candidates.append({audc, audf, dot, w.norm - dot*dot/norm});
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.bound < b.bound;
+    });
+
+    for (const Candidate &candidate : candidates) {
+        if (candidate.bound >= w.frame.distance) {
+            break;
+        }
+        int volume;
+        double exactVolume;
+        double distance = VoiceDictionary::fitVolume(candidate.dot, w.norm,
+                                                     dictionary.getSquaredNorm(candidate.audc, candidate.audf),
+                                                     1, &volume, &exactVolume);
+        if (distance < w.frame.distance) {
+            w.frame = {TiaSound::distortions[candidate.audc], candidate.audf, volume, distance};
+            w.exactVolume = exactVolume;
+        }
+    }
+}
+
+}
+
+/*************************************************************************/
+
+PercussionFitter::PercussionFitter(TiaSound::TvStandard standard, const QList<TiaSound::Distortion> &waveforms) :
+    frameRate(standard == TiaSound::TvStandard::PAL ? 50 : 60)
+{
+    for (TiaSound::Distortion waveform : waveforms) {
+        if (waveform != TiaSound::Distortion::SILENT) {
+            audcs.append(TiaSound::getDistortionInt(waveform));
+        }
+    }
+}
+
+/*************************************************************************/
+
+bool PercussionFitter::fit(const QString &fileName) {
+    WavFileSource source(fileName);
+    if (!source.load()) {
+        errorMessage = source.getErrorMessage();
+        return false;
+    }
+    if (source.getSamples().isEmpty()) {
+        errorMessage = fileName + " contains no samples!";
+        return false;
+    }
+    fit(source.getSamples(), source.getSampleRate());
+    return true;
+}
+
+/*************************************************************************/
+
+void PercussionFitter::fit(const QVector<double> &samples, int sampleRate) {
+    int frameLength = qMax(1, int(std::round(double(sampleRate)/frameRate)));
+    QSharedPointer<const VoiceDictionary> dictionary = VoiceDictionary::get(sampleRate, frameLength);
+    const BandAnalyzer &analyzer = dictionary->getAnalyzer();
+
+    QVector<QVector<double>> bands = analyzer.analyzeFrames(samples, Track::Percussion::maxEnvelopeLength);
+    QVector<Work> work(bands.size());
+    for (int i = 0; i < bands.size(); ++i) {
+        work[i].bands = bands[i];
+    }
+
+    // Start with the loudest frame at the level of a typical voice
+    double gain = dictionary->getLevelingGain(bands);
+    const VoiceDictionary *pDictionary = dictionary.data();
+    const QVector<int> &audcList = audcs;
+    QtConcurrent::blockingMap(work, [pDictionary, &audcList, &gain](Work &w) {
+        fitFrame(*pDictionary, audcList, gain, w);
+    });
+
+    // Volume is proportional to the gain, so rescale to make full use
+    // of the volume range and fit again
+    double maxVolume = 0.0;
+    for (const Work &w : work) {
+        maxVolume = qMax(maxVolume, w.exactVolume);
+    }
+    if (maxVolume > 0.0) {
+        gain *= 15.0/maxVolume;
+        QtConcurrent::blockingMap(work, [pDictionary, &audcList, &gain](Work &w) {
+            fitFrame(*pDictionary, audcList, gain, w);
+        });
+    }
+
+    frames.clear();
+    double totalDistance = 0.0;
+    double totalNorm = 0.0;
+    for (const Work &w : work) {
+        frames.append(w.frame);
+        totalDistance += w.frame.distance;
+        totalNorm += w.norm;
+    }
+    relativeError = totalNorm > 0.0 ? totalDistance/totalNorm : 0.0;
+
+    // Silent frames keep the sound of the previous one, which is
+    // easier to edit
+    for (int i = 0; i < frames.size(); ++i) {
+        if (frames[i].volume == 0) {
+            frames[i].waveform = i > 0 ? frames[i - 1].waveform : TiaSound::Distortion::WHITE_NOISE;
+            frames[i].frequency = i > 0 ? frames[i - 1].frequency : 0;
+        }
+    }
+    // Keep one silent frame after the last audible one
+    int length = frames.size();
+    while (length > 1 && frames[length - 1].volume == 0 && frames[length - 2].volume == 0) {
+        length--;
+    }
+    frames.resize(length);
+}
+
+/*************************************************************************/
+
+const QVector<PercussionFitter::Frame> &PercussionFitter::getFrames() const {
+    return frames;
+}
+
+/*************************************************************************/
+
+double PercussionFitter::getRelativeError() const {
+    return relativeError;
+}
+
+/*************************************************************************/
+
+void PercussionFitter::apply(Track::Percussion *percussion) const {
+    if (frames.isEmpty()) {
+        return;
+    }
+    percussion->volumes.clear();
+    percussion->frequencies.clear();
+    percussion->waveforms.clear();
+    for (const Frame &frame : frames) {
+        percussion->volumes.append(frame.volume);
+        percussion->frequencies.append(frame.frequency);
+        percussion->waveforms.append(frame.waveform);
+    }
+    percussion->setEnvelopeLength(frames.size());
+}
+
+/*************************************************************************/
+
+QString PercussionFitter::getErrorMessage() const {
+    return errorMessage;
+}
+
+}
@@ -0,0 +1,70 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PERCUSSIONFITTER_H
+#define PERCUSSIONFITTER_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "tiasound/tiasound.h"
+#include "track/percussion.h"
+
+
+namespace Emulation {
+
+/* Converts a sampled drum hit into a percussion envelope. The sample is
+ * cut into TV frames, and every frame gets the waveform, frequency and
+ * volume whose TIA output has the closest compressed band spectrum.
+ *
+ * Spectra of all waveforms and frequencies come from a VoiceDictionary.
+ * Bands scale with the volume, so for each of them the best volume
+ * follows in closed form, and the distance at the continuous optimum is
+ * a lower bound that prunes most candidates before scoring integer
+ * volumes. Frames are fitted in parallel.
+ */
+class PercussionFitter
+{
+public:
+    struct Frame {
+        TiaSound::Distortion waveform;
+        int frequency;
+        int volume;
+        // Squared distance of the compressed band spectra
+        double distance;
+    };
+
+    /* waveforms are the ones to choose from */
+    PercussionFitter(TiaSound::TvStandard standard, const QList<TiaSound::Distortion> &waveforms);
+
+    /* Returns false if the file can't be read, see getErrorMessage() */
+    bool fit(const QString &fileName);
+    void fit(const QVector<double> &samples, int sampleRate);
+
+    /* Fitted frames, without trailing silence except for one frame */
+    const QVector<Frame> &getFrames() const;
+
+    /* Remaining distance relative to the sample, 0 being a perfect match */
+    double getRelativeError() const;
+
+    /* Replaces the envelope of a percussion with the fitted one */
+    void apply(Track::Percussion *percussion) const;
+
+    QString getErrorMessage() const;
+
+private:
+    QVector<int> audcs;
+    int frameRate;
+    QVector<Frame> frames;
+    double relativeError = 0.0;
+    QString errorMessage;
+};
+
+}
+
+#endif // PERCUSSIONFITTER_H
@@ -0,0 +1,214 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "pitchmeasurement.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <cmath>
+
+#include "TIASnd.h"
+#include "spectrum.h"
+#include "tiasound/pitchguidefactory.h"
+
+
+namespace Emulation {
+
+PitchMeasurement::PitchMeasurement()
+{
+    periods.fill(0.0, 16*32);
+}
+
+/*************************************************************************/
+
+void PitchMeasurement::measure() {
+    QVector<int> combinations;
+    for (int i = 0; i < 16*32; ++i) {
+        combinations.append(i);
+    }
+    QVector<double> *pPeriods = &periods;
+    QtConcurrent::blockingMap(combinations, [pPeriods](int &combination) {
+        (*pPeriods)[combination] = measurePeriod(combination/32, combination%32);
+    });
+}
+
+/*************************************************************************/
+
+bool PitchMeasurement::load(const QString &fileName) {
+    QFile loadFile(fileName);
+    if (!loadFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject json = QJsonDocument::fromJson(loadFile.readAll()).object();
+    QJsonArray periodArray = json["periods"].toArray();
+    if (json["version"].toInt() != Version
+            || json["numSamples"].toInt() != NumSamples
+            || periodArray.size() != periods.size()) {
+        return false;
+    }
+    for (int i = 0; i < periods.size(); ++i) {
+        periods[i] = periodArray[i].toDouble();
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+bool PitchMeasurement::save(const QString &fileName) const {
+    QDir().mkpath(QFileInfo(fileName).path());
+    QFile saveFile(fileName);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QJsonArray periodArray;
+    for (double period : periods) {
+        periodArray.append(period);
+    }
+    QJsonObject json;
+    json["version"] = Version;
+    json["numSamples"] = NumSamples;
+    json["periods"] = periodArray;
+    saveFile.write(QJsonDocument(json).toJson());
+    return true;
+}
+
+/*************************************************************************/
+
+double PitchMeasurement::getPeriod(int audc, int audf) const {
+    return periods[audc*32 + audf];
+}
+
+/*************************************************************************/
+
+double PitchMeasurement::getFrequency(TiaSound::TvStandard standard, int audc, int audf) const {
+    double period = getPeriod(audc, audf);
+    if (period == 0.0) {
+        return 0.0;
+    }
+    int clock = standard == TiaSound::TvStandard::PAL
+            ? TiaSound::PitchGuideFactory::PalFrequency
+            : TiaSound::PitchGuideFactory::NtscFrequency;
+    return clock/period;
+}
+
+/*************************************************************************/
+
+QMap<TiaSound::Distortion, QList<double>> PitchMeasurement::getFrequencyTable(TiaSound::TvStandard standard) const {
+    QMap<TiaSound::Distortion, QList<double>> table;
+    for (TiaSound::Distortion dist : TiaSound::distortions) {
+        if (dist == TiaSound::Distortion::SILENT || dist == TiaSound::Distortion::PURE_COMBINED) {
+            continue;
+        }
+        int audc = TiaSound::getDistortionInt(dist);
+        QList<double> frequencies;
+        for (int audf = 0; audf < 32; ++audf) {
+            frequencies.append(getFrequency(standard, audc, audf));
+        }
+        table[dist] = frequencies;
+    }
+    return table;
+}
+
+/*************************************************************************/
+
+QString PitchMeasurement::getCacheFileName() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/measuredpitches.json";
+}
+
+/*************************************************************************/
+
+double PitchMeasurement::measurePeriod(int audc, int audf) {
+    // At 31400Hz, TIASound outputs exactly one sample per audio clock
+    TIASound tiaSound(31400);
+    tiaSound.channels(1, false);
+    tiaSound.set(AUDC0, audc);
+    tiaSound.set(AUDF0, audf);
+    tiaSound.set(AUDV0, 15);
+    QVector<Int16> samples(NumSamples);
+    // Let the divider and poly counters settle first
+    tiaSound.process(samples.data(), 1024);
+    tiaSound.process(samples.data(), NumSamples);
+
+    // Autocorrelation via the power spectrum, zero-padded against
+    // wrap-around
+    double mean = 0.0;
+    for (Int16 sample : samples) {
+        mean += sample;
+    }
+    mean /= NumSamples;
+    QVector<Complex> spectrum(2*NumSamples);
+    for (int i = 0; i < NumSamples; ++i) {
+        spectrum[i] = samples[i] - mean;
+    }
+    fft(spectrum, false);
+    for (Complex &bin : spectrum) {
+        bin = std::norm(bin);
+    }
+    fft(spectrum, true);
+    double energy = spectrum[0].real();
+    if (energy < 1e-6*NumSamples) {
+        // Constant output
+        return 0.0;
+    }
+
+    // Unbiased and normalized, so a periodic signal reaches 1 at
+    // every multiple of its period
+    const int maxLag = NumSamples/2;
+    QVector<double> correlation(maxLag + 1);
+    for (int lag = 0; lag <= maxLag; ++lag) {
+        correlation[lag] = spectrum[lag].real()/energy*NumSamples/(NumSamples - lag);
+    }
+
+    // Highest peak of every positive lobe after the one around lag 0
+    QList<int> peaks;
+    int lag = 1;
+    while (lag < maxLag && correlation[lag] > 0.0) {
+        lag++;
+    }
+    for (; lag < maxLag; ++lag) {
+        if (correlation[lag] <= 0.0) {
+            continue;
+        }
+        int peak = lag;
+        for (; lag < maxLag && correlation[lag] > 0.0; ++lag) {
+            if (correlation[lag] > correlation[peak]) {
+                peak = lag;
+            }
+        }
+        peaks.append(peak);
+    }
+    if (peaks.isEmpty()) {
+        return 0.0;
+    }
+
+    // The perceived fundamental is the first peak that is almost as
+    // strong as the strongest one
+    double maxPeak = 0.0;
+    for (int peak : peaks) {
+        maxPeak = qMax(maxPeak, correlation[peak]);
+    }
+    for (int peak : peaks) {
+        if (correlation[peak] >= 0.9*maxPeak) {
+            // Parabolic interpolation for a fractional period
+            double left = correlation[peak - 1];
+            double center = correlation[peak];
+            double right = correlation[peak + 1];
+            double denominator = left - 2.0*center + right;
+            double offset = denominator < 0.0 ? 0.5*(left - right)/denominator : 0.0;
+            return peak + offset;
+        }
+    }
+    return 0.0;
+}
+
+}
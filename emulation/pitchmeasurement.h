@@ -0,0 +1,68 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PITCHMEASUREMENT_H
+#define PITCHMEASUREMENT_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include "tiasound/tiasound.h"
+
+
+namespace Emulation {
+
+/* Measures the pitch of every AUDC/AUDF combination instead of deriving
+ * it from idealized dividers. Each combination is rendered through
+ * TIASound, and the fundamental period is found in an FFT based
+ * autocorrelation of the output. TIASound renders one sample per TIA
+ * audio clock, so the period in clocks gives the frequency for both
+ * PAL and NTSC. Combinations are measured in parallel.
+ *
+ * Measuring takes a moment, so results can be cached in a file.
+ */
+class PitchMeasurement
+{
+public:
+    // Long enough for two periods of the slowest poly9 noise
+    static const int NumSamples = 32768;
+
+    PitchMeasurement();
+
+    /* Renders and measures all combinations */
+    void measure();
+
+    /* Loads measurements from a cache file. Returns false if there is
+     * none or if it's from a different measurement setup. */
+    bool load(const QString &fileName);
+    bool save(const QString &fileName) const;
+
+    /* Period in TIA audio clocks, or 0 if no pitch was found */
+    double getPeriod(int audc, int audf) const;
+    /* Frequency in Hz, or 0 if no pitch was found */
+    double getFrequency(TiaSound::TvStandard standard, int audc, int audf) const;
+
+    /* Frequencies per distortion, for PitchGuideFactory::setFrequencyTables() */
+    QMap<TiaSound::Distortion, QList<double>> getFrequencyTable(TiaSound::TvStandard standard) const;
+
+    /* Default cache file in the user's cache directory */
+    static QString getCacheFileName();
+
+private:
+    static const int Version = 1;
+
+    static double measurePeriod(int audc, int audf);
+
+    // Indexed by audc*32 + audf
+    QVector<double> periods;
+};
+
+}
+
+#endif // PITCHMEASUREMENT_H
@@ -12,32 +12,30 @@
 #include "track/instrument.h"
 #include "track/pattern.h"
 #include "player.h"
-#include <SDL.h>
 #include <QElapsedTimer>
 #include <QVector>
 #include <QCoreApplication>
+#include <QMutexLocker>
+#include "monotonicclock.h"
+#include "inputlatencytracer.h"
+#include "eventtrace.h"
+#include "registerlog.h"
 
 
 namespace Emulation {
 
-Player::Player(Track::Track *parentTrack, QObject *parent) : QObject(parent)
+Player::Player(Track::Track *parentTrack, AudioSink *sink, QObject *parent) : QObject(parent)
 {
     pTrack = parentTrack;
+    audioSink = sink;
 
-    tiaSound.channels(2, false);
-    sdlSound.setFrameRate(50.0);
-    sdlSound.open();
-    sdlSound.mute(false);
-    sdlSound.setEnabled(true);
-    sdlSound.setVolume(100);
-
-    sdlSound.set(AUDC0, 0, 10);
-    sdlSound.set(AUDV0, 0, 15);
-    sdlSound.set(AUDF0, 0, 18);
+    setChannel0(0, 0, 0);
 }
 
 Player::~Player()
 {
+    delete registerLog;
+    delete audioSink;
 /*
     delete eTimer;
 
@@ -51,14 +49,112 @@ Player::~Player()
 /*************************************************************************/
 
 void Player::setFrameRate(float rate) {
-    sdlSound.close();
-    sdlSound.setFrameRate(rate);
-    sdlSound.open();
+    if (audioSink == nullptr) {
+        return;
+    }
+    audioSink->setFrameRate(rate);
+}
+
+/*************************************************************************/
+
+bool Player::isPlaying() const {
+    return mode != PlayMode::None;
+}
+
+/*************************************************************************/
+
+void Player::getChannelRegisters(int channel, int *pAudC, int *pAudF, int *pAudV) const {
+    *pAudC = channelAudC[channel];
+    *pAudF = channelAudF[channel];
+    *pAudV = channelAudV[channel];
+}
+
+/*************************************************************************/
+
+void Player::getTrackPosition(int channel, int *pEntryIndex, int *pNoteIndex) const {
+    *pEntryIndex = trackCurEntryIndex[channel];
+    *pNoteIndex = trackCurNoteIndex[channel];
+}
+
+/*************************************************************************/
+
+bool Player::getPlayerPos(int *pPos1, int *pPos2) const {
+    int pos = playerPos.loadAcquire();
+    if (pos == -1) {
+        return false;
+    }
+    *pPos1 = pos>>16;
+    *pPos2 = pos&0xffff;
+    return true;
+}
+
+/*************************************************************************/
+
+Player::TrackState Player::getTrackState() const {
+    TrackState state;
+    for (int channel = 0; channel < 2; ++channel) {
+        state.noteIndex[channel] = trackCurNoteIndex[channel];
+        state.entryIndex[channel] = trackCurEntryIndex[channel];
+        state.note[channel] = trackCurNote[channel];
+        state.envelopeIndex[channel] = trackCurEnvelopeIndex[channel];
+        state.trackMode[channel] = trackMode[channel];
+        state.isOverlay[channel] = trackIsOverlay[channel];
+        state.audC[channel] = channelAudC[channel];
+        state.audF[channel] = channelAudF[channel];
+        state.audV[channel] = channelAudV[channel];
+    }
+    state.tick = trackCurTick;
+    state.isFirstNote = isFirstNote;
+    return state;
+}
+
+/*************************************************************************/
+
+void Player::jamInstrument(Track::Instrument *instrument, int frequency) {
+    postJamCommand({JamCommand::Type::Instrument, instrument, nullptr, frequency, -1});
+}
+
+/*************************************************************************/
+
+void Player::jamPercussion(Track::Percussion *percussion) {
+    postJamCommand({JamCommand::Type::Percussion, nullptr, percussion, 0, -1});
+}
+
+/*************************************************************************/
+
+void Player::jamRelease() {
+    postJamCommand({JamCommand::Type::Release, nullptr, nullptr, 0, -1});
+}
+
+/*************************************************************************/
+
+bool Player::isPlayingTrack() const {
+    return trackPlaying.loadAcquire() != 0;
+}
+
+/*************************************************************************/
+
+void Player::postJamCommand(const JamCommand &command) {
+    // Called without a traced key press, time the note from here
+    qint64 micros = InputLatencyTracer::getShared().getInputMicros();
+    QMutexLocker locker(&jamMutex);
+    jamCommands.append(command);
+    jamCommands.last().inputMicros = micros != -1 ? micros : MonotonicClock::micros();
+    hasJamCommands.storeRelease(1);
+}
+
+/*************************************************************************/
+
+void Player::noteReceived() {
+    InputLatencyTracer &tracer = InputLatencyTracer::getShared();
+    tracer.mark(InputLatencyTracer::PlayerReceived);
+    inputMicros = tracer.getInputMicros();
 }
 
 /*************************************************************************/
 
 void Player::startTimer() {
+    EventTrace::nameThread("Player");
     QElapsedTimer elapsedTimer;
     elapsedTimer.start();
     double lastReplayTime = 0;
@@ -116,6 +212,7 @@ void Player::playInstrument(Track::Instrument *instrument, int frequency) {
         currentInstrumentFrequency = frequency;
         currentInstrumentFrame = 0;
         mode = PlayMode::Instrument;
+        noteReceived();
     }
 }
 
@@ -126,6 +223,7 @@ void Player::playInstrumentOnce(Track::Instrument *instrument, int frequency) {
     currentInstrumentFrequency = frequency;
     currentInstrumentFrame = 0;
     mode = PlayMode::InstrumentOnce;
+    noteReceived();
 }
 
 /*************************************************************************/
@@ -142,6 +240,7 @@ void Player::playPercussion(Track::Percussion *percussion) {
     currentPercussion = percussion;
     currentPercussionFrame = 0;
     mode = PlayMode::Percussion;
+    noteReceived();
 }
 
 /*************************************************************************/
@@ -159,9 +258,7 @@ void Player::stopTrack() {
 /*************************************************************************/
 
 void Player::setChannel0(int distortion, int frequency, int volume) {
-    sdlSound.set(AUDC0, distortion, 10);
-    sdlSound.set(AUDV0, volume, 15);
-    sdlSound.set(AUDF0, frequency, 18);
+    setChannel(0, distortion, frequency, volume);
 }
 
 /*************************************************************************/
@@ -170,9 +267,14 @@ void Player::setChannel(int channel, int distortion, int frequency, int volume)
     int audC = channel == 0 ? AUDC0 : AUDC1;
     int audV = channel == 0 ? AUDV0 : AUDV1;
     int audF = channel == 0 ? AUDF0 : AUDF1;
-    sdlSound.set(audC, distortion, 10);
-    sdlSound.set(audV, volume, 15);
-    sdlSound.set(audF, frequency, 18);
+    channelAudC[channel] = distortion;
+    channelAudF[channel] = frequency;
+    channelAudV[channel] = volume;
+    if (audioSink != nullptr) {
+        audioSink->set(audC, distortion);
+        audioSink->set(audV, volume);
+        audioSink->set(audF, frequency);
+    }
 }
 
 /*************************************************************************/
@@ -187,6 +289,13 @@ void Player::playWaveform(TiaSound::Distortion waveform, int frequency, int volu
 
 void Player::playTrack(int start1, int start2) {
     pTrack->lock();
+    startTrack(start1, start2);
+    pTrack->unlock();
+}
+
+/*************************************************************************/
+
+void Player::startTrack(int start1, int start2) {
     trackCurNoteIndex[0] = pTrack->getNoteIndexInPattern(0, start1);
     trackCurNoteIndex[1] = pTrack->getNoteIndexInPattern(1, start2);
     trackCurEntryIndex[0] = pTrack->getSequenceEntryIndex(0, start1);
@@ -202,7 +311,23 @@ void Player::playTrack(int start1, int start2) {
     trackIsOverlay[1] = false;
     mode = PlayMode::Track;
     isFirstNote = true;
-    pTrack->unlock();
+}
+
+/*************************************************************************/
+
+void Player::playTrackState(const TrackState &state) {
+    for (int channel = 0; channel < 2; ++channel) {
+        trackCurNoteIndex[channel] = state.noteIndex[channel];
+        trackCurEntryIndex[channel] = state.entryIndex[channel];
+        trackCurNote[channel] = state.note[channel];
+        trackCurEnvelopeIndex[channel] = state.envelopeIndex[channel];
+        trackMode[channel] = state.trackMode[channel];
+        trackIsOverlay[channel] = state.isOverlay[channel];
+        setChannel(channel, state.audC[channel], state.audF[channel], state.audV[channel]);
+    }
+    trackCurTick = state.tick;
+    isFirstNote = state.isFirstNote;
+    mode = PlayMode::Track;
 }
 
 /*************************************************************************/
@@ -230,6 +355,60 @@ void Player::setTVStandard(int iNewStandard) {
 
 /*************************************************************************/
 
+void Player::setAudioDevice(int sampleRate, int bufferSize, bool adaptive, int prerenderFrames) {
+    if (audioSink == nullptr) {
+        return;
+    }
+    audioSink->configureDevice(sampleRate, bufferSize, adaptive, prerenderFrames);
+}
+
+/*************************************************************************/
+
+void Player::resetAudioStatus() {
+    if (audioSink == nullptr) {
+        return;
+    }
+    audioSink->resetStatus();
+}
+
+/*************************************************************************/
+
+void Player::startRegisterLog(QString fileName) {
+    stopRegisterLog();
+    registerLog = new RegisterLogWriter(fileName);
+    if (!registerLog->open(replayTvStandard == TiaSound::TvStandard::PAL ? 50 : 60)) {
+        emit registerLogStopped(fileName, 0, registerLog->getErrorMessage());
+        delete registerLog;
+        registerLog = nullptr;
+    }
+}
+
+/*************************************************************************/
+
+void Player::stopRegisterLog() {
+    if (registerLog == nullptr) {
+        return;
+    }
+    registerLog->close();
+    emit registerLogStopped(registerLog->getFileName(), registerLog->getNumFrames(), registerLog->getErrorMessage());
+    delete registerLog;
+    registerLog = nullptr;
+}
+
+/*************************************************************************/
+
+void Player::logRegisters() {
+    uInt8 registers[RegisterLog::NumRegisters];
+    for (int channel = 0; channel < 2; ++channel) {
+        registers[(channel == 0 ? AUDC0 : AUDC1) - AUDC0] = uInt8(channelAudC[channel]);
+        registers[(channel == 0 ? AUDF0 : AUDF1) - AUDC0] = uInt8(channelAudF[channel]);
+        registers[(channel == 0 ? AUDV0 : AUDV1) - AUDC0] = uInt8(channelAudV[channel]);
+    }
+    registerLog->writeFrame(registers);
+}
+
+/*************************************************************************/
+
 void Player::updateSilence() {
     setChannel(0, 0, 0, 0);
     setChannel(1, 0, 0, 0);
@@ -244,23 +423,19 @@ void Player::updateInstrument() {
         // Go into silence if currentFrame is illegal
         mode = PlayMode::None;
     } else {
-        int CValue = currentInstrument->getAudCValue(currentInstrumentFrequency);
-        int realFrequency = currentInstrumentFrequency <= 31 ? currentInstrumentFrequency : currentInstrumentFrequency - 32;
-        int FValue = realFrequency + currentInstrument->frequencies[currentInstrumentFrame];
-        // Check if envelope has caused an underrun
-        if (FValue < 0) {
-            FValue = 256 + FValue;
+        if (!currentInstrumentEnvelope.isValidFor(currentInstrument, currentInstrumentFrequency)) {
+            currentInstrumentEnvelope = EnvelopeCache::getShared().get(currentInstrument, currentInstrumentFrequency);
         }
-        int VValue = currentInstrument->volumes[currentInstrumentFrame];
-        setChannel0(CValue, FValue, VValue);
+        const EnvelopeCache::Envelope &envelope = currentInstrumentEnvelope;
+        setChannel0(envelope.audC, envelope.audF[currentInstrumentFrame], envelope.audV[currentInstrumentFrame]);
 
         /* Advance frame */
         currentInstrumentFrame++;
         // Check for end of sustain or release
         if (mode != PlayMode::InstrumentOnce
-                && currentInstrumentFrame == currentInstrument->getReleaseStart()) {
-            currentInstrumentFrame = currentInstrument->getSustainStart();
-        } else if (currentInstrumentFrame == currentInstrument->getEnvelopeLength()) {
+                && currentInstrumentFrame == envelope.releaseStart) {
+            currentInstrumentFrame = envelope.sustainStart;
+        } else if (currentInstrumentFrame == envelope.getLength()) {
             // End of release: Go into silence
             mode = PlayMode::None;
         }
@@ -364,25 +539,23 @@ void Player::updateChannel(int channel) {
         case Track::Note::instrumentType::Instrument:
         {
             Track::Instrument *curInstrument = &(pTrack->instruments[trackCurNote[channel].instrumentNumber]);
-            int CValue = curInstrument->getAudCValue(trackCurNote[channel].value);
+            int curFrequency = trackCurNote[channel].value;
+            // Note, slide or an edit of the instrument invalidates the envelope
+            if (!trackCurEnvelope[channel].isValidFor(curInstrument, curFrequency)) {
+                trackCurEnvelope[channel] = EnvelopeCache::getShared().get(curInstrument, curFrequency);
+            }
+            const EnvelopeCache::Envelope &envelope = trackCurEnvelope[channel];
             // If at end of release, play silence; otherwise ADSR envelope
-            if (trackCurEnvelopeIndex[channel] >= curInstrument->getEnvelopeLength()) {
-                setChannel(channel, CValue, 0, 0);
+            if (trackCurEnvelopeIndex[channel] >= envelope.getLength()) {
+                setChannel(channel, envelope.audC, 0, 0);
             } else {
-                int curFrequency = trackCurNote[channel].value;
-                int realFrequency = curFrequency <= 31 ? curFrequency : curFrequency - 32;
-                int FValue = realFrequency + curInstrument->frequencies[trackCurEnvelopeIndex[channel]];
-                // Check if envelope has caused an underrun
-                if (FValue < 0) {
-                    FValue = 256 + FValue;
-                }
-                int VValue = curInstrument->volumes[trackCurEnvelopeIndex[channel]];
-                setChannel(channel, CValue, FValue, VValue);
+                int index = trackCurEnvelopeIndex[channel];
+                setChannel(channel, envelope.audC, envelope.audF[index], envelope.audV[index]);
                 // Advance frame
                 trackCurEnvelopeIndex[channel]++;
                 // Check for end of sustain
-                if (trackCurEnvelopeIndex[channel] == curInstrument->getReleaseStart()) {
-                    trackCurEnvelopeIndex[channel] = curInstrument->getSustainStart();
+                if (trackCurEnvelopeIndex[channel] == envelope.releaseStart) {
+                    trackCurEnvelopeIndex[channel] = envelope.sustainStart;
                 }
             }
             break;
@@ -454,7 +627,7 @@ void Player::updateTrack() {
                 + trackCurNoteIndex[0];
         int pos2 = pTrack->channelSequences[1].sequence[trackCurEntryIndex[1]].firstNoteNumber
                 + trackCurNoteIndex[1];
-        emit newPlayerPos(pos1, pos2);
+        playerPos.storeRelease((pos1<<16)|pos2);
     }
     for (int channel = 0; channel < 2; ++channel) {
         if (!channelMuted[channel]) {
@@ -462,12 +635,103 @@ void Player::updateTrack() {
         } else {
             setChannel(channel, 0, 0, 0);
         }
+        // The track channel keeps running underneath, so it continues
+        // in sync once the jam note has ended
+        if (jamMode != PlayMode::None && channel == jamChannel) {
+            updateJam();
+        }
+    }
+}
+
+/*************************************************************************/
+
+void Player::processJamCommands() {
+    if (hasJamCommands.loadAcquire() == 0) {
+        return;
+    }
+    QVector<JamCommand> commands;
+    jamMutex.lock();
+    commands.swap(jamCommands);
+    hasJamCommands.storeRelease(0);
+    jamMutex.unlock();
+    if (mode != PlayMode::Track) {
+        return;
+    }
+    for (const JamCommand &command : commands) {
+        switch (command.type) {
+        case JamCommand::Type::Instrument:
+            jamMode = PlayMode::Instrument;
+            jamCurInstrument = command.instrument;
+            jamCurFrequency = command.frequency;
+            jamCurFrame = 0;
+            break;
+        case JamCommand::Type::Percussion:
+            jamMode = PlayMode::Percussion;
+            jamCurPercussion = command.percussion;
+            jamCurFrame = 0;
+            break;
+        case JamCommand::Type::Release:
+            if (jamMode == PlayMode::Instrument) {
+                // A short key press still plays the note for one frame
+                if (jamCurFrame == 0) {
+                    jamReleasePending = true;
+                } else {
+                    jamCurFrame = jamCurInstrument->getReleaseStart();
+                }
+            }
+            continue;
+        }
+        jamChannel = channelSelected;
+        jamReleasePending = false;
+        InputLatencyTracer::getShared().mark(InputLatencyTracer::PlayerReceived);
+        inputMicros = command.inputMicros;
+    }
+}
+
+/*************************************************************************/
+
+void Player::updateJam() {
+    if (jamMode == PlayMode::Percussion) {
+        if (jamCurFrame >= jamCurPercussion->getEnvelopeLength()) {
+            jamMode = PlayMode::None;
+            return;
+        }
+        TiaSound::Distortion waveform = jamCurPercussion->waveforms[jamCurFrame];
+        int CValue = TiaSound::getDistortionInt(waveform);
+        int FValue = jamCurPercussion->frequencies[jamCurFrame];
+        int VValue = jamCurPercussion->volumes[jamCurFrame];
+        setChannel(jamChannel, CValue, FValue, VValue);
+        jamCurFrame++;
+        return;
+    }
+
+    // Check if instrument has changed and made jamCurFrame illegal
+    if (jamCurFrame >= jamCurInstrument->getEnvelopeLength()) {
+        jamMode = PlayMode::None;
+        return;
+    }
+    if (!jamCurEnvelope.isValidFor(jamCurInstrument, jamCurFrequency)) {
+        jamCurEnvelope = EnvelopeCache::getShared().get(jamCurInstrument, jamCurFrequency);
+    }
+    const EnvelopeCache::Envelope &envelope = jamCurEnvelope;
+    setChannel(jamChannel, envelope.audC, envelope.audF[jamCurFrame], envelope.audV[jamCurFrame]);
+
+    /* Advance frame */
+    jamCurFrame++;
+    if (jamReleasePending) {
+        jamReleasePending = false;
+        jamCurFrame = envelope.releaseStart;
+    } else if (jamCurFrame == envelope.releaseStart) {
+        jamCurFrame = envelope.sustainStart;
+    } else if (jamCurFrame == envelope.getLength()) {
+        jamMode = PlayMode::None;
     }
 }
 
 /*************************************************************************/
 
 void Player::timerFired() {
+    EventTrace::Scope trace("player", "Player::timerFired");
 /*
     // Jitter test statistics
     long elapsed = (long)eTimer->elapsed();
@@ -485,6 +749,28 @@ void Player::timerFired() {
 */
 
     pTrack->lock();
+    advanceFrame();
+    pTrack->unlock();
+    if (audioSink != nullptr) {
+        audioSink->update();
+        AudioSink::InputTiming timing;
+        if (audioSink->takeInputTiming(&timing)) {
+            InputLatencyTracer::getShared().finish(timing.inputMicros, timing.appliedMicros, timing.audibleMicros);
+            emit inputLatencyMeasured(int(timing.audibleMicros - timing.inputMicros));
+        }
+        if (++framesSinceAudioStatus >= AudioStatusInterval) {
+            framesSinceAudioStatus = 0;
+            AudioSink::Status status = audioSink->getStatus();
+            emit audioStatusChanged(status.sampleRate, status.bufferSize, status.underruns,
+                                    status.lateFrames, status.maxCallbackMicros);
+        }
+    }
+}
+
+/*************************************************************************/
+
+void Player::advanceFrame() {
+    processJamCommands();
     switch (mode) {
     case PlayMode::Instrument:
     case PlayMode::InstrumentOnce:
@@ -501,7 +787,23 @@ void Player::timerFired() {
     default:
         updateSilence();
     }
-    pTrack->unlock();
+    if (mode != PlayMode::Track) {
+        jamMode = PlayMode::None;
+    }
+    trackPlaying.storeRelease(mode == PlayMode::Track ? 1 : 0);
+    if (inputMicros != -1) {
+        InputLatencyTracer::getShared().mark(InputLatencyTracer::FrameWritten);
+        if (audioSink != nullptr) {
+            audioSink->markInput(inputMicros);
+        }
+        inputMicros = -1;
+    }
+    if (registerLog != nullptr) {
+        logRegisters();
+    }
+    if (audioSink != nullptr) {
+        audioSink->endFrame();
+    }
 }
 
 }
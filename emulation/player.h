@@ -16,13 +16,18 @@
 #include "track/instrument.h"
 #include "tiasound/tiasound.h"
 #include "emulation/TIASnd.h"
-#include "emulation/SoundSDL2.h"
+#include "emulation/audiosink.h"
+#include "emulation/envelopecache.h"
 #include <QElapsedTimer>
 #include <QVector>
+#include <QAtomicInt>
+#include <QMutex>
 
 
 namespace Emulation {
 
+class RegisterLogWriter;
+
 class Player : public QObject {
     Q_OBJECT
 
@@ -50,14 +55,78 @@ public:
     static const int NotePause = 16;
     static const int NoteFirstPerc = 17;
 
+    /* Frames between two audioStatusChanged() signals */
+    static const int AudioStatusInterval = 50;
+
     bool channelMuted[2]{false, false};
 
-    explicit Player(Track::Track *parentTrack, QObject *parent = 0);
+    /* Everything needed to continue playing a track from the start of
+     * a given frame, including envelopes of notes that are still
+     * sounding and the audio registers of the last frame. */
+    struct TrackState {
+        int noteIndex[2];
+        int entryIndex[2];
+        int tick;
+        Track::Note note[2];
+        int envelopeIndex[2];
+        Track::Note::instrumentType trackMode[2];
+        bool isOverlay[2];
+        bool isFirstNote;
+        int audC[2];
+        int audF[2];
+        int audV[2];
+    };
+
+    /* The player takes ownership of sink. Without a sink, nothing
+     * gets output; the player can still be driven with advanceFrame(),
+     * e.g. to compare register values. */
+    explicit Player(Track::Track *parentTrack, AudioSink *sink = nullptr, QObject *parent = 0);
     ~Player();
 
     /* Set framerate to play at */
     void setFrameRate(float rate);
 
+    /* Plays one frame without timing and sends it to the sink. The
+     * track must be locked by the caller. */
+    void advanceFrame();
+
+    /* Same as playTrack(), for callers that already hold the track
+     * lock, e.g. to drive the player with advanceFrame() */
+    void startTrack(int start1, int start2);
+
+    /* Returns false if nothing is being played anymore */
+    bool isPlaying() const;
+
+    /* Last values set for the audio registers of a channel */
+    void getChannelRegisters(int channel, int *pAudC, int *pAudF, int *pAudV) const;
+
+    /* Current sequence entry and note index inside its pattern when
+     * playing a track */
+    void getTrackPosition(int channel, int *pEntryIndex, int *pNoteIndex) const;
+
+    /* Rows last played in both channels. Can be called from any
+     * thread, e.g. by a GUI timer. Returns false if no track has been
+     * played yet. */
+    bool getPlayerPos(int *pPos1, int *pPos2) const;
+
+    /* Current track state. Only meaningful while playing a track */
+    TrackState getTrackState() const;
+
+    /* Live jam mode: while a track plays, a note can be previewed on
+     * the selected channel and the track goes on in the other one.
+     * Unlike the slots, these are meant to be called directly from the
+     * GUI thread, so a key press doesn't wait for the player thread to
+     * handle queued events. Notes start with the next frame. Nothing
+     * happens if no track is playing. */
+    void jamInstrument(Track::Instrument *instrument, int frequency);
+    void jamPercussion(Track::Percussion *percussion);
+    /* Sends the jammed instrument into release */
+    void jamRelease();
+
+    /* Returns true while a track is playing. Can be called from any
+     * thread, but lags behind by up to one frame. */
+    bool isPlayingTrack() const;
+
 public slots:
     void startTimer();
     void stopTimer();
@@ -82,20 +151,44 @@ public slots:
 
     /* Play song from given channel note indexes */
     void playTrack(int start1, int start2);
+    /* Continue playing a song from a saved state, e.g. a keyframe.
+     * The registers of the state are sent to the sink right away. */
+    void playTrackState(const Emulation::Player::TrackState &state);
 
     void selectedChannelChanged(int newChannel);
     void toggleLoop(bool toggle);
 
     void setTVStandard(int iNewStandard);
 
+    /* Reopen the audio device. With adaptive set, the buffer size
+     * is only the starting point. See AudioSink::configureDevice(). */
+    void setAudioDevice(int sampleRate, int bufferSize, bool adaptive, int prerenderFrames);
+    /* Restart the counters reported by audioStatusChanged() */
+    void resetAudioStatus();
+
+    /* Record the registers of every frame into a register log until
+     * stopRegisterLog(). Replaces a log that is being recorded. */
+    void startRegisterLog(QString fileName);
+    void stopRegisterLog();
+
 signals:
-    void newPlayerPos(int pos1, int pos2);
+    /* Emitted regularly while the audio device is open. The counters
+     * are totals since the start or the last resetAudioStatus(). */
+    void audioStatusChanged(int sampleRate, int bufferSize, int underruns, int lateFrames, int maxCallbackMicros);
     void invalidNoteFound(int channel, int entryIndex, int noteIndex, QString reason);
+    /* Time from a key press until its note started to play */
+    void inputLatencyMeasured(int micros);
+    /* A register log has been closed. errorMessage is empty on success. */
+    void registerLogStopped(QString fileName, int numFrames, QString errorMessage);
 
 private:
     Track::Track *pTrack = nullptr;
-    Emulation::TIASound tiaSound;
-    Emulation::SoundSDL2 sdlSound{&tiaSound};
+    // nullptr if the player runs without output
+    AudioSink *audioSink = nullptr;
+    // Last values set per channel
+    int channelAudC[2]{};
+    int channelAudF[2]{};
+    int channelAudV[2]{};
 
     TiaSound::TvStandard replayTvStandard = TiaSound::TvStandard::PAL;
     bool doReplay;
@@ -120,11 +213,49 @@ private:
     Track::Instrument *currentInstrument = nullptr;
     int currentInstrumentFrequency;
     int currentInstrumentFrame;
+    EnvelopeCache::Envelope currentInstrumentEnvelope;
 
     /* Current values for percussion play */
     Track::Percussion *currentPercussion;
     int currentPercussionFrame;
 
+    // Key press of the note that starts this frame, -1 if none
+    qint64 inputMicros = -1;
+
+    /* Jam commands from the GUI thread, waiting for the next frame */
+    struct JamCommand {
+        enum class Type {
+            Instrument, Percussion, Release
+        };
+        Type type;
+        Track::Instrument *instrument;
+        Track::Percussion *percussion;
+        int frequency;
+        // Time of the key press, see MonotonicClock
+        qint64 inputMicros;
+    };
+    QMutex jamMutex;
+    QVector<JamCommand> jamCommands;
+    // Non-zero if jamCommands is not empty, to check without locking
+    QAtomicInt hasJamCommands{0};
+
+    /* Current values for jam play, on top of the track. jamMode is
+     * Instrument, Percussion or None. */
+    PlayMode jamMode = PlayMode::None;
+    int jamChannel = 0;
+    Track::Instrument *jamCurInstrument = nullptr;
+    int jamCurFrequency = 0;
+    int jamCurFrame = 0;
+    EnvelopeCache::Envelope jamCurEnvelope;
+    Track::Percussion *jamCurPercussion = nullptr;
+    // Release requested for a note that has not played a frame yet
+    bool jamReleasePending = false;
+
+    QAtomicInt trackPlaying{0};
+
+    // nullptr if not recording
+    RegisterLogWriter *registerLog = nullptr;
+
     /* Helper methods for timerFired() */
     void updateSilence();
     void updateInstrument();
@@ -135,6 +266,16 @@ private:
     void updateChannel(int channel);
     // Do next tick for track
     void updateTrack();
+    // Note from a key press has arrived in the player thread
+    void noteReceived();
+    // Queue a jam command from the GUI thread
+    void postJamCommand(const JamCommand &command);
+    // Take over jam commands from the GUI thread
+    void processJamCommands();
+    // Play current jam note in its channel
+    void updateJam();
+    // Append the registers of this frame to the register log
+    void logRegisters();
 
     /* Set values for channel 0 */
     void setChannel0(int distortion, int frequency, int volume);
@@ -150,6 +291,8 @@ private:
     int trackCurTick;
     Track::Note trackCurNote[2];
     int trackCurEnvelopeIndex[2];
+    // Resolved envelope of the instrument currently playing
+    EnvelopeCache::Envelope trackCurEnvelope[2];
     // Current mode, to validate track
     Track::Note::instrumentType trackMode[2];
     // Was the current note fetched via overlay?
@@ -159,10 +302,18 @@ private:
     bool loopPattern = false;
     int channelSelected = 0;
 
+    int framesSinceAudioStatus = 0;
+
+    // Both rows of the last sequencer tick, row of channel 0 in the
+    // upper 16 bits. -1 if no track has been played yet.
+    QAtomicInt playerPos{-1};
+
 private slots:
     void timerFired();
 };
 
 }
 
+Q_DECLARE_METATYPE(Emulation::Player::TrackState)
+
 #endif // PLAYER_H
@@ -0,0 +1,314 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "playerharness.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <algorithm>
+
+#include "assembler6502.h"
+#include "TIASnd.h"
+
+
+namespace Emulation {
+
+PlayerHarness::PlayerHarness()
+{
+}
+
+/*************************************************************************/
+
+bool PlayerHarness::loadTrack(Track::Track *track, const DasmExporter::Variant &variant) {
+    const QString baseName = "tt";
+    DasmExporter exporter(track);
+    exporter.variant = variant;
+    if (!exporter.exportTrackSpecifics()
+            || !exporter.exportPlayer()
+            || !exporter.exportHarness(baseName)) {
+        errorMessage = exporter.getErrorMessage();
+        return false;
+    }
+    Assembler6502 assembler;
+    assembler.addFile(baseName + "_variables.asm", exporter.variablesString);
+    assembler.addFile(baseName + "_init.asm", exporter.initString);
+    assembler.addFile(baseName + "_player.asm", exporter.playerString);
+    assembler.addFile(baseName + "_trackdata.asm", exporter.trackDataString);
+    assembler.addFile(baseName + "_harness.asm", exporter.harnessString);
+    if (!assembler.assemble(baseName + "_harness.asm")) {
+        errorMessage = "Unable to assemble player: " + assembler.getErrorMessage();
+        return false;
+    }
+    image = assembler.getImage();
+    origin = assembler.getOrigin();
+    symbols = assembler.getSymbols();
+    sequenceSize[0] = exporter.sequenceSize[0];
+    sequenceSize[1] = exporter.sequenceSize[1];
+    return setupSymbols();
+}
+
+/*************************************************************************/
+
+bool PlayerHarness::loadBinary(const QString &binFileName, const QString &symFileName) {
+    QFile binFile(binFileName);
+    if (!binFile.open(QIODevice::ReadOnly)) {
+        errorMessage = "Unable to open file " + binFileName + "!";
+        return false;
+    }
+    image = binFile.readAll();
+    binFile.close();
+
+    // dasm symbol file: one "name value flags" line per symbol, value in hex
+    QFile symFile(symFileName);
+    if (!symFile.open(QIODevice::ReadOnly)) {
+        errorMessage = "Unable to open symbol file " + symFileName + "!";
+        return false;
+    }
+    symbols.clear();
+    QTextStream inStream(&symFile);
+    while (!inStream.atEnd()) {
+        QStringList fields = inStream.readLine().simplified().split(' ');
+        if (fields.size() < 2) {
+            continue;
+        }
+        bool ok;
+        int value = fields[1].toInt(&ok, 16);
+        if (ok) {
+            symbols[fields[0]] = value;
+        }
+    }
+    symFile.close();
+
+    // The harness starts with init, so the image gets loaded there
+    origin = symbols.value("tt_HarnessInit", -1);
+    sequenceSize[0] = -1;
+    sequenceSize[1] = -1;
+    return setupSymbols();
+}
+
+/*************************************************************************/
+
+bool PlayerHarness::setupSymbols() {
+    const QStringList required{
+        "tt_HarnessInit", "tt_HarnessPlay", "tt_timer",
+        "tt_cur_pat_index_c0", "tt_cur_pat_index_c1",
+        "tt_cur_note_index_c0", "tt_cur_note_index_c1"
+    };
+    for (const QString &symbol : required) {
+        if (!symbols.contains(symbol)) {
+            errorMessage = "Symbol " + symbol + " not found. Was the player assembled from tt_harness.asm?";
+            image.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+int PlayerHarness::ramValue(const QString &symbol) {
+    return cpu.peek(symbols[symbol]);
+}
+
+/*************************************************************************/
+
+bool PlayerHarness::run(int maxFrames) {
+    frameCycles.clear();
+    frameRegisters.clear();
+    audioWrites.clear();
+    looped = false;
+    if (image.isEmpty()) {
+        errorMessage = "No player loaded!";
+        return false;
+    }
+
+    cpu.reset();
+    cpu.loadImage(origin, image);
+    if (cpu.callSubroutine(symbols["tt_HarnessInit"], maxCyclesPerCall) == -1) {
+        errorMessage = QString("Player init crashed at $%1!").arg(cpu.pc, 4, 16, QChar('0'));
+        return false;
+    }
+    if (cpu.romWrites != 0) {
+        errorMessage = "Player init wrote into ROM!";
+        return false;
+    }
+
+    int playAddress = symbols["tt_HarnessPlay"];
+    FrameRegisters registers{{0, 0}, {0, 0}, {0, 0}};
+    // Sequencer positions seen so far, to detect when the song loops
+    QMap<quint32, bool> visited;
+    for (int frame = 0; frame < maxFrames; ++frame) {
+        bool isSequencerTick = ramValue("tt_timer") == 0;
+        cpu.tiaWrites.clear();
+        long frameStart = cpu.cycles;
+        long cycles = cpu.callSubroutine(playAddress, maxCyclesPerCall);
+        if (cycles == -1) {
+            errorMessage = QString("Player crashed at $%1 in frame %2!")
+                    .arg(cpu.pc, 4, 16, QChar('0')).arg(frame);
+            return false;
+        }
+        if (cpu.romWrites != 0) {
+            errorMessage = QString("Player wrote into ROM in frame %1!").arg(frame);
+            return false;
+        }
+        if (isSequencerTick) {
+            int patIndex0 = ramValue("tt_cur_pat_index_c0");
+            int patIndex1 = ramValue("tt_cur_pat_index_c1");
+            // Without goto, the player runs into the next sequence
+            if (sequenceSize[0] != -1
+                    && (patIndex0 >= sequenceSize[0]
+                        || patIndex1 >= sequenceSize[0] + sequenceSize[1])) {
+                break;
+            }
+            quint32 position = quint32(patIndex0)
+                    | (quint32(patIndex1)<<8)
+                    | (quint32(ramValue("tt_cur_note_index_c0"))<<16)
+                    | (quint32(ramValue("tt_cur_note_index_c1"))<<24);
+            if (visited.contains(position)) {
+                looped = true;
+                break;
+            }
+            visited[position] = true;
+        }
+
+        frameCycles.append(int(cycles) - HarnessOverhead);
+        for (const Cpu6502::TiaWrite &write : cpu.tiaWrites) {
+            switch (write.address) {
+            case AUDC0:
+                registers.audc[0] = write.value&0x0f;
+                break;
+            case AUDC1:
+                registers.audc[1] = write.value&0x0f;
+                break;
+            case AUDF0:
+                registers.audf[0] = write.value&0x1f;
+                break;
+            case AUDF1:
+                registers.audf[1] = write.value&0x1f;
+                break;
+            case AUDV0:
+                registers.audv[0] = write.value&0x0f;
+                break;
+            case AUDV1:
+                registers.audv[1] = write.value&0x0f;
+                break;
+            default:
+                // Not an audio register
+                continue;
+            }
+            audioWrites.append({frame, int(write.cycle - frameStart), write.address, write.value});
+        }
+        frameRegisters.append(registers);
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+QString PlayerHarness::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+int PlayerHarness::getNumFrames() const {
+    return frameCycles.size();
+}
+
+/*************************************************************************/
+
+int PlayerHarness::getMinCycles() const {
+    if (frameCycles.isEmpty()) {
+        return 0;
+    }
+    return *std::min_element(frameCycles.begin(), frameCycles.end());
+}
+
+/*************************************************************************/
+
+int PlayerHarness::getMaxCycles() const {
+    if (frameCycles.isEmpty()) {
+        return 0;
+    }
+    return *std::max_element(frameCycles.begin(), frameCycles.end());
+}
+
+/*************************************************************************/
+
+double PlayerHarness::getAverageCycles() const {
+    if (frameCycles.isEmpty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (int cycles : frameCycles) {
+        sum += cycles;
+    }
+    return sum/frameCycles.size();
+}
+
+/*************************************************************************/
+
+QList<PlayerHarness::FrameCycles> PlayerHarness::getWorstFrames(int count) const {
+    QList<FrameCycles> frames;
+    for (int i = 0; i < frameCycles.size(); ++i) {
+        frames.append({i, frameCycles[i]});
+    }
+    std::stable_sort(frames.begin(), frames.end(), [](const FrameCycles &a, const FrameCycles &b) {
+        return a.cycles > b.cycles;
+    });
+    return frames.mid(0, count);
+}
+
+/*************************************************************************/
+
+const QVector<int> &PlayerHarness::getFrameCycles() const {
+    return frameCycles;
+}
+
+/*************************************************************************/
+
+const QVector<PlayerHarness::FrameRegisters> &PlayerHarness::getFrameRegisters() const {
+    return frameRegisters;
+}
+
+/*************************************************************************/
+
+const QVector<PlayerHarness::AudioWrite> &PlayerHarness::getAudioWrites() const {
+    return audioWrites;
+}
+
+/*************************************************************************/
+
+bool PlayerHarness::songLooped() const {
+    return looped;
+}
+
+/*************************************************************************/
+
+int PlayerHarness::getPlayerSize() const {
+    if (!symbols.contains("tt_PlayerStart") || !symbols.contains("tt_TrackDataStart")) {
+        return -1;
+    }
+    // -1 for the rts of the harness
+    return symbols["tt_TrackDataStart"] - symbols["tt_PlayerStart"] - 1;
+}
+
+/*************************************************************************/
+
+int PlayerHarness::getImageSize() const {
+    return image.size();
+}
+
+/*************************************************************************/
+
+int PlayerHarness::getVBlankCycles(TiaSound::TvStandard standard) {
+    int timer = standard == TiaSound::TvStandard::PAL ? VBlankTimerPal : VBlankTimerNtsc;
+    return timer*64;
+}
+
+}
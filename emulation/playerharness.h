@@ -0,0 +1,129 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PLAYERHARNESS_H
+#define PLAYERHARNESS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMap>
+#include <QList>
+#include <QVector>
+
+#include "cpu6502.h"
+#include "dasmexporter.h"
+#include "track/track.h"
+#include "tiasound/tiasound.h"
+
+
+namespace Emulation {
+
+/* Runs the exported 6502 player routine on an emulated CPU, once per
+ * frame for a whole song, to measure its cost in CPU cycles and to
+ * capture the TIA audio register writes it produces.
+ *
+ * The player is wrapped by player/dasm/tt_harness.asm into the
+ * subroutines tt_HarnessInit and tt_HarnessPlay. It can either be
+ * assembled in memory from a track, or loaded from a binary assembled
+ * by dasm from the same harness.
+ */
+class PlayerHarness
+{
+public:
+    /* VBlank timer values from tt_player_framework.asm. The player
+     * has TIM_VBLANK*64 cycles in the framework. */
+    static const int VBlankTimerPal = 43;
+    static const int VBlankTimerNtsc = 45;
+    static const int CyclesPerScanline = 76;
+    // The harness wraps the player into a subroutine; the framework doesn't
+    static const int HarnessOverhead = 6;
+    // 30 minutes of PAL frames
+    static const int DefaultMaxFrames = 30*60*50;
+
+    /* Audio register state after a frame */
+    struct FrameRegisters {
+        int audc[2];
+        int audf[2];
+        int audv[2];
+    };
+
+    /* A write into an audio register during a frame */
+    struct AudioWrite {
+        int frame;
+        // Cycle within the frame's player call
+        int cycle;
+        int address;
+        int value;
+    };
+
+    struct FrameCycles {
+        int frame;
+        int cycles;
+    };
+
+    PlayerHarness();
+
+    /* Exports and assembles the player for a track in memory. The
+     * track should be locked by the caller. */
+    bool loadTrack(Track::Track *track, const DasmExporter::Variant &variant = DasmExporter::Variant{false, false});
+
+    /* Loads a binary assembled by dasm from <name>_harness.asm with
+     * -f3, and its symbol file written with -s. */
+    bool loadBinary(const QString &binFileName, const QString &symFileName);
+
+    /* Calls init and then tt_Player once per frame, until the song
+     * loops, runs past the end of a sequence or maxFrames have been
+     * played. Returns false on error. */
+    bool run(int maxFrames = DefaultMaxFrames);
+
+    QString getErrorMessage() const;
+
+    /* Results of the last run */
+    int getNumFrames() const;
+    int getMinCycles() const;
+    int getMaxCycles() const;
+    double getAverageCycles() const;
+    // Most expensive frames, most expensive first
+    QList<FrameCycles> getWorstFrames(int count) const;
+    const QVector<int> &getFrameCycles() const;
+    const QVector<FrameRegisters> &getFrameRegisters() const;
+    const QVector<AudioWrite> &getAudioWrites() const;
+    // True if the run ended because the song looped
+    bool songLooped() const;
+
+    /* Size of the player routine and of the whole image in bytes */
+    int getPlayerSize() const;
+    int getImageSize() const;
+
+    /* Cycles available to the player in the framework's VBlank */
+    static int getVBlankCycles(TiaSound::TvStandard standard);
+
+private:
+    // Upper limit for a single player call before it's considered hung
+    static const long maxCyclesPerCall = 100000;
+
+    bool setupSymbols();
+    int ramValue(const QString &symbol);
+
+    Cpu6502 cpu;
+    QByteArray image;
+    int origin = 0;
+    QMap<QString, int> symbols;
+    // Sequence table sizes, if known (-1 otherwise)
+    int sequenceSize[2]{-1, -1};
+
+    QString errorMessage;
+
+    QVector<int> frameCycles;
+    QVector<FrameRegisters> frameRegisters;
+    QVector<AudioWrite> audioWrites;
+    bool looped = false;
+};
+
+}
+
+#endif // PLAYERHARNESS_H
@@ -0,0 +1,142 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "playervalidator.h"
+
+#include "player.h"
+
+
+namespace Emulation {
+
+PlayerValidator::PlayerValidator(Track::Track *track)
+{
+    pTrack = track;
+}
+
+/*************************************************************************/
+
+bool PlayerValidator::validate(int maxFrames) {
+    errorMessage.clear();
+    numFrames = 0;
+    numMismatches = 0;
+    mismatches.clear();
+    playerStopFrame = -1;
+
+    // Emulated 6502 routine first, to know how many frames to compare
+    PlayerHarness harness;
+    pTrack->lock();
+    bool loaded = harness.loadTrack(pTrack);
+    int startRow[2];
+    for (int channel = 0; channel < 2; ++channel) {
+        int startEntry = pTrack->startPatterns[channel];
+        startRow[channel] = pTrack->channelSequences[channel].sequence[startEntry].firstNoteNumber;
+    }
+    pTrack->unlock();
+    if (!loaded || !harness.run(maxFrames)) {
+        errorMessage = harness.getErrorMessage();
+        return false;
+    }
+    const QVector<PlayerHarness::FrameRegisters> &routineFrames = harness.getFrameRegisters();
+
+    Player player(pTrack);
+    player.playTrack(startRow[0], startRow[1]);
+    pTrack->lock();
+    for (int frame = 0; frame < routineFrames.size(); ++frame) {
+        player.advanceFrame();
+        if (!player.isPlaying()) {
+            playerStopFrame = frame;
+            break;
+        }
+        numFrames++;
+        for (int channel = 0; channel < 2; ++channel) {
+            ChannelRegisters playerRegs;
+            player.getChannelRegisters(channel, &playerRegs.audc, &playerRegs.audf, &playerRegs.audv);
+            playerRegs.audc &= 0x0f;
+            playerRegs.audf &= 0x1f;
+            playerRegs.audv &= 0x0f;
+            ChannelRegisters routineRegs{
+                routineFrames[frame].audc[channel],
+                routineFrames[frame].audf[channel],
+                routineFrames[frame].audv[channel]
+            };
+            if (playerRegs.audv == 0 && routineRegs.audv == 0) {
+                continue;
+            }
+            if (playerRegs.audc == routineRegs.audc
+                    && playerRegs.audf == routineRegs.audf
+                    && playerRegs.audv == routineRegs.audv) {
+                continue;
+            }
+            numMismatches++;
+            if (mismatches.size() < MaxMismatches) {
+                Mismatch mismatch;
+                mismatch.frame = frame;
+                mismatch.channel = channel;
+                player.getTrackPosition(channel, &mismatch.entryIndex, &mismatch.noteIndex);
+                mismatch.player = playerRegs;
+                mismatch.routine = routineRegs;
+                mismatches.append(mismatch);
+            }
+        }
+    }
+    pTrack->unlock();
+    return true;
+}
+
+/*************************************************************************/
+
+Track::Track *PlayerValidator::getTrack() const {
+    return pTrack;
+}
+
+/*************************************************************************/
+
+QString PlayerValidator::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+int PlayerValidator::getNumFrames() const {
+    return numFrames;
+}
+
+/*************************************************************************/
+
+int PlayerValidator::getNumMismatches() const {
+    return numMismatches;
+}
+
+/*************************************************************************/
+
+const QVector<PlayerValidator::Mismatch> &PlayerValidator::getMismatches() const {
+    return mismatches;
+}
+
+/*************************************************************************/
+
+int PlayerValidator::getPlayerStopFrame() const {
+    return playerStopFrame;
+}
+
+/*************************************************************************/
+
+bool PlayerValidator::isValid() const {
+    return errorMessage.isEmpty() && numMismatches == 0 && playerStopFrame == -1;
+}
+
+/*************************************************************************/
+
+QString PlayerValidator::mismatchToString(const Mismatch &mismatch) {
+    return QString("Frame %1, channel %2, sequence entry %3, row %4: C++ %5/%6/%7, 6502 %8/%9/%10")
+            .arg(mismatch.frame).arg(mismatch.channel)
+            .arg(mismatch.entryIndex).arg(mismatch.noteIndex)
+            .arg(mismatch.player.audc).arg(mismatch.player.audf).arg(mismatch.player.audv)
+            .arg(mismatch.routine.audc).arg(mismatch.routine.audf).arg(mismatch.routine.audv);
+}
+
+}
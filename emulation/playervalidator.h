@@ -0,0 +1,85 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PLAYERVALIDATOR_H
+#define PLAYERVALIDATOR_H
+
+#include <QString>
+#include <QVector>
+
+#include "playerharness.h"
+#include "track/track.h"
+
+
+namespace Emulation {
+
+/* Cross-validates the C++ Player against the exported 6502 player
+ * routine. Both are run over a whole song and the audio registers they
+ * produce are compared frame by frame.
+ *
+ * Frames in which both players have a channel at volume 0 count as
+ * equal, since the routines set AUDC and AUDF differently on silence.
+ *
+ * A validator holds no shared state, so several of them can be run in
+ * parallel on different tracks.
+ */
+class PlayerValidator
+{
+public:
+    // Only this many mismatches are stored, but all are counted
+    static const int MaxMismatches = 100;
+
+    struct ChannelRegisters {
+        int audc;
+        int audf;
+        int audv;
+    };
+
+    struct Mismatch {
+        int frame;
+        int channel;
+        // Position of the C++ player in the track
+        int entryIndex;
+        int noteIndex;
+        ChannelRegisters player;
+        ChannelRegisters routine;
+    };
+
+    explicit PlayerValidator(Track::Track *track = nullptr);
+
+    /* Plays the song in both players and compares the results. Locks
+     * the track while needed. Returns false if the comparison could
+     * not be made, see getErrorMessage(). */
+    bool validate(int maxFrames = PlayerHarness::DefaultMaxFrames);
+
+    Track::Track *getTrack() const;
+    QString getErrorMessage() const;
+
+    /* Results of the last validation */
+    int getNumFrames() const;
+    int getNumMismatches() const;
+    const QVector<Mismatch> &getMismatches() const;
+    // Frame in which the C++ player stopped early, or -1
+    int getPlayerStopFrame() const;
+    // True if the song matched in every frame
+    bool isValid() const;
+
+    static QString mismatchToString(const Mismatch &mismatch);
+
+private:
+    Track::Track *pTrack = nullptr;
+    QString errorMessage;
+
+    int numFrames = 0;
+    int numMismatches = 0;
+    QVector<Mismatch> mismatches;
+    int playerStopFrame = -1;
+};
+
+}
+
+#endif // PLAYERVALIDATOR_H
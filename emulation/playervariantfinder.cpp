@@ -0,0 +1,178 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "playervariantfinder.h"
+
+#include <QStringList>
+#include <QtConcurrent>
+
+#include "playerharness.h"
+
+
+namespace Emulation {
+
+namespace {
+
+struct Measurement {
+    PlayerVariantFinder::Candidate candidate;
+    QVector<PlayerHarness::FrameRegisters> registers;
+};
+
+void measure(Track::Track *track, Measurement &measurement) {
+    PlayerHarness harness;
+    track->lock();
+    bool loaded = harness.loadTrack(track, measurement.candidate.variant);
+    track->unlock();
+    if (!loaded || !harness.run()) {
+        measurement.candidate.errorMessage = harness.getErrorMessage();
+        return;
+    }
+    measurement.candidate.isValid = true;
+    measurement.candidate.playerSize = harness.getPlayerSize();
+    measurement.candidate.maxCycles = harness.getMaxCycles();
+    measurement.candidate.averageCycles = harness.getAverageCycles();
+    measurement.registers = harness.getFrameRegisters();
+}
+
+bool isSameOutput(const QVector<PlayerHarness::FrameRegisters> &a, const QVector<PlayerHarness::FrameRegisters> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int frame = 0; frame < a.size(); ++frame) {
+        for (int channel = 0; channel < 2; ++channel) {
+            if (a[frame].audc[channel] != b[frame].audc[channel]
+                    || a[frame].audf[channel] != b[frame].audf[channel]
+                    || a[frame].audv[channel] != b[frame].audv[channel]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+/*************************************************************************/
+
+PlayerVariantFinder::PlayerVariantFinder(Track::Track *track)
+{
+    pTrack = track;
+}
+
+/*************************************************************************/
+
+bool PlayerVariantFinder::find(int cycleBudget) {
+    errorMessage.clear();
+    candidates.clear();
+    bestIndex = -1;
+    withinBudget = false;
+
+    pTrack->lock();
+    bool usesOverlay = pTrack->usesOverlay();
+    pTrack->unlock();
+    QVector<Measurement> measurements;
+    for (const DasmExporter::Variant &variant : getVariants(usesOverlay)) {
+        measurements.append({{variant, false, "", 0, 0, 0.0}, {}});
+    }
+
+    Track::Track *track = pTrack;
+    QtConcurrent::blockingMap(measurements, [track](Measurement &measurement) {
+        measure(track, measurement);
+    });
+
+    // Variants must play exactly like the first one that works
+    int referenceIndex = -1;
+    for (int i = 0; i < measurements.size(); ++i) {
+        Candidate &candidate = measurements[i].candidate;
+        if (candidate.isValid) {
+            if (referenceIndex == -1) {
+                referenceIndex = i;
+            } else if (!isSameOutput(measurements[i].registers, measurements[referenceIndex].registers)) {
+                candidate.isValid = false;
+                candidate.errorMessage = "Plays differently than " + variantToString(measurements[referenceIndex].candidate.variant);
+            }
+        }
+        candidates.append(candidate);
+    }
+    if (referenceIndex == -1) {
+        errorMessage = "No player variant works for this track: " + candidates[0].errorMessage;
+        return false;
+    }
+
+    // Smallest within budget, or fastest if none is
+    for (int i = 0; i < candidates.size(); ++i) {
+        const Candidate &candidate = candidates[i];
+        if (!candidate.isValid || candidate.maxCycles > cycleBudget) {
+            continue;
+        }
+        if (bestIndex == -1
+                || candidate.playerSize < candidates[bestIndex].playerSize
+                || (candidate.playerSize == candidates[bestIndex].playerSize
+                    && candidate.maxCycles < candidates[bestIndex].maxCycles)) {
+            bestIndex = i;
+        }
+    }
+    withinBudget = bestIndex != -1;
+    if (!withinBudget) {
+        for (int i = 0; i < candidates.size(); ++i) {
+            const Candidate &candidate = candidates[i];
+            if (candidate.isValid
+                    && (bestIndex == -1 || candidate.maxCycles < candidates[bestIndex].maxCycles)) {
+                bestIndex = i;
+            }
+        }
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+const QVector<PlayerVariantFinder::Candidate> &PlayerVariantFinder::getCandidates() const {
+    return candidates;
+}
+
+/*************************************************************************/
+
+int PlayerVariantFinder::getBestIndex() const {
+    return bestIndex;
+}
+
+/*************************************************************************/
+
+bool PlayerVariantFinder::isWithinBudget() const {
+    return withinBudget;
+}
+
+/*************************************************************************/
+
+QString PlayerVariantFinder::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+QVector<DasmExporter::Variant> PlayerVariantFinder::getVariants(bool usesOverlay) {
+    QVector<DasmExporter::Variant> variants;
+    for (int inlineCalcInsIndex = 0; inlineCalcInsIndex < 2; ++inlineCalcInsIndex) {
+        // Inlining tt_FetchNote makes no difference without overlay
+        for (int inlineFetchNote = 0; inlineFetchNote < (usesOverlay ? 2 : 1); ++inlineFetchNote) {
+            variants.append({inlineCalcInsIndex == 1, inlineFetchNote == 1});
+        }
+    }
+    return variants;
+}
+
+/*************************************************************************/
+
+QString PlayerVariantFinder::variantToString(const DasmExporter::Variant &variant) {
+    QStringList flags;
+    flags.append(QString("TT_INLINE_CALCINSINDEX = %1").arg(variant.inlineCalcInsIndex ? 1 : 0));
+    flags.append(QString("TT_INLINE_FETCHNOTE = %1").arg(variant.inlineFetchNote ? 1 : 0));
+    return flags.join(", ");
+}
+
+}
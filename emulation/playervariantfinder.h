@@ -0,0 +1,67 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PLAYERVARIANTFINDER_H
+#define PLAYERVARIANTFINDER_H
+
+#include <QString>
+#include <QVector>
+
+#include "dasmexporter.h"
+#include "track/track.h"
+
+
+namespace Emulation {
+
+/* Finds the best dasm player variant for a track. Every variant is
+ * assembled and run over the whole song with PlayerHarness, so size
+ * and cycles are exact for this song. Variants are measured in
+ * parallel.
+ */
+class PlayerVariantFinder
+{
+public:
+    struct Candidate {
+        DasmExporter::Variant variant;
+        // False if the variant can't be used, see errorMessage
+        bool isValid;
+        QString errorMessage;
+        int playerSize;
+        int maxCycles;
+        double averageCycles;
+    };
+
+    explicit PlayerVariantFinder(Track::Track *track);
+
+    /* Measures all variants and picks the smallest one whose worst
+     * case is within cycleBudget. If there is none, the fastest one
+     * gets picked. Locks the track while needed. Returns false if no
+     * variant works at all. */
+    bool find(int cycleBudget);
+
+    const QVector<Candidate> &getCandidates() const;
+    // Index of the picked candidate, or -1
+    int getBestIndex() const;
+    bool isWithinBudget() const;
+    QString getErrorMessage() const;
+
+    /* All variants that make a difference for a track */
+    static QVector<DasmExporter::Variant> getVariants(bool usesOverlay);
+    static QString variantToString(const DasmExporter::Variant &variant);
+
+private:
+    Track::Track *pTrack = nullptr;
+    QString errorMessage;
+
+    QVector<Candidate> candidates;
+    int bestIndex = -1;
+    bool withinBudget = false;
+};
+
+}
+
+#endif // PLAYERVARIANTFINDER_H
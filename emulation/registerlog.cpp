@@ -0,0 +1,259 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "registerlog.h"
+
+#include <cstring>
+
+#include "TIASnd.h"
+#include "audiosink.h"
+
+
+namespace Emulation {
+
+namespace {
+
+const char magic[4] = {'T', 'T', 'R', 'L'};
+
+}
+
+/*************************************************************************/
+
+RegisterLogWriter::RegisterLogWriter(const QString &fileName) :
+    file(fileName)
+{
+}
+
+/*************************************************************************/
+
+RegisterLogWriter::~RegisterLogWriter() {
+    close();
+}
+
+/*************************************************************************/
+
+bool RegisterLogWriter::open(int frameRate) {
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorMessage = "Unable to write " + file.fileName();
+        return false;
+    }
+    // The number of frames gets filled in by close()
+    char header[RegisterLog::HeaderSize]{};
+    for (int i = 0; i < 4; ++i) {
+        header[i] = magic[i];
+    }
+    header[4] = char(RegisterLog::Version);
+    header[5] = char(frameRate);
+    file.write(header, RegisterLog::HeaderSize);
+    return true;
+}
+
+/*************************************************************************/
+
+void RegisterLogWriter::writeFrame(const uInt8 *registers) {
+    if (!file.isOpen()) {
+        return;
+    }
+    numFrames++;
+    uInt8 mask = 0;
+    for (int i = 0; i < RegisterLog::NumRegisters; ++i) {
+        if (registers[i] != previous[i]) {
+            mask |= uInt8(1 << i);
+        }
+    }
+    if (mask == 0) {
+        if (++runLength == RegisterLog::MaxRun) {
+            flushRun();
+        }
+        return;
+    }
+    flushRun();
+    char entry[1 + RegisterLog::NumRegisters];
+    int length = 0;
+    entry[length++] = char(mask);
+    for (int i = 0; i < RegisterLog::NumRegisters; ++i) {
+        if ((mask & (1 << i)) != 0) {
+            entry[length++] = char(registers[i]);
+            previous[i] = registers[i];
+        }
+    }
+    file.write(entry, length);
+}
+
+/*************************************************************************/
+
+bool RegisterLogWriter::close() {
+    if (!file.isOpen()) {
+        return errorMessage.isEmpty();
+    }
+    flushRun();
+    file.seek(8);
+    char count[4];
+    for (int i = 0; i < 4; ++i) {
+        count[i] = char(numFrames >> (8*i));
+    }
+    file.write(count, 4);
+    bool ok = file.error() == QFileDevice::NoError;
+    file.close();
+    if (!ok) {
+        errorMessage = "Unable to write " + file.fileName();
+    }
+    return ok;
+}
+
+/*************************************************************************/
+
+QString RegisterLogWriter::getFileName() const {
+    return file.fileName();
+}
+
+/*************************************************************************/
+
+int RegisterLogWriter::getNumFrames() const {
+    return numFrames;
+}
+
+/*************************************************************************/
+
+QString RegisterLogWriter::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+void RegisterLogWriter::flushRun() {
+    if (runLength > 0) {
+        char entry = char(0x80 | (runLength - 1));
+        file.write(&entry, 1);
+        runLength = 0;
+    }
+}
+
+/*************************************************************************/
+
+RegisterLogReader::RegisterLogReader(const QString &fileName) :
+    file(fileName)
+{
+}
+
+/*************************************************************************/
+
+RegisterLogReader::~RegisterLogReader() {
+    if (data != nullptr) {
+        file.unmap(const_cast<uchar *>(data));
+    }
+}
+
+/*************************************************************************/
+
+bool RegisterLogReader::open() {
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorMessage = "Unable to read " + file.fileName();
+        return false;
+    }
+    size = file.size();
+    if (size >= RegisterLog::HeaderSize) {
+        data = file.map(0, size);
+    }
+    if (data == nullptr || memcmp(data, magic, 4) != 0) {
+        errorMessage = file.fileName() + " is no register log!";
+        return false;
+    }
+    if (data[4] != RegisterLog::Version) {
+        errorMessage = file.fileName() + " is from a later version of TIATracker!";
+        return false;
+    }
+    frameRate = data[5];
+    numFrames = 0;
+    for (int i = 0; i < 4; ++i) {
+        numFrames |= int(data[8 + i]) << (8*i);
+    }
+    rewind();
+    return true;
+}
+
+/*************************************************************************/
+
+int RegisterLogReader::getFrameRate() const {
+    return frameRate;
+}
+
+/*************************************************************************/
+
+int RegisterLogReader::getNumFrames() const {
+    return numFrames;
+}
+
+/*************************************************************************/
+
+bool RegisterLogReader::readFrame(uInt8 *registers) {
+    if (data == nullptr || frame >= numFrames) {
+        return false;
+    }
+    if (runLeft == 0) {
+        if (pos >= size) {
+            errorMessage = QString("Register log ends in frame %1 of %2").arg(frame).arg(numFrames);
+            return false;
+        }
+        uInt8 code = data[pos++];
+        if ((code & 0x80) != 0) {
+            runLeft = (code & 0x7f) + 1;
+        } else {
+            for (int i = 0; i < RegisterLog::NumRegisters; ++i) {
+                if ((code & (1 << i)) != 0 && pos < size) {
+                    current[i] = data[pos++];
+                    code &= ~(1 << i);
+                }
+            }
+            // Unknown bits, or values missing at the end of the file
+            if (code != 0) {
+                errorMessage = QString("Register log is corrupt in frame %1").arg(frame);
+                return false;
+            }
+            runLeft = 1;
+        }
+    }
+    runLeft--;
+    frame++;
+    for (int i = 0; i < RegisterLog::NumRegisters; ++i) {
+        registers[i] = current[i];
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+void RegisterLogReader::rewind() {
+    pos = RegisterLog::HeaderSize;
+    frame = 0;
+    runLeft = 0;
+    for (int i = 0; i < RegisterLog::NumRegisters; ++i) {
+        current[i] = 0;
+    }
+}
+
+/*************************************************************************/
+
+bool RegisterLogReader::replay(AudioSink *sink) {
+    sink->setFrameRate(float(frameRate));
+    uInt8 registers[RegisterLog::NumRegisters];
+    while (readFrame(registers)) {
+        for (int i = 0; i < RegisterLog::NumRegisters; ++i) {
+            sink->set(uInt16(AUDC0 + i), registers[i]);
+        }
+        sink->endFrame();
+    }
+    return frame == numFrames;
+}
+
+/*************************************************************************/
+
+QString RegisterLogReader::getErrorMessage() const {
+    return errorMessage;
+}
+
+}
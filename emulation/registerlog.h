@@ -0,0 +1,126 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef REGISTERLOG_H
+#define REGISTERLOG_H
+
+#include <QFile>
+#include <QString>
+
+#include "bspf.h"
+
+
+namespace Emulation {
+
+class AudioSink;
+
+/* Binary log of the six TIA audio registers, one entry per frame, so
+ * a song can be captured once and then rendered at any sample rate or
+ * compared with another player without running the sequencer again.
+ *
+ * The file starts with a 12 byte header: "TTRL", the format version,
+ * the frame rate, two reserved bytes and the number of frames as a
+ * little endian 32 bit value. Then follows one code byte per frame or
+ * run of frames:
+ *  - 0mmmmmmm: a frame in which the registers with their bit set in
+ *    the mask m changed. Bit 0 is AUDC0, bit 5 AUDV1, in the order of
+ *    their addresses. The new values follow, one byte each.
+ *  - 1nnnnnnn: n + 1 frames without changes.
+ * All registers are 0 before the first frame.
+ */
+class RegisterLog
+{
+public:
+    static const int NumRegisters = 6;
+    static const int HeaderSize = 12;
+    static const uInt8 Version = 1;
+    static const int MaxRun = 128;
+};
+
+/*************************************************************************/
+
+/* Writes a register log, frame by frame */
+class RegisterLogWriter
+{
+public:
+    explicit RegisterLogWriter(const QString &fileName);
+    ~RegisterLogWriter();
+
+    /* Returns false if the file can't be written, see getErrorMessage() */
+    bool open(int frameRate);
+
+    /* Appends a frame. registers holds the values of AUDC0 to AUDV1
+     * in the order of their addresses. */
+    void writeFrame(const uInt8 *registers);
+
+    /* Writes pending frames and the number of frames into the header.
+     * Also done by the destructor. */
+    bool close();
+
+    QString getFileName() const;
+    int getNumFrames() const;
+    QString getErrorMessage() const;
+
+private:
+    void flushRun();
+
+    QFile file;
+    uInt8 previous[RegisterLog::NumRegisters]{};
+    // Unchanged frames not written yet
+    int runLength = 0;
+    int numFrames = 0;
+    QString errorMessage;
+};
+
+/*************************************************************************/
+
+/* Reads a register log. The file is memory-mapped and decoded as it
+ * is read, so logs of any length take no memory of their own. */
+class RegisterLogReader
+{
+public:
+    explicit RegisterLogReader(const QString &fileName);
+    ~RegisterLogReader();
+
+    /* Returns false if the file can't be read or is no register log,
+     * see getErrorMessage() */
+    bool open();
+
+    int getFrameRate() const;
+    int getNumFrames() const;
+
+    /* Decodes the next frame into registers, in the order of
+     * RegisterLogWriter::writeFrame(). Returns false after the last
+     * frame or if the log is corrupt, see getErrorMessage(). */
+    bool readFrame(uInt8 *registers);
+
+    /* Starts reading from the first frame again */
+    void rewind();
+
+    /* Sends the remaining frames to a sink, setting all registers in
+     * every frame. Returns false if the log is corrupt. */
+    bool replay(AudioSink *sink);
+
+    QString getErrorMessage() const;
+
+private:
+    QFile file;
+    const uchar *data = nullptr;
+    qint64 size = 0;
+    qint64 pos = RegisterLog::HeaderSize;
+    int frameRate = 50;
+    int numFrames = 0;
+    int frame = 0;
+    // Frames left in the current run of unchanged frames
+    int runLeft = 0;
+    uInt8 current[RegisterLog::NumRegisters]{};
+    QString errorMessage;
+};
+
+}
+
+#endif // REGISTERLOG_H
@@ -0,0 +1,358 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "rendercorpus.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+
+#include "TIASnd.h"
+#include "audiosink.h"
+#include "player.h"
+#include "track/track.h"
+
+
+namespace Emulation {
+
+const QString RenderCorpus::goldenFileName{"golden_renders.json"};
+
+/*************************************************************************/
+
+namespace {
+
+/* Appends the hash of every rendered frame and the registers at its end */
+class HashingSink : public RenderingSink
+{
+public:
+    HashingSink(QVector<quint64> *pcmHashes, QVector<quint64> *registers) :
+        RenderingSink(RenderCorpus::SampleRate), pPcmHashes(pcmHashes), pRegisters(registers)
+    {
+    }
+
+    void set(uInt16 address, uInt8 value) override {
+        int shift = 8*(address - AUDC0);
+        state = (state & ~(quint64(0xff) << shift)) | (quint64(value) << shift);
+        RenderingSink::set(address, value);
+    }
+
+protected:
+    void writeSamples(const Int16 *samples, int count) override {
+        // 64 bit FNV-1a
+        quint64 hash = 14695981039346656037ull;
+        const uchar *bytes = reinterpret_cast<const uchar *>(samples);
+        for (int i = 0; i < count*int(sizeof(Int16)); ++i) {
+            hash = (hash^bytes[i])*1099511628211ull;
+        }
+        pPcmHashes->append(hash);
+        pRegisters->append(state);
+    }
+
+private:
+    QVector<quint64> *pPcmHashes;
+    QVector<quint64> *pRegisters;
+    quint64 state = 0;
+};
+
+/*************************************************************************/
+
+quint64 packRegisters(int audc0, int audf0, int audv0, int audc1, int audf1, int audv1) {
+    quint64 values[6];
+    values[AUDC0 - AUDC0] = quint64(audc0);
+    values[AUDC1 - AUDC0] = quint64(audc1);
+    values[AUDF0 - AUDC0] = quint64(audf0);
+    values[AUDF1 - AUDC0] = quint64(audf1);
+    values[AUDV0 - AUDC0] = quint64(audv0);
+    values[AUDV1 - AUDC0] = quint64(audv1);
+    quint64 packed = 0;
+    for (int i = 0; i < 6; ++i) {
+        packed |= values[i] << (8*i);
+    }
+    return packed;
+}
+
+/*************************************************************************/
+
+QString toBase64(const QVector<quint64> &values) {
+    QByteArray bytes;
+    bytes.reserve(values.size()*8);
+    for (quint64 value : values) {
+        for (int i = 0; i < 8; ++i) {
+            bytes.append(char(value >> (8*i)));
+        }
+    }
+    return QString::fromLatin1(bytes.toBase64());
+}
+
+/*************************************************************************/
+
+QVector<quint64> fromBase64(const QString &string) {
+    QByteArray bytes = QByteArray::fromBase64(string.toLatin1());
+    QVector<quint64> values(bytes.size()/8);
+    for (int v = 0; v < values.size(); ++v) {
+        quint64 value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= quint64(uchar(bytes[v*8 + i])) << (8*i);
+        }
+        values[v] = value;
+    }
+    return values;
+}
+
+}
+
+/*************************************************************************/
+
+bool RenderCorpus::addSong(const QString &name, const QByteArray &json) {
+    // Loading reports errors to the user, so find out here instead of
+    // in a render thread
+    Track::Track track;
+    if (!track.fromJson(QJsonDocument::fromJson(json).object())) {
+        return false;
+    }
+    Case songCase;
+    songCase.name = name;
+    songCase.songJson = json;
+    cases.append(songCase);
+    return true;
+}
+
+/*************************************************************************/
+
+int RenderCorpus::addSongFolder(const QString &folderName) {
+    QDir dir(folderName);
+    QStringList fileNames = dir.entryList(QStringList("*.ttt"), QDir::Files);
+    int numAdded = 0;
+    for (const QString &fileName : fileNames) {
+        QFile loadFile(dir.filePath(fileName));
+        if (loadFile.open(QIODevice::ReadOnly) && addSong(fileName, loadFile.readAll())) {
+            numAdded++;
+        }
+    }
+    return numAdded;
+}
+
+/*************************************************************************/
+
+void RenderCorpus::addSyntheticCases() {
+    // Channel 1 stays silent, so differences show up in channel 0 alone
+    for (int audc = 0; audc < 16; ++audc) {
+        Case distortionCase;
+        distortionCase.name = QString("AUDC %1").arg(audc);
+        for (int from = 0; from < 32; ++from) {
+            for (int to = 0; to < 32; ++to) {
+                distortionCase.script.append(packRegisters(audc, from, 15, 0, 0, 0));
+                distortionCase.script.append(packRegisters(audc, to, 15, 0, 0, 0));
+            }
+        }
+        for (int from = 0; from < 16; ++from) {
+            for (int to = 0; to < 16; ++to) {
+                distortionCase.script.append(packRegisters(audc, 10, from, 0, 0, 0));
+                distortionCase.script.append(packRegisters(audc, 10, to, 0, 0, 0));
+            }
+        }
+        cases.append(distortionCase);
+    }
+
+    // Channel 1 goes through the transitions backwards, which also
+    // covers mixing both channels
+    Case transitionCase;
+    transitionCase.name = "AUDC transitions";
+    for (int from = 0; from < 16; ++from) {
+        for (int to = 0; to < 16; ++to) {
+            transitionCase.script.append(packRegisters(from, 10, 15, to, 20, 8));
+            transitionCase.script.append(packRegisters(to, 10, 15, from, 20, 8));
+        }
+    }
+    cases.append(transitionCase);
+}
+
+/*************************************************************************/
+
+void RenderCorpus::render() {
+    QtConcurrent::blockingMap(cases, [](Case &renderCase) {
+        renderCase.pcmHashes.clear();
+        renderCase.registers.clear();
+        renderFrames(renderCase);
+    });
+}
+
+/*************************************************************************/
+
+int RenderCorpus::getNumCases() const {
+    return cases.size();
+}
+
+/*************************************************************************/
+
+long RenderCorpus::getNumFrames() const {
+    long numFrames = 0;
+    for (const Case &renderCase : cases) {
+        numFrames += renderCase.pcmHashes.size();
+    }
+    return numFrames;
+}
+
+/*************************************************************************/
+
+bool RenderCorpus::save(const QString &fileName) const {
+    QDir().mkpath(QFileInfo(fileName).path());
+    QFile saveFile(fileName);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QJsonArray caseArray;
+    for (const Case &renderCase : cases) {
+        QJsonObject caseObject;
+        caseObject["name"] = renderCase.name;
+        caseObject["numFrames"] = renderCase.pcmHashes.size();
+        caseObject["pcm"] = toBase64(renderCase.pcmHashes);
+        caseObject["registers"] = toBase64(renderCase.registers);
+        caseArray.append(caseObject);
+    }
+    QJsonObject json;
+    json["version"] = Version;
+    json["sampleRate"] = SampleRate;
+    json["cases"] = caseArray;
+    saveFile.write(QJsonDocument(json).toJson());
+    return true;
+}
+
+/*************************************************************************/
+
+bool RenderCorpus::load(const QString &fileName) {
+    QFile loadFile(fileName);
+    if (!loadFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject json = QJsonDocument::fromJson(loadFile.readAll()).object();
+    if (json["version"].toInt() != Version || json["sampleRate"].toInt() != SampleRate) {
+        return false;
+    }
+    cases.clear();
+    QJsonArray caseArray = json["cases"].toArray();
+    for (int i = 0; i < caseArray.size(); ++i) {
+        QJsonObject caseObject = caseArray[i].toObject();
+        Case loadedCase;
+        loadedCase.name = caseObject["name"].toString();
+        loadedCase.pcmHashes = fromBase64(caseObject["pcm"].toString());
+        loadedCase.registers = fromBase64(caseObject["registers"].toString());
+        if (loadedCase.pcmHashes.size() != caseObject["numFrames"].toInt()
+                || loadedCase.registers.size() != loadedCase.pcmHashes.size()) {
+            return false;
+        }
+        cases.append(loadedCase);
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+QList<RenderCorpus::Divergence> RenderCorpus::compare(const RenderCorpus &golden) const {
+    QList<Divergence> divergences;
+    QStringList goldenNames;
+    for (const Case &goldenCase : golden.cases) {
+        goldenNames.append(goldenCase.name);
+        const Case *pCase = nullptr;
+        for (const Case &renderCase : cases) {
+            if (renderCase.name == goldenCase.name) {
+                pCase = &renderCase;
+                break;
+            }
+        }
+        if (pCase == nullptr) {
+            divergences.append({goldenCase.name, -1, false, 0, 0, "missing from this render"});
+            continue;
+        }
+
+        int numFrames = qMin(pCase->pcmHashes.size(), goldenCase.pcmHashes.size());
+        int frame = 0;
+        while (frame < numFrames
+               && pCase->registers[frame] == goldenCase.registers[frame]
+               && pCase->pcmHashes[frame] == goldenCase.pcmHashes[frame]) {
+            frame++;
+        }
+        if (frame < numFrames) {
+            bool registersDiffer = pCase->registers[frame] != goldenCase.registers[frame];
+            divergences.append({goldenCase.name, frame, registersDiffer,
+                                goldenCase.registers[frame], pCase->registers[frame],
+                                registersDiffer ? "registers differ" : "samples differ"});
+        } else if (pCase->pcmHashes.size() != goldenCase.pcmHashes.size()) {
+            divergences.append({goldenCase.name, frame, false, 0, 0,
+                                QString("ends after %1 frames instead of %2")
+                                .arg(pCase->pcmHashes.size()).arg(goldenCase.pcmHashes.size())});
+        }
+    }
+    for (const Case &renderCase : cases) {
+        if (!goldenNames.contains(renderCase.name)) {
+            divergences.append({renderCase.name, -1, false, 0, 0, "not in the golden corpus"});
+        }
+    }
+    return divergences;
+}
+
+/*************************************************************************/
+
+QString RenderCorpus::divergenceToString(const Divergence &divergence) {
+    if (divergence.frame == -1) {
+        return divergence.name + ": " + divergence.reason;
+    }
+    QString result = QString("%1: frame %2, %3").arg(divergence.name).arg(divergence.frame).arg(divergence.reason);
+    if (divergence.registersDiffer) {
+        const char *names[6] = {"AUDC0", "AUDC1", "AUDF0", "AUDF1", "AUDV0", "AUDV1"};
+        for (int i = 0; i < 6; ++i) {
+            int goldenValue = int((divergence.goldenRegisters >> (8*i)) & 0xff);
+            int value = int((divergence.registers >> (8*i)) & 0xff);
+            if (value != goldenValue) {
+                result.append(QString(", %1 %2 instead of %3").arg(names[i]).arg(value).arg(goldenValue));
+            }
+        }
+    }
+    return result;
+}
+
+/*************************************************************************/
+
+void RenderCorpus::renderFrames(Case &renderCase) {
+    // The player owns its sink
+    HashingSink *sink = new HashingSink(&renderCase.pcmHashes, &renderCase.registers);
+    if (renderCase.songJson.isEmpty()) {
+        for (quint64 state : renderCase.script) {
+            for (int i = 0; i < 6; ++i) {
+                sink->set(uInt16(AUDC0 + i), uInt8(state >> (8*i)));
+            }
+            sink->endFrame();
+        }
+        delete sink;
+        return;
+    }
+
+    Track::Track track;
+    track.fromJson(QJsonDocument::fromJson(renderCase.songJson).object());
+    sink->setFrameRate(track.getTvMode() == TiaSound::TvStandard::PAL ? 50.0 : 60.0);
+    Player player(&track, sink);
+    int startRow[2];
+    for (int channel = 0; channel < 2; ++channel) {
+        int startEntry = track.startPatterns[channel];
+        startRow[channel] = track.channelSequences[channel].sequence[startEntry].firstNoteNumber;
+    }
+    player.playTrack(startRow[0], startRow[1]);
+    track.lock();
+    for (int frame = 0; frame < MaxSongFrames; ++frame) {
+        player.advanceFrame();
+        if (!player.isPlaying()) {
+            break;
+        }
+    }
+    track.unlock();
+}
+
+}
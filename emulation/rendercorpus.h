@@ -0,0 +1,100 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef RENDERCORPUS_H
+#define RENDERCORPUS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+
+namespace Emulation {
+
+/* Regression corpus for the sound emulation and the player. Songs and
+ * synthetic register scripts are rendered offline, exactly like
+ * SoundSDL2 plays them in precise mode, and every frame is reduced to
+ * a hash of its samples plus the six audio registers at its end. The
+ * registers are few enough to be kept verbatim rather than hashed.
+ *
+ * A corpus saved from a known good build is the golden one. Comparing
+ * a fresh render against it points to the first frame where each case
+ * diverges, and tells whether the player wrote different registers or
+ * only the synthesized samples changed.
+ */
+class RenderCorpus
+{
+public:
+    // The golden corpus of the songs in songs/ and the synthetic cases.
+    // It is kept in data/ and installed next to the program.
+    static const QString goldenFileName;
+    static const int Version = 1;
+    static const int SampleRate = 44100;
+    // Songs that don't end on their own are cut, after 3 minutes in PAL
+    static const int MaxSongFrames = 3*60*50;
+
+    /* First difference of a case from the golden corpus */
+    struct Divergence {
+        QString name;
+        // -1 if the case is missing in one of the corpora
+        int frame;
+        // False if only the samples differ
+        bool registersDiffer;
+        // Registers at the end of the frame, AUDC0 in the lowest byte
+        quint64 goldenRegisters;
+        quint64 registers;
+        QString reason;
+    };
+
+    /* Adds a song, json being the contents of its .ttt file. Returns
+     * false if it can't be loaded. */
+    bool addSong(const QString &name, const QByteArray &json);
+
+    /* Adds all .ttt files of a folder and returns how many could be
+     * loaded */
+    int addSongFolder(const QString &folderName);
+
+    /* Adds register scripts that go through every AUDF and every AUDV
+     * transition of every distortion, and through every AUDC transition */
+    void addSyntheticCases();
+
+    /* Renders all cases, in parallel */
+    void render();
+
+    int getNumCases() const;
+    long getNumFrames() const;
+
+    /* Returns false if the file can't be written or read */
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+    /* Differences from the golden corpus, in its order of cases */
+    QList<Divergence> compare(const RenderCorpus &golden) const;
+
+    static QString divergenceToString(const Divergence &divergence);
+
+private:
+    struct Case {
+        QString name;
+        // Empty for synthetic cases
+        QByteArray songJson;
+        // Register state of every frame, packed like Divergence::registers
+        QVector<quint64> script;
+
+        QVector<quint64> pcmHashes;
+        QVector<quint64> registers;
+    };
+
+    static void renderFrames(Case &renderCase);
+
+    QVector<Case> cases;
+};
+
+}
+
+#endif // RENDERCORPUS_H
@@ -0,0 +1,74 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "ringsink.h"
+
+#include <QMutexLocker>
+
+
+namespace Emulation {
+
+RingSink::RingSink(int capacity, int sampleRate) :
+    RenderingSink(sampleRate),
+    ring(capacity)
+{
+}
+
+/*************************************************************************/
+
+int RingSink::read(Int16 *dest, int maxCount) {
+    QMutexLocker locker(&mutex);
+    int count = qMin(maxCount, numAvailable);
+    for (int i = 0; i < count; ++i) {
+        dest[i] = ring[readPos];
+        readPos = (readPos + 1)%ring.size();
+    }
+    numAvailable -= count;
+    return count;
+}
+
+/*************************************************************************/
+
+int RingSink::getNumAvailable() {
+    QMutexLocker locker(&mutex);
+    return numAvailable;
+}
+
+/*************************************************************************/
+
+long RingSink::getNumOverwritten() {
+    QMutexLocker locker(&mutex);
+    return numOverwritten;
+}
+
+/*************************************************************************/
+
+void RingSink::clear() {
+    QMutexLocker locker(&mutex);
+    readPos = 0;
+    numAvailable = 0;
+    numOverwritten = 0;
+}
+
+/*************************************************************************/
+
+void RingSink::writeSamples(const Int16 *samples, int count) {
+    QMutexLocker locker(&mutex);
+    int capacity = ring.size();
+    for (int i = 0; i < count; ++i) {
+        ring[(readPos + numAvailable)%capacity] = samples[i];
+        if (numAvailable == capacity) {
+            // Full: drop the oldest sample
+            readPos = (readPos + 1)%capacity;
+            numOverwritten++;
+        } else {
+            numAvailable++;
+        }
+    }
+}
+
+}
@@ -0,0 +1,51 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef RINGSINK_H
+#define RINGSINK_H
+
+#include <QMutex>
+#include <QVector>
+
+#include "audiosink.h"
+
+
+namespace Emulation {
+
+/* Renders frames into an in-memory ring of mono samples that can be
+ * read from another thread. If the reader falls behind, the oldest
+ * samples get overwritten.
+ */
+class RingSink : public RenderingSink
+{
+public:
+    RingSink(int capacity, int sampleRate = 44100);
+
+    /* Copies up to maxCount samples into dest and removes them.
+     * Returns the number of samples copied. */
+    int read(Int16 *dest, int maxCount);
+
+    int getNumAvailable();
+    // Samples that got overwritten before they were read
+    long getNumOverwritten();
+
+    void clear();
+
+protected:
+    void writeSamples(const Int16 *samples, int count) override;
+
+private:
+    QMutex mutex;
+    QVector<Int16> ring;
+    int readPos = 0;
+    int numAvailable = 0;
+    long numOverwritten = 0;
+};
+
+}
+
+#endif // RINGSINK_H
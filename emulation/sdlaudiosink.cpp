@@ -0,0 +1,102 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "sdlaudiosink.h"
+
+
+namespace Emulation {
+
+SdlAudioSink::SdlAudioSink(int sampleRate, int bufferSize) :
+    sdlSound(&tiaSound, sampleRate, bufferSize)
+{
+    tiaSound.channels(2, false);
+    sdlSound.setFrameRate(50.0);
+    sdlSound.setPreciseTiming(true);
+    sdlSound.open();
+    sdlSound.mute(false);
+    sdlSound.setEnabled(true);
+    sdlSound.setVolume(100);
+}
+
+/*************************************************************************/
+
+SdlAudioSink::~SdlAudioSink() {
+    sdlSound.close();
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::set(uInt16 address, uInt8 value) {
+    // Cycles are not used in precise mode
+    sdlSound.set(address, value, 0);
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::endFrame() {
+    sdlSound.endFrame();
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::setFrameRate(float rate) {
+    sdlSound.close();
+    sdlSound.setFrameRate(rate);
+    sdlSound.open();
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::configureDevice(int sampleRate, int bufferSize, bool adaptive, int prerenderFrames) {
+    sdlSound.setDevice(sampleRate, bufferSize);
+    sdlSound.setAdaptiveBufferSize(adaptive);
+    sdlSound.setPrerenderFrames(uInt32(prerenderFrames));
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::update() {
+    sdlSound.adaptBufferSize();
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::markInput(qint64 inputMicros) {
+    sdlSound.markInput(inputMicros);
+}
+
+/*************************************************************************/
+
+bool SdlAudioSink::takeInputTiming(InputTiming *pTiming) {
+    SoundSDL2::TimingStats stats = sdlSound.getTimingStats();
+    if (stats.measuredInputs == measuredInputs) {
+        return false;
+    }
+    measuredInputs = stats.measuredInputs;
+    *pTiming = {stats.lastInputMicros, stats.lastAppliedMicros, stats.lastAudibleMicros};
+    return true;
+}
+
+/*************************************************************************/
+
+AudioSink::Status SdlAudioSink::getStatus() {
+    SoundSDL2::TimingStats stats = sdlSound.getTimingStats();
+    // Only one of them counts, depending on the mode
+    int lateFrames = int(stats.starvedFrames + stats.ringUnderruns);
+    return {
+        sdlSound.getSampleRate(), sdlSound.getBufferSize(),
+        int(sdlSound.getUnderruns()), lateFrames, int(stats.maxCallbackMicros)
+    };
+}
+
+/*************************************************************************/
+
+void SdlAudioSink::resetStatus() {
+    sdlSound.resetTimingStats();
+}
+
+}
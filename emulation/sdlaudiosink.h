@@ -0,0 +1,46 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef SDLAUDIOSINK_H
+#define SDLAUDIOSINK_H
+
+#include <SDL.h>
+
+#include "audiosink.h"
+#include "TIASnd.h"
+#include "SoundSDL2.h"
+
+
+namespace Emulation {
+
+/* Plays frames on the sound device, using SoundSDL2 in precise mode */
+class SdlAudioSink : public AudioSink
+{
+public:
+    SdlAudioSink(int sampleRate = 44100, int bufferSize = 1024);
+    ~SdlAudioSink();
+
+    void set(uInt16 address, uInt8 value) override;
+    void endFrame() override;
+    void setFrameRate(float rate) override;
+    void configureDevice(int sampleRate, int bufferSize, bool adaptive, int prerenderFrames) override;
+    void update() override;
+    void markInput(qint64 inputMicros) override;
+    bool takeInputTiming(InputTiming *pTiming) override;
+    Status getStatus() override;
+    void resetStatus() override;
+
+private:
+    TIASound tiaSound;
+    SoundSDL2 sdlSound;
+    // Inputs measured at the last takeInputTiming()
+    uInt32 measuredInputs = 0;
+};
+
+}
+
+#endif // SDLAUDIOSINK_H
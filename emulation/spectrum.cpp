@@ -0,0 +1,153 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "spectrum.h"
+
+#include <QtConcurrent>
+#include <cmath>
+
+
+namespace Emulation {
+
+constexpr double BandAnalyzer::LowestFrequency;
+constexpr double BandAnalyzer::HighestFrequency;
+constexpr double BandAnalyzer::Compression;
+
+/*************************************************************************/
+
+void fft(QVector<Complex> &data, bool inverse) {
+    int size = data.size();
+    for (int i = 1, j = 0; i < size; ++i) {
+        int bit = size>>1;
+        for (; (j&bit) != 0; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    QVector<Complex> twiddles(size/2);
+    for (int k = 0; k < size/2; ++k) {
+        twiddles[k] = std::polar(1.0, (inverse ? 2.0 : -2.0)*M_PI*k/size);
+    }
+    for (int length = 2; length <= size; length <<= 1) {
+        int stride = size/length;
+        for (int start = 0; start < size; start += length) {
+            for (int k = 0; k < length/2; ++k) {
+                Complex even = data[start + k];
+                Complex odd = data[start + k + length/2]*twiddles[k*stride];
+                data[start + k] = even + odd;
+                data[start + k + length/2] = even - odd;
+            }
+        }
+    }
+}
+
+/*************************************************************************/
+
+BandAnalyzer::BandAnalyzer(int sampleRate, int frameLength) :
+    sampleRate(sampleRate), frameLength(frameLength)
+{
+    while (fftSize < frameLength) {
+        fftSize <<= 1;
+    }
+    window.resize(frameLength);
+    for (int i = 0; i < frameLength; ++i) {
+        window[i] = 0.5 - 0.5*std::cos(2.0*M_PI*(i + 0.5)/frameLength);
+    }
+
+    // Bands too narrow for the FFT resolution get at least one bin
+    double highest = std::min(HighestFrequency, sampleRate/2.0);
+    int lastBin = fftSize/2;
+    bandStarts.resize(NumBands + 1);
+    for (int band = 0; band <= NumBands; ++band) {
+        double freq = LowestFrequency*std::pow(highest/LowestFrequency, double(band)/NumBands);
+        int bin = int(std::round(freq*fftSize/sampleRate));
+        bandStarts[band] = std::max(1, std::min(bin, lastBin));
+    }
+}
+
+/*************************************************************************/
+
+int BandAnalyzer::getSampleRate() const {
+    return sampleRate;
+}
+
+/*************************************************************************/
+
+int BandAnalyzer::getFrameLength() const {
+    return frameLength;
+}
+
+/*************************************************************************/
+
+QVector<double> BandAnalyzer::analyze(const double *samples) const {
+    QVector<double> bands = analyzePower(samples);
+    for (double &band : bands) {
+        band = std::sqrt(band);
+    }
+    return bands;
+}
+
+/*************************************************************************/
+
+QVector<double> BandAnalyzer::analyzePower(const double *samples) const {
+    // TIA output is far from zero-centered, so remove the offset
+    // before it leaks into the lowest bands
+    double mean = 0.0;
+    for (int i = 0; i < frameLength; ++i) {
+        mean += samples[i];
+    }
+    mean /= frameLength;
+    QVector<Complex> spectrum(fftSize);
+    for (int i = 0; i < frameLength; ++i) {
+        spectrum[i] = (samples[i] - mean)*window[i];
+    }
+    fft(spectrum, false);
+    QVector<double> bands(NumBands);
+    for (int band = 0; band < NumBands; ++band) {
+        int start = bandStarts[band];
+        int end = std::max(bandStarts[band + 1], start + 1);
+        double power = 0.0;
+        for (int bin = start; bin < end; ++bin) {
+            power += std::norm(spectrum[bin]);
+        }
+        bands[band] = power/frameLength;
+    }
+    return bands;
+}
+
+/*************************************************************************/
+
+QVector<QVector<double>> BandAnalyzer::analyzeFrames(const QVector<double> &samples, int maxFrames) const {
+    int numFrames = qMin(maxFrames, (samples.size() + frameLength - 1)/frameLength);
+    QVector<int> starts;
+    for (int frame = 0; frame < numFrames; ++frame) {
+        starts.append(frame*frameLength);
+    }
+    QVector<QVector<double>> frames(numFrames);
+    QVector<QVector<double>> *pFrames = &frames;
+    QtConcurrent::blockingMap(starts, [this, &samples, pFrames](int &start) {
+        QVector<double> frameSamples(frameLength, 0.0);
+        for (int i = 0; i < frameLength && start + i < samples.size(); ++i) {
+            frameSamples[i] = samples[start + i];
+        }
+        (*pFrames)[start/frameLength] = analyze(frameSamples.constData());
+    });
+    return frames;
+}
+
+/*************************************************************************/
+
+void BandAnalyzer::compress(QVector<double> &bands) {
+    for (double &band : bands) {
+        band = std::pow(band, Compression);
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <QVector>
+#include <complex>
+
+
+namespace Emulation {
+
+typedef std::complex<double> Complex;
+
+/* Iterative radix-2 FFT, size must be a power of 2. The inverse is not
+ * scaled by 1/size. */
+void fft(QVector<Complex> &data, bool inverse);
+
+/* Reduces one TV frame of audio to the amplitudes of a few logarithmically
+ * spaced frequency bands, which is what sample fitting compares. The
+ * frame gets a Hann window and is zero-padded to the next power of 2.
+ *
+ * Bands are linear in the amplitude of the input, so scaling the input
+ * by a volume scales all bands by the same factor. The same holds for
+ * compressed bands, which are closer to perceived loudness.
+ */
+class BandAnalyzer
+{
+public:
+    static const int NumBands = 32;
+    static constexpr double LowestFrequency = 40.0;
+    static constexpr double HighestFrequency = 16000.0;
+    // Exponent of the loudness compression
+    static constexpr double Compression = 0.3;
+
+    BandAnalyzer(int sampleRate, int frameLength);
+
+    int getSampleRate() const;
+    int getFrameLength() const;
+
+    /* Band amplitudes of frameLength samples */
+    QVector<double> analyze(const double *samples) const;
+
+    /* Band powers of frameLength samples, for averaging several frames */
+    QVector<double> analyzePower(const double *samples) const;
+
+    /* Band amplitudes of consecutive frames of a sample, at most
+     * maxFrames of them. The last one is padded with silence. Frames
+     * are analyzed in parallel. */
+    QVector<QVector<double>> analyzeFrames(const QVector<double> &samples, int maxFrames) const;
+
+    /* Compresses band amplitudes towards perceived loudness */
+    static void compress(QVector<double> &bands);
+
+private:
+    int sampleRate;
+    int frameLength;
+    int fftSize = 1;
+    QVector<double> window;
+    // First FFT bin of every band, plus the end of the last one
+    QVector<int> bandStarts;
+};
+
+}
+
+#endif // SPECTRUM_H
@@ -0,0 +1,111 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "stemfilesink.h"
+
+
+namespace Emulation {
+
+StemFileSink::StemFileSink(const QString &baseName, int sampleRate) :
+    sampleRate(sampleRate),
+    frameClock(sampleRate, 50.0),
+    channel0Writer(baseName + "_ch0.wav", sampleRate),
+    channel1Writer(baseName + "_ch1.wav", sampleRate),
+    mixWriter(baseName + "_mix.wav", sampleRate)
+{
+    tiaSound.outputFrequency(sampleRate);
+    tiaSound.channels(2, true);
+}
+
+/*************************************************************************/
+
+void StemFileSink::set(uInt16 address, uInt8 value) {
+    tiaSound.set(address, value);
+}
+
+/*************************************************************************/
+
+void StemFileSink::endFrame() {
+    int count = frameClock.nextFrameSamples();
+    stereoBuffer.resize(count*2);
+    tiaSound.process(stereoBuffer.data(), uInt32(count));
+    for (QVector<Int16> &stemBuffer : stemBuffers) {
+        stemBuffer.resize(count);
+    }
+    const Int16 *stereo = stereoBuffer.constData();
+    Int16 *channel0 = stemBuffers[0].data();
+    Int16 *channel1 = stemBuffers[1].data();
+    Int16 *mix = stemBuffers[2].data();
+    for (int i = 0; i < count; ++i) {
+        channel0[i] = stereo[2*i];
+        channel1[i] = stereo[2*i + 1];
+        mix[i] = Int16(stereo[2*i] + stereo[2*i + 1]);
+    }
+    channel0Writer.write(channel0, count);
+    channel1Writer.write(channel1, count);
+    mixWriter.write(mix, count);
+}
+
+/*************************************************************************/
+
+void StemFileSink::setFrameRate(float rate) {
+    frameClock.setRates(sampleRate, rate);
+}
+
+/*************************************************************************/
+
+bool StemFileSink::open() {
+    for (WavFileWriter *writer : {&channel0Writer, &channel1Writer, &mixWriter}) {
+        if (!writer->open()) {
+            errorMessage = writer->getErrorMessage();
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+bool StemFileSink::close() {
+    bool ok = true;
+    for (WavFileWriter *writer : {&channel0Writer, &channel1Writer, &mixWriter}) {
+        // Writers that were never opened have nothing to finish
+        if (!writer->close() && !writer->getErrorMessage().isEmpty()) {
+            errorMessage = writer->getErrorMessage();
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/*************************************************************************/
+
+QString StemFileSink::getFileName(int stem) const {
+    switch (stem) {
+    case 0:
+        return channel0Writer.getFileName();
+    case 1:
+        return channel1Writer.getFileName();
+    default:
+        return mixWriter.getFileName();
+    }
+}
+
+/*************************************************************************/
+
+long StemFileSink::getNumSamples() const {
+    return mixWriter.getNumSamples();
+}
+
+/*************************************************************************/
+
+QString StemFileSink::getErrorMessage() const {
+    return errorMessage;
+}
+
+}
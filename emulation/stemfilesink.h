@@ -0,0 +1,63 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef STEMFILESINK_H
+#define STEMFILESINK_H
+
+#include <QString>
+#include <QVector>
+
+#include "audiosink.h"
+#include "wavfilewriter.h"
+
+
+namespace Emulation {
+
+/* Renders frames into three 16 bit mono WAV files at once: channel 0,
+ * channel 1 and their mix, named <baseName>_ch0.wav, <baseName>_ch1.wav
+ * and <baseName>_mix.wav.
+ *
+ * TIASound runs in stereo mode, which emits both channels side by side
+ * in one pass. Their sum is what the mono modes output, so the mix is
+ * the same as the output of a WavFileSink.
+ */
+class StemFileSink : public AudioSink
+{
+public:
+    static const int NumStems = 3;
+
+    StemFileSink(const QString &baseName, int sampleRate = 44100);
+
+    void set(uInt16 address, uInt8 value) override;
+    void endFrame() override;
+    void setFrameRate(float rate) override;
+
+    /* Returns false if a file can't be written, see getErrorMessage() */
+    bool open();
+    /* Finishes the WAV headers. Also done by the destructor. */
+    bool close();
+
+    QString getFileName(int stem) const;
+    long getNumSamples() const;
+    QString getErrorMessage() const;
+
+private:
+    int sampleRate;
+    TIASound tiaSound;
+    FrameClock frameClock;
+    // Samples of channel 0 and 1, interleaved
+    QVector<Int16> stereoBuffer;
+    QVector<Int16> stemBuffers[NumStems];
+    WavFileWriter channel0Writer;
+    WavFileWriter channel1Writer;
+    WavFileWriter mixWriter;
+    QString errorMessage;
+};
+
+}
+
+#endif // STEMFILESINK_H
@@ -0,0 +1,167 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "trackkeyframes.h"
+
+#include "track/pattern.h"
+
+
+namespace Emulation {
+
+TrackKeyframes::TrackKeyframes(Track::Track *track, int interval)
+{
+    pTrack = track;
+    this->interval = interval;
+}
+
+/*************************************************************************/
+
+void TrackKeyframes::updateToRow(int channel, int row, int maxFrames) {
+    restartIfChanged();
+    fastForward(channel, row, maxFrames);
+}
+
+/*************************************************************************/
+
+void TrackKeyframes::update(int maxFrames) {
+    restartIfChanged();
+    fastForward(-1, 0, maxFrames);
+}
+
+/*************************************************************************/
+
+void TrackKeyframes::restartIfChanged() {
+    quint32 newChecksum = pTrack->calcChecksum(true);
+    if (isValid && newChecksum == checksum) {
+        return;
+    }
+    checksum = newChecksum;
+    isValid = true;
+    isComplete = false;
+    numFrames = 0;
+    keyframes.clear();
+    rowFrames[0].clear();
+    rowFrames[1].clear();
+    visited.clear();
+    pitchUsage.fill(0, 16*32);
+
+    int startRow[2];
+    for (int channel = 0; channel < 2; ++channel) {
+        int startEntry = pTrack->startPatterns[channel];
+        startRow[channel] = pTrack->channelSequences[channel].sequence[startEntry].firstNoteNumber;
+    }
+    Player player(pTrack);
+    player.startTrack(startRow[0], startRow[1]);
+    nextState = player.getTrackState();
+}
+
+/*************************************************************************/
+
+void TrackKeyframes::fastForward(int channel, int row, int maxFrames) {
+    if (isComplete || (channel != -1 && rowFrames[channel].contains(row))) {
+        return;
+    }
+    Player player(pTrack);
+    player.playTrackState(nextState);
+    while (numFrames < maxFrames) {
+        int frame = numFrames;
+        Player::TrackState state = nextState;
+        if (frame%interval == 0) {
+            keyframes.append(state);
+        }
+        player.advanceFrame();
+        if (!player.isPlaying()) {
+            isComplete = true;
+            return;
+        }
+        numFrames++;
+        nextState = player.getTrackState();
+        for (int c = 0; c < 2; ++c) {
+            if (nextState.trackMode[c] == Track::Note::instrumentType::Instrument
+                    && (nextState.audV[c]&0x0f) != 0) {
+                pitchUsage[(nextState.audC[c]&0x0f)*32 + (nextState.audF[c]&0x1f)]++;
+            }
+        }
+        if (state.tick != 0) {
+            continue;
+        }
+        // Sequencer tick: both channels got a new row. Taken from the
+        // state before the frame, since an overlay percussion can
+        // already have moved on to the next row within the frame.
+        quint64 position = 0;
+        for (int c = 0; c < 2; ++c) {
+            int entryIndex = state.entryIndex[c];
+            int noteIndex = state.noteIndex[c];
+            if (!state.isFirstNote && !state.isOverlay[c]) {
+                pTrack->getNextNoteWithGoto(c, &entryIndex, &noteIndex);
+            }
+            int playedRow = pTrack->channelSequences[c].sequence[entryIndex].firstNoteNumber + noteIndex;
+            if (!rowFrames[c].contains(playedRow)) {
+                rowFrames[c][playedRow] = frame;
+            }
+            position = (position<<16)|quint64(entryIndex);
+            position = (position<<16)|quint64(noteIndex);
+        }
+        if (visited.contains(position)) {
+            isComplete = true;
+            return;
+        }
+        visited.insert(position);
+        if (channel != -1 && rowFrames[channel].contains(row)) {
+            return;
+        }
+    }
+}
+
+/*************************************************************************/
+
+void TrackKeyframes::invalidate() {
+    isValid = false;
+}
+
+/*************************************************************************/
+
+int TrackKeyframes::getRowFrame(int channel, int row) const {
+    return rowFrames[channel].value(row, -1);
+}
+
+/*************************************************************************/
+
+bool TrackKeyframes::getRowState(int channel, int row, Player::TrackState *pState) const {
+    int frame = getRowFrame(channel, row);
+    if (frame == -1) {
+        return false;
+    }
+    int keyframe = frame/interval;
+    Player player(pTrack);
+    player.playTrackState(keyframes[keyframe]);
+    for (int i = keyframe*interval; i < frame; ++i) {
+        player.advanceFrame();
+    }
+    *pState = player.getTrackState();
+    return true;
+}
+
+/*************************************************************************/
+
+int TrackKeyframes::getNumFrames() const {
+    return numFrames;
+}
+
+/*************************************************************************/
+
+int TrackKeyframes::getNumKeyframes() const {
+    return keyframes.size();
+}
+
+/*************************************************************************/
+
+const QVector<int> &TrackKeyframes::getPitchUsage() const {
+    return pitchUsage;
+}
+
+}
@@ -0,0 +1,108 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef TRACKKEYFRAMES_H
+#define TRACKKEYFRAMES_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include "player.h"
+#include "track/track.h"
+
+
+namespace Emulation {
+
+/* Keyframes of the player state for seeking inside a song. The song is
+ * fast-forwarded without output from the start patterns, and the full
+ * track state is stored every few frames. Seeking to a row then
+ * restores the keyframe before it and plays at most one interval
+ * forward, so notes started before the row keep sounding exactly as
+ * they would have.
+ *
+ * The fast-forward only goes as far as it has been asked for and
+ * continues from there later, so seeking near the start after an edit
+ * stays cheap. It stops at the end of the song, when the song loops,
+ * at the first invalid note or after maxFrames.
+ *
+ * The same run counts how many frames every AUDC/AUDF pair is played
+ * by instruments, as input for tuning a pitch guide to the song.
+ *
+ * The keyframes are rebuilt when the track has changed since the last
+ * update. The TIA poly counters are not part of the state, since they
+ * run in the audio sink.
+ */
+class TrackKeyframes
+{
+public:
+    // Frames between two keyframes
+    static const int DefaultInterval = 32;
+    // 30 minutes PAL
+    static const int DefaultMaxFrames = 30*60*50;
+
+    explicit TrackKeyframes(Track::Track *track, int interval = DefaultInterval);
+
+    /* Starts over if the track has changed and fast-forwards until
+     * a row of a channel has been played. The track must be locked by
+     * the caller. */
+    void updateToRow(int channel, int row, int maxFrames = DefaultMaxFrames);
+
+    /* Same, but fast-forwards as far as the song goes */
+    void update(int maxFrames = DefaultMaxFrames);
+
+    /* Forces a rebuild on the next update */
+    void invalidate();
+
+    /* Frame in which a row of a channel gets played first when playing
+     * from the start patterns, or -1 if it never does */
+    int getRowFrame(int channel, int row) const;
+
+    /* State right before a row of a channel gets played first. The
+     * track must be locked by the caller. Returns false if the row
+     * hasn't been reached by the fast-forward. */
+    bool getRowState(int channel, int row, Player::TrackState *pState) const;
+
+    int getNumFrames() const;
+    int getNumKeyframes() const;
+
+    /* Frames in which instruments play an AUDC/AUDF pair with a volume
+     * above 0, summed over both channels. Indexed by audc*32 + audf.
+     * Covers the whole song only after update(). */
+    const QVector<int> &getPitchUsage() const;
+
+private:
+    /* Clears everything if the track has changed since the last run */
+    void restartIfChanged();
+
+    /* Fast-forwards until the row has been played, or to the end of
+     * the song for channel -1 */
+    void fastForward(int channel, int row, int maxFrames);
+
+    Track::Track *pTrack = nullptr;
+    int interval;
+
+    bool isValid = false;
+    // Track::calcChecksum() with contents
+    quint32 checksum = 0;
+    // The song has ended or looped
+    bool isComplete = false;
+    int numFrames = 0;
+    // State before frame numFrames, to continue the fast-forward
+    Player::TrackState nextState;
+    // Sequencer positions seen so far, to detect when the song loops
+    QSet<quint64> visited;
+    // State before frame i*interval
+    QVector<Player::TrackState> keyframes;
+    // First frame in which a row gets played, per channel
+    QHash<int, int> rowFrames[2];
+    QVector<int> pitchUsage;
+};
+
+}
+
+#endif // TRACKKEYFRAMES_H
@@ -0,0 +1,178 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "voicedictionary.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+#include "TIASnd.h"
+
+
+namespace Emulation {
+
+VoiceDictionary::VoiceDictionary(const BandAnalyzer &analyzer) :
+    analyzer(analyzer)
+{
+    voices.resize(16*32);
+    QVector<int> combinations;
+    for (int i = 0; i < 16*32; ++i) {
+        combinations.append(i);
+    }
+    QtConcurrent::blockingMap(combinations, [this](int &combination) {
+        render(combination/32, combination%32, voices[combination]);
+    });
+
+    // Median, as the quietest and loudest voices are far apart
+    QVector<double> levels;
+    for (const Voice &voice : voices) {
+        if (voice.level > 0.0) {
+            levels.append(voice.level);
+        }
+    }
+    if (!levels.isEmpty()) {
+        std::sort(levels.begin(), levels.end());
+        referenceLevel = levels[levels.size()/2];
+    }
+}
+
+/*************************************************************************/
+
+QSharedPointer<const VoiceDictionary> VoiceDictionary::get(int sampleRate, int frameLength) {
+    static QMutex mutex;
+    static QMap<QPair<int, int>, QSharedPointer<const VoiceDictionary>> cache;
+    QMutexLocker locker(&mutex);
+    QPair<int, int> key(sampleRate, frameLength);
+    if (!cache.contains(key)) {
+        cache[key] = QSharedPointer<const VoiceDictionary>(
+                    new VoiceDictionary(BandAnalyzer(sampleRate, frameLength)));
+    }
+    return cache[key];
+}
+
+/*************************************************************************/
+
+const BandAnalyzer &VoiceDictionary::getAnalyzer() const {
+    return analyzer;
+}
+
+/*************************************************************************/
+
+const QVector<double> &VoiceDictionary::getBands(int audc, int audf) const {
+    return voices[audc*32 + audf].bands;
+}
+
+/*************************************************************************/
+
+double VoiceDictionary::getSquaredNorm(int audc, int audf) const {
+    return voices[audc*32 + audf].squaredNorm;
+}
+
+/*************************************************************************/
+
+double VoiceDictionary::getReferenceLevel() const {
+    return referenceLevel;
+}
+
+/*************************************************************************/
+
+double VoiceDictionary::getLevelingGain(const QVector<QVector<double>> &frames) const {
+    double maxLevel = 0.0;
+    for (const QVector<double> &bands : frames) {
+        double level = 0.0;
+        for (double band : bands) {
+            level += band*band;
+        }
+        maxLevel = qMax(maxLevel, std::sqrt(level));
+    }
+    return maxLevel > 0.0 ? referenceLevel/maxLevel : 0.0;
+}
+
+/*************************************************************************/
+
+double VoiceDictionary::fitVolume(double dot, double targetNorm, double voiceNorm, int count,
+                                  int *volume, double *exactVolume) {
+    // Compressed band scale of every volume
+    static const QVector<double> scales = [] {
+        QVector<double> result;
+        for (int v = 0; v <= 15; ++v) {
+            result.append(std::pow(v/15.0, BandAnalyzer::Compression));
+        }
+        return result;
+    }();
+
+    double best = targetNorm;
+    *volume = 0;
+    if (exactVolume != nullptr) {
+        *exactVolume = 0.0;
+    }
+    if (dot <= 0.0 || voiceNorm <= 0.0) {
+        return best;
+    }
+    double scale = dot/(count*voiceNorm);
+    if (exactVolume != nullptr) {
+        *exactVolume = 15.0*std::pow(scale, 1.0/BandAnalyzer::Compression);
+    }
+    int low = 1;
+    while (low < 15 && scales[low + 1] <= scale) {
+        low++;
+    }
+    for (int v = low; v <= qMin(low + 1, 15); ++v) {
+        double distance = targetNorm - 2.0*scales[v]*dot + count*scales[v]*scales[v]*voiceNorm;
+        if (distance < best) {
+            best = distance;
+            *volume = v;
+        }
+    }
+    return best;
+}
+
+/*************************************************************************/
+
+void VoiceDictionary::render(int audc, int audf, Voice &voice) const {
+    int frameLength = analyzer.getFrameLength();
+    TIASound tiaSound(analyzer.getSampleRate());
+    tiaSound.channels(1, false);
+    tiaSound.set(AUDC0, audc);
+    tiaSound.set(AUDF0, audf);
+    tiaSound.set(AUDV0, 15);
+    QVector<Int16> rendered(NumFrames*frameLength);
+    // Let the divider and poly counters settle first
+    tiaSound.process(rendered.data(), quint32(qMin(1024, rendered.size())));
+    tiaSound.process(rendered.data(), quint32(rendered.size()));
+    QVector<double> samples(rendered.size());
+    for (int i = 0; i < rendered.size(); ++i) {
+        samples[i] = rendered[i]/32768.0;
+    }
+
+    QVector<double> power(BandAnalyzer::NumBands, 0.0);
+    for (int frame = 0; frame < NumFrames; ++frame) {
+        QVector<double> framePower = analyzer.analyzePower(samples.constData() + frame*frameLength);
+        for (int band = 0; band < power.size(); ++band) {
+            power[band] += framePower[band]/NumFrames;
+        }
+    }
+    voice.bands = power;
+    voice.level = 0.0;
+    for (double &band : voice.bands) {
+        voice.level += band;
+        band = std::sqrt(band);
+    }
+    voice.level = std::sqrt(voice.level);
+    BandAnalyzer::compress(voice.bands);
+    voice.squaredNorm = 0.0;
+    for (double band : voice.bands) {
+        voice.squaredNorm += band*band;
+    }
+}
+
+}
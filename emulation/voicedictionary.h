@@ -0,0 +1,81 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef VOICEDICTIONARY_H
+#define VOICEDICTIONARY_H
+
+#include <QSharedPointer>
+#include <QVector>
+
+#include "spectrum.h"
+
+
+namespace Emulation {
+
+/* Compressed band spectra of every AUDC/AUDF combination at volume 15,
+ * rendered through TIASound at the sample rate of the audio to fit.
+ * Noise and long periods don't repeat within a frame, so each spectrum
+ * is averaged over several frames. Combinations are rendered in
+ * parallel.
+ *
+ * Since bands scale with the volume, these spectra are all that sample
+ * fitting needs to score any volume. Dictionaries are cached per sample
+ * rate and frame length, so batch jobs only build them once.
+ */
+class VoiceDictionary
+{
+public:
+    static const int NumFrames = 8;
+
+    explicit VoiceDictionary(const BandAnalyzer &analyzer);
+
+    /* Shared dictionary for a sample rate and frame length, built on
+     * first use. Thread-safe. */
+    static QSharedPointer<const VoiceDictionary> get(int sampleRate, int frameLength);
+
+    const BandAnalyzer &getAnalyzer() const;
+
+    /* Compressed band amplitudes */
+    const QVector<double> &getBands(int audc, int audf) const;
+    /* Squared norm of the compressed band amplitudes */
+    double getSquaredNorm(int audc, int audf) const;
+
+    /* Typical norm of the uncompressed band amplitudes of an audible
+     * voice, to bring samples to the level of the TIA */
+    double getReferenceLevel() const;
+
+    /* Gain that brings the loudest of some uncompressed band amplitudes
+     * to the reference level */
+    double getLevelingGain(const QVector<QVector<double>> &frames) const;
+
+    /* Best volume to play a voice at for count target frames. dot is
+     * the sum of the dot products of their compressed bands with the
+     * voice's, targetNorm the sum of their squared norms. Distance is
+     * convex in the scale of the bands, which grows with the volume, so
+     * only the volumes next to the continuous optimum and silence need
+     * to be scored. Returns the squared distance. */
+    static double fitVolume(double dot, double targetNorm, double voiceNorm, int count,
+                            int *volume, double *exactVolume = nullptr);
+
+private:
+    struct Voice {
+        QVector<double> bands;
+        double squaredNorm;
+        double level;
+    };
+
+    void render(int audc, int audf, Voice &voice) const;
+
+    BandAnalyzer analyzer;
+    // Indexed by audc*32 + audf
+    QVector<Voice> voices;
+    double referenceLevel = 0.0;
+};
+
+}
+
+#endif // VOICEDICTIONARY_H
@@ -0,0 +1,49 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "wavfilesink.h"
+
+
+namespace Emulation {
+
+WavFileSink::WavFileSink(const QString &fileName, int sampleRate) :
+    RenderingSink(sampleRate),
+    writer(fileName, sampleRate)
+{
+}
+
+/*************************************************************************/
+
+bool WavFileSink::open() {
+    return writer.open();
+}
+
+/*************************************************************************/
+
+bool WavFileSink::close() {
+    return writer.close();
+}
+
+/*************************************************************************/
+
+long WavFileSink::getNumSamples() const {
+    return writer.getNumSamples();
+}
+
+/*************************************************************************/
+
+QString WavFileSink::getErrorMessage() const {
+    return writer.getErrorMessage();
+}
+
+/*************************************************************************/
+
+void WavFileSink::writeSamples(const Int16 *samples, int count) {
+    writer.write(samples, count);
+}
+
+}
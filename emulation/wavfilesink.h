@@ -0,0 +1,42 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef WAVFILESINK_H
+#define WAVFILESINK_H
+
+#include <QString>
+
+#include "audiosink.h"
+#include "wavfilewriter.h"
+
+
+namespace Emulation {
+
+/* Renders frames into a 16 bit mono WAV file */
+class WavFileSink : public RenderingSink
+{
+public:
+    WavFileSink(const QString &fileName, int sampleRate = 44100);
+
+    /* Returns false if the file can't be written, see getErrorMessage() */
+    bool open();
+    /* Finishes the WAV header. Also done by the destructor. */
+    bool close();
+
+    long getNumSamples() const;
+    QString getErrorMessage() const;
+
+protected:
+    void writeSamples(const Int16 *samples, int count) override;
+
+private:
+    WavFileWriter writer;
+};
+
+}
+
+#endif // WAVFILESINK_H
@@ -0,0 +1,135 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "wavfilesource.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <cstring>
+
+
+namespace Emulation {
+
+namespace {
+
+quint32 readLittleEndian(const QByteArray &bytes, int pos, int size) {
+    quint32 value = 0;
+    for (int i = 0; i < size; ++i) {
+        value |= quint32(quint8(bytes[pos + i]))<<(8*i);
+    }
+    return value;
+}
+
+}
+
+/*************************************************************************/
+
+WavFileSource::WavFileSource(const QString &fileName) :
+    fileName(fileName)
+{
+}
+
+/*************************************************************************/
+
+bool WavFileSource::load() {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorMessage = "Unable to open file " + fileName + "!";
+        return false;
+    }
+    QByteArray bytes = file.readAll();
+    file.close();
+    if (bytes.size() < 12 || !bytes.startsWith("RIFF") || bytes.mid(8, 4) != "WAVE") {
+        errorMessage = fileName + " is not a WAV file!";
+        return false;
+    }
+
+    // Walk the chunks for the format and the sample data
+    int format = 0;
+    int numChannels = 0;
+    int bitsPerSample = 0;
+    int dataStart = -1;
+    int dataSize = 0;
+    int pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        QByteArray id = bytes.mid(pos, 4);
+        int size = int(readLittleEndian(bytes, pos + 4, 4));
+        int body = pos + 8;
+        size = qMin(size, bytes.size() - body);
+        if (id == "fmt " && size >= 16) {
+            format = int(readLittleEndian(bytes, body, 2));
+            numChannels = int(readLittleEndian(bytes, body + 2, 2));
+            sampleRate = int(readLittleEndian(bytes, body + 4, 4));
+            bitsPerSample = int(readLittleEndian(bytes, body + 14, 2));
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub format
+            if (format == 0xfffe && size >= 26) {
+                format = int(readLittleEndian(bytes, body + 24, 2));
+            }
+        } else if (id == "data") {
+            dataStart = body;
+            dataSize = size;
+        }
+        // Chunks are padded to even sizes
+        pos = body + size + (size&1);
+    }
+    if (dataStart < 0 || numChannels == 0 || sampleRate <= 0) {
+        errorMessage = fileName + " is not a valid WAV file!";
+        return false;
+    }
+    bool isInteger = format == 1 && (bitsPerSample == 8 || bitsPerSample == 16
+                                     || bitsPerSample == 24 || bitsPerSample == 32);
+    bool isFloat = format == 3 && bitsPerSample == 32;
+    if (!isInteger && !isFloat) {
+        errorMessage = "Unsupported WAV format in " + fileName + "! Please use integer or float PCM.";
+        return false;
+    }
+
+    int bytesPerSample = bitsPerSample/8;
+    int numFrames = dataSize/(bytesPerSample*numChannels);
+    samples.fill(0.0, numFrames);
+    for (int i = 0; i < numFrames; ++i) {
+        double sum = 0.0;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            int samplePos = dataStart + (i*numChannels + channel)*bytesPerSample;
+            quint32 raw = readLittleEndian(bytes, samplePos, bytesPerSample);
+            if (isFloat) {
+                float value;
+                std::memcpy(&value, &raw, sizeof(value));
+                sum += value;
+            } else if (bitsPerSample == 8) {
+                // 8 bit samples are unsigned
+                sum += (int(raw) - 128)/128.0;
+            } else {
+                // Sign-extend from the top bit
+                qint32 value = qint32(raw<<(32 - bitsPerSample));
+                sum += value/2147483648.0;
+            }
+        }
+        samples[i] = sum/numChannels;
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+int WavFileSource::getSampleRate() const {
+    return sampleRate;
+}
+
+/*************************************************************************/
+
+const QVector<double> &WavFileSource::getSamples() const {
+    return samples;
+}
+
+/*************************************************************************/
+
+QString WavFileSource::getErrorMessage() const {
+    return errorMessage;
+}
+
+}
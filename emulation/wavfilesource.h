@@ -0,0 +1,42 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef WAVFILESOURCE_H
+#define WAVFILESOURCE_H
+
+#include <QString>
+#include <QVector>
+
+
+namespace Emulation {
+
+/* Reads a WAV file for analysis. Supports 8, 16, 24 and 32 bit integer
+ * and 32 bit float PCM. All channels are mixed down to mono, and samples
+ * are scaled to [-1, 1].
+ */
+class WavFileSource
+{
+public:
+    WavFileSource(const QString &fileName);
+
+    /* Returns false if the file can't be read, see getErrorMessage() */
+    bool load();
+
+    int getSampleRate() const;
+    const QVector<double> &getSamples() const;
+    QString getErrorMessage() const;
+
+private:
+    QString fileName;
+    int sampleRate = 0;
+    QVector<double> samples;
+    QString errorMessage;
+};
+
+}
+
+#endif // WAVFILESOURCE_H
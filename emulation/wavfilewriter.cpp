@@ -0,0 +1,134 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "wavfilewriter.h"
+
+
+namespace Emulation {
+
+namespace {
+
+void appendLittleEndian(QByteArray &bytes, quint32 value, int size) {
+    for (int i = 0; i < size; ++i) {
+        bytes.append(char((value>>(8*i))&0xff));
+    }
+}
+
+}
+
+/*************************************************************************/
+
+WavFileWriter::WavFileWriter(const QString &fileName, int sampleRate) :
+    file(fileName), sampleRate(sampleRate)
+{
+}
+
+/*************************************************************************/
+
+WavFileWriter::~WavFileWriter() {
+    close();
+}
+
+/*************************************************************************/
+
+bool WavFileWriter::open() {
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorMessage = "Unable to open file " + file.fileName() + " for writing!";
+        return false;
+    }
+    numSamples = 0;
+    buffer.clear();
+    buffer.reserve(BufferSamples*2);
+    // Sizes get filled in by close()
+    writeHeader();
+    return true;
+}
+
+/*************************************************************************/
+
+bool WavFileWriter::close() {
+    if (!file.isOpen()) {
+        return false;
+    }
+    flush();
+    bool ok = file.seek(0);
+    if (ok) {
+        writeHeader();
+    }
+    file.close();
+    if (!ok || file.error() != QFileDevice::NoError) {
+        errorMessage = "Unable to write file " + file.fileName() + "!";
+        return false;
+    }
+    return true;
+}
+
+/*************************************************************************/
+
+void WavFileWriter::write(const Int16 *samples, int count) {
+    if (!file.isOpen()) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        appendLittleEndian(buffer, quint16(samples[i]), 2);
+    }
+    numSamples += count;
+    if (buffer.size() >= BufferSamples*2) {
+        flush();
+    }
+}
+
+/*************************************************************************/
+
+QString WavFileWriter::getFileName() const {
+    return file.fileName();
+}
+
+/*************************************************************************/
+
+long WavFileWriter::getNumSamples() const {
+    return numSamples;
+}
+
+/*************************************************************************/
+
+QString WavFileWriter::getErrorMessage() const {
+    return errorMessage;
+}
+
+/*************************************************************************/
+
+void WavFileWriter::flush() {
+    file.write(buffer);
+    // Keeps the reserved capacity
+    buffer.resize(0);
+}
+
+/*************************************************************************/
+
+void WavFileWriter::writeHeader() {
+    const int bytesPerSample = 2;
+    quint32 dataSize = quint32(numSamples*bytesPerSample);
+    QByteArray header;
+    header.append("RIFF");
+    appendLittleEndian(header, 36 + dataSize, 4);
+    header.append("WAVE");
+    header.append("fmt ");
+    appendLittleEndian(header, 16, 4);
+    // PCM, mono
+    appendLittleEndian(header, 1, 2);
+    appendLittleEndian(header, 1, 2);
+    appendLittleEndian(header, quint32(sampleRate), 4);
+    appendLittleEndian(header, quint32(sampleRate*bytesPerSample), 4);
+    appendLittleEndian(header, bytesPerSample, 2);
+    appendLittleEndian(header, 16, 2);
+    header.append("data");
+    appendLittleEndian(header, dataSize, 4);
+    file.write(header);
+}
+
+}
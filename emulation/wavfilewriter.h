@@ -0,0 +1,57 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef WAVFILEWRITER_H
+#define WAVFILEWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "bspf.h"
+
+
+namespace Emulation {
+
+/* Streams 16 bit mono samples into a WAV file. Samples are collected
+ * and written in large blocks, so writing several files at once
+ * doesn't turn into many small writes. */
+class WavFileWriter
+{
+public:
+    // Samples collected before they are written
+    static const int BufferSamples = 64*1024;
+
+    WavFileWriter(const QString &fileName, int sampleRate);
+    ~WavFileWriter();
+
+    /* Returns false if the file can't be written, see getErrorMessage() */
+    bool open();
+    /* Writes the remaining samples and finishes the WAV header. Also
+     * done by the destructor. */
+    bool close();
+
+    void write(const Int16 *samples, int count);
+
+    QString getFileName() const;
+    long getNumSamples() const;
+    QString getErrorMessage() const;
+
+private:
+    void flush();
+    void writeHeader();
+
+    QFile file;
+    int sampleRate;
+    QByteArray buffer;
+    long numSamples = 0;
+    QString errorMessage;
+};
+
+}
+
+#endif // WAVFILEWRITER_H
@@ -161,6 +161,7 @@ void EnvelopeShaper::processMouseEvent(int x, int y) {
                 newValue = scaleMin + scaleMax - newValue;
             }
             (*values)[iValue] = newValue;
+            pInstrument->markChanged();
             draggingIndex = iValue;
             update();
         }
@@ -20,6 +20,9 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include "mainwindow.h"
+#include <QApplication>
+#include <QFileInfo>
+#include "emulation/instrumentfitter.h"
 
 
 const QList<TiaSound::Distortion> InstrumentsTab::availableWaveforms{
@@ -292,6 +295,94 @@ void InstrumentsTab::on_buttonInstrumentImport_clicked() {
 
 /*************************************************************************/
 
+void InstrumentsTab::on_buttonInstrumentFitWav_clicked() {
+    // Ask for filenames
+    QFileDialog dialog(this);
+    dialog.setDirectory(curInstrumentsDialogPath);
+    dialog.setAcceptMode(QFileDialog::AcceptOpen);
+    dialog.setFileMode(QFileDialog::ExistingFiles);
+    dialog.setNameFilter("*.wav");
+    dialog.setViewMode(QFileDialog::Detail);
+    QStringList fileNames;
+    if (dialog.exec()) {
+        fileNames = dialog.selectedFiles();
+    }
+    if (fileNames.isEmpty()) {
+        return;
+    }
+    curInstrumentsDialogPath = dialog.directory().absolutePath();
+    Emulation::InstrumentFitter fitter(pTrack->getTvMode(), availableWaveforms);
+
+    // A single sample replaces the current instrument
+    if (fileNames.size() == 1) {
+        Track::Instrument *curInstrument = getSelectedInstrument();
+        if (!curInstrument->isEmpty()) {
+            QMessageBox msgBox(QMessageBox::NoIcon,
+                               "Fit Instrument to WAV",
+                               "Do you really want to overwrite the current instrument?",
+                               QMessageBox::Yes | QMessageBox::No, this,
+                               Qt::FramelessWindowHint);
+            if (msgBox.exec() != QMessageBox::Yes) {
+                return;
+            }
+        }
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        bool ok = fitter.fit(fileNames[0]);
+        QApplication::restoreOverrideCursor();
+        if (!ok) {
+            MainWindow::displayMessage(fitter.getErrorMessage());
+            return;
+        }
+        pTrack->lock();
+        fitter.apply(curInstrument);
+        pTrack->unlock();
+        updateInstrumentsTab();
+        update();
+        QMessageBox msgBox(QMessageBox::NoIcon,
+                           "Fit Instrument to WAV",
+                           "The instrument sounds like the sample when played at frequency "
+                           + QString::number(fitter.getFrequency()) + ".",
+                           QMessageBox::Ok, this,
+                           Qt::FramelessWindowHint);
+        msgBox.exec();
+        return;
+    }
+
+    // Several samples get exported as instruments next to them
+    QStringList results;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    for (const QString &fileName : fileNames) {
+        QFileInfo info(fileName);
+        if (!fitter.fit(fileName)) {
+            results.append(fitter.getErrorMessage());
+            continue;
+        }
+        Track::Instrument instrument(info.completeBaseName().left(maxInstrumentNameLength));
+        fitter.apply(&instrument);
+        QString instrumentName = info.dir().filePath(info.completeBaseName() + ".tti");
+        QFile saveFile(instrumentName);
+        if (!saveFile.open(QIODevice::WriteOnly)) {
+            results.append("Unable to open file " + instrumentName + "!");
+            continue;
+        }
+        QJsonObject insObject;
+        instrument.toJson(insObject);
+        saveFile.write(QJsonDocument(insObject).toJson());
+        saveFile.close();
+        results.append(info.completeBaseName() + ".tti: frequency "
+                       + QString::number(fitter.getFrequency()));
+    }
+    QApplication::restoreOverrideCursor();
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Fit Instruments to WAVs",
+                       results.join("\n"),
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
 void InstrumentsTab::on_spinBoxInstrumentEnvelopeLength_editingFinished() {
     QSpinBox *sb = findChild<QSpinBox *>("spinBoxInstrumentEnvelopeLength");
     int newLength = sb->value();
@@ -382,6 +473,7 @@ void InstrumentsTab::on_spinBoxInstrumentVolume_editingFinished() {
         for (int i = 0; i < curInstrument->getEnvelopeLength(); ++i) {
             curInstrument->volumes[i] += volumeShift;
         }
+        curInstrument->markChanged();
     } else {
         // Invalid value: Set volume to current max
         sb->setValue(curInstrument->getMaxVolume());
@@ -403,6 +495,7 @@ void InstrumentsTab::on_comboBoxWaveforms_currentIndexChanged(int index) {
     Track::Instrument *curInstrument = getSelectedInstrument();
     TiaSound::Distortion newDistortion = availableWaveforms[index];
     curInstrument->baseDistortion = newDistortion;
+    curInstrument->markChanged();
 
     updateInstrumentsTab();
     update();
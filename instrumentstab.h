@@ -43,6 +43,9 @@ public slots:
     void on_buttonInstrumentDelete_clicked();
     void on_buttonInstrumentExport_clicked();
     void on_buttonInstrumentImport_clicked();
+    /* Fits the current instrument to a WAV sample, or exports an
+     * instrument fitted to each of several samples */
+    void on_buttonInstrumentFitWav_clicked();
 
     void on_spinBoxInstrumentEnvelopeLength_editingFinished();
     void on_spinBoxInstrumentEnvelopeLength_valueChanged(int newLength);
@@ -20,6 +20,8 @@
 #include "percussiontab.h"
 #include "tracktab.h"
 #include "emulation/player.h"
+#include "emulation/sdlaudiosink.h"
+#include "emulation/eventtrace.h"
 #include <QThread>
 #include "track/note.h"
 #include "track/pattern.h"
@@ -28,12 +30,12 @@
 #include <QFile>
 #include <QJsonObject>
 #include <QJsonDocument>
-#include "timeline.h"
 #include <iostream>
 #include <patterneditor.h>
 #include <QCheckBox>
 #include "optionstab.h"
 #include <QTextStream>
+#include <QSettings>
 
 
 #include "SDL.h"
@@ -41,6 +43,7 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    Emulation::EventTrace::nameThread("GUI");
 
     // Load and set stylesheet
     QFile styleFile(":/style.qss");
@@ -53,6 +56,8 @@ int main(int argc, char *argv[])
 
     // GUI
     MainWindow::loadKeymap();
+    // Before any pitch guide gets calculated
+    OptionsTab::applyPitchTables(QSettings("Kylearan", "TIATracker").value("measuredPitches", false).toBool());
     MainWindow w;
     w.registerTrack(&myTrack);
 
@@ -80,7 +85,7 @@ int main(int argc, char *argv[])
     w.initConnections();
 
     /* Create and initialize player thread */
-    Emulation::Player *tiaPlayer = new Emulation::Player(&myTrack);
+    Emulation::Player *tiaPlayer = new Emulation::Player(&myTrack, new Emulation::SdlAudioSink());
     QThread *thread = new QThread();
     QObject::connect(&w, SIGNAL(initPlayerTimer()), tiaPlayer, SLOT(startTimer()));
     QObject::connect(&w, SIGNAL(stopPlayerTimer()), tiaPlayer, SLOT(stopTimer()));
@@ -92,24 +97,32 @@ int main(int argc, char *argv[])
     QObject::connect(&w, SIGNAL(playPercussion(Track::Percussion*)), tiaPlayer, SLOT(playPercussion(Track::Percussion*)));
     QObject::connect(&w, SIGNAL(stopPercussion()), tiaPlayer, SLOT(stopPercussion()));
     QObject::connect(&w, SIGNAL(playTrack(int,int)), tiaPlayer, SLOT(playTrack(int,int)));
+    qRegisterMetaType<Emulation::Player::TrackState>();
+    QObject::connect(&w, SIGNAL(playTrackState(Emulation::Player::TrackState)), tiaPlayer, SLOT(playTrackState(Emulation::Player::TrackState)));
     QObject::connect(&w, SIGNAL(stopTrack()), tiaPlayer, SLOT(stopTrack()));
-    Timeline *tl = w.findChild<Timeline *>("trackTimeline");
+    QObject::connect(&w, SIGNAL(startRegisterLog(QString)), tiaPlayer, SLOT(startRegisterLog(QString)));
+    QObject::connect(&w, SIGNAL(stopRegisterLog()), tiaPlayer, SLOT(stopRegisterLog()));
+    QObject::connect(tiaPlayer, SIGNAL(registerLogStopped(QString,int,QString)), &w, SLOT(registerLogStopped(QString,int,QString)));
     PatternEditor *editor = w.findChild<PatternEditor *>("trackEditor");
-    QObject::connect(tiaPlayer, SIGNAL(newPlayerPos(int,int)), tl, SLOT(playerPosChanged(int,int)));
-    QObject::connect(tiaPlayer, SIGNAL(newPlayerPos(int,int)), editor, SLOT(newPlayerPos(int,int)));
     QObject::connect(tiaPlayer, SIGNAL(invalidNoteFound(int,int,int,QString)), tt, SLOT(invalidNoteFound(int,int,int,QString)));
     QObject::connect(tt, SIGNAL(stopTrack()), tiaPlayer, SLOT(stopTrack()));
     QObject::connect(editor, SIGNAL(editChannelChanged(int)), tiaPlayer, SLOT(selectedChannelChanged(int)));
     QCheckBox *cbLoop = w.findChild<QCheckBox *>("checkBoxLoop");
     QObject::connect(cbLoop, SIGNAL(toggled(bool)), tiaPlayer, SLOT(toggleLoop(bool)));
     QObject::connect(ot, SIGNAL(setTVStandard(int)), tiaPlayer, SLOT(setTVStandard(int)));
+    QObject::connect(ot, SIGNAL(setAudioDevice(int,int,bool,int)), tiaPlayer, SLOT(setAudioDevice(int,int,bool,int)));
+    QObject::connect(ot, SIGNAL(resetAudioStatus()), tiaPlayer, SLOT(resetAudioStatus()));
+    QObject::connect(tiaPlayer, SIGNAL(audioStatusChanged(int,int,int,int,int)), ot, SLOT(audioStatusChanged(int,int,int,int,int)));
+    QObject::connect(tiaPlayer, SIGNAL(inputLatencyMeasured(int)), ot, SLOT(inputLatencyMeasured(int)));
 
     pt->connectPlayer(tiaPlayer);
     tt->registerPlayer(tiaPlayer);
     editor->registerPlayer(tiaPlayer);
+    w.registerPlayer(tiaPlayer);
 
     thread->start(QThread::HighestPriority);
     w.initPlayer();
+    ot->applyAudioSettings();
 
     w.updateAllTabs();
 
@@ -17,6 +17,7 @@
 #include "tiasound/pitchguidefactory.h"
 #include "tiasound/pitchguide.h"
 #include "tiasound/instrumentpitchguide.h"
+#include "tiasound/tuningoptimizer.h"
 #include <QMenu>
 #include <QFileDialog>
 #include <QJsonDocument>
@@ -27,11 +28,27 @@
 #include "track/sequence.h"
 #include "track/sequenceentry.h"
 #include "emulation/player.h"
+#include "emulation/dasmexporter.h"
+#include "emulation/playervalidator.h"
+#include "emulation/playervariantfinder.h"
+#include "emulation/inputlatencytracer.h"
+#include "emulation/eventtrace.h"
+#include "emulation/benchmarkrunner.h"
+#include "emulation/benchmarksuite.h"
+#include "emulation/rendercorpus.h"
+#include "emulation/registerlog.h"
+#include "emulation/wavfilesink.h"
+#include "emulation/stemfilesink.h"
 #include "aboutdialog.h"
 #include <QFileInfo>
 #include <QDesktopServices>
 #include <QCloseEvent>
 #include <QSettings>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QInputDialog>
+#include <QTemporaryDir>
 
 
 const QColor MainWindow::dark{"#002b36"};
@@ -94,6 +111,7 @@ MainWindow::MainWindow(QWidget *parent) :
 /*************************************************************************/
 
 MainWindow::~MainWindow() {
+    delete trackKeyframes;
     delete ui;
 }
 
@@ -135,6 +153,7 @@ void MainWindow::initConnections() {
     QObject::connect(ui->buttonInstrumentDelete, &QPushButton::clicked, ui->tabInstruments, &InstrumentsTab::on_buttonInstrumentDelete_clicked);
     QObject::connect(ui->buttonInstrumentExport, &QPushButton::clicked, ui->tabInstruments, &InstrumentsTab::on_buttonInstrumentExport_clicked);
     QObject::connect(ui->buttonInstrumentImport, &QPushButton::clicked, ui->tabInstruments, &InstrumentsTab::on_buttonInstrumentImport_clicked);
+    QObject::connect(ui->buttonInstrumentFitWav, &QPushButton::clicked, ui->tabInstruments, &InstrumentsTab::on_buttonInstrumentFitWav_clicked);
     QObject::connect(ui->spinBoxInstrumentEnvelopeLength, &QSpinBox::editingFinished, ui->tabInstruments, &InstrumentsTab::on_spinBoxInstrumentEnvelopeLength_editingFinished);
     QObject::connect(ui->spinBoxInstrumentEnvelopeLength, SIGNAL(valueChanged(int)), ui->tabInstruments, SLOT(on_spinBoxInstrumentEnvelopeLength_valueChanged(int)));
     QObject::connect(ui->spinBoxSustainStart, &QSpinBox::editingFinished, ui->tabInstruments, &InstrumentsTab::on_spinBoxSustainStart_editingFinished);
@@ -154,6 +173,7 @@ void MainWindow::initConnections() {
     QObject::connect(ui->buttonPercussionDelete, &QPushButton::clicked, ui->tabPercussion, &PercussionTab::on_buttonPercussionDelete_clicked);
     QObject::connect(ui->buttonPercussionExport, &QPushButton::clicked, ui->tabPercussion, &PercussionTab::on_buttonPercussionExport_clicked);
     QObject::connect(ui->buttonPercussionImport, &QPushButton::clicked, ui->tabPercussion, &PercussionTab::on_buttonPercussionImport_clicked);
+    QObject::connect(ui->buttonPercussionFitWav, &QPushButton::clicked, ui->tabPercussion, &PercussionTab::on_buttonPercussionFitWav_clicked);
     QObject::connect(ui->spinBoxPercussionLength, &QSpinBox::editingFinished, ui->tabPercussion, &PercussionTab::on_spinBoxPercussionLength_editingFinished);
     QObject::connect(ui->spinBoxPercussionLength, SIGNAL(valueChanged(int)), ui->tabPercussion, SLOT(on_spinBoxPercussionLength_valueChanged(int)));
     QObject::connect(ui->checkBoxOverlay, SIGNAL(stateChanged(int)), ui->tabPercussion, SLOT(on_checkBoxOverlay_stateChanged(int)));
@@ -191,6 +211,12 @@ void MainWindow::initConnections() {
     QObject::connect(ui->lineEditAuthor, SIGNAL(textChanged(QString)), ui->tabOptions, SLOT(on_lineEditAuthor_textChanged(QString)));
     QObject::connect(ui->lineEditSongName, SIGNAL(textChanged(QString)), ui->tabOptions, SLOT(on_lineEditSongName_textChanged(QString)));
     QObject::connect(ui->plainTextEditComment, SIGNAL(textChanged()), ui->tabOptions, SLOT(on_plainTextEditComment_textChanged()));
+    QObject::connect(ui->comboBoxSampleRate, SIGNAL(currentIndexChanged(int)), ui->tabOptions, SLOT(on_comboBoxSampleRate_currentIndexChanged(int)));
+    QObject::connect(ui->comboBoxBufferSize, SIGNAL(currentIndexChanged(int)), ui->tabOptions, SLOT(on_comboBoxBufferSize_currentIndexChanged(int)));
+    QObject::connect(ui->checkBoxAdaptiveBuffer, SIGNAL(toggled(bool)), ui->tabOptions, SLOT(on_checkBoxAdaptiveBuffer_toggled(bool)));
+    QObject::connect(ui->spinBoxPrerenderFrames, SIGNAL(valueChanged(int)), ui->tabOptions, SLOT(on_spinBoxPrerenderFrames_valueChanged(int)));
+    QObject::connect(ui->pushButtonResetAudioStatus, SIGNAL(clicked(bool)), ui->tabOptions, SLOT(on_pushButtonResetAudioStatus_clicked(bool)));
+    QObject::connect(ui->checkBoxMeasuredPitches, SIGNAL(toggled(bool)), ui->tabOptions, SLOT(on_checkBoxMeasuredPitches_toggled(bool)));
 
     // PianoKeyboard
     ui->pianoKeyboard->initPianoKeyboard();
@@ -228,8 +254,16 @@ void MainWindow::stopPlayer() {
 
 /*************************************************************************/
 
+void MainWindow::registerPlayer(Emulation::Player *newPlayer) {
+    pPlayer = newPlayer;
+}
+
+/*************************************************************************/
+
 void MainWindow::registerTrack(Track::Track *newTrack) {
     pTrack = newTrack;
+    delete trackKeyframes;
+    trackKeyframes = new Emulation::TrackKeyframes(pTrack);
     setTrackName(pTrack->name);
 }
 
@@ -243,6 +277,7 @@ TiaSound::PitchGuide *MainWindow::getPitchGuide() {
 
 void MainWindow::setPitchGuide(TiaSound::PitchGuide newGuide) {
     curPitchGuide = newGuide;
+    ui->trackEditor->invalidateRowCache();
     updateAllTabs();
     update();
 }
@@ -288,17 +323,33 @@ void MainWindow::updateSpeedSpinBoxes(int editPos) {
 /*************************************************************************/
 
 void MainWindow::newPianoKeyPressed(int frequency) {
+    Emulation::InputLatencyTracer::getShared().mark(Emulation::InputLatencyTracer::Dispatched);
     switch (ui->tabWidget->currentIndex()) {
     case iTabTrack:
     {
-        emit setRowToInstrument(frequency);
+        // Jamming to a playing track neither edits nor stops it
+        bool jam = ui->checkBoxJam->isChecked() && pPlayer != nullptr && pPlayer->isPlayingTrack();
+        if (!jam) {
+            emit setRowToInstrument(frequency);
+        } else if (frequency == -1) {
+            pPlayer->jamRelease();
+            break;
+        }
         int insIndex = ui->trackInstrumentSelector->getSelectedInstrument();
         if (insIndex < Track::Track::numInstruments) {
             Track::Instrument *instrument = &(pTrack->instruments[insIndex]);
-            emit playInstrumentOnce(instrument, frequency);
+            if (jam) {
+                pPlayer->jamInstrument(instrument, frequency);
+            } else {
+                emit playInstrumentOnce(instrument, frequency);
+            }
         } else {
             Track::Percussion *percussion = &(pTrack->percussion[insIndex - Track::Track::numInstruments]);
-            emit playPercussion(percussion);
+            if (jam) {
+                pPlayer->jamPercussion(percussion);
+            } else {
+                emit playPercussion(percussion);
+            }
         }
         break;
     }
@@ -323,6 +374,11 @@ void MainWindow::newPianoKeyPressed(int frequency) {
 
 void MainWindow::pianoKeyReleased() {
     switch (ui->tabWidget->currentIndex()) {
+    case iTabTrack:
+        if (ui->checkBoxJam->isChecked() && pPlayer != nullptr) {
+            pPlayer->jamRelease();
+        }
+        break;
     case iTabInstruments:
         emit stopInstrument();
         break;
@@ -450,6 +506,7 @@ void MainWindow::on_actionSave_triggered() {
 /*************************************************************************/
 
 void MainWindow::saveTrackByName(const QString &fileName) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::saveTrackByName");
     QFile saveFile(fileName);
     // Export track
     if (!saveFile.open(QIODevice::WriteOnly)) {
@@ -467,6 +524,7 @@ void MainWindow::saveTrackByName(const QString &fileName) {
 /*************************************************************************/
 
 void MainWindow::loadTrackByName(const QString &fileName) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::loadTrackByName");
     QFile loadFile(fileName);
     if (!loadFile.open(QIODevice::ReadOnly)) {
         displayMessage("Unable to open file!");
@@ -481,6 +539,7 @@ void MainWindow::loadTrackByName(const QString &fileName) {
         return;
     }
     pTrack->unlock();
+    dasmVariant = Emulation::DasmExporter::Variant{false, false};
     setTrackName(fileName);
     ui->trackEditor->setEditPos(0);
     updateAllTabs();
@@ -601,6 +660,19 @@ void MainWindow::addShortcut(QAction *action, QString actionName) {
 /*************************************************************************/
 
 void MainWindow::playTrackFrom(int channel, int row) {
+    // Start from the nearest keyframe, so notes still sounding get played
+    Emulation::Player::TrackState state;
+    pTrack->lock();
+    trackKeyframes->updateToRow(channel, row);
+    bool hasState = trackKeyframes->getRowState(channel, row, &state);
+    pTrack->unlock();
+    if (hasState) {
+        emit playTrackState(state);
+        return;
+    }
+
+    // The fast-forward stops at invalid notes and after a maximum
+    // length, so walk the sequences instead and start with no notes
     int otherChannel = 1 - channel;
     // Try to find parallel note in other channel
     int thisStartIndex = pTrack->startPatterns[channel];
@@ -811,6 +883,7 @@ void MainWindow::on_actionNew_triggered() {
     }
     pTrack->lock();
     pTrack->newTrack();
+    dasmVariant = Emulation::DasmExporter::Variant{false, false};
     setTrackName(pTrack->name);
     ui->trackEditor->setEditPos(0);
     updateAllTabs();
@@ -837,6 +910,7 @@ QString MainWindow::readAsm(QString fileName) {
 /*************************************************************************/
 
 bool MainWindow::writeAsm(QString fileName, QString content, QString extension) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::writeAsm");
     QFile outFile(fileName + extension);
     if (!outFile.open(QIODevice::WriteOnly)) {
         return false;
@@ -849,26 +923,6 @@ bool MainWindow::writeAsm(QString fileName, QString content, QString extension)
 
 /*************************************************************************/
 
-QString MainWindow::listToDasmBytes(QList<int> list) {
-    QString out;
-    for (int i = 0; i < list.size(); ++i) {
-        if (i%8 == 0) {
-            if (i > 0) {
-                out.append("\n");
-            }
-            out.append("        dc.b ");
-        }
-        out = (out + "$%1").arg(list[i], 2, 16, QChar('0'));
-        if (i%8 != 7 && i != list.size() - 1) {
-            out.append(", ");
-        }
-    }
-    out.append("\n");
-    return out;
-}
-
-/*************************************************************************/
-
 QString MainWindow::listToMadsBytes(QList<int> list) {
     QString out;
     for (int i = 0; i < list.size(); ++i) {
@@ -937,15 +991,15 @@ QString MainWindow::getExportFileName() {
 
 /*************************************************************************/
 
-bool MainWindow::exportDasmFlags(QString fileName) {
+bool MainWindow::exportMadsFlags(QString fileName) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::exportMadsFlags");
     // Export flags
-    QString flagsString = readAsm("player/dasm/tt_variables.asm");
+    QString flagsString = readAsm("player/mads/tt_variables.asm");
     if (flagsString == "") {
         return false;
     }
     flagsString.replace("%%AUTHOR%%", pTrack->metaAuthor);
     flagsString.replace("%%NAME%%", pTrack->metaName);
-    flagsString.replace("%%GLOBALSPEED%%", QString::number(pTrack->globalSpeed));
     flagsString.replace("%%EVENSPEED%%", QString::number(pTrack->evenSpeed));
     flagsString.replace("%%ODDSPEED%%", QString::number(pTrack->oddSpeed));
     bool usesGoto = pTrack->usesGoto();
@@ -969,44 +1023,38 @@ bool MainWindow::exportDasmFlags(QString fileName) {
 
 /*************************************************************************/
 
-bool MainWindow::exportMadsFlags(QString fileName) {
-    // Export flags
-    QString flagsString = readAsm("player/mads/tt_variables.asm");
-    if (flagsString == "") {
+bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::exportTrackSpecificsDasm");
+    Emulation::DasmExporter exporter(pTrack);
+    exporter.variant = dasmVariant;
+    if (!exporter.exportTrackSpecifics()) {
+        displayMessage(exporter.getErrorMessage());
         return false;
     }
-    flagsString.replace("%%AUTHOR%%", pTrack->metaAuthor);
-    flagsString.replace("%%NAME%%", pTrack->metaName);
-    flagsString.replace("%%EVENSPEED%%", QString::number(pTrack->evenSpeed));
-    flagsString.replace("%%ODDSPEED%%", QString::number(pTrack->oddSpeed));
-    bool usesGoto = pTrack->usesGoto();
-    flagsString.replace("%%USEGOTO%%", (usesGoto ? "1" : "0"));
-    bool usesSlide = pTrack->usesSlide();
-    flagsString.replace("%%USESLIDE%%", (usesSlide ? "1" : "0"));
-    bool usesOverlay = pTrack->usesOverlay();
-    flagsString.replace("%%USEOVERLAY%%", (usesOverlay ? "1" : "0"));
-    bool usesFunk = pTrack->usesFunktempo();
-    flagsString.replace("%%USEFUNKTEMPO%%", (usesFunk ? "1" : "0"));
-    flagsString.replace("%%GLOBALSPEED%%", (pTrack->globalSpeed ? "1" : "0"));
-    bool startsWithHold = pTrack->startsWithHold();
-    flagsString.replace("%%STARTSWITHNOTES%%", (startsWithHold ? "0" : "1"));
     // Write flags
-    if (!writeAsm(fileName, flagsString, "_variables.asm")) {
+    if (!writeAsm(fileName, exporter.variablesString, "_variables.asm")) {
         displayMessage("Unable to write variables file!");
         return false;
     }
+    // Write track data
+    if (!writeAsm(fileName, exporter.trackDataString, "_trackdata.asm")) {
+        displayMessage("Unable to write trackdata file!");
+        return false;
+    }
+    // Write init
+    if (!writeAsm(fileName, exporter.initString, "_init.asm")) {
+        displayMessage("Unable to write init file!");
+        return false;
+    }
     return true;
 }
 
 /*************************************************************************/
 
-bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
-    if (!exportDasmFlags(fileName)) {
-        return false;
-    }
-
+bool MainWindow::exportTrackSpecificsK65(QString fileName) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::exportTrackSpecificsK65");
     // Export track data
-    QString trackString = readAsm("player/dasm/tt_trackdata.asm");
+    QString trackString = readAsm("player/k65/tt_trackdata.k65");
     if (trackString == "") {
         return false;
     }
@@ -1043,8 +1091,8 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
                 patternMapping[patternIndex] = numPatterns;
                 numPatterns++;
                 // Write out pattern
-                patternString.append("; " + pTrack->patterns[patternIndex].name + "\n");
-                patternString.append("tt_pattern" + QString::number(patternMapping[patternIndex]) + ":\n");
+                patternString.append("// " + pTrack->patterns[patternIndex].name + "\n");
+                patternString.append("data tt_pattern" + QString::number(patternMapping[patternIndex]) + " {\n");
                 // Loop over all notes
                 QList<int> patternValues;
                 for (int n = 0; n < pTrack->patterns[patternIndex].notes.size(); ++n) {
@@ -1088,12 +1136,12 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
                                 insWaveforms.append(TiaSound::getDistortionInt(ins->baseDistortion));
                             }
                             // Write out instrument data
-                            insString.append("; " + QString::number(numInstruments));
+                            insString.append("// " + QString::number(numInstruments));
                             if (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED) {
                                 insString.append("+" + QString::number(numInstruments + 1));
                             }
                             insString.append(": " + ins->name + "\n");
-                            insString.append(listToDasmBytes(insEnvelopeValues));
+                            insString.append(listToK65Bytes(insEnvelopeValues));
                             // Increase running instrument index
                             numInstruments += (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED ? 2 : 1);
                             // +1 for dummy byte, +1 for end marker
@@ -1140,10 +1188,10 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
                             // Insert index. +1 because player expects that
                             percStarts.append(percEnvelopeIndex + 1);
                             // Write out percussion data
-                            percFreqString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
-                            percFreqString.append(listToDasmBytes(percFreqValues));
-                            percCtrlVolString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
-                            percCtrlVolString.append(listToDasmBytes(percCtrlVolValues));
+                            percFreqString.append("// " + QString::number(numPercussion) + ": " + perc->name + "\n");
+                            percFreqString.append(listToK65Bytes(percFreqValues));
+                            percCtrlVolString.append("// " + QString::number(numPercussion) + ": " + perc->name + "\n");
+                            percCtrlVolString.append(listToK65Bytes(percCtrlVolValues));
                             // Increase running percussion index
                             numPercussion++;
                             // +1 for end marker
@@ -1161,8 +1209,8 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
                 }
                 // Pattern end marker
                 patternValues.append(0);
-                patternString.append(listToDasmBytes(patternValues));
-                patternString.append("\n");
+                patternString.append(listToK65Bytes(patternValues));
+                patternString.append("\n}\n");
                 // Pattern speed, if local tempo
                 if (!pTrack->globalSpeed) {
                     if (usesFunktempo) {
@@ -1175,11 +1223,11 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
                 }
                 // Pattern ptr
                 if ((patternMapping.size())%4 == 1) {
-                    patternPtrString.append("        dc.b ");
+                    patternPtrString.append("        ");
                 } else {
-                    patternPtrString.append(", ");
+                    patternPtrString.append(" ");
                 }
-                patternPtrString.append("<tt_pattern" + QString::number(patternMapping[patternIndex]));
+                patternPtrString.append("&<tt_pattern" + QString::number(patternMapping[patternIndex]));
                 if ((patternMapping.size())%4 == 0) {
                     patternPtrString.append("\n");
                 }
@@ -1201,36 +1249,41 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
         }
     }
     trackString.replace("%%INSFREQVOLTABLE%%", insString);
-    trackString.replace("%%INSCTRLTABLE%%", listToDasmBytes(insWaveforms));
-    trackString.replace("%%INSADINDEXES%%", listToDasmBytes(insADStarts));
-    trackString.replace("%%INSSUSTAININDEXES%%", listToDasmBytes(insSustainStarts));
-    trackString.replace("%%INSRELEASEINDEXES%%", listToDasmBytes(insReleaseStarts));
-    trackString.replace("%%PERCINDEXES%%", listToDasmBytes(percStarts));
+    trackString.replace("%%INSCTRLTABLE%%", listToK65Bytes(insWaveforms));
+    trackString.replace("%%INSADINDEXES%%", listToK65Bytes(insADStarts));
+    trackString.replace("%%INSSUSTAININDEXES%%", listToK65Bytes(insSustainStarts));
+    trackString.replace("%%INSRELEASEINDEXES%%", listToK65Bytes(insReleaseStarts));
+    trackString.replace("%%PERCINDEXES%%", listToK65Bytes(percStarts));
     trackString.replace("%%PERCFREQTABLE%%", percFreqString);
     trackString.replace("%%PERCCTRLVOLTABLE%%", percCtrlVolString);
-    trackString.replace("%%SEQUENCECHANNEL0%%", listToDasmBytes(sequence[0]));
-    trackString.replace("%%SEQUENCECHANNEL1%%", listToDasmBytes(sequence[1]));
+    trackString.replace("%%SEQUENCECHANNEL0%%", listToK65Bytes(sequence[0]));
+    trackString.replace("%%SEQUENCECHANNEL1%%", listToK65Bytes(sequence[1]));
     trackString.replace("%%PATTERNDEFS%%", patternString);
     if (!pTrack->globalSpeed) {
-        trackString.replace("%%PATTERNSPEEDS%%", listToDasmBytes(patternSpeeds));
+        trackString.replace("%%PATTERNSPEEDS%%", listToK65Bytes(patternSpeeds));
+    } else {
+        trackString.replace("%%PATTERNSPEEDS%%", "");
     }
     trackString.replace("%%PATTERNPTRLO%%", patternPtrString);
     patternPtrString.replace("<", ">");
     trackString.replace("%%PATTERNPTRHI%%", patternPtrString);
 
-    // Write track data
-    if (!writeAsm(fileName, trackString, "_trackdata.asm")) {
-        displayMessage("Unable to write trackdata file!");
-        return false;
-    }
+    // Flags
+    trackString.replace("%%EVENSPEED%%", QString::number(pTrack->evenSpeed));
+    trackString.replace("%%ODDSPEED%%", QString::number(pTrack->oddSpeed));
+    bool usesGoto = pTrack->usesGoto();
+    trackString.replace("%%USEGOTO%%", (usesGoto ? "1" : "0"));
+    bool usesSlide = pTrack->usesSlide();
+    trackString.replace("%%USESLIDE%%", (usesSlide ? "1" : "0"));
+    bool usesOverlay = pTrack->usesOverlay();
+    trackString.replace("%%USEOVERLAY%%", (usesOverlay ? "1" : "0"));
+    bool usesFunk = pTrack->usesFunktempo();
+    trackString.replace("%%USEFUNKTEMPO%%", (usesFunk ? "1" : "0"));
+    trackString.replace("%%GLOBALSPEED%%", (pTrack->globalSpeed ? "1" : "0"));
+    bool startsWithHold = pTrack->startsWithHold();
+    trackString.replace("%%STARTSWITHNOTES%%", (startsWithHold ? "0" : "1"));
 
-    // Export Init
-    QString initString = readAsm("player/dasm/tt_init.asm");
-    if (initString == "") {
-        return false;
-    }
-    initString.replace("%%AUTHOR%%", pTrack->metaAuthor);
-    initString.replace("%%NAME%%", pTrack->metaName);
+    // Init
     // Correct start values for any gotos before
     int start0 = pTrack->startPatterns[0];
     for (int i = 0; i <= start0; ++i) {
@@ -1238,17 +1291,18 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
             start0++;
         }
     }
-    initString.replace("%%C0INIT%%", QString::number(start0));
+    trackString.replace("%%C0INIT%%", QString::number(start0));
     int start1 = pTrack->startPatterns[1];
     for (int i = 0; i <= start1; ++i) {
         if (sequence[1][i] > 127) {
             start1++;
         }
     }
-    initString.replace("%%C1INIT%%", QString::number(start1 + sequence[0].size()));
-    // Write init
-    if (!writeAsm(fileName, initString, "_init.asm")) {
-        displayMessage("Unable to write init file!");
+    trackString.replace("%%C1INIT%%", QString::number(start1 + sequence[0].size()));
+
+    // Write track data
+    if (!writeAsm(fileName, trackString, "_trackdata.k65")) {
+        displayMessage("Unable to write trackdata file!");
         return false;
     }
 
@@ -1257,9 +1311,74 @@ bool MainWindow::exportTrackSpecificsDasm(QString fileName) {
 
 /*************************************************************************/
 
-bool MainWindow::exportTrackSpecificsK65(QString fileName) {
+void MainWindow::on_actionExportDasm_triggered() {
+    emit stopTrack();
+    QString fileName = getExportFileName();
+    if (fileName!="" && !exportTrackSpecificsDasm(fileName)) {
+        return;
+    }
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionExport_complete_player_to_dasm_triggered() {
+    emit stopTrack();
+    QString fileName = getExportFileName();
+    if (fileName!="" && !exportTrackSpecificsDasm(fileName)) {
+        return;
+    }
+    // Player
+    Emulation::DasmExporter exporter(pTrack);
+    if (!exporter.exportPlayer()) {
+        displayMessage(exporter.getErrorMessage());
+        return;
+    }
+    if (!writeAsm(fileName, exporter.playerString, "_player.asm")) {
+        displayMessage("Unable to write player file!");
+        return;
+    }
+    // Framework
+    QString frameworkString = readAsm("player/dasm/tt_player_framework.asm");
+    if (frameworkString == "") {
+        return;
+    }
+    frameworkString.replace("%%AUTHOR%%", pTrack->metaAuthor);
+    frameworkString.replace("%%NAME%%", pTrack->metaName);
+    if (pTrack->getTvMode() == TiaSound::TvStandard::PAL) {
+        frameworkString.replace("%%PAL%%", "1");
+        frameworkString.replace("%%NTSC%%", "0");
+    } else {
+        frameworkString.replace("%%PAL%%", "0");
+        frameworkString.replace("%%NTSC%%", "1");
+    }
+    // Remove path info from filename
+    QString baseName(QFileInfo(fileName).fileName());
+    frameworkString.replace("%%FILENAME%%", baseName);
+    if (!writeAsm(fileName, frameworkString, "_player_framework.asm")) {
+        displayMessage("Unable to write framework file!");
+        return;
+    }
+    // Harness for measuring the player via "Measure player binary"
+    if (!exporter.exportHarness(baseName)) {
+        displayMessage(exporter.getErrorMessage());
+        return;
+    }
+    if (!writeAsm(fileName, exporter.harnessString, "_harness.asm")) {
+        displayMessage("Unable to write harness file!");
+        return;
+    }
+}
+
+/*************************************************************************/
+
+bool MainWindow::exportTrackSpecificsMads(QString fileName) {
+    Emulation::EventTrace::Scope trace("io", "MainWindow::exportTrackSpecificsMads");
+    if (!exportMadsFlags(fileName)) {
+        return false;
+    }
+
     // Export track data
-    QString trackString = readAsm("player/k65/tt_trackdata.k65");
+    QString trackString = readAsm("player/mads/tt_trackdata.asm");
     if (trackString == "") {
         return false;
     }
@@ -1296,8 +1415,8 @@ bool MainWindow::exportTrackSpecificsK65(QString fileName) {
                 patternMapping[patternIndex] = numPatterns;
                 numPatterns++;
                 // Write out pattern
-                patternString.append("// " + pTrack->patterns[patternIndex].name + "\n");
-                patternString.append("data tt_pattern" + QString::number(patternMapping[patternIndex]) + " {\n");
+                patternString.append("; " + pTrack->patterns[patternIndex].name + "\n");
+                patternString.append("tt_pattern" + QString::number(patternMapping[patternIndex]) + ":\n");
                 // Loop over all notes
                 QList<int> patternValues;
                 for (int n = 0; n < pTrack->patterns[patternIndex].notes.size(); ++n) {
@@ -1341,12 +1460,12 @@ bool MainWindow::exportTrackSpecificsK65(QString fileName) {
                                 insWaveforms.append(TiaSound::getDistortionInt(ins->baseDistortion));
                             }
                             // Write out instrument data
-                            insString.append("// " + QString::number(numInstruments));
+                            insString.append("; " + QString::number(numInstruments));
                             if (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED) {
                                 insString.append("+" + QString::number(numInstruments + 1));
                             }
                             insString.append(": " + ins->name + "\n");
-                            insString.append(listToK65Bytes(insEnvelopeValues));
+                            insString.append(listToMadsBytes(insEnvelopeValues));
                             // Increase running instrument index
                             numInstruments += (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED ? 2 : 1);
                             // +1 for dummy byte, +1 for end marker
@@ -1393,10 +1512,10 @@ bool MainWindow::exportTrackSpecificsK65(QString fileName) {
                             // Insert index. +1 because player expects that
                             percStarts.append(percEnvelopeIndex + 1);
                             // Write out percussion data
-                            percFreqString.append("// " + QString::number(numPercussion) + ": " + perc->name + "\n");
-                            percFreqString.append(listToK65Bytes(percFreqValues));
-                            percCtrlVolString.append("// " + QString::number(numPercussion) + ": " + perc->name + "\n");
-                            percCtrlVolString.append(listToK65Bytes(percCtrlVolValues));
+                            percFreqString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
+                            percFreqString.append(listToMadsBytes(percFreqValues));
+                            percCtrlVolString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
+                            percCtrlVolString.append(listToMadsBytes(percCtrlVolValues));
                             // Increase running percussion index
                             numPercussion++;
                             // +1 for end marker
@@ -1414,8 +1533,8 @@ bool MainWindow::exportTrackSpecificsK65(QString fileName) {
                 }
                 // Pattern end marker
                 patternValues.append(0);
-                patternString.append(listToK65Bytes(patternValues));
-                patternString.append("\n}\n");
+                patternString.append(listToMadsBytes(patternValues));
+                patternString.append("\n");
                 // Pattern speed, if local tempo
                 if (!pTrack->globalSpeed) {
                     if (usesFunktempo) {
@@ -1428,11 +1547,11 @@ bool MainWindow::exportTrackSpecificsK65(QString fileName) {
                 }
                 // Pattern ptr
                 if ((patternMapping.size())%4 == 1) {
-                    patternPtrString.append("        ");
+                    patternPtrString.append("        .byte ");
                 } else {
-                    patternPtrString.append(" ");
+                    patternPtrString.append(", ");
                 }
-                patternPtrString.append("&<tt_pattern" + QString::number(patternMapping[patternIndex]));
+                patternPtrString.append("<tt_pattern" + QString::number(patternMapping[patternIndex]));
                 if ((patternMapping.size())%4 == 0) {
                     patternPtrString.append("\n");
                 }
@@ -1454,333 +1573,18 @@ bool MainWindow::exportTrackSpecificsK65(QString fileName) {
         }
     }
     trackString.replace("%%INSFREQVOLTABLE%%", insString);
-    trackString.replace("%%INSCTRLTABLE%%", listToK65Bytes(insWaveforms));
-    trackString.replace("%%INSADINDEXES%%", listToK65Bytes(insADStarts));
-    trackString.replace("%%INSSUSTAININDEXES%%", listToK65Bytes(insSustainStarts));
-    trackString.replace("%%INSRELEASEINDEXES%%", listToK65Bytes(insReleaseStarts));
-    trackString.replace("%%PERCINDEXES%%", listToK65Bytes(percStarts));
+    trackString.replace("%%INSCTRLTABLE%%", listToMadsBytes(insWaveforms));
+    trackString.replace("%%INSADINDEXES%%", listToMadsBytes(insADStarts));
+    trackString.replace("%%INSSUSTAININDEXES%%", listToMadsBytes(insSustainStarts));
+    trackString.replace("%%INSRELEASEINDEXES%%", listToMadsBytes(insReleaseStarts));
+    trackString.replace("%%PERCINDEXES%%", listToMadsBytes(percStarts));
     trackString.replace("%%PERCFREQTABLE%%", percFreqString);
     trackString.replace("%%PERCCTRLVOLTABLE%%", percCtrlVolString);
-    trackString.replace("%%SEQUENCECHANNEL0%%", listToK65Bytes(sequence[0]));
-    trackString.replace("%%SEQUENCECHANNEL1%%", listToK65Bytes(sequence[1]));
+    trackString.replace("%%SEQUENCECHANNEL0%%", listToMadsBytes(sequence[0]));
+    trackString.replace("%%SEQUENCECHANNEL1%%", listToMadsBytes(sequence[1]));
     trackString.replace("%%PATTERNDEFS%%", patternString);
     if (!pTrack->globalSpeed) {
-        trackString.replace("%%PATTERNSPEEDS%%", listToK65Bytes(patternSpeeds));
-    } else {
-        trackString.replace("%%PATTERNSPEEDS%%", "");
-    }
-    trackString.replace("%%PATTERNPTRLO%%", patternPtrString);
-    patternPtrString.replace("<", ">");
-    trackString.replace("%%PATTERNPTRHI%%", patternPtrString);
-
-    // Flags
-    trackString.replace("%%EVENSPEED%%", QString::number(pTrack->evenSpeed));
-    trackString.replace("%%ODDSPEED%%", QString::number(pTrack->oddSpeed));
-    bool usesGoto = pTrack->usesGoto();
-    trackString.replace("%%USEGOTO%%", (usesGoto ? "1" : "0"));
-    bool usesSlide = pTrack->usesSlide();
-    trackString.replace("%%USESLIDE%%", (usesSlide ? "1" : "0"));
-    bool usesOverlay = pTrack->usesOverlay();
-    trackString.replace("%%USEOVERLAY%%", (usesOverlay ? "1" : "0"));
-    bool usesFunk = pTrack->usesFunktempo();
-    trackString.replace("%%USEFUNKTEMPO%%", (usesFunk ? "1" : "0"));
-    trackString.replace("%%GLOBALSPEED%%", (pTrack->globalSpeed ? "1" : "0"));
-    bool startsWithHold = pTrack->startsWithHold();
-    trackString.replace("%%STARTSWITHNOTES%%", (startsWithHold ? "0" : "1"));
-
-    // Init
-    // Correct start values for any gotos before
-    int start0 = pTrack->startPatterns[0];
-    for (int i = 0; i <= start0; ++i) {
-        if (sequence[0][i] > 127) {
-            start0++;
-        }
-    }
-    trackString.replace("%%C0INIT%%", QString::number(start0));
-    int start1 = pTrack->startPatterns[1];
-    for (int i = 0; i <= start1; ++i) {
-        if (sequence[1][i] > 127) {
-            start1++;
-        }
-    }
-    trackString.replace("%%C1INIT%%", QString::number(start1 + sequence[0].size()));
-
-    // Write track data
-    if (!writeAsm(fileName, trackString, "_trackdata.k65")) {
-        displayMessage("Unable to write trackdata file!");
-        return false;
-    }
-
-    return true;
-}
-
-/*************************************************************************/
-
-void MainWindow::on_actionExportDasm_triggered() {
-    emit stopTrack();
-    QString fileName = getExportFileName();
-    if (fileName!="" && !exportTrackSpecificsDasm(fileName)) {
-        return;
-    }
-}
-
-/*************************************************************************/
-
-void MainWindow::on_actionExport_complete_player_to_dasm_triggered() {
-    emit stopTrack();
-    QString fileName = getExportFileName();
-    if (fileName!="" && !exportTrackSpecificsDasm(fileName)) {
-        return;
-    }
-    // Player
-    QString playerString = readAsm("player/dasm/tt_player.asm");
-    if (playerString == "") {
-        return;
-    }
-    playerString.replace("%%AUTHOR%%", pTrack->metaAuthor);
-    playerString.replace("%%NAME%%", pTrack->metaName);
-    if (!writeAsm(fileName, playerString, "_player.asm")) {
-        displayMessage("Unable to write player file!");
-        return;
-    }
-    // Framework
-    QString frameworkString = readAsm("player/dasm/tt_player_framework.asm");
-    if (frameworkString == "") {
-        return;
-    }
-    frameworkString.replace("%%AUTHOR%%", pTrack->metaAuthor);
-    frameworkString.replace("%%NAME%%", pTrack->metaName);
-    if (pTrack->getTvMode() == TiaSound::TvStandard::PAL) {
-        frameworkString.replace("%%PAL%%", "1");
-        frameworkString.replace("%%NTSC%%", "0");
-    } else {
-        frameworkString.replace("%%PAL%%", "0");
-        frameworkString.replace("%%NTSC%%", "1");
-    }
-    // Remove path info from filename
-    QString baseName(QFileInfo(fileName).fileName());
-    frameworkString.replace("%%FILENAME%%", baseName);
-    if (!writeAsm(fileName, frameworkString, "_player_framework.asm")) {
-        displayMessage("Unable to write framework file!");
-        return;
-    }
-}
-
-/*************************************************************************/
-
-bool MainWindow::exportTrackSpecificsMads(QString fileName) {
-    if (!exportMadsFlags(fileName)) {
-        return false;
-    }
-
-    // Export track data
-    QString trackString = readAsm("player/mads/tt_trackdata.asm");
-    if (trackString == "") {
-        return false;
-    }
-    trackString.replace("%%AUTHOR%%", pTrack->metaAuthor);
-    trackString.replace("%%NAME%%", pTrack->metaName);
-    // Mapping of encountered to real, to weed out the unused
-    QMap<int, int> insMapping{};
-    int numInstruments = 0;
-    QList<int> insWaveforms;
-    QList<int> insADStarts;
-    QList<int> insSustainStarts;
-    QList<int> insReleaseStarts;
-    int insEnvelopeIndex = 0;
-    QString insString;
-    QMap<int, int> percMapping{};
-    int numPercussion = 0;
-    QList<int> percStarts;
-    int percEnvelopeIndex = 0;
-    QString percFreqString;
-    QString percCtrlVolString;
-    QMap<int, int> patternMapping{};
-    QString patternString;
-    QString patternPtrString;
-    QVector<QList<int>> sequence(2);
-    QList<int> patternSpeeds;
-    bool usesFunktempo = pTrack->usesFunktempo();
-    int numPatterns = 0;
-    for (int channel = 0; channel < 2; ++channel) {
-        int gotoOffset = 0;
-        for (int entry = 0; entry < pTrack->channelSequences[channel].sequence.size(); ++entry) {
-            int patternIndex = pTrack->channelSequences[channel].sequence[entry].patternIndex;
-            if (!patternMapping.contains(patternIndex)) {
-                // Pattern not encountered yet
-                patternMapping[patternIndex] = numPatterns;
-                numPatterns++;
-                // Write out pattern
-                patternString.append("; " + pTrack->patterns[patternIndex].name + "\n");
-                patternString.append("tt_pattern" + QString::number(patternMapping[patternIndex]) + ":\n");
-                // Loop over all notes
-                QList<int> patternValues;
-                for (int n = 0; n < pTrack->patterns[patternIndex].notes.size(); ++n) {
-                    Track::Note *note = &(pTrack->patterns[patternIndex].notes[n]);
-                    switch (note->type) {
-                    case Track::Note::instrumentType::Hold:
-                    {
-                        patternValues.append(int(Emulation::Player::NoteHold));
-                        break;
-                    }
-                    case Track::Note::instrumentType::Instrument:
-                    {
-                        if (!insMapping.contains(note->instrumentNumber)) {
-                            // Instrument not encountered yet
-                            insMapping[note->instrumentNumber] = numInstruments;
-                            Track::Instrument *ins = &(pTrack->instruments[note->instrumentNumber]);
-                            // insSize includes end marker that is not in vol/freq lists, so do -1
-                            int insSize = ins->calcEffectiveSize() - 1;
-                            QList<int> insEnvelopeValues;
-                            for (int i = 0; i < insSize; ++i) {
-                                int freqValue = ins->frequencies[i] + 8;
-                                int volValue = ins->volumes[i];
-                                insEnvelopeValues.append((freqValue<<4)|volValue);
-                            }
-                            // Insert dummy byte between sustain and release
-                            insEnvelopeValues.insert(ins->getReleaseStart(), 0);
-                            // Insert end marker
-                            insEnvelopeValues.append(0);
-                            // Insert indexes. Two times if PURE_COMBINED
-                            for (int i = 0; i < (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED ? 2 : 1); ++i) {
-                                insADStarts.append(insEnvelopeIndex);
-                                insSustainStarts.append(insEnvelopeIndex + ins->getSustainStart());
-                                // +1 for dummy byte, -1 because player expects that
-                                insReleaseStarts.append(insEnvelopeIndex + ins->getReleaseStart());
-                            }
-                            // Store waveform(s)
-                            if (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED) {
-                                insWaveforms.append(TiaSound::getDistortionInt(TiaSound::Distortion::PURE_HIGH));
-                                insWaveforms.append(TiaSound::getDistortionInt(TiaSound::Distortion::PURE_LOW));
-                            } else {
-                                insWaveforms.append(TiaSound::getDistortionInt(ins->baseDistortion));
-                            }
-                            // Write out instrument data
-                            insString.append("; " + QString::number(numInstruments));
-                            if (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED) {
-                                insString.append("+" + QString::number(numInstruments + 1));
-                            }
-                            insString.append(": " + ins->name + "\n");
-                            insString.append(listToMadsBytes(insEnvelopeValues));
-                            // Increase running instrument index
-                            numInstruments += (ins->baseDistortion == TiaSound::Distortion::PURE_COMBINED ? 2 : 1);
-                            // +1 for dummy byte, +1 for end marker
-                            insEnvelopeIndex += insSize + 2;
-                        }
-                        // +1 because first instrument number is 1
-                        int valueIns = insMapping[note->instrumentNumber] + 1;
-                        if (pTrack->instruments[note->instrumentNumber].baseDistortion == TiaSound::Distortion::PURE_COMBINED
-                                && note->value > 31) {
-                            valueIns++;
-                        }
-                        int valueFreq = (note->value)%32;
-                        patternValues.append((valueIns<<5)|valueFreq);
-                        break;
-                    }
-                    case Track::Note::instrumentType::Pause:
-                    {
-                        patternValues.append(int(Emulation::Player::NotePause));
-                        break;
-                    }
-                    case Track::Note::instrumentType::Percussion:
-                    {
-                        if (!percMapping.contains(note->instrumentNumber)) {
-                            // Percussion not encountered yet
-                            percMapping[note->instrumentNumber] = numPercussion;
-                            Track::Percussion *perc = &(pTrack->percussion[note->instrumentNumber]);
-                            // percSize includes end marker that is not in lists, so do -1
-                            int percSize = perc->calcEffectiveSize() - 1;
-                            QList<int> percFreqValues;
-                            QList<int> percCtrlVolValues;
-                            for (int i = 0; i < percSize; ++i) {
-                                int freqValue = perc->frequencies[i];
-                                if (perc->overlay && i == percSize - 1) {
-                                    freqValue += 128;
-                                }
-                                percFreqValues.append(freqValue);
-                                int ctrlValue = TiaSound::getDistortionInt(perc->waveforms[i]);
-                                int volValue = perc->volumes[i];
-                                percCtrlVolValues.append((ctrlValue<<4)|volValue);
-                            }
-                            // Insert end marker
-                            percFreqValues.append(0);
-                            percCtrlVolValues.append(0);
-                            // Insert index. +1 because player expects that
-                            percStarts.append(percEnvelopeIndex + 1);
-                            // Write out percussion data
-                            percFreqString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
-                            percFreqString.append(listToMadsBytes(percFreqValues));
-                            percCtrlVolString.append("; " + QString::number(numPercussion) + ": " + perc->name + "\n");
-                            percCtrlVolString.append(listToMadsBytes(percCtrlVolValues));
-                            // Increase running percussion index
-                            numPercussion++;
-                            // +1 for end marker
-                            percEnvelopeIndex += percSize + 1;
-                        }
-                        patternValues.append(percMapping[note->instrumentNumber] + Emulation::Player::NoteFirstPerc);
-                        break;
-                    }
-                    case Track::Note::instrumentType::Slide:
-                    {
-                        patternValues.append(Emulation::Player::NoteHold + note->value);
-                        break;
-                    }
-                    }
-                }
-                // Pattern end marker
-                patternValues.append(0);
-                patternString.append(listToMadsBytes(patternValues));
-                patternString.append("\n");
-                // Pattern speed, if local tempo
-                if (!pTrack->globalSpeed) {
-                    if (usesFunktempo) {
-                        int evenSpeed = pTrack->patterns[patternIndex].evenSpeed - 1;
-                        int oddSpeed = pTrack->patterns[patternIndex].oddSpeed - 1;
-                        patternSpeeds.append(evenSpeed*16 + oddSpeed);
-                    } else {
-                        patternSpeeds.append(pTrack->patterns[patternIndex].evenSpeed - 1);
-                    }
-                }
-                // Pattern ptr
-                if ((patternMapping.size())%4 == 1) {
-                    patternPtrString.append("        .byte ");
-                } else {
-                    patternPtrString.append(", ");
-                }
-                patternPtrString.append("<tt_pattern" + QString::number(patternMapping[patternIndex]));
-                if ((patternMapping.size())%4 == 0) {
-                    patternPtrString.append("\n");
-                }
-            }
-            sequence[channel].append(patternMapping[patternIndex]);
-            int gotoTarget = pTrack->channelSequences[channel].sequence[entry].gotoTarget;
-            if (gotoTarget != -1) {
-                int value = 128 + gotoTarget + gotoOffset;
-                gotoOffset++;
-                if (channel == 1) {
-                    value += sequence[0].size();
-                }
-                if (value > 255) {
-                    displayMessage("Unable to export: Goto target in channel " + QString::number(channel) + " is out of range (" + QString::number(value) + ")!");
-                    return false;
-                }
-                sequence[channel].append(value);
-            }
-        }
-    }
-    trackString.replace("%%INSFREQVOLTABLE%%", insString);
-    trackString.replace("%%INSCTRLTABLE%%", listToMadsBytes(insWaveforms));
-    trackString.replace("%%INSADINDEXES%%", listToMadsBytes(insADStarts));
-    trackString.replace("%%INSSUSTAININDEXES%%", listToMadsBytes(insSustainStarts));
-    trackString.replace("%%INSRELEASEINDEXES%%", listToMadsBytes(insReleaseStarts));
-    trackString.replace("%%PERCINDEXES%%", listToMadsBytes(percStarts));
-    trackString.replace("%%PERCFREQTABLE%%", percFreqString);
-    trackString.replace("%%PERCCTRLVOLTABLE%%", percCtrlVolString);
-    trackString.replace("%%SEQUENCECHANNEL0%%", listToMadsBytes(sequence[0]));
-    trackString.replace("%%SEQUENCECHANNEL1%%", listToMadsBytes(sequence[1]));
-    trackString.replace("%%PATTERNDEFS%%", patternString);
-    if (!pTrack->globalSpeed) {
-        trackString.replace("%%PATTERNSPEEDS%%", listToMadsBytes(patternSpeeds));
+        trackString.replace("%%PATTERNSPEEDS%%", listToMadsBytes(patternSpeeds));
     } else {
         trackString.replace("%%PATTERNSPEEDS%%", "");
     }
@@ -2006,6 +1810,7 @@ void MainWindow::on_actionExport_track_data_to_csv_triggered() {
     QString fileName = fileNames[0];
 
     // Export to csv
+    Emulation::EventTrace::Scope trace("io", "MainWindow::exportCsv");
     QFile outFile(fileName);
     if (!outFile.open(QIODevice::WriteOnly)) {
         displayMessage("Unable to open file!");
@@ -2016,50 +1821,701 @@ void MainWindow::on_actionExport_track_data_to_csv_triggered() {
     // Write format description
     outStream << "tick, C0 sequence, C0 pattern, C0 pattern name, C0 row, C0 note, C1 sequence, C1 pattern, C1 pattern name, C1 row, C1 note\n";
 
-    // Go through notes and write
-    int startIndex1 = pTrack->startPatterns[0];
-    int curNote1 = pTrack->channelSequences[0].sequence[startIndex1].firstNoteNumber;
-    int startIndex2 = pTrack->startPatterns[1];
-    int curNote2 = pTrack->channelSequences[1].sequence[startIndex2].firstNoteNumber;
-
-    QMap<int, bool> visited;
-    int numRow = 0;
-    while (curNote1 != -1 && curNote2 != -1
-           && !visited.contains(curNote1)) {
+    // Go through notes in play order and write
+    const Track::PlayOrder &playOrder = pTrack->getPlayOrder();
+    for (int numRow = 0; numRow < playOrder.getSteps().size(); ++numRow) {
+        const Track::PlayOrder::Step &step = playOrder.getSteps()[numRow];
         // Construct and write line
         QString line = QString::number(numRow);
+        for (int channel = 0; channel < 2; ++channel) {
+            int seqEntry = step.entryIndex[channel];
+            int pattern = pTrack->channelSequences[channel].sequence[seqEntry].patternIndex;
+            int row = step.noteIndex[channel];
+            QString patName = pTrack->patterns[pattern].name;
+            patName.replace(',', ' ');
+            line.append(", " + QString::number(seqEntry));
+            line.append(", " + QString::number(pattern));
+            line.append(", " + patName);
+            line.append(", " + QString::number(row));
+            line.append(", " + ui->trackEditor->constructRowString(row, &(pTrack->patterns[pattern])));
+        }
+        outStream << line << "\n";
+    }
 
-        int seqEntry1 = pTrack->getSequenceEntryIndex(0, curNote1);
-        int pattern1 = pTrack->getPatternIndex(0, curNote1);
-        int row1 = pTrack->getNoteIndexInPattern(0, curNote1);
-        QString patName1 = pTrack->patterns[pattern1].name;
-        patName1.replace(',', ' ');
-        line.append(", " + QString::number(seqEntry1));
-        line.append(", " + QString::number(pattern1));
-        line.append(", " + patName1);
-        line.append(", " + QString::number(row1));
-        line.append(", " + ui->trackEditor->constructRowString(row1, &(pTrack->patterns[pattern1])));
-
-        int seqEntry2 = pTrack->getSequenceEntryIndex(1, curNote2);
-        int pattern2 = pTrack->getPatternIndex(1, curNote2);
-        int row2 = pTrack->getNoteIndexInPattern(1, curNote2);
-        QString patName2 = pTrack->patterns[pattern2].name;
-        patName2.replace(',', ' ');
-        line.append(", " + QString::number(seqEntry2));
-        line.append(", " + QString::number(pattern2));
-        line.append(", " + patName2);
-        line.append(", " + QString::number(row2));
-        line.append(", " + ui->trackEditor->constructRowString(row2, &(pTrack->patterns[pattern2])));
+    outFile.close();
 
-        outStream << line << "\n";
+}
 
-        // Mark visited and go to next row
-        visited[curNote1] = true;
-        curNote1 = pTrack->getNextNoteWithGoto(0, curNote1);
-        curNote2 = pTrack->getNextNoteWithGoto(1, curNote2);
-        numRow++;
+/*************************************************************************/
+
+void MainWindow::on_actionExport_stems_to_WAV_triggered() {
+    emit stopTrack();
+    bool ok;
+    int seconds = QInputDialog::getInt(this, "Export stems to WAV",
+                                       "Maximum length in seconds:", 180, 1, 3600, 1, &ok);
+    if (!ok) {
+        return;
     }
 
-    outFile.close();
+    // Ask for filename; the stems get suffixes
+    QFileDialog dialog(this);
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setFileMode(QFileDialog::AnyFile);
+    dialog.setNameFilter("*.wav");
+    dialog.setDefaultSuffix("wav");
+    dialog.setViewMode(QFileDialog::Detail);
+    dialog.selectFile(QFileInfo(pTrack->name).completeBaseName() + ".wav");
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+        return;
+    }
+    QFileInfo fileInfo(dialog.selectedFiles()[0]);
+    QString baseName = fileInfo.path() + "/" + fileInfo.completeBaseName();
+
+    // The player owns its sink
+    const int sampleRate = 44100;
+    Emulation::StemFileSink *sink = new Emulation::StemFileSink(baseName, sampleRate);
+    if (!sink->open()) {
+        displayMessage(sink->getErrorMessage());
+        delete sink;
+        return;
+    }
+    int frameRate = pTrack->getTvMode() == TiaSound::TvStandard::PAL ? 50 : 60;
+    sink->setFrameRate(frameRate);
+    Emulation::Player player(pTrack, sink);
+    int startRow[2];
+    pTrack->lock();
+    for (int channel = 0; channel < 2; ++channel) {
+        int startEntry = pTrack->startPatterns[channel];
+        startRow[channel] = pTrack->channelSequences[channel].sequence[startEntry].firstNoteNumber;
+    }
+    pTrack->unlock();
+
+    // One emulation pass renders all three stems
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    player.playTrack(startRow[0], startRow[1]);
+    pTrack->lock();
+    for (int frame = 0; frame < seconds*frameRate; ++frame) {
+        player.advanceFrame();
+        if (!player.isPlaying()) {
+            break;
+        }
+    }
+    pTrack->unlock();
+    bool closed = sink->close();
+    QApplication::restoreOverrideCursor();
+    if (!closed) {
+        displayMessage(sink->getErrorMessage());
+        return;
+    }
+
+    QString result = QString("%1 seconds rendered into\n").arg(double(sink->getNumSamples())/sampleRate, 0, 'f', 1);
+    for (int stem = 0; stem < Emulation::StemFileSink::NumStems; ++stem) {
+        result.append(sink->getFileName(stem) + "\n");
+    }
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Export stems",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::displayHarnessResults(const Emulation::PlayerHarness &harness) {
+    int budget = Emulation::PlayerHarness::getVBlankCycles(pTrack->getTvMode());
+    int maxCycles = harness.getMaxCycles();
+    QString result;
+    result.append("Frames played: " + QString::number(harness.getNumFrames()));
+    if (harness.songLooped()) {
+        result.append(" (song loops)\n");
+    } else if (harness.getNumFrames() >= Emulation::PlayerHarness::DefaultMaxFrames) {
+        result.append(" (limit reached)\n");
+    } else {
+        result.append(" (song ends)\n");
+    }
+    int playerSize = harness.getPlayerSize();
+    if (playerSize != -1) {
+        result.append("Player size: " + QString::number(playerSize) + " bytes\n");
+    }
+    result.append("Image size: " + QString::number(harness.getImageSize()) + " bytes\n\n");
+    result.append("Cycles per frame:\n");
+    result.append("  min " + QString::number(harness.getMinCycles()));
+    result.append(", avg " + QString::number(harness.getAverageCycles(), 'f', 1));
+    result.append(", max " + QString::number(maxCycles) + "\n");
+    result.append("Worst case: " + QString::number(double(maxCycles)/Emulation::PlayerHarness::CyclesPerScanline, 'f', 1) + " scanlines, ");
+    result.append(QString::number(100.0*maxCycles/budget, 'f', 1) + "% of the ");
+    result.append(QString::number(budget) + " VBlank cycles of the framework\n\n");
+    result.append("Most expensive frames:\n");
+    QList<Emulation::PlayerHarness::FrameCycles> worstFrames = harness.getWorstFrames(5);
+    for (const Emulation::PlayerHarness::FrameCycles &frame : worstFrames) {
+        result.append("  frame " + QString::number(frame.frame) + ": " + QString::number(frame.cycles) + " cycles\n");
+    }
+
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Player cycles",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionMeasure_player_cycles_triggered() {
+    emit stopTrack();
+    Emulation::PlayerHarness harness;
+    pTrack->lock();
+    bool loaded = harness.loadTrack(pTrack);
+    pTrack->unlock();
+    if (!loaded || !harness.run()) {
+        displayMessage(harness.getErrorMessage());
+        return;
+    }
+    displayHarnessResults(harness);
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionMeasure_player_binary_triggered() {
+    emit stopTrack();
+    QFileDialog dialog(this);
+    dialog.setAcceptMode(QFileDialog::AcceptOpen);
+    dialog.setFileMode(QFileDialog::ExistingFile);
+    dialog.setNameFilter("*.bin");
+    dialog.setViewMode(QFileDialog::Detail);
+    QStringList fileNames;
+    if (dialog.exec()) {
+        fileNames = dialog.selectedFiles();
+    }
+    if (fileNames.isEmpty()) {
+        return;
+    }
+    QString binFileName = fileNames[0];
+    // Symbol file is expected next to the binary
+    QFileInfo binInfo(binFileName);
+    QString symFileName = binInfo.path() + "/" + binInfo.completeBaseName() + ".sym";
+
+    Emulation::PlayerHarness harness;
+    if (!harness.loadBinary(binFileName, symFileName) || !harness.run()) {
+        displayMessage(harness.getErrorMessage());
+        return;
+    }
+    displayHarnessResults(harness);
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionValidate_player_routine_triggered() {
+    emit stopTrack();
+    Emulation::PlayerValidator validator(pTrack);
+    if (!validator.validate()) {
+        displayMessage(validator.getErrorMessage());
+        return;
+    }
+    QString result = "Frames compared: " + QString::number(validator.getNumFrames()) + "\n";
+    if (validator.getPlayerStopFrame() != -1) {
+        result.append("The tracker stopped playing in frame " + QString::number(validator.getPlayerStopFrame()) + "!\n");
+    }
+    result.append("Mismatches: " + QString::number(validator.getNumMismatches()) + "\n");
+    const QVector<Emulation::PlayerValidator::Mismatch> &mismatches = validator.getMismatches();
+    for (int i = 0; i < mismatches.size() && i < 10; ++i) {
+        result.append(Emulation::PlayerValidator::mismatchToString(mismatches[i]) + "\n");
+    }
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Player validation",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionValidate_player_on_song_folder_triggered() {
+    emit stopTrack();
+    QString folder = QFileDialog::getExistingDirectory(this, "Song folder", curSongsDialogPath);
+    if (folder == "") {
+        return;
+    }
+    QDir dir(folder);
+    QStringList fileNames = dir.entryList(QStringList("*.ttt"), QDir::Files);
+
+    // Load sequentially, since loading may report errors to the user
+    QVector<Emulation::PlayerValidator> validators;
+    QStringList loadedNames;
+    for (const QString &fileName : fileNames) {
+        QFile loadFile(dir.filePath(fileName));
+        if (!loadFile.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QJsonDocument loadDoc(QJsonDocument::fromJson(loadFile.readAll()));
+        Track::Track *track = new Track::Track();
+        if (!track->fromJson(loadDoc.object())) {
+            delete track;
+            continue;
+        }
+        validators.append(Emulation::PlayerValidator(track));
+        loadedNames.append(fileName);
+    }
+
+    // Songs are independent of each other, so validate them on all cores
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(validators, [](Emulation::PlayerValidator &validator) {
+        validator.validate();
+    });
+    qint64 elapsed = timer.elapsed();
+
+    int numValid = 0;
+    QString failures;
+    for (int i = 0; i < validators.size(); ++i) {
+        const Emulation::PlayerValidator &validator = validators[i];
+        if (validator.isValid()) {
+            numValid++;
+        } else {
+            failures.append(loadedNames[i] + ": ");
+            if (!validator.getErrorMessage().isEmpty()) {
+                failures.append(validator.getErrorMessage());
+            } else if (!validator.getMismatches().isEmpty()) {
+                failures.append(QString::number(validator.getNumMismatches()) + " mismatches. ");
+                failures.append(Emulation::PlayerValidator::mismatchToString(validator.getMismatches()[0]));
+            } else {
+                failures.append("Tracker stopped playing in frame " + QString::number(validator.getPlayerStopFrame()));
+            }
+            failures.append("\n");
+        }
+        delete validator.getTrack();
+    }
+    QString result = QString("%1 of %2 songs are identical in both players (%3 ms).\n")
+            .arg(numValid).arg(validators.size()).arg(elapsed);
+    if (!failures.isEmpty()) {
+        result.append("\n" + failures);
+    }
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Player validation",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionFind_best_player_variant_triggered() {
+    emit stopTrack();
+    bool ok;
+    int budget = QInputDialog::getInt(this, "Find best player variant",
+                                      "Maximum cycles per frame:",
+                                      Emulation::PlayerHarness::getVBlankCycles(pTrack->getTvMode()),
+                                      1, 100000, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    Emulation::PlayerVariantFinder finder(pTrack);
+    if (!finder.find(budget)) {
+        displayMessage(finder.getErrorMessage());
+        return;
+    }
+    QString result;
+    const QVector<Emulation::PlayerVariantFinder::Candidate> &candidates = finder.getCandidates();
+    for (int i = 0; i < candidates.size(); ++i) {
+        const Emulation::PlayerVariantFinder::Candidate &candidate = candidates[i];
+        result.append(i == finder.getBestIndex() ? "* " : "  ");
+        result.append(Emulation::PlayerVariantFinder::variantToString(candidate.variant) + ": ");
+        if (candidate.isValid) {
+            result.append(QString("%1 bytes, max %2 cycles, avg %3 cycles\n")
+                          .arg(candidate.playerSize).arg(candidate.maxCycles)
+                          .arg(candidate.averageCycles, 0, 'f', 1));
+        } else {
+            result.append(candidate.errorMessage + "\n");
+        }
+    }
+    if (!finder.isWithinBudget()) {
+        result.append("\nNo variant is within " + QString::number(budget) + " cycles, picked the fastest one.\n");
+    }
+    dasmVariant = candidates[finder.getBestIndex()].variant;
+    result.append("\nThe picked variant (*) will be used for dasm exports of this track.");
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Player variants",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionTune_pitch_guide_to_track_triggered() {
+    // The usage comes with the keyframes, which only get rebuilt if
+    // the track has changed
+    pTrack->lock();
+    trackKeyframes->update();
+    TiaSound::TuningOptimizer optimizer(pTrack->getTvMode(), trackKeyframes->getPitchUsage());
+    pTrack->unlock();
+    QVector<TiaSound::TuningOptimizer::Result> results = optimizer.optimizeAll();
+    const TiaSound::TuningOptimizer::Result &best = results[0];
+    if (best.frames == 0) {
+        displayMessage("The track doesn't play any instrument notes!");
+        return;
+    }
+
+    TiaSound::TuningOptimizer::Result current = optimizer.evaluate(curPitchGuide.baseFreq);
+    QString result = "Instrument frames played: " + QString::number(best.frames) + "\n";
+    result.append(QString("Current guide, A4 = %1Hz: %2 cents off on average\n")
+                  .arg(curPitchGuide.baseFreq, 0, 'f', 1).arg(current.rmsCents, 0, 'f', 1));
+    result.append(QString("Best tuning, A4 = %1Hz: %2 cents off on average\n")
+                  .arg(best.baseFreq, 0, 'f', 1).arg(best.rmsCents, 0, 'f', 1));
+    result.append("Shifting A4 by whole semitones gives the same tuning with renamed notes.\n");
+    result.append("\nBest tuning per waveform:\n");
+    for (int i = 1; i < results.size(); ++i) {
+        result.append(QString("%1: A4 = %2Hz, %3 cents off on average, %4 frames\n")
+                      .arg(TiaSound::getDistortionName(results[i].distortion))
+                      .arg(results[i].baseFreq, 0, 'f', 1).arg(results[i].rmsCents, 0, 'f', 1)
+                      .arg(results[i].frames));
+    }
+    result.append("\nMost played pitches with the best tuning:\n");
+    QList<TiaSound::TuningOptimizer::Retuning> retuning = optimizer.getRetuning(best.baseFreq);
+    for (int i = 0; i < retuning.size() && i < 10; ++i) {
+        const TiaSound::TuningOptimizer::Retuning &pitch = retuning[i];
+        QString noteName = pitch.note == TiaSound::Note::NotANote ? "---" : TiaSound::getNoteNameWithOctave(pitch.note);
+        int cents = qRound(pitch.centsOff);
+        result.append(QString("%1 %2: %3 frames, %4 %5%6 cents\n")
+                      .arg(TiaSound::getDistortionName(pitch.distortion)).arg(pitch.frequency)
+                      .arg(pitch.frames).arg(noteName)
+                      .arg(cents >= 0 ? "+" : "").arg(cents));
+    }
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Pitch guide tuning",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionShow_key_latency_triggered() {
+    typedef Emulation::InputLatencyTracer Tracer;
+    Tracer &tracer = Tracer::getShared();
+    QString result;
+    Tracer::StageStats total = tracer.getStats(Tracer::KeyPressed, Tracer::Audible);
+    if (total.count == 0) {
+        result.append("No key presses have been traced yet. Play some notes first.\n");
+    } else {
+        double frameMs = pTrack->getTvMode() == TiaSound::TvStandard::PAL ? 1000.0/50.0 : 1000.0/60.0;
+        result.append(QString("%1 key presses, %2 ms on average (%3 frames), %4 ms max\n\n")
+                      .arg(total.count).arg(total.averageMicros/1000.0, 0, 'f', 1)
+                      .arg(total.averageMicros/1000.0/frameMs, 0, 'f', 1)
+                      .arg(total.maxMicros/1000.0, 0, 'f', 1));
+        result.append("Per stage, min/avg/max:\n");
+        for (int stage = Tracer::Dispatched; stage < Tracer::NumStages; ++stage) {
+            Tracer::StageStats stats = tracer.getStats(Tracer::Stage(stage - 1), Tracer::Stage(stage));
+            if (stats.count == 0) {
+                continue;
+            }
+            result.append(QString("  to %1: %2 / %3 / %4 ms\n")
+                          .arg(Tracer::getStageName(Tracer::Stage(stage)))
+                          .arg(stats.minMicros/1000.0, 0, 'f', 1).arg(stats.averageMicros/1000.0, 0, 'f', 1)
+                          .arg(stats.maxMicros/1000.0, 0, 'f', 1));
+        }
+        result.append("\nKey press to audible:\n");
+        QVector<int> histogram = tracer.getHistogram();
+        int maxCount = 0;
+        for (int count : histogram) {
+            maxCount = qMax(maxCount, count);
+        }
+        int last = histogram.size() - 1;
+        while (histogram[last] == 0) {
+            last--;
+        }
+        for (int bucket = 0; bucket <= last; ++bucket) {
+            int fromMs = bucket*Tracer::BucketMicros/1000;
+            QString range = bucket == Tracer::NumBuckets - 1
+                    ? QString("%1+ ms").arg(fromMs)
+                    : QString("%1-%2 ms").arg(fromMs).arg(fromMs + Tracer::BucketMicros/1000);
+            result.append(QString("  %1: %2 %3\n").arg(range)
+                          .arg(QString(qRound(40.0*histogram[bucket]/maxCount), '#'))
+                          .arg(histogram[bucket]));
+        }
+    }
+
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Key to sound latency",
+                       result,
+                       QMessageBox::Save | QMessageBox::Reset | QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    int reply = msgBox.exec();
+    if (reply == QMessageBox::Reset) {
+        tracer.clear();
+    } else if (reply == QMessageBox::Save) {
+        QFileDialog dialog(this);
+        dialog.setAcceptMode(QFileDialog::AcceptSave);
+        dialog.setFileMode(QFileDialog::AnyFile);
+        dialog.setNameFilter("*.csv");
+        dialog.setDefaultSuffix("csv");
+        dialog.selectFile("latency.csv");
+        if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+            return;
+        }
+        if (!tracer.exportCsv(dialog.selectedFiles()[0])) {
+            displayMessage("Unable to open file!");
+        }
+    }
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionRecord_trace_events_toggled(bool checked) {
+    Emulation::EventTrace::setEnabled(checked);
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionSave_trace_events_triggered() {
+    if (!Emulation::EventTrace::isEnabled()) {
+        displayMessage("Enable \"Record trace events\" first, then save right after the problem shows up.");
+        return;
+    }
+    QFileDialog dialog(this);
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setFileMode(QFileDialog::AnyFile);
+    dialog.setNameFilter("*.json");
+    dialog.setDefaultSuffix("json");
+    dialog.selectFile("trace.json");
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+        return;
+    }
+    if (!Emulation::EventTrace::writeJson(dialog.selectedFiles()[0])) {
+        displayMessage("Unable to open file!");
+    }
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionRun_benchmarks_triggered() {
+    emit stopTrack();
+    QString folder = QFileDialog::getExistingDirectory(this, "Song folder", curSongsDialogPath);
+    if (folder == "") {
+        return;
+    }
+    QDir dir(folder);
+    QStringList fileNames = dir.entryList(QStringList("*.ttt"), QDir::Files);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    Emulation::BenchmarkRunner runner;
+    Emulation::BenchmarkSuite suite(&runner);
+    suite.runTiaSound();
+    suite.runSoundDevice();
+    for (const QString &fileName : fileNames) {
+        QFile loadFile(dir.filePath(fileName));
+        if (loadFile.open(QIODevice::ReadOnly)) {
+            suite.runSong(fileName, loadFile.readAll());
+        }
+    }
+    // The K65 and MADS exporters write files, so they get timed with
+    // the current track only. A failing export would report its error
+    // on every iteration, so try it once first.
+    QTemporaryDir tempDir;
+    QString baseName = tempDir.path() + "/benchmark";
+    if (tempDir.isValid() && exportTrackSpecificsK65(baseName)) {
+        runner.run("Current track: MainWindow::exportTrackSpecificsK65", [this, &baseName]() {
+            exportTrackSpecificsK65(baseName);
+        });
+    }
+    if (tempDir.isValid() && exportTrackSpecificsMads(baseName)) {
+        runner.run("Current track: MainWindow::exportTrackSpecificsMads", [this, &baseName]() {
+            exportTrackSpecificsMads(baseName);
+        });
+    }
+    qint64 elapsed = timer.elapsed();
+
+    QString fileName = Emulation::BenchmarkRunner::getDefaultFileName();
+    Emulation::BenchmarkRunner baseline;
+    bool hasBaseline = baseline.load(fileName);
+    QList<Emulation::BenchmarkRunner::Change> regressions;
+    if (hasBaseline) {
+        regressions = runner.findRegressions(baseline);
+    }
+    bool saved = runner.save(fileName);
+    QApplication::restoreOverrideCursor();
+
+    QList<Emulation::BenchmarkRunner::Result> results = runner.getResults();
+    QString result = QString("%1 benchmarks on %2 songs (%3 s).\n")
+            .arg(results.size()).arg(fileNames.size()).arg(elapsed/1000.0, 0, 'f', 1);
+    if (!hasBaseline) {
+        result.append("No earlier results to compare with.\n");
+    } else if (regressions.isEmpty()) {
+        result.append(QString("No benchmark is more than %1% slower than in the last run.\n")
+                      .arg(qRound(Emulation::BenchmarkRunner::RegressionThreshold*100.0)));
+    } else {
+        result.append(QString("\n%1 benchmarks are slower than in the last run:\n").arg(regressions.size()));
+        for (const Emulation::BenchmarkRunner::Change &change : regressions) {
+            result.append(QString("  %1: +%2%\n").arg(change.name)
+                          .arg(qRound((change.ratio - 1.0)*100.0)));
+        }
+    }
+    QStringList skipped = runner.getSkipped();
+    if (!skipped.isEmpty()) {
+        result.append("\nSkipped:\n  " + skipped.join("\n  ") + "\n");
+    }
+    if (!saved) {
+        result.append("\nUnable to save the results to " + fileName + "\n");
+    }
+    QString details;
+    for (const Emulation::BenchmarkRunner::Result &benchmark : results) {
+        details.append(QString("%1: %2 us, %3 %4/s\n").arg(benchmark.name)
+                       .arg(benchmark.nanosPerIteration/1000.0, 0, 'f', 2)
+                       .arg(benchmark.getItemsPerSecond(), 0, 'f', 0).arg(benchmark.itemName));
+    }
+
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Benchmarks",
+                       result,
+                       QMessageBox::Save | QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.setDetailedText(details);
+    if (msgBox.exec() == QMessageBox::Save) {
+        QFileDialog dialog(this);
+        dialog.setAcceptMode(QFileDialog::AcceptSave);
+        dialog.setFileMode(QFileDialog::AnyFile);
+        dialog.setNameFilter("*.json");
+        dialog.setDefaultSuffix("json");
+        dialog.selectFile("benchmarks.json");
+        if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+            return;
+        }
+        if (!runner.save(dialog.selectedFiles()[0])) {
+            displayMessage("Unable to open file!");
+        }
+    }
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionCheck_golden_renders_triggered() {
+    emit stopTrack();
+    // The golden renders are made by tools/ttgolden from the songs
+    // that come with TIATracker, so compare the same ones
+    Emulation::RenderCorpus golden;
+    if (!golden.load(Emulation::RenderCorpus::goldenFileName)) {
+        displayMessage("Unable to read " + Emulation::RenderCorpus::goldenFileName + "!");
+        return;
+    }
+    // Load sequentially, since loading may report errors to the user
+    Emulation::RenderCorpus corpus;
+    corpus.addSongFolder("songs");
+    corpus.addSyntheticCases();
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    corpus.render();
+    qint64 elapsed = timer.elapsed();
+    QApplication::restoreOverrideCursor();
+
+    QString result = QString("Rendered %1 cases, %2 frames (%3 ms).\n\n")
+            .arg(corpus.getNumCases()).arg(corpus.getNumFrames()).arg(elapsed);
+    QList<Emulation::RenderCorpus::Divergence> divergences = corpus.compare(golden);
+    if (divergences.isEmpty()) {
+        result.append("All cases are identical to the golden renders.");
+    } else {
+        result.append(QString("%1 cases differ from the golden renders:\n").arg(divergences.size()));
+        for (const Emulation::RenderCorpus::Divergence &divergence : divergences) {
+            result.append(Emulation::RenderCorpus::divergenceToString(divergence) + "\n");
+        }
+        result.append("\nIf the changes are intended, run tools/ttgolden with --update.");
+    }
+
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Golden renders",
+                       result,
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionRecord_register_log_toggled(bool checked) {
+    if (!checked) {
+        emit stopRegisterLog();
+        return;
+    }
+    QFileDialog dialog(this);
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setFileMode(QFileDialog::AnyFile);
+    dialog.setNameFilter("*.ttrl");
+    dialog.setDefaultSuffix("ttrl");
+    dialog.selectFile(QFileInfo(pTrack->name).completeBaseName() + ".ttrl");
+    if (!dialog.exec() || dialog.selectedFiles().isEmpty()) {
+        ui->actionRecord_register_log->setChecked(false);
+        return;
+    }
+    emit startRegisterLog(dialog.selectedFiles()[0]);
+}
+
+/*************************************************************************/
+
+void MainWindow::registerLogStopped(QString fileName, int numFrames, QString errorMessage) {
+    if (!errorMessage.isEmpty()) {
+        ui->actionRecord_register_log->setChecked(false);
+        displayMessage(errorMessage);
+        return;
+    }
+    QMessageBox msgBox(QMessageBox::NoIcon,
+                       "Register log",
+                       QString("%1 frames recorded into\n%2").arg(numFrames).arg(fileName),
+                       QMessageBox::Ok, this,
+                       Qt::FramelessWindowHint);
+    msgBox.exec();
+}
+
+/*************************************************************************/
+
+void MainWindow::on_actionRender_register_log_triggered() {
+    QFileDialog openDialog(this);
+    openDialog.setAcceptMode(QFileDialog::AcceptOpen);
+    openDialog.setFileMode(QFileDialog::ExistingFile);
+    openDialog.setNameFilter("*.ttrl");
+    if (!openDialog.exec() || openDialog.selectedFiles().isEmpty()) {
+        return;
+    }
+    QString logName = openDialog.selectedFiles()[0];
+    Emulation::RegisterLogReader reader(logName);
+    if (!reader.open()) {
+        displayMessage(reader.getErrorMessage());
+        return;
+    }
 
+    QStringList sampleRates{"22050", "31400", "44100", "48000"};
+    bool ok;
+    QString sampleRate = QInputDialog::getItem(this, "Render register log", "Sample rate:",
+                                               sampleRates, 2, false, &ok);
+    if (!ok) {
+        return;
+    }
+    QFileDialog saveDialog(this);
+    saveDialog.setAcceptMode(QFileDialog::AcceptSave);
+    saveDialog.setFileMode(QFileDialog::AnyFile);
+    saveDialog.setNameFilter("*.wav");
+    saveDialog.setDefaultSuffix("wav");
+    saveDialog.selectFile(QFileInfo(logName).completeBaseName() + ".wav");
+    if (!saveDialog.exec() || saveDialog.selectedFiles().isEmpty()) {
+        return;
+    }
+
+    Emulation::WavFileSink sink(saveDialog.selectedFiles()[0], sampleRate.toInt());
+    if (!sink.open()) {
+        displayMessage(sink.getErrorMessage());
+        return;
+    }
+    bool replayed = reader.replay(&sink);
+    if (!sink.close()) {
+        displayMessage(sink.getErrorMessage());
+    } else if (!replayed) {
+        displayMessage(reader.getErrorMessage());
+    }
 }
@@ -14,6 +14,9 @@
 #include "tiasound/pitchguide.h"
 #include "tiasound/pitchguidefactory.h"
 #include "emulation/player.h"
+#include "emulation/playerharness.h"
+#include "emulation/trackkeyframes.h"
+#include "emulation/dasmexporter.h"
 
 #include <QList>
 #include <QMenu>
@@ -63,6 +66,9 @@ public:
 
     void registerTrack(Track::Track *newTrack);
 
+    /* The player is only called directly for jam mode */
+    void registerPlayer(Emulation::Player *newPlayer);
+
     TiaSound::PitchGuide *getPitchGuide();
 
     /* Displays a message in an "OK" messagebox */
@@ -78,6 +84,8 @@ public slots:
     void setWaveform(TiaSound::Distortion dist);
     // Update odd and even speeds based on new edit pos (if global tempo is false)
     void updateSpeedSpinBoxes(int editPos);
+    // The player has closed a register log
+    void registerLogStopped(QString fileName, int numFrames, QString errorMessage);
 
 signals:
     void initPlayerTimer();
@@ -89,7 +97,10 @@ signals:
     void stopPercussion();
     void setRowToInstrument(int frequency);
     void playTrack(int start1, int start2);
+    void playTrackState(const Emulation::Player::TrackState &state);
     void stopTrack();
+    void startRegisterLog(QString fileName);
+    void stopRegisterLog();
 
 private slots:
 
@@ -147,10 +158,38 @@ private slots:
 
     void on_actionExport_track_data_to_csv_triggered();
 
+    void on_actionExport_stems_to_WAV_triggered();
+
     void on_actionExport_track_data_to_MADS_triggered();
 
     void on_actionExport_complete_player_to_MADS_triggered();
 
+    void on_actionMeasure_player_cycles_triggered();
+
+    void on_actionMeasure_player_binary_triggered();
+
+    void on_actionValidate_player_routine_triggered();
+
+    void on_actionValidate_player_on_song_folder_triggered();
+
+    void on_actionFind_best_player_variant_triggered();
+
+    void on_actionTune_pitch_guide_to_track_triggered();
+
+    void on_actionShow_key_latency_triggered();
+
+    void on_actionRecord_trace_events_toggled(bool checked);
+
+    void on_actionSave_trace_events_triggered();
+
+    void on_actionRun_benchmarks_triggered();
+
+    void on_actionCheck_golden_renders_triggered();
+
+    void on_actionRecord_register_log_toggled(bool checked);
+
+    void on_actionRender_register_log_triggered();
+
 private:
     /* Tab index values */
     static const int iTabTrack = 0;
@@ -174,18 +213,20 @@ private:
 
     QString readAsm(QString fileName);
     bool writeAsm(QString fileName, QString content, QString extension);
-    QString listToDasmBytes(QList<int> list);
     QString listToMadsBytes(QList<int> list);
     QString listToK65Bytes(QList<int> list);
     QString getExportFileName();
-    bool exportDasmFlags(QString fileName);
     bool exportMadsFlags(QString fileName);
     bool exportTrackSpecificsDasm(QString fileName);
     bool exportTrackSpecificsMads(QString fileName);
     bool exportTrackSpecificsK65(QString fileName);
+    void displayHarnessResults(const Emulation::PlayerHarness &harness);
 
     Ui::MainWindow *ui = nullptr;
     Track::Track *pTrack = nullptr;
+    Emulation::Player *pPlayer = nullptr;
+    // For starting to play in the middle of a song
+    Emulation::TrackKeyframes *trackKeyframes = nullptr;
     TiaSound::PitchGuideFactory pgFactory;
     TiaSound::PitchGuide curPitchGuide = pgFactory.getPitchPerfectPalGuide();
 
@@ -199,6 +240,9 @@ private:
     QAction actionToggleLoop{this};
 
     QString curSongsDialogPath;
+
+    // dasm player variant for exports, see "Find best player variant"
+    Emulation::DasmExporter::Variant dasmVariant{false, false};
 };
 
 #endif // MAINWINDOW_H
@@ -12,6 +12,10 @@
 #include <QRadioButton>
 #include <QPlainTextEdit>
 #include <QTextDocument>
+#include <QCheckBox>
+#include <QSettings>
+#include <QApplication>
+#include "emulation/pitchmeasurement.h"
 
 
 OptionsTab::OptionsTab(QWidget *parent) : QWidget(parent)
@@ -48,6 +52,116 @@ void OptionsTab::initOptionsTab() {
     for (int i = 0; i < guides.size(); ++i) {
         cbGuides->addItem(guides[i].name);
     }
+
+    QSettings settings("Kylearan", "TIATracker");
+    QCheckBox *cbMeasured = findChild<QCheckBox *>("checkBoxMeasuredPitches");
+    cbMeasured->blockSignals(true);
+    cbMeasured->setChecked(settings.value("measuredPitches", false).toBool());
+    cbMeasured->blockSignals(false);
+
+    // Audio device
+    int sampleRate = settings.value("audioSampleRate", 44100).toInt();
+    int bufferSize = settings.value("audioBufferSize", 1024).toInt();
+    bool adaptive = settings.value("audioAdaptive", false).toBool();
+    int prerenderFrames = settings.value("audioPrerenderFrames", 0).toInt();
+    QComboBox *cbSampleRate = findChild<QComboBox *>("comboBoxSampleRate");
+    QComboBox *cbBufferSize = findChild<QComboBox *>("comboBoxBufferSize");
+    QCheckBox *cbAdaptive = findChild<QCheckBox *>("checkBoxAdaptiveBuffer");
+    QSpinBox *sbPrerender = findChild<QSpinBox *>("spinBoxPrerenderFrames");
+    cbSampleRate->blockSignals(true);
+    cbBufferSize->blockSignals(true);
+    cbAdaptive->blockSignals(true);
+    sbPrerender->blockSignals(true);
+    for (int rate : sampleRates) {
+        cbSampleRate->addItem(QString::number(rate) + " Hz");
+    }
+    for (int size : bufferSizes) {
+        cbBufferSize->addItem(QString::number(size));
+    }
+    cbSampleRate->setCurrentIndex(qMax(0, sampleRates.indexOf(sampleRate)));
+    cbBufferSize->setCurrentIndex(qMax(0, bufferSizes.indexOf(bufferSize)));
+    cbAdaptive->setChecked(adaptive);
+    sbPrerender->setValue(prerenderFrames);
+    cbSampleRate->blockSignals(false);
+    cbBufferSize->blockSignals(false);
+    cbAdaptive->blockSignals(false);
+    sbPrerender->blockSignals(false);
+}
+
+/*************************************************************************/
+
+void OptionsTab::applyAudioSettings() {
+    QComboBox *cbSampleRate = findChild<QComboBox *>("comboBoxSampleRate");
+    QComboBox *cbBufferSize = findChild<QComboBox *>("comboBoxBufferSize");
+    QCheckBox *cbAdaptive = findChild<QCheckBox *>("checkBoxAdaptiveBuffer");
+    int sampleRate = sampleRates[cbSampleRate->currentIndex()];
+    int bufferSize = bufferSizes[cbBufferSize->currentIndex()];
+    bool adaptive = cbAdaptive->isChecked();
+    int prerenderFrames = findChild<QSpinBox *>("spinBoxPrerenderFrames")->value();
+
+    QSettings settings("Kylearan", "TIATracker");
+    settings.setValue("audioSampleRate", sampleRate);
+    settings.setValue("audioBufferSize", bufferSize);
+    settings.setValue("audioAdaptive", adaptive);
+    settings.setValue("audioPrerenderFrames", prerenderFrames);
+    emit setAudioDevice(sampleRate, bufferSize, adaptive, prerenderFrames);
+}
+
+/*************************************************************************/
+
+void OptionsTab::audioStatusChanged(int sampleRate, int bufferSize, int underruns, int lateFrames, int maxCallbackMicros) {
+    QLabel *statusLabel = findChild<QLabel *>("labelAudioStatus");
+    if (sampleRate == 0) {
+        statusLabel->setText("(Audio device not open)");
+        return;
+    }
+    double bufferMs = 1000.0*bufferSize/sampleRate;
+    statusLabel->setText(QString("%1 Hz, %2 samples (%3 ms), %4 underruns, %5 late frames, callback max %6 us")
+                         .arg(sampleRate).arg(bufferSize).arg(bufferMs, 0, 'f', 1)
+                         .arg(underruns).arg(lateFrames).arg(maxCallbackMicros));
+}
+
+/*************************************************************************/
+
+void OptionsTab::inputLatencyMeasured(int micros) {
+    maxInputLatencyMicros = qMax(maxInputLatencyMicros, micros);
+    double frameMs = pTrack->getTvMode() == TiaSound::TvStandard::PAL ? 1000.0/50.0 : 1000.0/60.0;
+    QLabel *latencyLabel = findChild<QLabel *>("labelInputLatency");
+    latencyLabel->setText(QString("Key to sound %1 ms, max %2 ms (%3 frames)")
+                          .arg(micros/1000.0, 0, 'f', 1).arg(maxInputLatencyMicros/1000.0, 0, 'f', 1)
+                          .arg(maxInputLatencyMicros/1000.0/frameMs, 0, 'f', 1));
+}
+
+/*************************************************************************/
+
+void OptionsTab::on_comboBoxSampleRate_currentIndexChanged(int) {
+    applyAudioSettings();
+}
+
+/*************************************************************************/
+
+void OptionsTab::on_comboBoxBufferSize_currentIndexChanged(int) {
+    applyAudioSettings();
+}
+
+/*************************************************************************/
+
+void OptionsTab::on_checkBoxAdaptiveBuffer_toggled(bool) {
+    applyAudioSettings();
+}
+
+/*************************************************************************/
+
+void OptionsTab::on_spinBoxPrerenderFrames_valueChanged(int) {
+    applyAudioSettings();
+}
+
+/*************************************************************************/
+
+void OptionsTab::on_pushButtonResetAudioStatus_clicked(bool) {
+    maxInputLatencyMicros = 0;
+    findChild<QLabel *>("labelInputLatency")->setText("");
+    emit resetAudioStatus();
 }
 
 /*************************************************************************/
@@ -235,3 +349,39 @@ void OptionsTab::on_plainTextEditComment_textChanged() {
     QPlainTextEdit *te = findChild<QPlainTextEdit *>("plainTextEditComment");
     pTrack->metaComment = te->document()->toPlainText();
 }
+
+/*************************************************************************/
+
+void OptionsTab::applyPitchTables(bool measured) {
+    if (!measured) {
+        TiaSound::PitchGuideFactory::setFrequencyTables({}, {});
+        return;
+    }
+    Emulation::PitchMeasurement measurement;
+    QString cacheFileName = Emulation::PitchMeasurement::getCacheFileName();
+    if (!measurement.load(cacheFileName)) {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        measurement.measure();
+        QApplication::restoreOverrideCursor();
+        // Without a cache, it just gets measured again next time
+        measurement.save(cacheFileName);
+    }
+    TiaSound::PitchGuideFactory::setFrequencyTables(measurement.getFrequencyTable(TiaSound::TvStandard::PAL),
+                                                    measurement.getFrequencyTable(TiaSound::TvStandard::NTSC));
+}
+
+/*************************************************************************/
+
+void OptionsTab::on_checkBoxMeasuredPitches_toggled(bool checked) {
+    QSettings settings("Kylearan", "TIATracker");
+    settings.setValue("measuredPitches", checked);
+    applyPitchTables(checked);
+
+    // Recalculate all guides with the new frequencies
+    TiaSound::PitchGuideFactory pgFactory;
+    for (int i = 0; i < guides.size(); ++i) {
+        guides[i] = pgFactory.calculateGuide(guides[i].name, guides[i].tvStandard, guides[i].baseFreq);
+    }
+    QComboBox *cbGuides = findChild<QComboBox *>("comboBoxPitchGuide");
+    on_comboBoxPitchGuide_currentIndexChanged(cbGuides->currentIndex());
+}
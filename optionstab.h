@@ -24,6 +24,14 @@ public:
     /* Fills GUI elements with data from the track. Called upon changes. */
     void updateOptionsTab();
 
+    /* Stores the audio settings and sends them to the player */
+    void applyAudioSettings();
+
+    /* Makes pitch guides use measured or theoretical frequencies. The
+     * measurements get cached, so only the first use takes a moment.
+     * Existing guides are not recalculated. */
+    static void applyPitchTables(bool measured);
+
     QString curGuidesDialogPath;
     QList<TiaSound::PitchGuide> guides{};
 
@@ -31,14 +39,25 @@ signals:
     void setTVStandard(int);
     void setPitchGuide(TiaSound::PitchGuide newGuide);
     void setOffTuneThreshold(int value);
+    void setAudioDevice(int sampleRate, int bufferSize, bool adaptive, int prerenderFrames);
+    void resetAudioStatus();
 
 public slots:
     void on_comboBoxPitchGuide_currentIndexChanged(int index);
 
+    void audioStatusChanged(int sampleRate, int bufferSize, int underruns, int lateFrames, int maxCallbackMicros);
+    void inputLatencyMeasured(int micros);
+
 private:
 
     Track::Track *pTrack = nullptr;
 
+    const QList<int> sampleRates{22050, 44100, 48000};
+    const QList<int> bufferSizes{64, 128, 256, 512, 1024, 2048};
+
+    // Worst key to sound latency so far
+    int maxInputLatencyMicros = 0;
+
     void addGuide(TiaSound::PitchGuide newGuide);
 
 private slots:
@@ -57,6 +76,13 @@ private slots:
     void on_lineEditSongName_textChanged(const QString newText);
     void on_plainTextEditComment_textChanged();
 
+    void on_comboBoxSampleRate_currentIndexChanged(int);
+    void on_comboBoxBufferSize_currentIndexChanged(int);
+    void on_checkBoxAdaptiveBuffer_toggled(bool);
+    void on_spinBoxPrerenderFrames_valueChanged(int);
+    void on_checkBoxMeasuredPitches_toggled(bool checked);
+    void on_pushButtonResetAudioStatus_clicked(bool);
+
 
 };
 
@@ -18,6 +18,8 @@
 #include "tiasound/instrumentpitchguide.h"
 #include "tiasound/tiasound.h"
 #include <QWheelEvent>
+#include <cstdlib>
+#include "emulation/eventtrace.h"
 
 
 PatternEditor::PatternEditor(QWidget *parent) : QWidget(parent)
@@ -51,6 +53,7 @@ void PatternEditor::registerTrack(Track::Track *newTrack) {
 
 void PatternEditor::registerPitchGuide(TiaSound::PitchGuide *newGuide) {
     pPitchGuide = newGuide;
+    invalidateRowCache();
 }
 
 /*************************************************************************/
@@ -332,6 +335,155 @@ QString PatternEditor::constructRowString(int curPatternNoteIndex, Track::Patter
     return rowText;
 }
 
+/*************************************************************************/
+
+void PatternEditor::invalidateRowCache() {
+    rowTextCache.clear();
+    for (int channel = 0; channel < 2; ++channel) {
+        noteColumn[channel] = QPixmap();
+        noteColumnKeys[channel].clear();
+    }
+    update();
+}
+
+/*************************************************************************/
+
+quint32 PatternEditor::calcRowTextKey(int curPatternNoteIndex, Track::Pattern *curPattern) {
+    const Track::Note &note = curPattern->notes[curPatternNoteIndex];
+    // Bits 0-6: row, 7-9: type, 10-17: value, 18-21: instrument, 22-26: distortion
+    quint32 key = quint32(curPatternNoteIndex) | (quint32(note.type)<<7);
+    switch (note.type) {
+    case Track::Note::instrumentType::Slide:
+        key |= quint32(note.value&0xff)<<10;
+        break;
+    case Track::Note::instrumentType::Percussion:
+        key |= quint32(note.instrumentNumber)<<18;
+        break;
+    case Track::Note::instrumentType::Instrument: {
+        TiaSound::Distortion dist = pTrack->instruments[note.instrumentNumber].baseDistortion;
+        key |= (quint32(note.value&0xff)<<10)
+                | (quint32(note.instrumentNumber)<<18)
+                | (quint32(dist)<<22);
+        break;
+    }
+    default:
+        break;
+    }
+    return key;
+}
+
+/*************************************************************************/
+
+QStaticText PatternEditor::getRowText(quint32 key, int curPatternNoteIndex, Track::Pattern *curPattern) {
+    QHash<quint32, QStaticText>::const_iterator it = rowTextCache.constFind(key);
+    if (it != rowTextCache.constEnd()) {
+        return it.value();
+    }
+    if (rowTextCache.size() >= maxCachedRowTexts) {
+        rowTextCache.clear();
+    }
+    QStaticText rowText(constructRowString(curPatternNoteIndex, curPattern));
+    rowText.setTextFormat(Qt::PlainText);
+    rowText.prepare(QTransform(), noteFont);
+    rowTextCache.insert(key, rowText);
+    return rowText;
+}
+
+/*************************************************************************/
+
+void PatternEditor::updateNoteColumn(int channel) {
+    // Marks a row that has to be rendered in any case
+    const quint64 dirtyKey = ~quint64(0);
+    // Bits above the row text key
+    const quint64 beatFlag = quint64(1)<<32;
+    const quint64 highlightFlag = quint64(1)<<33;
+    const quint64 validFlag = quint64(1)<<34;
+
+    if (numRows <= 0) {
+        return;
+    }
+    QPixmap &column = noteColumn[channel];
+    QVector<quint64> &keys = noteColumnKeys[channel];
+    int ratio = devicePixelRatio();
+    QSize size(noteAreaWidth*ratio, numRows*noteFontHeight*ratio);
+    int firstRow = editPos - numRows/2;
+    if (column.size() != size) {
+        column = QPixmap(size);
+        column.setDevicePixelRatio(ratio);
+        keys.fill(dirtyKey, numRows);
+    } else {
+        // Move rows rendered before to where they are now
+        int shift = firstRow - noteColumnFirstRow[channel];
+        if (std::abs(shift) >= numRows) {
+            keys.fill(dirtyKey, numRows);
+        } else if (shift != 0) {
+            column.scroll(0, -shift*noteFontHeight*ratio, column.rect());
+            QVector<quint64> shiftedKeys(numRows, dirtyKey);
+            for (int i = 0; i < numRows; ++i) {
+                if (i + shift >= 0 && i + shift < numRows) {
+                    shiftedKeys[i] = keys[i + shift];
+                }
+            }
+            keys = shiftedKeys;
+        }
+    }
+    noteColumnFirstRow[channel] = firstRow;
+
+    // Get pointers to first note
+    int channelSize = pTrack->getChannelNumRows(channel);
+    int curEntryIndex = 0;
+    int curPatternNoteIndex = 0;
+    Track::Pattern *curPattern = nullptr;
+    int firstValidRow = max(0, firstRow);
+    if (firstValidRow < channelSize) {
+        curEntryIndex = pTrack->getSequenceEntryIndex(channel, firstValidRow);
+        Track::SequenceEntry *curEntry = &(pTrack->channelSequences[channel].sequence[curEntryIndex]);
+        curPattern = &(pTrack->patterns[curEntry->patternIndex]);
+        curPatternNoteIndex = firstValidRow - curEntry->firstNoteNumber;
+    }
+
+    QPainter painter;
+    for (int i = 0; i < numRows; ++i) {
+        int row = firstRow + i;
+        quint64 key = 0;
+        quint32 textKey = 0;
+        bool isValid = row >= 0 && row < channelSize;
+        if (isValid) {
+            textKey = calcRowTextKey(curPatternNoteIndex, curPattern);
+            key = quint64(textKey) | validFlag;
+            if (channel == selectedChannel && row == editPos) {
+                key |= highlightFlag;
+            } else if (row%(pTrack->rowsPerBeat) == 0) {
+                key |= beatFlag;
+            }
+        }
+        if (key != keys[i]) {
+            if (!painter.isActive()) {
+                painter.begin(&column);
+                painter.setFont(noteFont);
+                painter.setPen(MainWindow::blue);
+            }
+            int yPos = i*noteFontHeight;
+            QColor background = MainWindow::dark;
+            if ((key&highlightFlag) != 0) {
+                background = MainWindow::light;
+            } else if ((key&beatFlag) != 0) {
+                background = MainWindow::darkHighlighted;
+            }
+            painter.fillRect(0, yPos, noteAreaWidth, noteFontHeight, background);
+            if (isValid) {
+                painter.drawStaticText(noteMargin, yPos, getRowText(textKey, curPatternNoteIndex, curPattern));
+            }
+            keys[i] = key;
+        }
+        // Advance note. At the end of the track, only empty rows follow.
+        if (isValid && pTrack->getNextNote(channel, &curEntryIndex, &curPatternNoteIndex)) {
+            int patternIndex = pTrack->channelSequences[channel].sequence[curEntryIndex].patternIndex;
+            curPattern = &(pTrack->patterns[patternIndex]);
+        }
+    }
+}
+
 void PatternEditor::drawPatternNameAndSeparator(int yPos, int nameXPos, int curPatternNoteIndex, int channel, int xPos, int curEntryIndex, QPainter *painter, Track::Pattern *curPattern)
 {
     if (curPatternNoteIndex == 0) {
@@ -375,32 +527,41 @@ void PatternEditor::drawGoto(int channel, int yPos, Track::Pattern *curPattern,
     }
 }
 
-void PatternEditor::drawTimestamp(int row, QPainter *painter, int yPos, int channel)
+void PatternEditor::drawTimestamp(const Track::PlayOrder &playOrder, int row, QPainter *painter, int yPos, int channel)
 {
-    if (pTrack->globalSpeed) {
-        int ticksPerSecond = pTrack->getTvMode() == TiaSound::TvStandard::PAL ? 50 : 60;
-        long numOddTicks = int((row + 1)/2)*pTrack->oddSpeed;
-        long numEvenTicks = int(row/2)*pTrack->evenSpeed;
-        long numTick = numOddTicks + numEvenTicks;
-        int curTicks = row%2 == 0 ? pTrack->evenSpeed : pTrack->oddSpeed;
-        if (channel == 0 && numTick%ticksPerSecond < curTicks) {
-            int minute = numTick/(ticksPerSecond*60);
-            int second = (numTick%(ticksPerSecond*60))/ticksPerSecond;
-            QString timestampText = QString::number(minute);
-            if (second < 10) {
-                timestampText.append(":0");
-            } else {
-                timestampText.append(":");
-            }
-            timestampText.append(QString::number(second));
-            painter->setFont(legendFont);
-            painter->setPen(MainWindow::contentDarker);
-            painter->drawText(patternNameWidth + noteAreaWidth, yPos, timeAreaWidth, legendFontHeight, Qt::AlignHCenter, timestampText);
+    if (channel != 0) {
+        return;
+    }
+    // Rows that are never played don't get a time
+    int step = playOrder.getFirstStep(channel, row);
+    if (step == -1) {
+        return;
+    }
+    const Track::PlayOrder::Step &curStep = playOrder.getSteps()[step];
+    int ticksPerSecond = pTrack->getTvMode() == TiaSound::TvStandard::PAL ? 50 : 60;
+    // Mark the row in which a new second starts
+    int seconds = (curStep.startFrame + ticksPerSecond - 1)/ticksPerSecond;
+    if (seconds*ticksPerSecond < curStep.startFrame + curStep.numFrames) {
+        int minute = seconds/60;
+        int second = seconds%60;
+        QString timestampText = QString::number(minute);
+        if (second < 10) {
+            timestampText.append(":0");
+        } else {
+            timestampText.append(":");
         }
+        timestampText.append(QString::number(second));
+        painter->setFont(legendFont);
+        painter->setPen(MainWindow::contentDarker);
+        painter->drawText(patternNameWidth + noteAreaWidth, yPos, timeAreaWidth, legendFontHeight, Qt::AlignHCenter, timestampText);
     }
 }
 
 void PatternEditor::paintChannel(QPainter *painter, int channel, int xPos, int nameXPos) {
+    // Note texts come pre-rendered
+    updateNoteColumn(channel);
+    painter->drawPixmap(xPos - noteMargin, topMargin, noteColumn[channel]);
+
     // Calc first note/pattern
     int firstNoteIndex = max(0, editPos - numRows/2);
     // Don't do anything if we are behind the last note
@@ -418,21 +579,13 @@ void PatternEditor::paintChannel(QPainter *painter, int channel, int xPos, int n
         curPattern = &(pTrack->patterns[curEntry->patternIndex]);
     }
     int curPatternNoteIndex = firstNoteIndex - curEntry->firstNoteNumber;
-    // Draw rows
+    const Track::PlayOrder &playOrder = pTrack->getPlayOrder();
+    // Draw legends
     for (int row = firstNoteIndex; row <= editPos + numRows/2; ++row) {
         int yPos = topMargin + noteFontHeight*(row - (editPos - numRows/2));
-        // First row in beat?
-        if (row%(pTrack->rowsPerBeat) == 0 && (channel != selectedChannel || row != editPos)) {
-            painter->fillRect(xPos - noteMargin, yPos, noteAreaWidth, noteFontHeight, MainWindow::darkHighlighted);
-        }
-        QString rowText = constructRowString(curPatternNoteIndex, curPattern);
-        painter->setFont(noteFont);
-        painter->setPen(MainWindow::blue);
-        painter->drawText(xPos, yPos, noteAreaWidth - 2*noteMargin, noteFontHeight, Qt::AlignLeft, rowText);
-
         drawPatternNameAndSeparator(yPos, nameXPos, curPatternNoteIndex, channel, xPos, curEntryIndex, painter, curPattern);
         drawGoto(channel, yPos, curPattern, curEntry, painter, nameXPos, curPatternNoteIndex);
-        drawTimestamp(row, painter, yPos, channel);
+        drawTimestamp(playOrder, row, painter, yPos, channel);
 
         // Advance note
         if (!pTrack->getNextNote(channel, &curEntryIndex, &curPatternNoteIndex)) {
@@ -445,6 +598,7 @@ void PatternEditor::paintChannel(QPainter *painter, int channel, int xPos, int n
 }
 
 void PatternEditor::paintEvent(QPaintEvent *) {
+    Emulation::EventTrace::Scope trace("gui", "PatternEditor::paintEvent");
     QPainter painter(this);
 
     // Pattern name areas
@@ -455,10 +609,6 @@ void PatternEditor::paintEvent(QPaintEvent *) {
     painter.fillRect(patternNameWidth + noteAreaWidth + timeAreaWidth, 0, noteAreaWidth, height(), MainWindow::dark);
     // Time area
     painter.fillRect(patternNameWidth + noteAreaWidth, 0, timeAreaWidth, height(), MainWindow::lightHighlighted);
-    // Current highlights
-    int highlightY = height()/2 - noteFontHeight/2;
-    int highlightX = patternNameWidth + selectedChannel*(noteAreaWidth + timeAreaWidth);
-    painter.fillRect(highlightX, highlightY, noteAreaWidth, noteFontHeight, MainWindow::light);
 
     // Calc number of visible rows
     numRows = height()/noteFontHeight;
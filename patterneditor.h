@@ -16,6 +16,10 @@
 #include <QMenu>
 #include "instrumentselector.h"
 #include "emulation/player.h"
+#include <QHash>
+#include <QPixmap>
+#include <QStaticText>
+#include <QVector>
 
 
 class PatternEditor : public QWidget
@@ -37,6 +41,11 @@ public:
 
     QString constructRowString(int curPatternNoteIndex, Track::Pattern *curPattern);
 
+    /* Forgets all rendered rows. Has to be called if something changes
+     * the text of rows without changing the notes, like a new pitch
+     * guide. */
+    void invalidateRowCache();
+
     QSize sizeHint() const;
 
 signals:
@@ -87,11 +96,23 @@ private:
     static const int patternNameMargin = 4;
     static const int minHeight = 400;
 
+    // The row text cache gets cleared when it grows beyond this
+    static const int maxCachedRowTexts = 4096;
+
     void drawPatternNameAndSeparator(int yPos, int nameXPos, int curPatternNoteIndex, int channel, int xPos, int curEntryIndex, QPainter *painter, Track::Pattern *curPattern);
     void drawGoto(int channel, int yPos, Track::Pattern *curPattern, Track::SequenceEntry *curEntry, QPainter *painter, int nameXPos, int curPatternNoteIndex);
-    void drawTimestamp(int row, QPainter *painter, int yPos, int channel);
+    void drawTimestamp(const Track::PlayOrder &playOrder, int row, QPainter *painter, int yPos, int channel);
     void paintChannel(QPainter *painter, int channel, int xPos, int nameXPos);
 
+    /* Everything that shows in the text of a row, packed into an int */
+    quint32 calcRowTextKey(int curPatternNoteIndex, Track::Pattern *curPattern);
+    QStaticText getRowText(quint32 key, int curPatternNoteIndex, Track::Pattern *curPattern);
+
+    /* Brings the rendered note column of a channel up to date. Rows
+     * already rendered get scrolled into place; only rows that are
+     * new or have changed get drawn. */
+    void updateNoteColumn(int channel);
+
     /* If x and y are in a valid row with regards to the channel clicked,
      * the channel number, row and note index get written to the parameters
      * and true is returned.
@@ -127,6 +148,14 @@ private:
 
     bool follow = false;
     bool loop = false;
+
+    // Row texts by calcRowTextKey()
+    QHash<quint32, QStaticText> rowTextCache;
+    // Rendered note columns, with the row each starts at and what has
+    // been rendered into each row
+    QPixmap noteColumn[2];
+    int noteColumnFirstRow[2]{0, 0};
+    QVector<quint64> noteColumnKeys[2];
 };
 
 #endif // PATTERNEDITOR_H
@@ -24,6 +24,8 @@
 #include "mainwindow.h"
 #include "track/percussion.h"
 #include <QCheckBox>
+#include <QApplication>
+#include "emulation/percussionfitter.h"
 
 
 const QList<TiaSound::Distortion> PercussionTab::availableWaveforms{
@@ -258,6 +260,57 @@ void PercussionTab::on_buttonPercussionImport_clicked() {
 
 /*************************************************************************/
 
+void PercussionTab::on_buttonPercussionFitWav_clicked() {
+    Track::Percussion *curPercussion = getSelectedPercussion();
+
+    // Ask if Percussion should really be overwritten
+    if (!curPercussion->isEmpty()) {
+        QMessageBox msgBox(QMessageBox::NoIcon,
+                           "Fit Percussion to WAV",
+                           "Do you really want to overwrite the current percussion?",
+                           QMessageBox::Yes | QMessageBox::No, this,
+                           Qt::FramelessWindowHint);
+        if (msgBox.exec() != QMessageBox::Yes) {
+            return;
+        }
+    }
+
+    // Ask for filename
+    QFileDialog dialog(this);
+    dialog.setDirectory(curPercussionDialogPath);
+    dialog.setAcceptMode(QFileDialog::AcceptOpen);
+    dialog.setFileMode(QFileDialog::ExistingFile);
+    dialog.setNameFilter("*.wav");
+    dialog.setViewMode(QFileDialog::Detail);
+    QStringList fileNames;
+    if (dialog.exec()) {
+        fileNames = dialog.selectedFiles();
+    }
+    if (fileNames.isEmpty()) {
+        return;
+    }
+    curPercussionDialogPath = dialog.directory().absolutePath();
+
+    Emulation::PercussionFitter fitter(pTrack->getTvMode(), availableWaveforms);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool ok = fitter.fit(fileNames[0]);
+    QApplication::restoreOverrideCursor();
+    if (!ok) {
+        MainWindow::displayMessage(fitter.getErrorMessage());
+        return;
+    }
+    // The player thread reads the envelopes while playing
+    pTrack->lock();
+    fitter.apply(curPercussion);
+    pTrack->unlock();
+
+    // Update display
+    updatePercussionTab();
+    update();
+}
+
+/*************************************************************************/
+
 Track::Percussion *PercussionTab::getSelectedPercussion() {
     int iCurPercussion = getSelectedPercussionIndex();
     Track::Percussion *curPercussion = &(pTrack->percussion[iCurPercussion]);
@@ -48,6 +48,8 @@ signals:
 public slots:
     void on_buttonPercussionExport_clicked();
     void on_buttonPercussionImport_clicked();
+    /* Replaces the current percussion with one fitted to a WAV sample */
+    void on_buttonPercussionFitWav_clicked();
     void on_buttonPercussionDelete_clicked();
 
     void on_spinBoxPercussionLength_editingFinished();
@@ -11,6 +11,7 @@
 
 #include "pianokeyboard.h"
 #include "mainwindow.h"
+#include "emulation/inputlatencytracer.h"
 
 
 // Fixed key traits (black yes/no, position index)
@@ -163,6 +164,7 @@ void PianoKeyboard::changeOctave(bool) {
 /*************************************************************************/
 
 void PianoKeyboard::pianoKeyShortcut(bool) {
+    Emulation::InputLatencyTracer::getShared().keyPressed();
     QAction *action = qobject_cast<QAction *>(sender());
     int noteBaseIndex = action->data().toInt();
     int keyIndex = selectedOctave*12 + noteBaseIndex;
@@ -306,6 +308,7 @@ void PianoKeyboard::addShortcut(QAction *action, QString actionName) {
 
 void PianoKeyboard::mousePressEvent(QMouseEvent *event)
 {
+    Emulation::InputLatencyTracer::getShared().keyPressed();
     int octave = int(event->x()/(keyWidth*numWhiteKeysPerOctave));
     int keyIndex;
     if (event->y() < blackKeyHeight) {
@@ -0,0 +1,75 @@
+; TIATracker music player
+; Copyright 2016 Andre "Kylearan" Wichmann
+; Website: https://bitbucket.org/kylearan/tiatracker
+; Email: andre.wichmann@gmx.de
+;
+; Licensed under the Apache License, Version 2.0 (the "License");
+; you may not use this file except in compliance with the License.
+; You may obtain a copy of the License at
+;
+;   http://www.apache.org/licenses/LICENSE-2.0
+;
+; Unless required by applicable law or agreed to in writing, software
+; distributed under the License is distributed on an "AS IS" BASIS,
+; WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+; See the License for the specific language governing permissions and
+; limitations under the License.
+
+; Song author: %%AUTHOR%%
+; Song name: %%NAME%%
+
+; @com.wudsn.ide.asm.hardware=ATARI2600
+
+; =====================================================================
+; Test harness for measuring the player routine in TIATracker.
+; Wraps init and player into subroutines that the tracker calls once
+; at startup and then once per frame.
+;
+; To measure a player assembled with dasm, use:
+;   dasm %%FILENAME%%_harness.asm -f3 -o%%FILENAME%%.bin -s%%FILENAME%%.sym
+; and load the .bin file in TIATracker. The .sym file must be in the
+; same folder.
+; =====================================================================
+
+        processor 6502
+
+; TIA audio registers
+AUDC0           = $15
+AUDC1           = $16
+AUDF0           = $17
+AUDF1           = $18
+AUDV0           = $19
+AUDV1           = $1a
+
+
+; =====================================================================
+; Variables
+; =====================================================================
+
+        SEG.U   variables
+        ORG     $80
+
+        include "%%FILENAME%%_variables.asm"
+
+
+; =====================================================================
+; Code
+; =====================================================================
+
+        SEG     code
+        ORG     $1000
+
+tt_HarnessInit SUBROUTINE
+        include "%%FILENAME%%_init.asm"
+        rts
+
+tt_HarnessPlay SUBROUTINE
+        include "%%FILENAME%%_player.asm"
+        rts
+
+
+; =====================================================================
+; Data
+; =====================================================================
+
+        include "%%FILENAME%%_trackdata.asm"
@@ -25,6 +25,11 @@
 ; =====================================================================
 tt_PlayerStart:
 
+; IMPLEMENTED PLAYER VARIANTS (see tt_variables.asm):
+; - Speed: Inline tt_CalcInsIndex (TT_INLINE_CALCINSINDEX)
+; - Speed: Inline tt_FetchNote in the sequencer if TT_USE_OVERLAY is
+;       used (TT_INLINE_FETCHNOTE)
+;
 ; PLANNED PLAYER VARIANTS:
 ; - RAM, speed, player ROM: c0/c1 patterns have same length
 ; - RAM: Pack 2 values (out of cur_pat_index, cur_note_index, envelope_index)
@@ -34,14 +39,14 @@ tt_PlayerStart:
 ; - ROM: Check if tt_SequenceTable can hold ptrs directly without indexing
 ;       tt_PatternPtrLo/Hi. Can be smaller if not many patterns get repeated
 ;       (saves table and decode routine)
-; - Speed: Inline tt_CalcInsIndex
 ; - Speed: Store ptr to current note in RAM instead of reconstructing it?
 ;       Might also save the need for cur_note_index
 
 
 ; ---------------------------------------------------------------------
 ; Helper macro: Retrieves current note. May advance pattern if needed.
-; Becomes a subroutine if TT_USE_OVERLAY is used.
+; Becomes a subroutine if TT_USE_OVERLAY is used. The sequencer still
+; inlines it if TT_INLINE_FETCHNOTE is set.
 ; ---------------------------------------------------------------------
     MAC TT_FETCH_CURRENT_NOTE
         ; construct ptr to pattern
@@ -92,6 +97,25 @@ tt_PlayerStart:
     ENDM
 
 
+; ---------------------------------------------------------------------
+; Helper macro: Calls tt_CalcInsIndex, or inlines it if
+; TT_INLINE_CALCINSINDEX is set.
+; ---------------------------------------------------------------------
+    MAC TT_CALC_INS_INDEX
+    IF TT_INLINE_CALCINSINDEX = 0
+        jsr tt_CalcInsIndex
+    ELSE
+        ; move upper 3 bits to lower 3
+        lsr
+        lsr
+        lsr
+        lsr
+        lsr
+        tay
+    ENDIF
+    ENDM
+
+
 ; ---------------------------------------------------------------------
 ; Music player entry. Call once per frame.
 ; ---------------------------------------------------------------------
@@ -99,14 +123,25 @@ tt_Player SUBROUTINE
         ; ==================== Sequencer ====================
         ; Decrease speed timer
         dec tt_timer
+    IF TT_USE_OVERLAY = 1 && TT_INLINE_FETCHNOTE = 1
+        ; Inlined tt_FetchNote makes the sequencer too long for branches
+        bmi .doSequencer
+        jmp .noNewNote
+.doSequencer:
+    ELSE
         bpl .noNewNote
+    ENDIF
         
         ; Timer ran out: Do sequencer
         ; Advance to next note
         ldx #1                          ; 2 channels
 .advanceLoop:
     IF TT_USE_OVERLAY = 1
+      IF TT_INLINE_FETCHNOTE = 0
         jsr tt_FetchNote
+      ELSE
+        TT_FETCH_CURRENT_NOTE
+      ENDIF
     ELSE
         TT_FETCH_CURRENT_NOTE
     ENDIF
@@ -137,7 +172,7 @@ tt_Player SUBROUTINE
         ; only follow an instrument, we don't need to handle percussion
         ; or commands.
         lda tt_cur_ins_c0,x
-        jsr tt_CalcInsIndex
+        TT_CALC_INS_INDEX
         lda tt_InsReleaseIndexes-1,y    ; -1 b/c instruments start at #1
         ; Put it into release. Skip junk byte so index no longer indicates
         ; sustain phase.
@@ -179,7 +214,7 @@ tt_FetchNote:
         bvs .finishedNewNote
     ENDIF
         ; Put note into attack/decay
-        jsr tt_CalcInsIndex
+        TT_CALC_INS_INDEX
         lda tt_InsADIndexes-1,y         ; -1 because instruments start at #1
 .storeADIndex:
         sta tt_envelope_index_c0,x      
@@ -191,7 +226,13 @@ tt_FetchNote:
         ; loop over channels
 .sequencerNextChannel:
         dex
+    IF TT_USE_OVERLAY = 1 && TT_INLINE_FETCHNOTE = 1
+        bmi .sequencerDone
+        jmp .advanceLoop
+.sequencerDone:
+    ELSE
         bpl .advanceLoop
+    ENDIF
 
         ; Reset timer value
     IF TT_GLOBAL_SPEED = 0
@@ -272,7 +313,7 @@ tt_FetchNote:
         bcc .afterAudioUpdate
         ; Instrument: Put into sustain
         sta tt_cur_ins_c0,x             ; set new instrument
-        jsr tt_CalcInsIndex
+        TT_CALC_INS_INDEX
         lda tt_InsSustainIndexes-1,y    ; -1 because instruments start at #1
         sta tt_envelope_index_c0,x      
         ; Set prefetch flag. asl-sec-ror is smaller than lda-ora #128-sta
@@ -286,9 +327,11 @@ tt_FetchNote:
 
     
 ; ---------------------------------------------------------------------
-; Helper subroutine to minimize ROM footprint.
+; Helper subroutine to minimize ROM footprint. Will be inlined if
+; TT_INLINE_CALCINSINDEX is set.
 ; Interleaved here so player routine can be inlined.
 ; ---------------------------------------------------------------------
+    IF TT_INLINE_CALCINSINDEX = 0
 tt_CalcInsIndex:
         ; move upper 3 bits to lower 3
         lsr
@@ -299,12 +342,17 @@ tt_CalcInsIndex:
         tay
 tt_Bit6Set:     ; This opcode has bit #6 set, for use with bit instruction
         rts
-
+    ELSE
+      IF TT_USE_OVERLAY = 1
+tt_Bit6Set:     ; This opcode has bit #6 set, for use with bit instruction
+        rts
+      ENDIF
+    ENDIF
 
 .instrument:
         ; --- Melodic instrument ---
         ; Compute index into ADSR indexes and master Ctrl tables
-        jsr tt_CalcInsIndex
+        TT_CALC_INS_INDEX
         ; Set AUDC with master value for this instrument, while we are at it
         lda tt_InsCtrlTable-1,y ; -1 because instruments start with #1
         sta AUDC0,x
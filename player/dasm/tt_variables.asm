@@ -45,6 +45,14 @@ TT_USE_FUNKTEMPO        = %%USEFUNKTEMPO%%
 ; 0: +2 bytes
 TT_STARTS_WITH_NOTES    = %%STARTSWITHNOTES%%
 
+; Player variants, which trade ROM for speed independently of the song.
+; 1: Inline tt_CalcInsIndex, +2 bytes (+6 with TT_USE_OVERLAY),
+;    -12 cycles per call
+TT_INLINE_CALCINSINDEX  = %%INLINECALCINSINDEX%%
+; 1: Inline tt_FetchNote in the sequencer (only with TT_USE_OVERLAY),
+;    -12 cycles per channel and note
+TT_INLINE_FETCHNOTE     = %%INLINEFETCHNOTE%%
+
 
 ; =====================================================================
 ; Permanent variables. These are states needed by the player.
@@ -12,6 +12,11 @@
 
 namespace TiaSound {
 
+QMap<Distortion, QList<double>> PitchGuideFactory::tableFrequenciesPal;
+QMap<Distortion, QList<double>> PitchGuideFactory::tableFrequenciesNtsc;
+
+/*************************************************************************/
+
 PitchGuideFactory::PitchGuideFactory()
 {
     // Generate lists of available frequencies for all TIA distortions
@@ -29,6 +34,12 @@ PitchGuideFactory::PitchGuideFactory()
                 palList.append(PalFrequency/divider/(1 + f));
                 ntscList.append(NtscFrequency/divider/(1 + f));
             }
+            if (tableFrequenciesPal.value(dist).value(f, 0.0) > 0.0) {
+                palList[f] = tableFrequenciesPal[dist][f];
+            }
+            if (tableFrequenciesNtsc.value(dist).value(f, 0.0) > 0.0) {
+                ntscList[f] = tableFrequenciesNtsc[dist][f];
+            }
         }
         distFrequenciesPal[dist] = palList;
         distFrequenciesNtsc[dist] = ntscList;
@@ -37,6 +48,13 @@ PitchGuideFactory::PitchGuideFactory()
 
 /*************************************************************************/
 
+void PitchGuideFactory::setFrequencyTables(const QMap<Distortion, QList<double>> &pal, const QMap<Distortion, QList<double>> &ntsc) {
+    tableFrequenciesPal = pal;
+    tableFrequenciesNtsc = ntsc;
+}
+
+/*************************************************************************/
+
 PitchGuide PitchGuideFactory::getPitchPerfectPalGuide() {
     return calculateGuide("PAL Pitch-perfect A4=440Hz", TvStandard::PAL, 440.0);
 }
@@ -188,6 +206,16 @@ QList<FrequencyPitchGuide> PitchGuideFactory::calcInstrumentPitchGuide(TiaSound:
     return fpg;
 }
 
+/*************************************************************************/
+
+QList<double> PitchGuideFactory::getTiaFrequencies(TvStandard standard, Distortion dist) const {
+    if (standard == TvStandard::PAL) {
+        return distFrequenciesPal[dist];
+    } else {
+        return distFrequenciesNtsc[dist];
+    }
+}
+
 }
 
 
@@ -25,6 +25,9 @@ class PitchGuideFactory
 {
 public:
     static const int numNotes = 7*12;
+    // TIA audio clocks per second
+    static const int PalFrequency = 31200;
+    static const int NtscFrequency = 31440;
 
     PitchGuideFactory();
 
@@ -49,9 +52,18 @@ public:
 
     QList<FrequencyPitchGuide> calcInstrumentPitchGuide(TvStandard standard, Distortion dist, double baseFreq);
 
+    /* Frequencies in Hz of all 32 AUDF values of a distortion */
+    QList<double> getTiaFrequencies(TvStandard standard, Distortion dist) const;
+
+    /* Replaces the theoretical frequencies for all factories created
+     * afterwards, e.g. by measured ones. Lists hold the frequencies in
+     * Hz of all 32 AUDF values; a frequency of 0 keeps the theoretical
+     * one. Empty maps restore the theoretical frequencies. */
+    static void setFrequencyTables(const QMap<Distortion, QList<double>> &pal, const QMap<Distortion, QList<double>> &ntsc);
+
 private:
-    static const int PalFrequency = 31200;
-    static const int NtscFrequency = 31440;
+    static QMap<Distortion, QList<double>> tableFrequenciesPal;
+    static QMap<Distortion, QList<double>> tableFrequenciesNtsc;
 
     const QMap<Distortion, double> distDividers{
         {Distortion::SILENT, 999999.9},
@@ -0,0 +1,150 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "pitchguideoptimizer.h"
+
+#include <QMap>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+#include "pitchguidefactory.h"
+
+
+namespace TiaSound {
+
+PitchGuideOptimizer::PitchGuideOptimizer(TvStandard standard, const QList<Distortion> &distortions,
+                                         const QVector<bool> &enabledNotes, int threshold) :
+    enabledNotes(enabledNotes), threshold(threshold)
+{
+    // Several distortions share the same frequencies
+    QMap<double, int> weights;
+    PitchGuideFactory pg;
+    for (Distortion dist : distortions) {
+        for (double tiaFreq : pg.getTiaFrequencies(standard, dist)) {
+            weights[1200.0*std::log2(tiaFreq/440.0)]++;
+        }
+    }
+    for (auto it = weights.constBegin(); it != weights.constEnd(); ++it) {
+        terms.append({it.key(), it.value()});
+    }
+}
+
+/*************************************************************************/
+
+QFuture<void> PitchGuideOptimizer::start(double lowerBound, double upperBound) {
+    double low = 1200.0*std::log2(lowerBound/440.0);
+    double high = 1200.0*std::log2(upperBound/440.0);
+    segments.clear();
+    int numSegments = int(std::ceil((high - low)/SegmentWidth));
+    for (int i = 0; i < numSegments; ++i) {
+        double start = low + i*SegmentWidth;
+        segments.append({start, qMin(start + SegmentWidth, high), start, -1, 0});
+    }
+    return QtConcurrent::map(segments, [this](Segment &segment) {
+        sweep(segment);
+    });
+}
+
+/*************************************************************************/
+
+PitchGuideOptimizer::Result PitchGuideOptimizer::getResult() const {
+    Result result{440.0, -1, 0};
+    double bestCents = 0.0;
+    for (const Segment &segment : segments) {
+        if (segment.bestNum > result.numNotes
+                || (segment.bestNum == result.numNotes && segment.bestError < result.error)) {
+            result.numNotes = segment.bestNum;
+            result.error = segment.bestError;
+            bestCents = segment.bestCents;
+        }
+    }
+    result.baseFreq = 440.0*std::pow(2.0, bestCents/1200.0);
+    return result;
+}
+
+/*************************************************************************/
+
+void PitchGuideOptimizer::evaluate(const Term &term, double cents, int *num, long *error) const {
+    *num = 0;
+    *error = 0;
+    // Nearest note like PitchGuideFactory, where A4 is n=49
+    double delta = term.cents - cents;
+    int n = qBound(0, int(std::round(delta/100.0)) + 49, 9*12 - 1);
+    double off = delta - 100.0*(n - 49);
+    int noteIndex = n - 4;
+    if (off >= 50 || noteIndex < 0 || noteIndex >= enabledNotes.size() || !enabledNotes[noteIndex]) {
+        return;
+    }
+    int percentOff = int(std::round(off));
+    if (std::abs(percentOff) <= threshold) {
+        *num = term.weight;
+        *error = long(term.weight)*percentOff*percentOff;
+    }
+}
+
+/*************************************************************************/
+
+void PitchGuideOptimizer::sweep(Segment &segment) const {
+    struct Breakpoint {
+        double phase;
+        int term;
+    };
+
+    // Every term has a breakpoint where its offset is at .5 cents. They
+    // repeat each cent, so their order within each cent is the same.
+    QVector<Breakpoint> breakpoints;
+    QVector<int> termNum(terms.size());
+    QVector<long> termError(terms.size());
+    int num = 0;
+    long error = 0;
+    for (int i = 0; i < terms.size(); ++i) {
+        double phase = terms[i].cents - 0.5 - segment.start;
+        phase -= std::floor(phase);
+        breakpoints.append({phase, i});
+        // Middle of the cent that started at or before the segment
+        evaluate(terms[i], segment.start + (phase > 0.0 ? phase - 0.5 : 0.5), &termNum[i], &termError[i]);
+        num += termNum[i];
+        error += termError[i];
+    }
+    std::sort(breakpoints.begin(), breakpoints.end(), [](const Breakpoint &a, const Breakpoint &b) {
+        return a.phase < b.phase;
+    });
+
+    // Score is constant from one breakpoint to the next
+    auto consider = [&segment](double start, double end, int curNum, long curError) {
+        if (end > start
+                && (curNum > segment.bestNum
+                    || (curNum == segment.bestNum && curError < segment.bestError))) {
+            segment.bestCents = (start + end)/2;
+            segment.bestNum = curNum;
+            segment.bestError = curError;
+        }
+    };
+    double intervalStart = segment.start;
+    bool isDone = breakpoints.isEmpty();
+    for (int cent = 0; !isDone; ++cent) {
+        for (const Breakpoint &breakpoint : breakpoints) {
+            double pos = segment.start + cent + breakpoint.phase;
+            if (pos >= segment.end) {
+                isDone = true;
+                break;
+            }
+            consider(intervalStart, pos, num, error);
+            int i = breakpoint.term;
+            num -= termNum[i];
+            error -= termError[i];
+            evaluate(terms[i], pos + 0.5, &termNum[i], &termError[i]);
+            num += termNum[i];
+            error += termError[i];
+            intervalStart = pos;
+        }
+    }
+    consider(intervalStart, segment.end, num, error);
+}
+
+}
@@ -0,0 +1,82 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PITCHGUIDEOPTIMIZER_H
+#define PITCHGUIDEOPTIMIZER_H
+
+#include <QList>
+#include <QVector>
+#include <QFuture>
+
+#include "tiasound.h"
+
+
+namespace TiaSound {
+
+/* Finds the base frequency for which a pitch guide hits the most
+ * requested notes within a threshold and, among those, has the
+ * smallest squared error, scored like PitchGuideFactory does.
+ *
+ * Works in cents relative to A4=440Hz. The rounded offset of a TIA
+ * frequency to its nearest note only changes at breakpoints exactly
+ * one cent apart, so the score is constant in between and sweeping
+ * all breakpoints finds the exact optimum. The range is split into
+ * one segment per semitone, and segments are swept in parallel.
+ */
+class PitchGuideOptimizer
+{
+public:
+    struct Result {
+        double baseFreq;
+        int numNotes;
+        long error;
+    };
+
+    /* enabledNotes holds one flag per note of a pitch guide */
+    PitchGuideOptimizer(TvStandard standard, const QList<Distortion> &distortions,
+                        const QVector<bool> &enabledNotes, int threshold);
+
+    /* Starts optimizing between the bounds in Hz on the global thread
+     * pool. The future reports one progress step per segment and can
+     * be canceled. The optimizer must outlive it. */
+    QFuture<void> start(double lowerBound, double upperBound);
+
+    /* Best result after the future has finished. The best score is
+     * reached on an interval of frequencies; the result is its middle.
+     * Ties between intervals go to the lowest one. */
+    Result getResult() const;
+
+private:
+    static const int SegmentWidth = 100;
+
+    // TIA frequency in cents, with the number of distortions sharing it
+    struct Term {
+        double cents;
+        int weight;
+    };
+
+    struct Segment {
+        double start;
+        double end;
+        double bestCents;
+        int bestNum;
+        long bestError;
+    };
+
+    void evaluate(const Term &term, double cents, int *num, long *error) const;
+    void sweep(Segment &segment) const;
+
+    QVector<Term> terms;
+    QVector<bool> enabledNotes;
+    int threshold;
+
+    QVector<Segment> segments;
+};
+
+}
+
+#endif // PITCHGUIDEOPTIMIZER_H
@@ -0,0 +1,217 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "tuningoptimizer.h"
+
+#include <QMap>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+#include "pitchguidefactory.h"
+
+
+namespace TiaSound {
+
+namespace {
+
+double toCents(double freq) {
+    return 1200.0*std::log2(freq/440.0);
+}
+
+// Offset in cents of a pitch to its nearest note
+double nearestOffset(double pitchCents, double baseCents) {
+    double delta = pitchCents - baseCents;
+    return delta - 100.0*std::round(delta/100.0);
+}
+
+}
+
+/*************************************************************************/
+
+TuningOptimizer::TuningOptimizer(TvStandard standard, const QVector<int> &pitchUsage)
+{
+    PitchGuideFactory pg;
+    // Several AUDC values share a distortion
+    QMap<int, int> termIndices;
+    for (int audc = 0; audc < 16; ++audc) {
+        Distortion dist = distortions[audc];
+        if (dist == Distortion::SILENT) {
+            continue;
+        }
+        QList<double> tiaFrequencies = pg.getTiaFrequencies(standard, dist);
+        for (int audf = 0; audf < 32; ++audf) {
+            int frames = pitchUsage.value(audc*32 + audf, 0);
+            if (frames == 0) {
+                continue;
+            }
+            int key = getDistortionInt(dist)*32 + audf;
+            if (termIndices.contains(key)) {
+                terms[termIndices[key]].frames += frames;
+            } else {
+                termIndices[key] = terms.size();
+                terms.append({dist, audf, toCents(tiaFrequencies[audf]), frames});
+            }
+        }
+    }
+    std::stable_sort(terms.begin(), terms.end(), [](const Term &a, const Term &b) {
+        return a.frames > b.frames;
+    });
+}
+
+/*************************************************************************/
+
+QList<Distortion> TuningOptimizer::getDistortions() const {
+    QMap<Distortion, int> frames;
+    for (const Term &term : terms) {
+        frames[term.distortion] += term.frames;
+    }
+    QList<Distortion> result = frames.keys();
+    std::stable_sort(result.begin(), result.end(), [&frames](Distortion a, Distortion b) {
+        return frames[a] > frames[b];
+    });
+    return result;
+}
+
+/*************************************************************************/
+
+TuningOptimizer::Result TuningOptimizer::optimize(Distortion distortion) const {
+    QVector<Term> used = getTerms(distortion);
+    Result result{distortion, 440.0, 0.0, 0};
+    if (used.isEmpty()) {
+        return result;
+    }
+
+    struct Breakpoint {
+        double pos;
+        int term;
+    };
+
+    // Within the semitone, every term is halfway between two notes
+    // once. Track the weighted sums of the term pitches minus their
+    // nearest notes, which give the error as a quadratic in the base
+    // frequency.
+    QVector<Breakpoint> breakpoints;
+    QVector<double> targets(used.size());
+    double weight = 0.0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for (int i = 0; i < used.size(); ++i) {
+        double pos = used[i].cents - 50.0;
+        pos -= 100.0*std::floor((pos + 50.0)/100.0);
+        breakpoints.append({pos, i});
+        // Nearest note in the middle of the piece before the breakpoint
+        targets[i] = used[i].cents - 100.0*std::round((used[i].cents - (pos - 50.0))/100.0);
+        weight += used[i].frames;
+        sum += used[i].frames*targets[i];
+        sumSquares += used[i].frames*targets[i]*targets[i];
+    }
+    std::sort(breakpoints.begin(), breakpoints.end(), [](const Breakpoint &a, const Breakpoint &b) {
+        return a.pos < b.pos;
+    });
+
+    double bestCents = 0.0;
+    double bestError = -1.0;
+    auto consider = [&](double start, double end) {
+        double cents = qBound(start, sum/weight, end);
+        double error = sumSquares - 2.0*cents*sum + cents*cents*weight;
+        if (bestError < 0.0 || error < bestError) {
+            bestCents = cents;
+            bestError = error;
+        }
+    };
+    double pieceStart = -50.0;
+    for (const Breakpoint &breakpoint : breakpoints) {
+        consider(pieceStart, breakpoint.pos);
+        // Past the breakpoint, the nearest note of the pitch is one
+        // semitone lower relative to the base frequency
+        int i = breakpoint.term;
+        double newTarget = targets[i] + 100.0;
+        sum += used[i].frames*(newTarget - targets[i]);
+        sumSquares += used[i].frames*(newTarget*newTarget - targets[i]*targets[i]);
+        targets[i] = newTarget;
+        pieceStart = breakpoint.pos;
+    }
+    consider(pieceStart, 50.0);
+
+    result.baseFreq = 440.0*std::pow(2.0, bestCents/1200.0);
+    // Exact error, without the rounding of the running sums
+    double error = 0.0;
+    for (const Term &term : used) {
+        double off = nearestOffset(term.cents, bestCents);
+        error += term.frames*off*off;
+    }
+    result.rmsCents = std::sqrt(error/weight);
+    result.frames = int(weight);
+    return result;
+}
+
+/*************************************************************************/
+
+QVector<TuningOptimizer::Result> TuningOptimizer::optimizeAll() const {
+    QVector<Result> results;
+    results.append({Distortion::SILENT, 440.0, 0.0, 0});
+    for (Distortion dist : getDistortions()) {
+        results.append({dist, 440.0, 0.0, 0});
+    }
+    QtConcurrent::blockingMap(results, [this](Result &result) {
+        result = optimize(result.distortion);
+    });
+    return results;
+}
+
+/*************************************************************************/
+
+TuningOptimizer::Result TuningOptimizer::evaluate(double baseFreq) const {
+    Result result{Distortion::SILENT, baseFreq, 0.0, 0};
+    double baseCents = toCents(baseFreq);
+    double error = 0.0;
+    for (const Term &term : terms) {
+        double off = nearestOffset(term.cents, baseCents);
+        error += term.frames*off*off;
+        result.frames += term.frames;
+    }
+    if (result.frames > 0) {
+        result.rmsCents = std::sqrt(error/result.frames);
+    }
+    return result;
+}
+
+/*************************************************************************/
+
+QList<TuningOptimizer::Retuning> TuningOptimizer::getRetuning(double baseFreq) const {
+    QList<Retuning> retuning;
+    double baseCents = toCents(baseFreq);
+    for (const Term &term : terms) {
+        double off = nearestOffset(term.cents, baseCents);
+        // A4 is note 45
+        int noteIndex = int(std::round((term.cents - baseCents - off)/100.0)) + 45;
+        Note note = Note::NotANote;
+        if (noteIndex >= 0 && noteIndex < getIntFromNote(Note::NotANote)) {
+            note = getNoteFromInt(noteIndex);
+        }
+        retuning.append({term.distortion, term.frequency, term.frames, note, off});
+    }
+    return retuning;
+}
+
+/*************************************************************************/
+
+QVector<TuningOptimizer::Term> TuningOptimizer::getTerms(Distortion distortion) const {
+    if (distortion == Distortion::SILENT) {
+        return terms;
+    }
+    QVector<Term> result;
+    for (const Term &term : terms) {
+        if (term.distortion == distortion) {
+            result.append(term);
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,88 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef TUNINGOPTIMIZER_H
+#define TUNINGOPTIMIZER_H
+
+#include <QList>
+#include <QVector>
+
+#include "tiasound.h"
+
+
+namespace TiaSound {
+
+/* Finds the base frequency that puts the pitches a song actually plays
+ * closest to equal temperament, weighted by how many frames each pitch
+ * is played. The error is the weighted mean of squared cents to the
+ * nearest note.
+ *
+ * Moving the base frequency by a semitone only renames the notes, so
+ * the search covers one semitone around A4=440Hz. In cents, the
+ * nearest note of a pitch changes once within it. In between these
+ * breakpoints the error is a quadratic whose minimum is the weighted
+ * mean offset, so sweeping them finds the exact optimum.
+ */
+class TuningOptimizer
+{
+public:
+    struct Result {
+        // All distortions, or the only one that got optimized for
+        Distortion distortion;
+        double baseFreq;
+        // Frame-weighted root mean square error in cents
+        double rmsCents;
+        int frames;
+    };
+
+    struct Retuning {
+        Distortion distortion;
+        int frequency;
+        int frames;
+        Note note;
+        double centsOff;
+    };
+
+    /* pitchUsage holds the frames per AUDC/AUDF pair, indexed by
+     * audc*32 + audf */
+    TuningOptimizer(TvStandard standard, const QVector<int> &pitchUsage);
+
+    /* Distortions the song plays, most played first */
+    QList<Distortion> getDistortions() const;
+
+    /* Best base frequency for all distortions together
+     * (Distortion::SILENT) or for a single one */
+    Result optimize(Distortion distortion = Distortion::SILENT) const;
+
+    /* Best base frequency for all distortions first, followed by the
+     * ones for every single distortion. Searched in parallel. */
+    QVector<Result> optimizeAll() const;
+
+    /* Error of a given base frequency for all distortions */
+    Result evaluate(double baseFreq) const;
+
+    /* Nearest notes of all played pitches for a base frequency, most
+     * played first */
+    QList<Retuning> getRetuning(double baseFreq) const;
+
+private:
+    struct Term {
+        Distortion distortion;
+        int frequency;
+        // Relative to A4=440Hz
+        double cents;
+        int frames;
+    };
+
+    QVector<Term> getTerms(Distortion distortion) const;
+
+    QVector<Term> terms;
+};
+
+}
+
+#endif // TUNINGOPTIMIZER_H
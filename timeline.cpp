@@ -16,6 +16,7 @@
 #include <QMouseEvent>
 #include <QHelpEvent>
 #include <QToolTip>
+#include "emulation/eventtrace.h"
 
 
 Timeline::Timeline(QWidget *parent) : QWidget(parent)
@@ -52,9 +53,15 @@ void Timeline::editPosChanged(int newPos) {
 /*************************************************************************/
 
 void Timeline::playerPosChanged(int pos1, int pos2) {
-    playerPos[0] = pos1;
-    playerPos[1] = pos2;
-    update();
+    // Only the old and new cursor lines need to be repainted
+    double rowHeight = calcRowHeight();
+    int newPos[2]{pos1, pos2};
+    for (int channel = 0; channel < 2; ++channel) {
+        int xPos = channel*(width()/2);
+        update(xPos, int(channelMargin + playerPos[channel]*rowHeight + rowHeight/2), width()/2, 2);
+        playerPos[channel] = newPos[channel];
+        update(xPos, int(channelMargin + playerPos[channel]*rowHeight + rowHeight/2), width()/2, 2);
+    }
 }
 
 /*************************************************************************/
@@ -77,9 +84,28 @@ double Timeline::calcRowHeight()
 
 /*************************************************************************/
 
-void Timeline::paintEvent(QPaintEvent *) {
-    QPainter painter(this);
+void Timeline::updateBackground() {
+    // Everything the pattern blocks depend on
+    QVector<int> layout;
+    layout.append(width());
+    layout.append(height());
+    layout.append(devicePixelRatio());
+    for (int channel = 0; channel < 2; ++channel) {
+        const Track::Sequence &sequence = pTrack->channelSequences[channel];
+        layout.append(sequence.sequence.size());
+        for (const Track::SequenceEntry &entry : sequence.sequence) {
+            layout.append(pTrack->patterns[entry.patternIndex].notes.size());
+        }
+    }
+    if (!background.isNull() && layout == backgroundLayout) {
+        return;
+    }
+    backgroundLayout = layout;
 
+    int ratio = devicePixelRatio();
+    background = QPixmap(width()*ratio, height()*ratio);
+    background.setDevicePixelRatio(ratio);
+    QPainter painter(&background);
     double rowHeight = calcRowHeight();
 
     // Paint patterns
@@ -87,20 +113,44 @@ void Timeline::paintEvent(QPaintEvent *) {
     int xPos = channelMargin;
     for (int channel = 0; channel < 2; ++channel) {
         Track::Sequence *sequence = &(pTrack->channelSequences[channel]);
-        for (int iEntry = 0; iEntry < sequence->sequence.size(); ++iEntry) {
-            int patternTop = channelMargin + int(rowHeight*sequence->sequence[iEntry].firstNoteNumber + 0.5);
-            int iPattern = sequence->sequence[iEntry].patternIndex;
-            int patternHeight = int(rowHeight*pTrack->patterns[iPattern].notes.size() + 0.5);
+        int iBlock = 0;
+        int iEntry = 0;
+        while (iEntry < sequence->sequence.size()) {
+            int firstNote = sequence->sequence[iEntry].firstNoteNumber;
+            int patternTop = channelMargin + int(rowHeight*firstNote + 0.5);
+            int numNotes = 0;
+            int patternHeight = 0;
+            // Merge entries until the block is high enough to be seen
+            do {
+                int iPattern = sequence->sequence[iEntry].patternIndex;
+                numNotes += pTrack->patterns[iPattern].notes.size();
+                patternHeight = int(rowHeight*numNotes + 0.5);
+                iEntry++;
+            } while (patternHeight < minBlockHeight && iEntry < sequence->sequence.size());
             QColor col;
-            if (iEntry%2 == 0) {
+            if (iBlock%2 == 0) {
                 col = MainWindow::contentDark;
             } else {
                 col = MainWindow::contentLight;
             }
             painter.fillRect(xPos, patternTop, channelWidth, patternHeight + 1, col);
+            iBlock++;
         }
         xPos += channelWidth + channelGap;
     }
+}
+
+/*************************************************************************/
+
+void Timeline::paintEvent(QPaintEvent *) {
+    Emulation::EventTrace::Scope trace("gui", "Timeline::paintEvent");
+    QPainter painter(this);
+
+    double rowHeight = calcRowHeight();
+
+    // Patterns come pre-rendered, only the cursors are drawn each time
+    updateBackground();
+    painter.drawPixmap(0, 0, background);
 
     // Draw edit position
     painter.fillRect(0, channelMargin + editPos*rowHeight + rowHeight/2, width(), 2, MainWindow::blue);
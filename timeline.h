@@ -12,6 +12,8 @@
 #include <QWidget>
 #include "track/track.h"
 #include <QMenu>
+#include <QPixmap>
+#include <QVector>
 
 
 class Timeline : public QWidget
@@ -47,10 +49,15 @@ private:
     static const int channelMargin = 8;
     static const int channelGap = 8;
     static const int minHeight = 400;
+    // Smaller sequence entries get merged, so long songs stay readable
+    static const int minBlockHeight = 3;
 
     /* Calc row height in pixels */
     double calcRowHeight();
 
+    /* Re-renders the pattern blocks if sequences or size have changed */
+    void updateBackground();
+
     int widgetWidth;
     int editPos = 0;
     int playerPos[2]{0};
@@ -58,6 +65,10 @@ private:
     Track::Track *pTrack = nullptr;
     QMenu *pPatternMenu = nullptr;
 
+    // Pattern blocks, and the pattern lengths they have been rendered for
+    QPixmap background;
+    QVector<int> backgroundLayout;
+
 };
 
 #endif // TIMELINE_H
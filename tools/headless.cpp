@@ -0,0 +1,37 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+/* The few GUI statics the track model and the pitch guides use, for the
+ * command line tools that link them without the GUI.
+ */
+
+#include <QTextStream>
+
+#include "mainwindow.h"
+#include "percussiontab.h"
+
+
+void MainWindow::displayMessage(const QString &message) {
+    QTextStream(stderr) << "ERROR: " << message << "\n";
+}
+
+/*************************************************************************/
+
+// Same as in percussiontab.cpp
+const QList<TiaSound::Distortion> PercussionTab::availableWaveforms{
+    TiaSound::Distortion::SILENT,
+    TiaSound::Distortion::BUZZY,
+    TiaSound::Distortion::BUZZY_RUMBLE,
+    TiaSound::Distortion::FLANGY_WAVERING,
+    TiaSound::Distortion::PURE_HIGH,
+    TiaSound::Distortion::PURE_BUZZY,
+    TiaSound::Distortion::REEDY_RUMBLE,
+    TiaSound::Distortion::WHITE_NOISE,
+    TiaSound::Distortion::PURE_LOW,
+    TiaSound::Distortion::ELECTRONIC_RUMBLE,
+    TiaSound::Distortion::ELECTRONIC_SQUEAL
+};
@@ -0,0 +1,125 @@
+#-------------------------------------------------
+#
+# Sound emulation and track model of TIATracker without the GUI, for
+# the command line tools. Include it from a tool's .pro file.
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+# The track model includes mainwindow.h for its static helpers
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+CONFIG(release, debug|release) {
+    CONFIG += optimize_full
+}
+
+INCLUDEPATH += $$PWD/..
+
+# Replaces MainWindow::displayMessage()
+SOURCES += $$PWD/headless.cpp
+
+SOURCES += \
+    $$PWD/../emulation/SoundSDL2.cpp \
+    $$PWD/../emulation/TIASnd.cpp \
+    $$PWD/../emulation/assembler6502.cpp \
+    $$PWD/../emulation/audiosink.cpp \
+    $$PWD/../emulation/benchmarkrunner.cpp \
+    $$PWD/../emulation/benchmarksuite.cpp \
+    $$PWD/../emulation/cpu6502.cpp \
+    $$PWD/../emulation/dasmexporter.cpp \
+    $$PWD/../emulation/envelopecache.cpp \
+    $$PWD/../emulation/eventtrace.cpp \
+    $$PWD/../emulation/frameclock.cpp \
+    $$PWD/../emulation/inputlatencytracer.cpp \
+    $$PWD/../emulation/instrumentfitter.cpp \
+    $$PWD/../emulation/monotonicclock.cpp \
+    $$PWD/../emulation/pcmring.cpp \
+    $$PWD/../emulation/percussionfitter.cpp \
+    $$PWD/../emulation/pitchmeasurement.cpp \
+    $$PWD/../emulation/player.cpp \
+    $$PWD/../emulation/playerharness.cpp \
+    $$PWD/../emulation/playervalidator.cpp \
+    $$PWD/../emulation/playervariantfinder.cpp \
+    $$PWD/../emulation/registerlog.cpp \
+    $$PWD/../emulation/rendercorpus.cpp \
+    $$PWD/../emulation/ringsink.cpp \
+    $$PWD/../emulation/sdlaudiosink.cpp \
+    $$PWD/../emulation/spectrum.cpp \
+    $$PWD/../emulation/stemfilesink.cpp \
+    $$PWD/../emulation/trackkeyframes.cpp \
+    $$PWD/../emulation/voicedictionary.cpp \
+    $$PWD/../emulation/wavfilesink.cpp \
+    $$PWD/../emulation/wavfilesource.cpp \
+    $$PWD/../emulation/wavfilewriter.cpp \
+    $$PWD/../tiasound/instrumentpitchguide.cpp \
+    $$PWD/../tiasound/pitchguide.cpp \
+    $$PWD/../tiasound/pitchguidefactory.cpp \
+    $$PWD/../tiasound/pitchguideoptimizer.cpp \
+    $$PWD/../tiasound/tiasound.cpp \
+    $$PWD/../tiasound/tuningoptimizer.cpp \
+    $$PWD/../track/instrument.cpp \
+    $$PWD/../track/note.cpp \
+    $$PWD/../track/pattern.cpp \
+    $$PWD/../track/percussion.cpp \
+    $$PWD/../track/playorder.cpp \
+    $$PWD/../track/sequence.cpp \
+    $$PWD/../track/sequenceentry.cpp \
+    $$PWD/../track/track.cpp
+
+HEADERS += \
+    $$PWD/../emulation/SoundSDL2.h \
+    $$PWD/../emulation/TIASnd.h \
+    $$PWD/../emulation/assembler6502.h \
+    $$PWD/../emulation/audiosink.h \
+    $$PWD/../emulation/benchmarkrunner.h \
+    $$PWD/../emulation/benchmarksuite.h \
+    $$PWD/../emulation/bspf.h \
+    $$PWD/../emulation/cpu6502.h \
+    $$PWD/../emulation/dasmexporter.h \
+    $$PWD/../emulation/envelopecache.h \
+    $$PWD/../emulation/eventtrace.h \
+    $$PWD/../emulation/frameclock.h \
+    $$PWD/../emulation/inputlatencytracer.h \
+    $$PWD/../emulation/instrumentfitter.h \
+    $$PWD/../emulation/monotonicclock.h \
+    $$PWD/../emulation/pcmring.h \
+    $$PWD/../emulation/percussionfitter.h \
+    $$PWD/../emulation/pitchmeasurement.h \
+    $$PWD/../emulation/player.h \
+    $$PWD/../emulation/playerharness.h \
+    $$PWD/../emulation/playervalidator.h \
+    $$PWD/../emulation/playervariantfinder.h \
+    $$PWD/../emulation/registerlog.h \
+    $$PWD/../emulation/rendercorpus.h \
+    $$PWD/../emulation/ringsink.h \
+    $$PWD/../emulation/sdlaudiosink.h \
+    $$PWD/../emulation/spectrum.h \
+    $$PWD/../emulation/stemfilesink.h \
+    $$PWD/../emulation/trackkeyframes.h \
+    $$PWD/../emulation/voicedictionary.h \
+    $$PWD/../emulation/wavfilesink.h \
+    $$PWD/../emulation/wavfilesource.h \
+    $$PWD/../emulation/wavfilewriter.h \
+    $$PWD/../tiasound/instrumentpitchguide.h \
+    $$PWD/../tiasound/pitchguide.h \
+    $$PWD/../tiasound/pitchguidefactory.h \
+    $$PWD/../tiasound/pitchguideoptimizer.h \
+    $$PWD/../tiasound/tiasound.h \
+    $$PWD/../tiasound/tuningoptimizer.h \
+    $$PWD/../track/instrument.h \
+    $$PWD/../track/note.h \
+    $$PWD/../track/pattern.h \
+    $$PWD/../track/percussion.h \
+    $$PWD/../track/playorder.h \
+    $$PWD/../track/sequence.h \
+    $$PWD/../track/sequenceentry.h \
+    $$PWD/../track/track.h
+
+win32: LIBS += -L$$PWD/../sdl/windows/lib/ -lSDL2
+linux: LIBS += -lSDL2
+
+INCLUDEPATH += $$PWD/../sdl/windows/include
+DEPENDPATH += $$PWD/../sdl/windows/include
@@ -0,0 +1,95 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+/* Runs the benchmark suite without the GUI, e.g. on a build server.
+ * The results are written as JSON to stdout or a file, and compared
+ * with the results of an earlier run if one is given.
+ *
+ * Exit code: 0 if nothing got slower, 1 if a benchmark regressed by
+ * more than BenchmarkRunner::RegressionThreshold, 2 on errors.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+#include "emulation/benchmarkrunner.h"
+#include "emulation/benchmarksuite.h"
+
+
+namespace {
+
+const int ExitRegressions = 1;
+const int ExitError = 2;
+
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ttbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the TIATracker benchmarks and compares them with an earlier run.");
+    parser.addHelpOption();
+    QCommandLineOption songsOption("songs", "Folder with the .ttt files to benchmark.",
+                                   "folder", QString(TT_SOURCE_DIR) + "/songs");
+    QCommandLineOption baselineOption("baseline", "Results of an earlier run to compare with.", "file");
+    QCommandLineOption outputOption("output", "Write the results to file instead of stdout.", "file");
+    parser.addOption(songsOption);
+    parser.addOption(baselineOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+    Emulation::BenchmarkRunner baseline;
+    if (parser.isSet(baselineOption) && !baseline.load(parser.value(baselineOption))) {
+        err << "Unable to read baseline " << parser.value(baselineOption) << "\n";
+        return ExitError;
+    }
+
+    Emulation::BenchmarkRunner runner;
+    Emulation::BenchmarkSuite suite(&runner);
+    suite.runTiaSound();
+    suite.runSoundDevice();
+    QDir dir(parser.value(songsOption));
+    QStringList fileNames = dir.entryList(QStringList("*.ttt"), QDir::Files);
+    for (const QString &fileName : fileNames) {
+        QFile loadFile(dir.filePath(fileName));
+        if (loadFile.open(QIODevice::ReadOnly)) {
+            suite.runSong(fileName, loadFile.readAll());
+        }
+    }
+
+    if (parser.isSet(outputOption)) {
+        if (!runner.save(parser.value(outputOption))) {
+            err << "Unable to write " << parser.value(outputOption) << "\n";
+            return ExitError;
+        }
+    } else {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(runner.toJson());
+    }
+
+    err << runner.getResults().size() << " benchmarks on " << fileNames.size() << " songs\n";
+    QStringList skipped = runner.getSkipped();
+    for (const QString &reason : skipped) {
+        err << "Skipped: " << reason << "\n";
+    }
+    if (!parser.isSet(baselineOption)) {
+        return 0;
+    }
+    QList<Emulation::BenchmarkRunner::Change> regressions = runner.findRegressions(baseline);
+    for (const Emulation::BenchmarkRunner::Change &change : regressions) {
+        err << "Slower: " << change.name << " +" << qRound((change.ratio - 1.0)*100.0) << "%\n";
+    }
+    return regressions.isEmpty() ? 0 : ExitRegressions;
+}
@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Command line benchmark runner, see main.cpp
+#
+#-------------------------------------------------
+
+TARGET = ttbench
+TEMPLATE = app
+
+include(../tiacore.pri)
+
+# Default song folder
+DEFINES += TT_SOURCE_DIR=\\\"$$PWD/../..\\\"
+
+SOURCES += main.cpp
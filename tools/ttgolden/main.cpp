@@ -0,0 +1,85 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+/* Renders the songs in songs/ and the synthetic register scripts and
+ * compares every frame with the golden corpus in data/, without the GUI.
+ * With --update, the renders become the new golden corpus instead, for
+ * changes of the output that are intended.
+ *
+ * Exit code: 0 if everything is identical, 1 if a case diverges, 2 on
+ * errors, e.g. if there is no golden corpus yet.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "emulation/rendercorpus.h"
+
+
+namespace {
+
+const int ExitDivergences = 1;
+const int ExitError = 2;
+
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ttgolden");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the sound output of TIATracker with the golden renders.");
+    parser.addHelpOption();
+    QCommandLineOption songsOption("songs", "Folder with the .ttt files to render.",
+                                   "folder", QString(TT_SOURCE_DIR) + "/songs");
+    QCommandLineOption goldenOption("golden", "Golden corpus to compare with.", "file",
+                                    QString(TT_SOURCE_DIR) + "/data/" + Emulation::RenderCorpus::goldenFileName);
+    QCommandLineOption updateOption("update", "Replace the golden corpus with the current renders.");
+    parser.addOption(songsOption);
+    parser.addOption(goldenOption);
+    parser.addOption(updateOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QString goldenPath = parser.value(goldenOption);
+    Emulation::RenderCorpus golden;
+    bool hasGolden = golden.load(goldenPath);
+    if (!hasGolden && !parser.isSet(updateOption)) {
+        out << "Unable to read " << goldenPath << ". Create it with --update.\n";
+        return ExitError;
+    }
+
+    Emulation::RenderCorpus corpus;
+    int numSongs = corpus.addSongFolder(parser.value(songsOption));
+    corpus.addSyntheticCases();
+    corpus.render();
+    out << "Rendered " << numSongs << " songs, " << corpus.getNumCases() << " cases, "
+        << corpus.getNumFrames() << " frames\n";
+
+    if (parser.isSet(updateOption)) {
+        if (!corpus.save(goldenPath)) {
+            out << "Unable to write " << goldenPath << "\n";
+            return ExitError;
+        }
+        out << "Wrote " << goldenPath << "\n";
+        return 0;
+    }
+
+    QList<Emulation::RenderCorpus::Divergence> divergences = corpus.compare(golden);
+    for (const Emulation::RenderCorpus::Divergence &divergence : divergences) {
+        out << Emulation::RenderCorpus::divergenceToString(divergence) << "\n";
+    }
+    if (!divergences.isEmpty()) {
+        out << divergences.size() << " cases differ from the golden renders\n";
+        return ExitDivergences;
+    }
+    out << "All cases are identical to the golden renders\n";
+    return 0;
+}
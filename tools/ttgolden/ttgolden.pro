@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Command line check against the golden renders, see main.cpp
+#
+#-------------------------------------------------
+
+TARGET = ttgolden
+TEMPLATE = app
+
+include(../tiacore.pri)
+
+# Default song folder and golden corpus
+DEFINES += TT_SOURCE_DIR=\\\"$$PWD/../..\\\"
+
+SOURCES += main.cpp
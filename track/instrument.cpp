@@ -19,6 +19,10 @@
 
 namespace Track {
 
+QAtomicInt Instrument::lastRevision{0};
+
+/*************************************************************************/
+
 /* TODO: More sensible empty detection, like a bool flag that gets
  * changed whenever the instrument data gets updated by the GUI...
  */
@@ -124,6 +128,7 @@ bool Instrument::import(const QJsonObject &json) {
     envelopeLength = newEnvelopeLength;
     sustainStart = newSustainStart;
     releaseStart = newReleaseStart;
+    markChanged();
 
     return true;
 }
@@ -142,6 +147,7 @@ void Instrument::setEnvelopeLength(int newSize) {
     }
     envelopeLength = newSize;
     validateSustainReleaseValues();
+    markChanged();
 }
 
 /*************************************************************************/
@@ -184,6 +190,7 @@ void Instrument::setSustainAndRelease(int newSustainStart, int newReleaseStart)
     }
     sustainStart = newSustainStart;
     releaseStart = newReleaseStart;
+    markChanged();
 }
 
 /*************************************************************************/
@@ -203,6 +210,7 @@ void Instrument::deleteInstrument()
     sustainStart = 0;
     releaseStart = 1;
     baseDistortion = TiaSound::Distortion::PURE_COMBINED;
+    markChanged();
 }
 
 /*************************************************************************/
@@ -260,6 +268,7 @@ void Instrument::insertFrameBefore(int frame) {
 
     volumes.insert(frame, newVol);
     frequencies.insert(frame, freqNew);
+    markChanged();
 }
 
 /*************************************************************************/
@@ -287,6 +296,7 @@ void Instrument::insertFrameAfter(int frame) {
 
     volumes.insert(frame + 1, newVol);
     frequencies.insert(frame + 1, newFreq);
+    markChanged();
 }
 
 /*************************************************************************/
@@ -328,6 +338,7 @@ void Instrument::deleteFrame(int frame) {
     // Delete frames
     volumes.removeAt(frame);
     frequencies.removeAt(frame);
+    markChanged();
 }
 
 /*************************************************************************/
@@ -356,4 +367,16 @@ int Instrument::getEnvelopeLength() {
     return envelopeLength;
 }
 
+/*************************************************************************/
+
+void Instrument::markChanged() {
+    revision = lastRevision.fetchAndAddOrdered(1) + 1;
+}
+
+/*************************************************************************/
+
+int Instrument::getRevision() const {
+    return revision;
+}
+
 }
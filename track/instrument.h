@@ -11,6 +11,7 @@
 #include <QString>
 #include <QList>
 #include <QMutex>
+#include <QAtomicInt>
 #include "tiasound/tiasound.h"
 #include <QJsonObject>
 
@@ -25,7 +26,7 @@ class Instrument
 public:
     static const int maxEnvelopeLength = 99;
 
-    Instrument(QString name) : name(name) {}
+    Instrument(QString name) : name(name) { markChanged(); }
 
     int getEnvelopeLength();
     void setEnvelopeLength(int newSize);
@@ -63,6 +64,12 @@ public:
     /* Calc ROM usage without superfluous trailing 0 bytes */
     int calcEffectiveSize();
 
+    /* Has to be called whenever the envelopes or the waveform are
+     * changed from outside, so cached envelopes get rebuilt. */
+    void markChanged();
+    /* Unique over all instruments, changes with every modification */
+    int getRevision() const;
+
     QString name;
     TiaSound::Distortion baseDistortion{TiaSound::Distortion::PURE_COMBINED};
     QList<int> volumes{0, 0};
@@ -75,6 +82,9 @@ private:
     int envelopeLength = 2;
     int sustainStart = 0;
     int releaseStart = 1;
+
+    int revision;
+    static QAtomicInt lastRevision;
 };
 
 }
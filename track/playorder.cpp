@@ -0,0 +1,131 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#include "playorder.h"
+
+#include <QHash>
+
+#include "track.h"
+
+
+namespace Track {
+
+void PlayOrder::update(Track *track) {
+    quint32 newChecksum = track->calcChecksum(false);
+    if (isValid && newChecksum == checksum) {
+        return;
+    }
+    checksum = newChecksum;
+    isValid = true;
+    build(track);
+}
+
+/*************************************************************************/
+
+const QVector<PlayOrder::Step> &PlayOrder::getSteps() const {
+    return steps;
+}
+
+/*************************************************************************/
+
+int PlayOrder::getLoopStep() const {
+    return loopStep;
+}
+
+/*************************************************************************/
+
+int PlayOrder::getFirstStep(int channel, int row) const {
+    if (row < 0 || row >= firstSteps[channel].size()) {
+        return -1;
+    }
+    return firstSteps[channel][row];
+}
+
+/*************************************************************************/
+
+int PlayOrder::getNumFrames() const {
+    if (steps.isEmpty()) {
+        return 0;
+    }
+    return steps.last().startFrame + steps.last().numFrames;
+}
+
+/*************************************************************************/
+
+void PlayOrder::build(Track *track) {
+    steps.clear();
+    loopStep = -1;
+    for (int channel = 0; channel < 2; ++channel) {
+        firstSteps[channel].fill(-1, track->getChannelNumRows(channel));
+    }
+
+    Step step;
+    step.startFrame = 0;
+    for (int channel = 0; channel < 2; ++channel) {
+        step.entryIndex[channel] = track->startPatterns[channel];
+        step.noteIndex[channel] = 0;
+    }
+    // Step index of each position of both channels seen so far
+    QHash<quint64, int> visited;
+    // Step index of each position of a single channel, until it loops
+    QHash<quint32, int> channelVisited[2];
+    bool hasLooped[2]{false, false};
+    while (true) {
+        quint64 position = 0;
+        quint32 channelPositions[2];
+        for (int channel = 0; channel < 2; ++channel) {
+            const SequenceEntry &entry = track->channelSequences[channel].sequence[step.entryIndex[channel]];
+            step.row[channel] = entry.firstNoteNumber + step.noteIndex[channel];
+            channelPositions[channel] = (quint32(step.entryIndex[channel])<<16)|quint32(step.noteIndex[channel]);
+            position = (position<<32)|quint64(channelPositions[channel]);
+        }
+        if (visited.contains(position)) {
+            loopStep = visited[position];
+            break;
+        }
+        for (int channel = 0; channel < 2; ++channel) {
+            if (channelVisited[channel].contains(channelPositions[channel])) {
+                hasLooped[channel] = true;
+            } else if (!hasLooped[channel]) {
+                channelVisited[channel][channelPositions[channel]] = steps.size();
+            }
+        }
+        if (hasLooped[0] && hasLooped[1]) {
+            // Both channels loop, but with different lengths. Every row
+            // has been reached by now, while the combined loop could be
+            // as long as the product of both. Continue where channel 0
+            // loops back to.
+            loopStep = channelVisited[0][channelPositions[0]];
+            break;
+        }
+        visited[position] = steps.size();
+
+        // Speed as in Player::updateTrack()
+        int evenSpeed = track->evenSpeed;
+        int oddSpeed = track->oddSpeed;
+        if (!track->globalSpeed) {
+            const Pattern &pattern = track->patterns[track->channelSequences[0].sequence[step.entryIndex[0]].patternIndex];
+            evenSpeed = pattern.evenSpeed;
+            oddSpeed = pattern.oddSpeed;
+        }
+        step.numFrames = step.noteIndex[0]%2 == 0 ? oddSpeed : evenSpeed;
+        for (int channel = 0; channel < 2; ++channel) {
+            if (firstSteps[channel][step.row[channel]] == -1) {
+                firstSteps[channel][step.row[channel]] = steps.size();
+            }
+        }
+        steps.append(step);
+
+        step.startFrame += step.numFrames;
+        if (!track->getNextNoteWithGoto(0, &step.entryIndex[0], &step.noteIndex[0])
+                || !track->getNextNoteWithGoto(1, &step.entryIndex[1], &step.noteIndex[1])) {
+            break;
+        }
+    }
+}
+
+}
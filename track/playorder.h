@@ -0,0 +1,76 @@
+/* TIATracker, (c) 2016 Andre "Kylearan" Wichmann.
+ * Website: https://bitbucket.org/kylearan/tiatracker
+ * Email: andre.wichmann@gmx.de
+ * See the file "license.txt" for information on usage and redistribution
+ * of this file.
+ */
+
+#ifndef PLAYORDER_H
+#define PLAYORDER_H
+
+#include <QVector>
+
+
+namespace Track {
+
+class Track;
+
+/* The order in which the rows of both channels get played when the
+ * song is played from the start patterns, with gotos resolved. Each
+ * step is one sequencer tick. The speed of a step is taken from
+ * channel 0 like the player does, so local tempo is respected.
+ *
+ * The order ends when the song ends or when both channels together
+ * repeat a position. If the channels loop with different lengths, it
+ * ends as soon as both have looped on their own, so its length stays
+ * within the rows of the longer channel, and the loop continues where
+ * channel 0 loops back to.
+ *
+ * Use Track::getPlayOrder(), which rebuilds it whenever sequences,
+ * pattern lengths or speeds have changed.
+ */
+class PlayOrder
+{
+public:
+    struct Step {
+        // Frame in which the step starts
+        int startFrame;
+        // Frames until the next step
+        int numFrames;
+        int entryIndex[2];
+        int noteIndex[2];
+        int row[2];
+    };
+
+    /* Rebuilds the play order if necessary */
+    void update(Track *track);
+
+    const QVector<Step> &getSteps() const;
+
+    /* Step the song continues with after the last one, or -1 if the
+     * song ends there. See the class comment for channels that loop
+     * with different lengths. */
+    int getLoopStep() const;
+
+    /* First step in which a row of a channel gets played, or -1 */
+    int getFirstStep(int channel, int row) const;
+
+    /* Frames until the end of the song or the loop back */
+    int getNumFrames() const;
+
+private:
+    void build(Track *track);
+
+    bool isValid = false;
+    // Track::calcChecksum() without contents
+    quint32 checksum = 0;
+
+    QVector<Step> steps;
+    int loopStep = -1;
+    // Step per row, or -1
+    QVector<int> firstSteps[2];
+};
+
+}
+
+#endif // PLAYORDER_H
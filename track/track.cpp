@@ -11,10 +11,22 @@
 #include <iostream>
 #include "mainwindow.h"
 #include <QJsonArray>
+#include "emulation/eventtrace.h"
 
 
 namespace Track {
 
+namespace {
+
+// FNV-1a, one int at a time
+void combine(quint32 &hash, int value) {
+    hash = (hash^quint32(value))*16777619u;
+}
+
+}
+
+/*************************************************************************/
+
 Track::Track() {
 }
 
@@ -253,6 +265,60 @@ int Track::getNextNoteWithGoto(int channel, int row) {
 
 /*************************************************************************/
 
+const PlayOrder &Track::getPlayOrder() {
+    playOrder.update(this);
+    return playOrder;
+}
+
+/*************************************************************************/
+
+quint32 Track::calcChecksum(bool withContents) const {
+    quint32 hash = 2166136261u;
+    combine(hash, startPatterns[0]);
+    combine(hash, startPatterns[1]);
+    combine(hash, globalSpeed ? 1 : 0);
+    combine(hash, evenSpeed);
+    combine(hash, oddSpeed);
+    for (const Sequence &sequence : channelSequences) {
+        combine(hash, sequence.sequence.size());
+        for (const SequenceEntry &entry : sequence.sequence) {
+            combine(hash, entry.patternIndex);
+            combine(hash, entry.gotoTarget);
+        }
+    }
+    for (const Pattern &pattern : patterns) {
+        combine(hash, pattern.notes.size());
+        combine(hash, pattern.evenSpeed);
+        combine(hash, pattern.oddSpeed);
+        if (withContents) {
+            for (const Note &note : pattern.notes) {
+                combine(hash, int(note.type));
+                combine(hash, note.instrumentNumber);
+                combine(hash, note.value);
+            }
+        }
+    }
+    if (!withContents) {
+        return hash;
+    }
+    // Instruments count their own edits
+    for (const Instrument &instrument : instruments) {
+        combine(hash, instrument.getRevision());
+    }
+    for (const Percussion &perc : percussion) {
+        combine(hash, perc.overlay ? 1 : 0);
+        combine(hash, perc.volumes.size());
+        for (int frame = 0; frame < perc.volumes.size(); ++frame) {
+            combine(hash, int(perc.waveforms[frame]));
+            combine(hash, perc.frequencies[frame]);
+            combine(hash, perc.volumes[frame]);
+        }
+    }
+    return hash;
+}
+
+/*************************************************************************/
+
 bool Track::checkSlideValidity(int channel, int row) {
     // Skip slides and holds immediately before
     int prevRow = row;
@@ -489,6 +555,7 @@ int Track::sequencesSize() {
 /*************************************************************************/
 
 void Track::toJson(QJsonObject &json) {
+    Emulation::EventTrace::Scope trace("io", "Track::toJson");
     // General data
     json["version"] = MainWindow::version;
     if (tvMode == TiaSound::TvStandard::PAL) {
@@ -552,6 +619,7 @@ void Track::toJson(QJsonObject &json) {
 /*************************************************************************/
 
 bool Track::fromJson(const QJsonObject &json) {
+    Emulation::EventTrace::Scope trace("io", "Track::fromJson");
     int version = json["version"].toInt();
     if (version > MainWindow::version) {
         MainWindow::displayMessage("This song is from a later version of TIATracker!");
@@ -16,6 +16,7 @@
 #include "tiasound/tiasound.h"
 #include "pattern.h"
 #include "sequence.h"
+#include "playorder.h"
 #include <QJsonObject>
 #include "tiasound/pitchguide.h"
 
@@ -76,6 +77,16 @@ public:
     /* Returns -1 if there is no next note */
     int getNextNoteWithGoto(int channel, int row);
 
+    /* Order in which the rows get played from the start patterns.
+     * Gets rebuilt only if the sequences or speeds have changed. */
+    const PlayOrder &getPlayOrder();
+
+    /* Checksum of the sequences, speeds and pattern lengths, which is
+     * what the play order depends on. With withContents set, notes,
+     * instruments and percussion are included as well, i.e. everything
+     * that influences track play. */
+    quint32 calcChecksum(bool withContents) const;
+
     bool checkSlideValidity(int channel, int row);
 
     int skipInstrumentType(int channel, int row, Note::instrumentType type, int direction);
@@ -131,6 +142,8 @@ public:
 private:
     QMutex mutex;
 
+    PlayOrder playOrder;
+
     TiaSound::TvStandard tvMode = TiaSound::TvStandard::PAL;
 };
 
@@ -25,6 +25,8 @@
 #include "insertpatterndialog.h"
 #include "createpatterndialog.h"
 #include <qcheckbox.h>
+#include <QGuiApplication>
+#include <QScreen>
 
 
 TrackTab::TrackTab(QWidget *parent) : QWidget(parent)
@@ -98,6 +100,15 @@ void TrackTab::registerPitchGuide(TiaSound::PitchGuide *newGuide) {
 
 void TrackTab::registerPlayer(Emulation::Player *newPlayer) {
     pPlayer = newPlayer;
+
+    double refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    if (refreshRate <= 0.0) {
+        refreshRate = 60.0;
+    }
+    playerPosTimer.setTimerType(Qt::PreciseTimer);
+    playerPosTimer.setInterval(std::max(1, int(1000.0/refreshRate)));
+    QObject::connect(&playerPosTimer, SIGNAL(timeout()), this, SLOT(pollPlayerPos()));
+    playerPosTimer.start();
 }
 
 /*************************************************************************/
@@ -551,6 +562,22 @@ void TrackTab::invalidNoteFound(int, int, int, QString reason) {
 
 /*************************************************************************/
 
+void TrackTab::pollPlayerPos() {
+    int pos[2];
+    if (!pPlayer->getPlayerPos(&pos[0], &pos[1])
+            || (pos[0] == lastPlayerPos[0] && pos[1] == lastPlayerPos[1])) {
+        return;
+    }
+    lastPlayerPos[0] = pos[0];
+    lastPlayerPos[1] = pos[1];
+    Timeline *timeline = findChild<Timeline *>("trackTimeline");
+    timeline->playerPosChanged(pos[0], pos[1]);
+    PatternEditor *editor = findChild<PatternEditor *>("trackEditor");
+    editor->newPlayerPos(pos[0], pos[1]);
+}
+
+/*************************************************************************/
+
 void TrackTab::updateTrackStats() {
     // Patterns
     QLabel *statsLabel = findChild<QLabel *>("labelPatternsUsed");
@@ -16,6 +16,7 @@
 #include "tiasound/instrumentpitchguide.h"
 #include <QMenu>
 #include <QAction>
+#include <QTimer>
 #include "emulation/player.h"
 
 
@@ -77,6 +78,9 @@ public slots:
     // Player error
     void invalidNoteFound(int channel, int entryIndex, int noteIndex, QString reason);
 
+    /* Passes a new player position on to editor and timeline */
+    void pollPlayerPos();
+
 private:
     /* Updates the pattern editor area */
     void updatePatternEditor();
@@ -92,6 +96,12 @@ private:
     TiaSound::PitchGuide *pPitchGuide;
     Emulation::Player *pPlayer = nullptr;
 
+    /* The player position is polled once per display frame, so the
+     * GUI never repaints more often than that no matter how fast the
+     * song plays. */
+    QTimer playerPosTimer{this};
+    int lastPlayerPos[2]{-1, -1};
+
     // Global actions
     QAction actionMoveUp{this};
     QAction actionMoveDown{this};